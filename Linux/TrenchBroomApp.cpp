@@ -23,8 +23,13 @@
 #include <wx/menu.h>
 
 #include "Utility/DocManager.h"
+#include "View/EditorFrame.h"
+#include "View/EditorView.h"
+#include "View/MapGLCanvas.h"
 
 #include <clocale>
+#include <cstdio>
+#include <limits>
 
 IMPLEMENT_APP(TrenchBroomApp)
 
@@ -53,10 +58,29 @@ bool TrenchBroomApp::OnInit() {
 		SetExitOnFrameDelete(true);
 		m_docManager->SetUseSDI(false);
         if (wxApp::argc > 1) {
+            // TrenchBroom <map> --render-benchmark[=<frames>] renders a camera flight around the map and exits
+            unsigned long frameCount = 0;
+            wxString frames;
+            if (wxApp::argc > 2 && wxApp::argv[2].StartsWith(wxT("--render-benchmark"), &frames)) {
+                frameCount = 360;
+                if (!frames.empty() &&
+                    (!frames.StartsWith(wxT("="), &frames) || !frames.ToULong(&frameCount) ||
+                     frameCount == 0 || frameCount > std::numeric_limits<unsigned int>::max())) {
+                    std::fprintf(stderr, "Invalid argument %s, expected --render-benchmark[=<frames>] with at least one frame\n", wxApp::argv[2].ToStdString().c_str());
+                    return false;
+                }
+            }
+
             wxString filename = wxApp::argv[1];
-            if (m_docManager->CreateDocument(filename) == NULL) {
+            wxDocument* document = m_docManager->CreateDocument(filename);
+            if (document == NULL) {
                 return false;
             }
+
+            if (frameCount > 0) {
+                TrenchBroom::View::EditorView* view = static_cast<TrenchBroom::View::EditorView*>(document->GetFirstView());
+                view->editorFrame().mapCanvas().scheduleRenderBenchmark(static_cast<unsigned int>(frameCount));
+            }
         } else {
 		    m_docManager->CreateNewDocument();
         }
@@ -58,6 +58,10 @@ namespace TrenchBroom {
                 return m_entities;
             }
 
+            inline const Model::BrushList& addedBrushes() const {
+                return m_addedBrushes;
+            }
+            
             inline bool hasAddedBrushes() const {
                 return m_hasAddedBrushes;
             }
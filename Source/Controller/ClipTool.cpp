@@ -78,12 +78,91 @@ namespace TrenchBroom {
             return sum / static_cast<float>((normals1.size() + normals2.size()));
         }
 
-        void ClipTool::updateBrushes() {
-            m_frontBrushes.clear();
-            m_backBrushes.clear();
+        void ClipTool::clipBrush(Model::Brush& brush, const Vec3f planePoints[3], const Planef& plane, ClipResult& result) const {
+            // a brush that the plane does not intersect ends up on one side as a whole
+            bool above = false;
+            bool below = false;
+            const Model::VertexList& vertices = brush.vertices();
+            Model::VertexList::const_iterator vertexIt, vertexEnd;
+            for (vertexIt = vertices.begin(), vertexEnd = vertices.end(); vertexIt != vertexEnd && !(above && below); ++vertexIt) {
+                const PointStatus::Type status = plane.pointStatus((*vertexIt)->position);
+                if (status == PointStatus::PSAbove)
+                    above = true;
+                else if (status == PointStatus::PSBelow)
+                    below = true;
+            }
+            
+            if (!above) {
+                result.front = &brush;
+                return;
+            }
+            if (!below) {
+                result.back = &brush;
+                return;
+            }
+            
+            const BBoxf& worldBounds = document().map().worldBounds();
+            const bool forceIntegerFacePoints = document().map().forceIntegerFacePoints();
+            const String textureName = document().mruTexture() != NULL ? document().mruTexture()->name() : Model::Texture::Empty;
+            
+            Model::Face* frontFace = new Model::Face(worldBounds, forceIntegerFacePoints, planePoints[0], planePoints[1], planePoints[2], textureName);
+            Model::Face* backFace = new Model::Face(worldBounds, forceIntegerFacePoints, planePoints[0], planePoints[2], planePoints[1], textureName);
+            
+            // determine the texture for the new faces
+            // we will use the texture of the face whose normal is closest to the newly inserted face
+            const Model::FaceList& faces = brush.faces();
+            Model::FaceList::const_iterator faceIt = faces.begin();
+            Model::FaceList::const_iterator faceEnd = faces.end();
+            const Model::Face* bestFrontFace = *faceIt++;
+            const Model::Face* bestBackFace = bestFrontFace;
+            
+            while (faceIt != faceEnd) {
+                const Model::Face* face = *faceIt++;
+                
+                const Vec3f bestFrontDiff = bestFrontFace->boundary().normal - frontFace->boundary().normal;
+                const Vec3f frontDiff = face->boundary().normal - frontFace->boundary().normal;
+                if (frontDiff.lengthSquared() < bestFrontDiff.lengthSquared())
+                    bestFrontFace = face;
+                
+                const Vec3f bestBackDiff = bestBackFace->boundary().normal - backFace->boundary().normal;
+                const Vec3f backDiff = face->boundary().normal - backFace->boundary().normal;
+                if (backDiff.lengthSquared() < bestBackDiff.lengthSquared())
+                    bestBackFace = face;
+            }
+            
+            frontFace->setAttributes(*bestFrontFace);
+            backFace->setAttributes(*bestBackFace);
             
-            Model::BrushList allFrontBrushes, allBackBrushes;
+            Model::Brush* frontBrush = new Model::Brush(worldBounds, forceIntegerFacePoints, brush);
+            if (frontBrush->clip(*frontFace))
+                result.front = frontBrush;
+            else
+                delete frontBrush;
             
+            Model::Brush* backBrush = new Model::Brush(worldBounds, forceIntegerFacePoints, brush);
+            if (backBrush->clip(*backFace))
+                result.back = backBrush;
+            else
+                delete backBrush;
+        }
+        
+        void ClipTool::deleteClipResult(Model::Brush* brush, ClipResult& result) const {
+            if (result.front != brush)
+                delete result.front;
+            if (result.back != brush)
+                delete result.back;
+            result.front = result.back = NULL;
+        }
+        
+        void ClipTool::clearClipResults() {
+            ClipResultMap::iterator it, end;
+            for (it = m_clipResults.begin(), end = m_clipResults.end(); it != end; ++it)
+                deleteClipResult(it->first, it->second);
+            m_clipResults.clear();
+            m_clipResultsValid = false;
+        }
+        
+        void ClipTool::updateBrushes() {
             Renderer::Camera& camera = view().camera();
             Vec3f planePoints[3];
             bool validPlane = false;
@@ -136,66 +215,52 @@ namespace TrenchBroom {
             }
             
             const Model::BrushList& brushes = document().editStateManager().selectedBrushes();
+            Model::BrushList frontBrushes, backBrushes;
+            
             if (validPlane) {
-                const BBoxf& worldBounds = document().map().worldBounds();
-                const bool forceIntegerFacePoints = document().map().forceIntegerFacePoints();
-                const String textureName = document().mruTexture() != NULL ? document().mruTexture()->name() : Model::Texture::Empty;
+                Planef plane;
+                plane.setPoints(planePoints[0], planePoints[1], planePoints[2]);
                 
+                const bool planeChanged = (!m_clipResultsValid ||
+                                           planePoints[0] != m_clipPlanePoints[0] ||
+                                           planePoints[1] != m_clipPlanePoints[1] ||
+                                           planePoints[2] != m_clipPlanePoints[2]);
+                
+                // only the brushes that were not clipped by the same plane before are clipped, and brushes that the
+                // plane does not intersect are not copied at all
+                ClipResultMap clipResults;
                 Model::BrushList::const_iterator brushIt, brushEnd;
                 for (brushIt = brushes.begin(), brushEnd = brushes.end(); brushIt != brushEnd; ++brushIt) {
-                    Model::Brush& brush = **brushIt;
-                    Model::Entity* entity = brush.entity();
-                    Model::Face* frontFace = new Model::Face(worldBounds, forceIntegerFacePoints, planePoints[0], planePoints[1], planePoints[2], textureName);
-                    Model::Face* backFace = new Model::Face(worldBounds, forceIntegerFacePoints, planePoints[0], planePoints[2], planePoints[1], textureName);
-                    
-                    // determine the texture for the new faces
-                    // we will use the texture of the face whose normal is closest to the newly inserted face
-                    const Model::FaceList& faces = brush.faces();
-                    Model::FaceList::const_iterator faceIt = faces.begin();
-                    Model::FaceList::const_iterator faceEnd = faces.end();
-                    const Model::Face* bestFrontFace = *faceIt++;
-                    const Model::Face* bestBackFace = bestFrontFace;
-                    
-                    while (faceIt != faceEnd) {
-                        const Model::Face* face = *faceIt++;
-                        
-                        const Vec3f bestFrontDiff = bestFrontFace->boundary().normal - frontFace->boundary().normal;
-                        const Vec3f frontDiff = face->boundary().normal - frontFace->boundary().normal;
-                        if (frontDiff.lengthSquared() < bestFrontDiff.lengthSquared())
-                            bestFrontFace = face;
-                        
-                        const Vec3f bestBackDiff = bestBackFace->boundary().normal - backFace->boundary().normal;
-                        const Vec3f backDiff = face->boundary().normal - backFace->boundary().normal;
-                        if (backDiff.lengthSquared() < bestBackDiff.lengthSquared())
-                            bestBackFace = face;
-                    }
-                    
-                    frontFace->setAttributes(*bestFrontFace);
-                    backFace->setAttributes(*bestBackFace);
-                    
-                    Model::Brush* frontBrush = new Model::Brush(worldBounds, forceIntegerFacePoints, brush);
-                    if (frontBrush->clip(*frontFace)) {
-                        m_frontBrushes[entity].push_back(frontBrush);
-                        allFrontBrushes.push_back(frontBrush);
+                    Model::Brush* brush = *brushIt;
+                    ClipResult& result = clipResults[brush];
+                    ClipResultMap::iterator cachedIt = m_clipResults.find(brush);
+                    if (cachedIt != m_clipResults.end() && !planeChanged) {
+                        result = cachedIt->second;
+                        m_clipResults.erase(cachedIt);
                     } else {
-                        delete frontBrush;
+                        clipBrush(*brush, planePoints, plane, result);
                     }
                     
-                    Model::Brush* backBrush = new Model::Brush(worldBounds, forceIntegerFacePoints, brush);
-                    if (backBrush->clip(*backFace)) {
-                        m_backBrushes[entity].push_back(backBrush);
-                        allBackBrushes.push_back(backBrush);
-                    } else {
-                        delete backBrush;
-                    }
+                    if (result.front != NULL)
+                        frontBrushes.push_back(result.front);
+                    if (result.back != NULL)
+                        backBrushes.push_back(result.back);
                 }
+                
+                // the figures must drop the previous copies before they are deleted
+                m_frontBrushFigure->setBrushes(frontBrushes);
+                m_backBrushFigure->setBrushes(backBrushes);
+                
+                clearClipResults();
+                m_clipResults.swap(clipResults);
+                for (size_t i = 0; i < 3; i++)
+                    m_clipPlanePoints[i] = planePoints[i];
+                m_clipResultsValid = true;
             } else {
-                allFrontBrushes = brushes;
-                m_frontBrushes = entityBrushes(allFrontBrushes);
+                m_frontBrushFigure->setBrushes(brushes);
+                m_backBrushFigure->setBrushes(backBrushes);
+                clearClipResults();
             }
-
-            m_frontBrushFigure->setBrushes(allFrontBrushes);
-            m_backBrushFigure->setBrushes(allBackBrushes);
         }
         
         Vec3f::List ClipTool::getNormals(const Vec3f& hitPoint, const Model::Face& hitFace) const {
@@ -271,6 +336,7 @@ namespace TrenchBroom {
         }
         
         bool ClipTool::handleDeactivate(InputState& inputState) {
+            clearClipResults();
             deleteFigure(m_frontBrushFigure);
             m_frontBrushFigure = NULL;
             deleteFigure(m_backBrushFigure);
@@ -555,6 +621,10 @@ namespace TrenchBroom {
                     case Controller::Command::ClearMap:
                     case Controller::Command::TransformObjects:
                     case Controller::Command::ResizeBrushes:
+                        // the selected brushes may have changed, so their clip results and edges are stale
+                        clearClipResults();
+                        m_frontBrushFigure->invalidate();
+                        m_backBrushFigure->invalidate();
                         updateBrushes();
                         break;
                     default:
@@ -570,6 +640,7 @@ namespace TrenchBroom {
         m_hitIndex(-1),
         m_directHit(false),
         m_clipSide(CMFront),
+        m_clipResultsValid(false),
         m_frontBrushFigure(NULL),
         m_backBrushFigure(NULL) {}
         
@@ -601,43 +672,69 @@ namespace TrenchBroom {
             assert(active());
             assert(m_numPoints > 0);
 
+            // brushes that the plane does not intersect are kept as they are if they are on a side that is kept
             Model::EntityBrushesMap addBrushes;
-            switch (m_clipSide) {
-                case CMFront:
-                    addBrushes = m_frontBrushes;
-                    break;
-                case CMBack:
-                    addBrushes = m_backBrushes;
-                    break;
-                default:
-                    addBrushes = mergeEntityBrushes(m_frontBrushes, m_backBrushes);
-                    break;
-            }
+            Model::BrushList keepBrushes;
+            Model::BrushList removeBrushes;
             
-            const Model::BrushList removeBrushes = document().editStateManager().selectedBrushes();
+            const Model::BrushList& brushes = document().editStateManager().selectedBrushes();
+            Model::BrushList::const_iterator brushIt, brushEnd;
+            for (brushIt = brushes.begin(), brushEnd = brushes.end(); brushIt != brushEnd; ++brushIt) {
+                Model::Brush* brush = *brushIt;
+                ClipResultMap::iterator resultIt = m_clipResults.find(brush);
+                if (resultIt == m_clipResults.end()) {
+                    keepBrushes.push_back(brush);
+                    continue;
+                }
+                
+                ClipResult& result = resultIt->second;
+                Model::Brush* sides[2];
+                sides[0] = m_clipSide != CMBack ? result.front : NULL;
+                sides[1] = m_clipSide != CMFront ? result.back : NULL;
+                
+                bool keep = false;
+                for (size_t i = 0; i < 2; i++) {
+                    if (sides[i] == brush) {
+                        keep = true;
+                    } else if (sides[i] != NULL) {
+                        addBrushes[brush->entity()].push_back(sides[i]);
+                        // the document owns the added brushes now
+                        if (sides[i] == result.front)
+                            result.front = NULL;
+                        else
+                            result.back = NULL;
+                    }
+                }
+                
+                if (keep)
+                    keepBrushes.push_back(brush);
+                else
+                    removeBrushes.push_back(brush);
+            }
 
             beginCommandGroup(wxT("Clip"));
             submitCommand(ChangeEditStateCommand::deselectAll(document()));
 
-            if (!addBrushes.empty()) {
-                Model::BrushList allBrushes;
-                Model::EntityBrushesMap::const_iterator it, end;
-                for (it = addBrushes.begin(), end = addBrushes.end(); it != end; ++it) {
-                    Model::Entity* entity = it->first;
-                    
-                    const Model::BrushList& entityBrushes = it->second;
-                    allBrushes.insert(allBrushes.end(), entityBrushes.begin(), entityBrushes.end());
-                    
-                    submitCommand(AddObjectsCommand::addBrushes(document(), entityBrushes));
-                    if (!entity->worldspawn())
-                        submitCommand(ReparentBrushesCommand::reparent(document(), entityBrushes, *entity));
-                }
-                submitCommand(ChangeEditStateCommand::select(document(), allBrushes));
+            Model::BrushList allBrushes = keepBrushes;
+            Model::EntityBrushesMap::const_iterator it, end;
+            for (it = addBrushes.begin(), end = addBrushes.end(); it != end; ++it) {
+                Model::Entity* entity = it->first;
+                
+                const Model::BrushList& entityBrushes = it->second;
+                allBrushes.insert(allBrushes.end(), entityBrushes.begin(), entityBrushes.end());
+                
+                submitCommand(AddObjectsCommand::addBrushes(document(), entityBrushes));
+                if (!entity->worldspawn())
+                    submitCommand(ReparentBrushesCommand::reparent(document(), entityBrushes, *entity));
             }
+            if (!allBrushes.empty())
+                submitCommand(ChangeEditStateCommand::select(document(), allBrushes));
 
-            submitCommand(RemoveObjectsCommand::removeBrushes(document(), removeBrushes));
+            if (!removeBrushes.empty())
+                submitCommand(RemoveObjectsCommand::removeBrushes(document(), removeBrushes));
             endCommandGroup();
             
+            clearClipResults();
             m_numPoints = 0;
             m_hitIndex = -1;
             
@@ -25,6 +25,7 @@
 #include "Utility/VecMath.h"
 
 #include <cassert>
+#include <map>
 
 using namespace TrenchBroom::VecMath;
 
@@ -96,6 +97,22 @@ namespace TrenchBroom {
                 }
             };
 
+            /**
+             * The result of clipping a selected brush. If the clip plane does not intersect the brush, one side refers
+             * to the brush itself and the other one is empty. Otherwise, both sides are clipped copies of the brush.
+             */
+            class ClipResult {
+            public:
+                Model::Brush* front;
+                Model::Brush* back;
+                
+                ClipResult() :
+                front(NULL),
+                back(NULL) {}
+            };
+            
+            typedef std::map<Model::Brush*, ClipResult> ClipResultMap;
+            
             ClipFilter m_filter;
             Vec3f m_points[3];
             Vec3f::List m_normals[3];
@@ -104,12 +121,16 @@ namespace TrenchBroom {
             bool m_directHit;
             
             ClipSide m_clipSide;
-            Model::EntityBrushesMap m_frontBrushes;
-            Model::EntityBrushesMap m_backBrushes;
+            ClipResultMap m_clipResults;
+            Vec3f m_clipPlanePoints[3];
+            bool m_clipResultsValid;
             Renderer::BrushFigure* m_frontBrushFigure;
             Renderer::BrushFigure* m_backBrushFigure;
             
             Vec3f selectNormal(const Vec3f::List& normals1, const Vec3f::List& normals2) const;
+            void clipBrush(Model::Brush& brush, const Vec3f planePoints[3], const Planef& plane, ClipResult& result) const;
+            void deleteClipResult(Model::Brush* brush, ClipResult& result) const;
+            void clearClipResults();
             void updateBrushes();
             Vec3f::List getNormals(const Vec3f& hitPoint, const Model::Face& hitFace) const;
             bool isPointIdenticalWithExistingPoint(const Vec3f& point) const;
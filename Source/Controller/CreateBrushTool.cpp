@@ -129,9 +129,11 @@ namespace TrenchBroom {
             
             updateBounds(curPoint);
             
-            delete m_brush;
+            // the figure only rebuilds brushes it does not know, so it must see the new brush before the old one is deleted
+            Model::Brush* oldBrush = m_brush;
             m_brush = new Model::Brush(document().map().worldBounds(), document().map().forceIntegerFacePoints(), m_bounds, document().mruTexture());
             m_brushFigure->setBrush(*m_brush);
+            delete oldBrush;
             return true;
         }
         
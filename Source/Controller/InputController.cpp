@@ -47,6 +47,7 @@
 #include "Renderer/SharedResources.h"
 #include "Utility/Console.h"
 #include "Utility/Grid.h"
+#include "Utility/Profiler.h"
 #include "View/DocumentViewHolder.h"
 
 namespace TrenchBroom {
@@ -75,6 +76,7 @@ namespace TrenchBroom {
         }
 
         void InputController::updateHits() {
+            Utility::Profiler::Suspension suspension(&m_documentViewHolder.view());
             m_inputState.invalidate();
             m_toolChain->updateHits(m_inputState);
         }
@@ -304,6 +306,13 @@ namespace TrenchBroom {
                     m_toolChain->mouseMove(m_inputState);
                 }
             } else {
+                // the pick ray only depends on the mouse position and the camera, and both camera and scene changes
+                // already update the hits, so a hover event that doesn't move the mouse doesn't change anything
+                if (x == m_inputState.x() && y == m_inputState.y()) {
+                    m_inputState.mouseMove(x, y);
+                    return;
+                }
+
                 m_inputState.mouseMove(x, y);
                 updateHits();
                 m_toolChain->mouseMove(m_inputState);
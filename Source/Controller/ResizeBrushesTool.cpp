@@ -74,50 +74,15 @@ namespace TrenchBroom {
             if (faceHit != NULL) {
                 inputState.pickResult().add(new Model::DragFaceHit(faceHit->hitPoint(), faceHit->distance(), faceHit->face()));
             } else {
-                float closestEdgeDist = std::numeric_limits<float>::max();
-                const Model::Edge* closestEdge = NULL;
-                Model::Face* dragFace = NULL;
-                Vec3f hitPoint;
-                float hitDistance = 0.0f;
-                
                 Model::EditStateManager& editStateManager = document().editStateManager();
-                const Model::BrushList& selectedBrushes = editStateManager.selectedBrushes();
-                
-
-                Model::BrushList::const_iterator brushIt, brushEnd;
-                for (brushIt = selectedBrushes.begin(), brushEnd = selectedBrushes.end(); brushIt != brushEnd; ++brushIt) {
-                    Model::Brush& brush = **brushIt;
-                    const Model::EdgeList& edges = brush.edges();
-                    Model::EdgeList::const_iterator edgeIt, edgeEnd;
-                    for (edgeIt = edges.begin(), edgeEnd = edges.end(); edgeIt != edgeEnd; ++edgeIt) {
-                        const Model::Edge* edge = *edgeIt;
-
-                        float leftDot = edge->left->face->boundary().normal.dot(inputState.pickRay().direction);
-                        float rightDot = edge->right->face->boundary().normal.dot(inputState.pickRay().direction);
-                        if ((leftDot > 0.0f) != (rightDot > 0.0f)) {
-                            Vec3f pointOnSegment;
-                            float distanceToClosestPointOnRay;
-                            float distanceBetweenRayAndEdge = inputState.pickRay().distanceToSegment(edge->start->position,
-                                                                                                     edge->end->position,
-                                                                                                     pointOnSegment,
-                                                                                                     distanceToClosestPointOnRay);
-                            if (!Math<float>::isnan(distanceBetweenRayAndEdge) && distanceBetweenRayAndEdge < closestEdgeDist) {
-                                closestEdge = edge;
-                                closestEdgeDist = distanceBetweenRayAndEdge;
-                                hitDistance = distanceToClosestPointOnRay;
-                                hitPoint = inputState.pickRay().pointAtDistance(hitDistance);
-                                if (leftDot > rightDot) {
-                                    dragFace = edge->left->face;
-                                } else {
-                                    dragFace = edge->right->face;
-                                }
-                            }
-                        }
-                    }
-                }
-                
-                if (closestEdge != NULL)
-                    inputState.pickResult().add(new Model::DragFaceHit(hitPoint, hitDistance, *dragFace));
+                if (!m_edgeIndex.valid())
+                    m_edgeIndex.build(editStateManager.selectedBrushes());
+                m_edgeIndex.setViewPoint(inputState.camera().position());
+
+                float edgeDistance, hitDistance;
+                Model::Face* dragFace = m_edgeIndex.findClosestEdge(inputState.pickRay(), edgeDistance, hitDistance);
+                if (dragFace != NULL)
+                    inputState.pickResult().add(new Model::DragFaceHit(inputState.pickRay().pointAtDistance(hitDistance), hitDistance, *dragFace));
             }
         }
 
@@ -236,6 +201,25 @@ namespace TrenchBroom {
             m_faces.clear();
         }
 
+        void ResizeBrushesTool::handleUpdate(const Command& command, InputState& inputState) {
+            switch (command.type()) {
+                case Controller::Command::LoadMap:
+                case Controller::Command::ClearMap:
+                case Controller::Command::ChangeEditState:
+                case Controller::Command::AddObjects:
+                case Controller::Command::RemoveObjects:
+                case Controller::Command::TransformObjects:
+                case Controller::Command::ResizeBrushes:
+                case Controller::Command::MoveVertices:
+                case Controller::Command::SnapVertices:
+                case Controller::Command::RebuildBrushGeometry:
+                    m_edgeIndex.invalidate();
+                    break;
+                default:
+                    break;
+            }
+        }
+
         ResizeBrushesTool::ResizeBrushesTool(View::DocumentViewHolder& documentViewHolder, InputController& inputController) :
         Tool(documentViewHolder, inputController, true),
         m_filter(Model::SelectedFilter(view().filter())) {}
@@ -20,6 +20,7 @@
 #ifndef __TrenchBroom__ResizeBrushesTool__
 #define __TrenchBroom__ResizeBrushesTool__
 
+#include "Controller/SilhouetteEdgeIndex.h"
 #include "Controller/Tool.h"
 #include "Model/FaceTypes.h"
 #include "Model/Picker.h"
@@ -61,6 +62,7 @@ namespace TrenchBroom {
             Vec3f m_totalDelta;
 
             Vec3f m_dragOrigin;
+            SilhouetteEdgeIndex m_edgeIndex;
             
             Model::FaceList dragFaces(Model::Face& dragFace);
             
@@ -73,6 +75,8 @@ namespace TrenchBroom {
             bool handleDrag(InputState& inputState);
             void handleEndDrag(InputState& inputState);
             void handleCancelDrag(InputState& inputState);
+
+            void handleUpdate(const Command& command, InputState& inputState);
         public:
             ResizeBrushesTool(View::DocumentViewHolder& documentViewHolder, InputController& inputController);
         };
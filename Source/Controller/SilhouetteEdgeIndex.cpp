@@ -0,0 +1,215 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SilhouetteEdgeIndex.h"
+
+#include "Model/Brush.h"
+#include "Model/BrushGeometry.h"
+#include "Model/Face.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace TrenchBroom {
+    namespace Controller {
+        class CompareEdgeCenters {
+        private:
+            size_t m_axis;
+        public:
+            CompareEdgeCenters(size_t axis) :
+            m_axis(axis) {}
+
+            template <typename T>
+            inline bool operator()(const T& edge1, const T& edge2) const {
+                return edge1.start[m_axis] + edge1.end[m_axis] < edge2.start[m_axis] + edge2.end[m_axis];
+            }
+        };
+
+        size_t SilhouetteEdgeIndex::buildNode(const size_t first, const size_t count) {
+            assert(count > 0);
+
+            BBoxf bounds(m_edges[first].start, m_edges[first].start);
+            BBoxf centerBounds(m_edges[first].start + m_edges[first].end, m_edges[first].start + m_edges[first].end);
+            for (size_t i = first; i < first + count; i++) {
+                const IndexedEdge& edge = m_edges[i];
+                bounds.mergeWith(edge.start);
+                bounds.mergeWith(edge.end);
+                centerBounds.mergeWith(edge.start + edge.end);
+            }
+
+            const size_t index = m_nodes.size();
+            m_nodes.push_back(Node());
+            m_nodes[index].center = bounds.center();
+            m_nodes[index].radius = (bounds.max - bounds.min).length() / 2.0f;
+            m_nodes[index].silhouette = false;
+
+            if (count <= MaxLeafSize) {
+                m_nodes[index].first = first;
+                m_nodes[index].count = count;
+                m_nodes[index].left = m_nodes[index].right = 0;
+            } else {
+                // split at the median of the edge centers along the axis in which they are spread the most
+                const Vec3f size = centerBounds.max - centerBounds.min;
+                const size_t axis = size.x() >= size.y() && size.x() >= size.z() ? 0 : (size.y() >= size.z() ? 1 : 2);
+                const size_t half = count / 2;
+                std::nth_element(m_edges.begin() + first, m_edges.begin() + first + half, m_edges.begin() + first + count, CompareEdgeCenters(axis));
+
+                const size_t left = buildNode(first, half);
+                const size_t right = buildNode(first + half, count - half);
+                m_nodes[index].first = first;
+                m_nodes[index].count = 0;
+                m_nodes[index].left = left;
+                m_nodes[index].right = right;
+            }
+
+            return index;
+        }
+
+        bool SilhouetteEdgeIndex::updateNode(const size_t index) {
+            Node& node = m_nodes[index];
+            if (node.count > 0) {
+                node.silhouette = false;
+                for (size_t i = node.first; i < node.first + node.count; i++) {
+                    IndexedEdge& edge = m_edges[i];
+                    // a face faces away from the viewer if the view point is below it
+                    const bool leftAway = edge.left->boundary().pointDistance(m_viewPoint) < 0.0f;
+                    const bool rightAway = edge.right->boundary().pointDistance(m_viewPoint) < 0.0f;
+                    if (leftAway != rightAway) {
+                        edge.dragFace = leftAway ? edge.left : edge.right;
+                        node.silhouette = true;
+                    } else {
+                        edge.dragFace = NULL;
+                    }
+                }
+            } else {
+                const bool left = updateNode(node.left);
+                const bool right = updateNode(node.right);
+                node.silhouette = left || right;
+            }
+            return node.silhouette;
+        }
+
+        float SilhouetteEdgeIndex::nodeDistance(const Node& node, const Rayf& ray) const {
+            float distanceToClosestPoint;
+            float distance = ray.distanceToPoint(node.center, distanceToClosestPoint);
+            if (Math<float>::isnan(distance))
+                distance = (node.center - ray.origin).length();
+            return distance - node.radius;
+        }
+
+        void SilhouetteEdgeIndex::findClosestEdge(const size_t index, const Rayf& ray, Hit& hit) const {
+            const Node& node = m_nodes[index];
+            if (node.count > 0) {
+                for (size_t i = node.first; i < node.first + node.count; i++) {
+                    const IndexedEdge& edge = m_edges[i];
+                    if (edge.dragFace == NULL)
+                        continue;
+
+                    Vec3f pointOnSegment;
+                    float distanceToClosestPoint;
+                    const float distance = ray.distanceToSegment(edge.start, edge.end, pointOnSegment, distanceToClosestPoint);
+                    if (Math<float>::isnan(distance))
+                        continue;
+
+                    // prefer the edge that comes first in the brush list, like a linear search would
+                    if (distance < hit.edgeDistance || (hit.edge != NULL && distance == hit.edgeDistance && edge.order < hit.edge->order)) {
+                        hit.edge = &edge;
+                        hit.edgeDistance = distance;
+                        hit.rayDistance = distanceToClosestPoint;
+                    }
+                }
+            } else {
+                const Node& left = m_nodes[node.left];
+                const Node& right = m_nodes[node.right];
+                const float leftDistance = left.silhouette ? nodeDistance(left, ray) : std::numeric_limits<float>::max();
+                const float rightDistance = right.silhouette ? nodeDistance(right, ray) : std::numeric_limits<float>::max();
+
+                if (leftDistance <= rightDistance) {
+                    if (left.silhouette && leftDistance <= hit.edgeDistance)
+                        findClosestEdge(node.left, ray, hit);
+                    if (right.silhouette && rightDistance <= hit.edgeDistance)
+                        findClosestEdge(node.right, ray, hit);
+                } else {
+                    if (right.silhouette && rightDistance <= hit.edgeDistance)
+                        findClosestEdge(node.right, ray, hit);
+                    if (left.silhouette && leftDistance <= hit.edgeDistance)
+                        findClosestEdge(node.left, ray, hit);
+                }
+            }
+        }
+
+        SilhouetteEdgeIndex::SilhouetteEdgeIndex() :
+        m_valid(false),
+        m_viewValid(false) {}
+
+        void SilhouetteEdgeIndex::invalidate() {
+            m_edges.clear();
+            m_nodes.clear();
+            m_valid = false;
+            m_viewValid = false;
+        }
+
+        void SilhouetteEdgeIndex::build(const Model::BrushList& brushes) {
+            invalidate();
+
+            Model::BrushList::const_iterator brushIt, brushEnd;
+            for (brushIt = brushes.begin(), brushEnd = brushes.end(); brushIt != brushEnd; ++brushIt) {
+                const Model::Brush& brush = **brushIt;
+                const Model::EdgeList& edges = brush.edges();
+                Model::EdgeList::const_iterator edgeIt, edgeEnd;
+                for (edgeIt = edges.begin(), edgeEnd = edges.end(); edgeIt != edgeEnd; ++edgeIt) {
+                    const Model::Edge& edge = **edgeIt;
+                    m_edges.push_back(IndexedEdge(edge.start->position, edge.end->position, edge.left->face, edge.right->face, m_edges.size()));
+                }
+            }
+
+            if (!m_edges.empty()) {
+                m_nodes.reserve(2 * m_edges.size() / MaxLeafSize + 1);
+                buildNode(0, m_edges.size());
+            }
+            m_valid = true;
+        }
+
+        void SilhouetteEdgeIndex::setViewPoint(const Vec3f& viewPoint) {
+            assert(m_valid);
+            if (m_viewValid && viewPoint == m_viewPoint)
+                return;
+
+            m_viewPoint = viewPoint;
+            m_viewValid = true;
+            if (!m_nodes.empty())
+                updateNode(0);
+        }
+
+        Model::Face* SilhouetteEdgeIndex::findClosestEdge(const Rayf& ray, float& edgeDistance, float& rayDistance) const {
+            assert(m_valid && m_viewValid);
+            if (m_nodes.empty() || !m_nodes[0].silhouette)
+                return NULL;
+
+            Hit hit;
+            findClosestEdge(0, ray, hit);
+            if (hit.edge == NULL)
+                return NULL;
+
+            edgeDistance = hit.edgeDistance;
+            rayDistance = hit.rayDistance;
+            return hit.edge->dragFace;
+        }
+    }
+}
@@ -0,0 +1,131 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__SilhouetteEdgeIndex__
+#define __TrenchBroom__SilhouetteEdgeIndex__
+
+#include "Model/BrushTypes.h"
+#include "Model/FaceTypes.h"
+#include "Utility/VecMath.h"
+
+#include <limits>
+#include <vector>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Controller {
+        /**
+         * Finds the silhouette edge of a set of brushes that is closest to a pick ray. A silhouette edge separates a
+         * face that faces the viewer from one that faces away from it. Since all pick rays start at the camera
+         * position, the silhouette only depends on that position.
+         *
+         * The edges are stored in a bounding volume hierarchy of spheres that is only rebuilt when the brushes
+         * change. When the view point changes, the silhouette flags of the edges and nodes are updated in a single
+         * pass over the hierarchy. A query visits the nodes that contain silhouette edges in order of their distance
+         * to the ray and skips every node that cannot contain an edge closer than the closest one found so far.
+         */
+        class SilhouetteEdgeIndex {
+        private:
+            static const size_t MaxLeafSize = 4;
+
+            class IndexedEdge {
+            public:
+                Vec3f start;
+                Vec3f end;
+                Model::Face* left;
+                Model::Face* right;
+                Model::Face* dragFace;
+                size_t order;
+
+                IndexedEdge(const Vec3f& i_start, const Vec3f& i_end, Model::Face* i_left, Model::Face* i_right, size_t i_order) :
+                start(i_start),
+                end(i_end),
+                left(i_left),
+                right(i_right),
+                dragFace(NULL),
+                order(i_order) {}
+            };
+
+            class Node {
+            public:
+                Vec3f center;
+                float radius;
+                size_t first;
+                size_t count;
+                size_t left;
+                size_t right;
+                bool silhouette;
+            };
+
+            class Hit {
+            public:
+                const IndexedEdge* edge;
+                float edgeDistance;
+                float rayDistance;
+
+                Hit() :
+                edge(NULL),
+                edgeDistance(std::numeric_limits<float>::max()),
+                rayDistance(0.0f) {}
+            };
+
+            typedef std::vector<IndexedEdge> EdgeList;
+            typedef std::vector<Node> NodeList;
+
+            EdgeList m_edges;
+            NodeList m_nodes;
+            bool m_valid;
+            bool m_viewValid;
+            Vec3f m_viewPoint;
+
+            size_t buildNode(size_t first, size_t count);
+            bool updateNode(size_t index);
+            float nodeDistance(const Node& node, const Rayf& ray) const;
+            void findClosestEdge(size_t index, const Rayf& ray, Hit& hit) const;
+        public:
+            SilhouetteEdgeIndex();
+
+            inline bool valid() const {
+                return m_valid;
+            }
+
+            void invalidate();
+
+            /**
+             * Indexes the edges of the given brushes.
+             */
+            void build(const Model::BrushList& brushes);
+
+            /**
+             * Updates the silhouette if the given view point differs from the previous one.
+             */
+            void setViewPoint(const Vec3f& viewPoint);
+
+            /**
+             * Returns the face that faces away from the viewer at the silhouette edge closest to the given ray, or
+             * NULL if there is no such edge. Otherwise, the distance between the ray and the edge and the distance
+             * from the ray origin to the closest point on the ray are returned in the given parameters.
+             */
+            Model::Face* findClosestEdge(const Rayf& ray, float& edgeDistance, float& rayDistance) const;
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__SilhouetteEdgeIndex__) */
@@ -57,6 +57,20 @@ namespace TrenchBroom {
             }
         };
         
+        /**
+         * A view of a range of another mapped file. The view keeps the underlying file mapped for as long as it exists.
+         */
+        class MappedFileView : public MappedFile {
+        private:
+            MappedFile::Ptr m_file;
+        public:
+            MappedFileView(MappedFile::Ptr file, char* begin, char* end) :
+            MappedFile(begin, end),
+            m_file(file) {
+                assert(m_begin >= m_file->begin() && m_end <= m_file->end());
+            }
+        };
+        
 #ifndef _WIN32
         class PosixMappedFile : public MappedFile {
         private:
@@ -60,6 +60,10 @@ namespace TrenchBroom {
                 m_index += sizeof(T);
             }
 
+            inline void append(const char* begin, const char* end) {
+                m_buffer.insert(m_buffer.end(), begin, end);
+            }
+
             inline void reset() {
                 m_index = 0;
             }
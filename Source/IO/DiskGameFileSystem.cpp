@@ -0,0 +1,47 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DiskGameFileSystem.h"
+
+#include "IO/FileManager.h"
+
+namespace TrenchBroom {
+    namespace IO {
+        StringList DiskGameFileSystem::findPaks(const String& directoryPath) {
+            FileManager fileManager;
+            StringList pakPaths = fileManager.directoryContents(directoryPath, "pak", false, true);
+            for (size_t i = 0; i < pakPaths.size(); i++)
+                pakPaths[i] = fileManager.appendPath(directoryPath, pakPaths[i]);
+            return pakPaths;
+        }
+        
+        MappedFile::Ptr DiskGameFileSystem::mapPak(const String& path) {
+            FileManager fileManager;
+            return fileManager.mapFile(path);
+        }
+        
+        MappedFile::Ptr DiskGameFileSystem::mapLooseFile(const String& directoryPath, const String& path) {
+            FileManager fileManager;
+            const String filePath = fileManager.appendPath(directoryPath, path);
+            if (!fileManager.exists(filePath) || fileManager.isDirectory(filePath))
+                return MappedFile::Ptr();
+            return fileManager.mapFile(filePath);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "GameFileSystem.h"
+
+#include "IO/Pak.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace IO {
+        GameFileSystem* GameFileSystem::sharedFileSystem = NULL;
+
+        String GameFileSystem::indexKey(const String& path) {
+            String key = Utility::toLower(path);
+            std::replace(key.begin(), key.end(), '\\', '/');
+            return key;
+        }
+
+        const GameFileSystem::PakIndex& GameFileSystem::pakIndex(const String& directoryPath) {
+            const String key = Utility::toLower(directoryPath);
+            PakIndexMap::iterator it = m_pakIndices.find(key);
+            if (it != m_pakIndices.end())
+                return it->second;
+            
+            std::vector<Pak> paks;
+            const StringList pakPaths = findPaks(directoryPath);
+            for (size_t i = 0; i < pakPaths.size(); i++) {
+                MappedFile::Ptr file = mapPak(pakPaths[i]);
+                if (file.get() != NULL)
+                    paks.push_back(Pak(pakPaths[i], file));
+            }
+            
+            // entries of paks with higher names override entries of paks with lower names
+            std::sort(paks.begin(), paks.end(), ComparePaksByPath());
+            PakIndex& index = m_pakIndices[key];
+            for (size_t i = 0; i < paks.size(); i++) {
+                const Pak::PakDirectory& directory = paks[i].directory();
+                Pak::PakDirectory::const_iterator entryIt, entryEnd;
+                for (entryIt = directory.begin(), entryEnd = directory.end(); entryIt != entryEnd; ++entryIt)
+                    index[indexKey(entryIt->first)] = entryIt->second.data();
+            }
+            return index;
+        }
+
+        MappedFile::Ptr GameFileSystem::findFile(const String& path, const StringList& searchPaths) {
+            const String key = indexKey(path);
+            
+            // files in later search paths override files in earlier search paths
+            StringList::const_reverse_iterator it, end;
+            for (it = searchPaths.rbegin(), end = searchPaths.rend(); it != end; ++it) {
+                MappedFile::Ptr file = mapLooseFile(*it, path);
+                if (file.get() != NULL)
+                    return file;
+                
+                const PakIndex& index = pakIndex(*it);
+                PakIndex::const_iterator entryIt = index.find(key);
+                if (entryIt != index.end())
+                    return entryIt->second;
+            }
+            return MappedFile::Ptr();
+        }
+
+        void GameFileSystem::refresh() {
+            m_pakIndices.clear();
+        }
+    }
+}
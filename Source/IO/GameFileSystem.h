@@ -0,0 +1,88 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__GameFileSystem__
+#define __TrenchBroom__GameFileSystem__
+
+#include "IO/AbstractFileManager.h"
+#include "Utility/String.h"
+
+#include <map>
+
+#if defined _WIN32
+#include <unordered_map>
+#else
+#include <tr1/unordered_map>
+#endif
+
+namespace TrenchBroom {
+    namespace IO {
+        /**
+         * Resolves game relative file paths such as "progs/player.mdl" against a list of search paths. Later search
+         * paths override earlier ones, loose files override pak entries in the same search path, and paks with a
+         * higher name override those with a lower one.
+         *
+         * The entries of all paks in a search path are indexed into a single hash table when the search path is first
+         * used. The pak indices are kept until they are refreshed, which must happen when paks may have been added,
+         * removed or replaced. Loose files are looked up when they are requested, so they are always up to date and no
+         * directory trees have to be walked.
+         *
+         * Subclasses provide access to the actual files.
+         */
+        class GameFileSystem {
+        private:
+            typedef std::tr1::unordered_map<String, MappedFile::Ptr> PakIndex;
+            typedef std::map<String, PakIndex> PakIndexMap;
+
+            PakIndexMap m_pakIndices;
+
+            static String indexKey(const String& path);
+            const PakIndex& pakIndex(const String& directoryPath);
+        protected:
+            /**
+             * Returns the paths of the pak files in the given directory.
+             */
+            virtual StringList findPaks(const String& directoryPath) = 0;
+
+            /**
+             * Maps the pak file at the given path, or returns a null pointer if it cannot be mapped.
+             */
+            virtual MappedFile::Ptr mapPak(const String& path) = 0;
+
+            /**
+             * Maps the loose file with the given game relative path in the given directory, or returns a null pointer
+             * if there is no such file.
+             */
+            virtual MappedFile::Ptr mapLooseFile(const String& directoryPath, const String& path) = 0;
+        public:
+            static GameFileSystem* sharedFileSystem;
+
+            virtual ~GameFileSystem() {}
+
+            MappedFile::Ptr findFile(const String& path, const StringList& searchPaths);
+
+            /**
+             * Discards the pak indices, so that they are rebuilt from the current paks when they are used again.
+             */
+            void refresh();
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__GameFileSystem__) */
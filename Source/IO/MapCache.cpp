@@ -0,0 +1,483 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MapCache.h"
+
+#include "IO/IOException.h"
+#include "Model/Brush.h"
+#include "Model/BrushGeometry.h"
+#include "Model/Entity.h"
+#include "Model/Face.h"
+#include "Model/Map.h"
+#include "Model/MapExceptions.h"
+#include "Model/Texture.h"
+#include "Utility/List.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace IO {
+        // the minimum number of bytes occupied by a cached face, brush and entity
+        static const size_t FaceSize = 9 * sizeof(float) + sizeof(uint32_t) + 5 * sizeof(float) + sizeof(uint32_t);
+        static const size_t BrushSize = 3 * sizeof(uint32_t) + sizeof(uint8_t) + 3 * sizeof(uint32_t);
+        static const size_t EntitySize = 4 * sizeof(uint32_t);
+
+        class CacheReader {
+        private:
+            const char* m_cursor;
+            const char* m_end;
+        public:
+            CacheReader(const char* begin, const char* end) :
+            m_cursor(begin),
+            m_end(end) {}
+
+            inline bool eof() const {
+                return m_cursor == m_end;
+            }
+
+            template <typename T>
+            inline T read() {
+                if (static_cast<size_t>(m_end - m_cursor) < sizeof(T))
+                    throw IOException::unexpectedEof();
+                T value;
+                memcpy(&value, m_cursor, sizeof(T));
+                m_cursor += sizeof(T);
+                return value;
+            }
+
+            inline size_t readSize() {
+                return static_cast<size_t>(read<uint32_t>());
+            }
+
+            /**
+             * Reads the number of elements that follow, each of which occupies at least the given number of bytes.
+             */
+            inline size_t readCount(const size_t minElementSize) {
+                const size_t count = readSize();
+                if (count > static_cast<size_t>(m_end - m_cursor) / minElementSize)
+                    throw IOException("Invalid element count %lu in map cache", static_cast<unsigned long>(count));
+                return count;
+            }
+
+            inline size_t readIndex(const size_t count) {
+                const size_t index = readSize();
+                if (index >= count)
+                    throw IOException("Invalid index %lu in map cache", static_cast<unsigned long>(index));
+                return index;
+            }
+
+            inline Vec3f readVec3f() {
+                Vec3f value;
+                for (size_t i = 0; i < 3; i++)
+                    value[i] = read<float>();
+                return value;
+            }
+
+            inline String readString() {
+                const size_t length = readSize();
+                if (static_cast<size_t>(m_end - m_cursor) < length)
+                    throw IOException::unexpectedEof();
+                const String result(m_cursor, length);
+                m_cursor += length;
+                return result;
+            }
+        };
+
+        float MapCache::savedValue(const float value) {
+            // the map writer writes face attributes with six significant digits and the parser reads them with atof
+            char buffer[64];
+            std::sprintf(buffer, "%.6g", value);
+            return static_cast<float>(std::atof(buffer));
+        }
+
+        void MapCache::writeString(const String& str, ByteBuffer& buffer) const {
+            buffer << static_cast<uint32_t>(str.size());
+            for (size_t i = 0; i < str.size(); i++)
+                buffer << str[i];
+        }
+
+        void MapCache::writeVec3f(const Vec3f& vec, ByteBuffer& buffer) const {
+            for (size_t i = 0; i < 3; i++)
+                buffer << vec[i];
+        }
+
+        bool MapCache::writeFace(const Model::Face& face, const bool asSaved, ByteBuffer& buffer) const {
+            for (size_t i = 0; i < 3; i++) {
+                // the parser corrects the points it reads, so a point that changes when corrected would not survive
+                if (asSaved && face.point(i).corrected() != face.point(i))
+                    return false;
+                writeVec3f(face.point(i), buffer);
+            }
+
+            writeString(face.textureName(), buffer);
+            if (asSaved) {
+                buffer << savedValue(face.xOffset());
+                buffer << savedValue(face.yOffset());
+                buffer << savedValue(face.rotation());
+                buffer << savedValue(face.xScale());
+                buffer << savedValue(face.yScale());
+            } else {
+                buffer << face.xOffset();
+                buffer << face.yOffset();
+                buffer << face.rotation();
+                buffer << face.xScale();
+                buffer << face.yScale();
+            }
+            buffer << static_cast<uint32_t>(face.filePosition());
+            return true;
+        }
+
+        bool MapCache::writeBrush(const Model::Brush& brush, const bool asSaved, ByteBuffer& buffer) const {
+            const Model::FaceList& faces = brush.faces();
+            const Model::BrushGeometry& geometry = brush.geometry();
+
+            buffer << static_cast<uint32_t>(brush.fileLine());
+            buffer << static_cast<uint32_t>(brush.fileLineCount());
+            buffer << static_cast<uint8_t>(brush.forceIntegerFacePoints() ? 1 : 0);
+
+            buffer << static_cast<uint32_t>(faces.size());
+            for (size_t i = 0; i < faces.size(); i++)
+                if (!writeFace(*faces[i], asSaved, buffer))
+                    return false;
+
+            buffer << static_cast<uint32_t>(geometry.vertices.size());
+            for (size_t i = 0; i < geometry.vertices.size(); i++)
+                writeVec3f(geometry.vertices[i]->position, buffer);
+
+            buffer << static_cast<uint32_t>(geometry.edges.size());
+            for (size_t i = 0; i < geometry.edges.size(); i++) {
+                const Model::Edge& edge = *geometry.edges[i];
+                buffer << static_cast<uint32_t>(Model::findElement(geometry.vertices, edge.start));
+                buffer << static_cast<uint32_t>(Model::findElement(geometry.vertices, edge.end));
+                buffer << static_cast<uint32_t>(Model::findElement(geometry.sides, edge.left));
+                buffer << static_cast<uint32_t>(Model::findElement(geometry.sides, edge.right));
+            }
+
+            buffer << static_cast<uint32_t>(geometry.sides.size());
+            for (size_t i = 0; i < geometry.sides.size(); i++) {
+                const Model::Side& side = *geometry.sides[i];
+                if (side.face != NULL)
+                    buffer << static_cast<uint32_t>(Model::findElement(faces, side.face));
+                else
+                    buffer << static_cast<uint32_t>(NoIndex);
+                buffer << static_cast<uint32_t>(side.edges.size());
+                for (size_t j = 0; j < side.edges.size(); j++)
+                    buffer << static_cast<uint32_t>(Model::findElement(geometry.edges, side.edges[j]));
+            }
+
+            return true;
+        }
+
+        bool MapCache::writeEntity(const Model::Entity& entity, const bool asSaved, ByteBuffer& buffer) const {
+            buffer << static_cast<uint32_t>(entity.fileLine());
+            buffer << static_cast<uint32_t>(entity.fileLineCount());
+
+            const Model::PropertyList& properties = entity.properties();
+            buffer << static_cast<uint32_t>(properties.size());
+            Model::PropertyList::const_iterator it, end;
+            for (it = properties.begin(), end = properties.end(); it != end; ++it) {
+                writeString(it->key(), buffer);
+                writeString(it->value(), buffer);
+            }
+
+            const Model::BrushList& brushes = entity.brushes();
+            buffer << static_cast<uint32_t>(brushes.size());
+            for (size_t i = 0; i < brushes.size(); i++)
+                if (!writeBrush(*brushes[i], asSaved, buffer))
+                    return false;
+            return true;
+        }
+
+        Model::Face* MapCache::readFace(const Model::Map& map, const bool forceIntegerFacePoints, CacheReader& reader) const {
+            Vec3f points[3];
+            for (size_t i = 0; i < 3; i++)
+                points[i] = reader.readVec3f();
+            const String textureName = reader.readString();
+            const float xOffset = reader.read<float>();
+            const float yOffset = reader.read<float>();
+            const float rotation = reader.read<float>();
+            const float xScale = reader.read<float>();
+            const float yScale = reader.read<float>();
+            const size_t filePosition = reader.readSize();
+
+            if (crossed(points[2] - points[0], points[1] - points[0]).null())
+                throw IOException("Invalid face points in map cache");
+
+            Model::Face* face = new Model::Face(map.worldBounds(), forceIntegerFacePoints, points[0], points[1], points[2], textureName);
+            face->setXOffset(xOffset);
+            face->setYOffset(yOffset);
+            face->setRotation(rotation);
+            face->setXScale(xScale);
+            face->setYScale(yScale);
+            face->setFilePosition(filePosition);
+
+            // the cached geometry is only valid for a face that ends up with exactly the cached points
+            for (size_t i = 0; i < 3; i++) {
+                if (face->point(i) != points[i]) {
+                    delete face;
+                    throw IOException("Face points in map cache have changed");
+                }
+            }
+
+            return face;
+        }
+
+        Model::BrushGeometry* MapCache::readGeometry(const Model::FaceList& faces, CacheReader& reader) const {
+            Model::VertexList vertices;
+            Model::EdgeList edges;
+            Model::SideList sides;
+
+            try {
+                const size_t vertexCount = reader.readCount(3 * sizeof(float));
+                for (size_t i = 0; i < vertexCount; i++) {
+                    const Vec3f position = reader.readVec3f();
+                    vertices.push_back(new Model::Vertex(position.x(), position.y(), position.z()));
+                }
+
+                // the edges refer to the sides, so they must be created first
+                const size_t edgeCount = reader.readCount(4 * sizeof(uint32_t));
+                std::vector<size_t> edgeIndices(4 * edgeCount);
+                for (size_t i = 0; i < edgeCount; i++) {
+                    edgeIndices[4 * i + 0] = reader.readIndex(vertexCount);
+                    edgeIndices[4 * i + 1] = reader.readIndex(vertexCount);
+                    edgeIndices[4 * i + 2] = reader.readSize();
+                    edgeIndices[4 * i + 3] = reader.readSize();
+                }
+
+                const size_t sideCount = reader.readCount(2 * sizeof(uint32_t));
+                for (size_t i = 0; i < sideCount; i++)
+                    sides.push_back(new Model::Side());
+
+                for (size_t i = 0; i < edgeCount; i++) {
+                    if (edgeIndices[4 * i + 2] >= sideCount || edgeIndices[4 * i + 3] >= sideCount)
+                        throw IOException("Invalid edge in map cache");
+                    edges.push_back(new Model::Edge(vertices[edgeIndices[4 * i + 0]],
+                                                    vertices[edgeIndices[4 * i + 1]],
+                                                    sides[edgeIndices[4 * i + 2]],
+                                                    sides[edgeIndices[4 * i + 3]]));
+                }
+
+                for (size_t i = 0; i < sideCount; i++) {
+                    Model::Side* side = sides[i];
+                    const size_t faceIndex = reader.readSize();
+                    if (faceIndex != NoIndex) {
+                        if (faceIndex >= faces.size())
+                            throw IOException("Invalid side in map cache");
+                        side->face = faces[faceIndex];
+                    }
+
+                    const size_t sideEdgeCount = reader.readCount(sizeof(uint32_t));
+                    side->edges.reserve(sideEdgeCount);
+                    side->vertices.reserve(sideEdgeCount);
+                    for (size_t j = 0; j < sideEdgeCount; j++) {
+                        Model::Edge* edge = edges[reader.readIndex(edgeCount)];
+                        Model::Vertex* vertex = edge->startVertex(side);
+                        if (vertex == NULL)
+                            throw IOException("Invalid side in map cache");
+                        side->edges.push_back(edge);
+                        side->vertices.push_back(vertex);
+                    }
+                }
+            } catch (IOException&) {
+                Utility::deleteAll(sides);
+                Utility::deleteAll(edges);
+                Utility::deleteAll(vertices);
+                throw;
+            }
+
+            for (size_t i = 0; i < sides.size(); i++)
+                if (sides[i]->face != NULL)
+                    sides[i]->face->setSide(sides[i]);
+            return new Model::BrushGeometry(vertices, edges, sides);
+        }
+
+        Model::Brush* MapCache::readBrush(const Model::Map& map, CacheReader& reader) const {
+            const size_t firstLine = reader.readSize();
+            const size_t lineCount = reader.readSize();
+            const bool forceIntegerFacePoints = reader.read<uint8_t>() != 0;
+
+            Model::FaceList faces;
+            Model::BrushGeometry* geometry = NULL;
+            try {
+                const size_t faceCount = reader.readCount(FaceSize);
+                faces.reserve(faceCount);
+                for (size_t i = 0; i < faceCount; i++)
+                    faces.push_back(readFace(map, forceIntegerFacePoints, reader));
+                geometry = readGeometry(faces, reader);
+            } catch (IOException&) {
+                Utility::deleteAll(faces);
+                throw;
+            } catch (Model::GeometryException&) {
+                Utility::deleteAll(faces);
+                throw;
+            }
+
+            Model::Brush* brush = new Model::Brush(map.worldBounds(), forceIntegerFacePoints, faces, geometry);
+            brush->setFilePosition(firstLine, lineCount);
+            return brush;
+        }
+
+        Model::Entity* MapCache::readEntity(const Model::Map& map, CacheReader& reader) const {
+            Model::Entity* entity = new Model::Entity(map.worldBounds());
+            try {
+                const size_t firstLine = reader.readSize();
+                const size_t lineCount = reader.readSize();
+                entity->setFilePosition(firstLine, lineCount);
+
+                const size_t propertyCount = reader.readCount(2 * sizeof(uint32_t));
+                for (size_t i = 0; i < propertyCount; i++) {
+                    const String key = reader.readString();
+                    const String value = reader.readString();
+                    entity->setProperty(key, value);
+                }
+
+                const size_t brushCount = reader.readCount(BrushSize);
+                for (size_t i = 0; i < brushCount; i++)
+                    entity->addBrush(*readBrush(map, reader));
+            } catch (IOException&) {
+                delete entity;
+                throw;
+            } catch (Model::GeometryException&) {
+                delete entity;
+                throw;
+            }
+            return entity;
+        }
+
+        MapCache::MapCache(const String& mapPath) :
+        m_path(mapPath + ".tbcache") {}
+
+        MapCache::Hash MapCache::hash(const char* begin, const char* end) {
+            // 64 bit FNV-1a
+            Hash result = 14695981039346656037ULL;
+            for (const char* cur = begin; cur < end; ++cur) {
+                result ^= static_cast<unsigned char>(*cur);
+                result *= 1099511628211ULL;
+            }
+            return result;
+        }
+
+        bool MapCache::write(const Model::Map& map, const char* mapBegin, const char* mapEnd, const bool asSaved, ByteBuffer& buffer) const {
+            ByteBuffer payload;
+            for (size_t i = 0; i < 3; i++)
+                payload << map.worldBounds().min[i];
+            for (size_t i = 0; i < 3; i++)
+                payload << map.worldBounds().max[i];
+
+            const Model::EntityList& entities = map.entities();
+            payload << static_cast<uint32_t>(entities.size());
+            for (size_t i = 0; i < entities.size(); i++)
+                if (!writeEntity(*entities[i], asSaved, payload))
+                    return false;
+
+            const size_t headerStart = buffer.size();
+            buffer << 'T'; buffer << 'B'; buffer << 'M'; buffer << 'C';
+            buffer << static_cast<uint32_t>(Version);
+            buffer << static_cast<uint64_t>(mapEnd - mapBegin);
+            buffer << hash(mapBegin, mapEnd);
+            buffer << static_cast<uint64_t>(payload.size());
+            buffer << hash(payload.get(), payload.get() + payload.size());
+            assert(buffer.size() - headerStart == HeaderSize);
+            buffer.append(payload.get(), payload.get() + payload.size());
+            return true;
+        }
+
+        bool MapCache::write(const Model::Map& map, const char* mapBegin, const char* mapEnd, const bool asSaved) const {
+            ByteBuffer buffer;
+            if (!write(map, mapBegin, mapEnd, asSaved, buffer))
+                return false;
+
+            FILE* stream = fopen(m_path.c_str(), "wb");
+            if (stream == NULL)
+                return false;
+            const bool success = fwrite(buffer.get(), 1, buffer.size(), stream) == buffer.size();
+            fclose(stream);
+            return success;
+        }
+
+        bool MapCache::read(Model::Map& map, const char* mapBegin, const char* mapEnd, const char* cacheBegin, const char* cacheEnd) const {
+            if (static_cast<size_t>(cacheEnd - cacheBegin) < HeaderSize)
+                return false;
+
+            Model::EntityList entities;
+            try {
+                CacheReader header(cacheBegin, cacheBegin + HeaderSize);
+                if (header.read<char>() != 'T' || header.read<char>() != 'B' || header.read<char>() != 'M' || header.read<char>() != 'C' ||
+                    header.read<uint32_t>() != Version ||
+                    header.read<uint64_t>() != static_cast<uint64_t>(mapEnd - mapBegin) ||
+                    header.read<uint64_t>() != hash(mapBegin, mapEnd))
+                    return false;
+
+                const uint64_t payloadSize = header.read<uint64_t>();
+                const Hash payloadHash = header.read<uint64_t>();
+                const char* payloadBegin = cacheBegin + HeaderSize;
+                const char* payloadEnd = cacheEnd;
+                if (payloadSize != static_cast<uint64_t>(payloadEnd - payloadBegin) || payloadHash != hash(payloadBegin, payloadEnd))
+                    return false;
+
+                CacheReader reader(payloadBegin, payloadEnd);
+                for (size_t i = 0; i < 3; i++)
+                    if (reader.read<float>() != map.worldBounds().min[i])
+                        return false;
+                for (size_t i = 0; i < 3; i++)
+                    if (reader.read<float>() != map.worldBounds().max[i])
+                        return false;
+
+                const size_t entityCount = reader.readCount(EntitySize);
+                entities.reserve(entityCount);
+                for (size_t i = 0; i < entityCount; i++)
+                    entities.push_back(readEntity(map, reader));
+                if (!reader.eof())
+                    throw IOException("Unexpected data at end of map cache");
+            } catch (IOException&) {
+                Utility::deleteAll(entities);
+                return false;
+            } catch (Model::GeometryException&) {
+                Utility::deleteAll(entities);
+                return false;
+            }
+
+            for (size_t i = 0; i < entities.size(); i++)
+                map.addEntity(*entities[i]);
+            return true;
+        }
+
+        bool MapCache::read(Model::Map& map, const char* mapBegin, const char* mapEnd) const {
+            FILE* stream = fopen(m_path.c_str(), "rb");
+            if (stream == NULL)
+                return false;
+
+            std::vector<char> contents;
+            char buffer[0x10000];
+            size_t count;
+            while ((count = fread(buffer, 1, sizeof(buffer), stream)) > 0)
+                contents.insert(contents.end(), buffer, buffer + count);
+            const bool success = ferror(stream) == 0;
+            fclose(stream);
+
+            if (!success || contents.empty())
+                return false;
+            return read(map, mapBegin, mapEnd, &contents.front(), &contents.front() + contents.size());
+        }
+    }
+}
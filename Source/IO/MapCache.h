@@ -0,0 +1,116 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__MapCache__
+#define __TrenchBroom__MapCache__
+
+#include "IO/ByteBuffer.h"
+#include "Model/BrushGeometryTypes.h"
+#include "Model/EntityTypes.h"
+#include "Utility/String.h"
+
+#if defined _MSC_VER
+#include <cstdint>
+#elif defined __GNUC__
+#include <stdint.h>
+#endif
+
+namespace TrenchBroom {
+    namespace Model {
+        class Brush;
+        class BrushGeometry;
+        class Entity;
+        class Face;
+        class Map;
+    }
+
+    namespace IO {
+        class CacheReader;
+
+        /**
+         * Stores the contents of a map in a binary file next to the map file, so that an unchanged map can be restored
+         * without parsing it and without building the brush geometry. The cache holds the entity properties, the face
+         * attributes and the geometry of every brush in a flat layout, preceded by a header with a format version,
+         * the size and hash of the map file it was created from, and a checksum of the cached data. Reading a cache
+         * fails if any of these do not match or if the data is inconsistent, and the caller must then parse the map
+         * file instead.
+         */
+        class MapCache {
+        public:
+            typedef uint64_t Hash;
+        private:
+            static const uint32_t Version = 1;
+            static const uint32_t NoIndex = 0xFFFFFFFF;
+            static const size_t HeaderSize = 40;
+
+            String m_path;
+
+            static float savedValue(float value);
+
+            void writeString(const String& str, ByteBuffer& buffer) const;
+            void writeVec3f(const Vec3f& vec, ByteBuffer& buffer) const;
+            bool writeFace(const Model::Face& face, bool asSaved, ByteBuffer& buffer) const;
+            bool writeBrush(const Model::Brush& brush, bool asSaved, ByteBuffer& buffer) const;
+            bool writeEntity(const Model::Entity& entity, bool asSaved, ByteBuffer& buffer) const;
+
+            Model::Face* readFace(const Model::Map& map, bool forceIntegerFacePoints, CacheReader& reader) const;
+            Model::BrushGeometry* readGeometry(const Model::FaceList& faces, CacheReader& reader) const;
+            Model::Brush* readBrush(const Model::Map& map, CacheReader& reader) const;
+            Model::Entity* readEntity(const Model::Map& map, CacheReader& reader) const;
+        public:
+            /**
+             * Creates a cache for the map file at the given path.
+             */
+            MapCache(const String& mapPath);
+
+            inline const String& path() const {
+                return m_path;
+            }
+
+            static Hash hash(const char* begin, const char* end);
+
+            /**
+             * Writes the given map to the cache, keyed by the contents of the map file it corresponds to. If asSaved is
+             * true, the map has just been written to that file, and the face attributes are stored like they will be
+             * read from it again. Returns false if the map cannot be cached because a face would change when it is
+             * parsed again, or if the cache file cannot be written.
+             */
+            bool write(const Model::Map& map, const char* mapBegin, const char* mapEnd, bool asSaved) const;
+
+            /**
+             * Appends the cache contents for the given map to the given buffer instead of writing them to the cache
+             * file.
+             */
+            bool write(const Model::Map& map, const char* mapBegin, const char* mapEnd, bool asSaved, ByteBuffer& buffer) const;
+
+            /**
+             * Adds the entities stored in the cache to the given map if the cache was created from a map file with the
+             * given contents. Returns false and leaves the map unchanged if the cache is missing, outdated or invalid.
+             */
+            bool read(Model::Map& map, const char* mapBegin, const char* mapEnd) const;
+
+            /**
+             * Like the above, but reads the cache contents from the given range instead of the cache file.
+             */
+            bool read(Model::Map& map, const char* mapBegin, const char* mapEnd, const char* cacheBegin, const char* cacheEnd) const;
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__MapCache__) */
@@ -204,8 +204,9 @@ namespace TrenchBroom {
         m_format(Undefined),
         m_size(str.size()) {}
 
-        void MapParser::parseMap(Model::Map& map, Utility::ProgressIndicator* indicator) {
+        bool MapParser::parseMap(Model::Map& map, Utility::ProgressIndicator* indicator) {
             Model::Entity* entity = NULL;
+            bool success = true;
             
             if (indicator != NULL) indicator->reset(static_cast<int>(m_size));
             try {
@@ -214,10 +215,12 @@ namespace TrenchBroom {
                     map.addEntity(*entity);
             } catch (MapParserException& e) {
                 m_console.error(e.what());
+                success = false;
             }
             
             if (indicator != NULL)
                 indicator->update(static_cast<int>(m_size));
+            return success;
         }
         
         Model::Entity* MapParser::parseEntity(const BBoxf& worldBounds, bool forceIntegerFacePoints, Utility::ProgressIndicator* indicator) {
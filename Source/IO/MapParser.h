@@ -157,7 +157,11 @@ namespace TrenchBroom {
             MapParser(const char* begin, const char* end, Utility::Console& console);
             MapParser(const String& str, Utility::Console& console);
             
-            void parseMap(Model::Map& map, Utility::ProgressIndicator* indicator);
+            /**
+             * Adds the entities of the map file to the given map. Returns false if a syntax error stopped the parser,
+             * in which case the map only contains the entities preceding the error.
+             */
+            bool parseMap(Model::Map& map, Utility::ProgressIndicator* indicator);
             Model::Entity* parseEntity(const BBoxf& worldBounds, bool forceIntegerFacePoints, Utility::ProgressIndicator* indicator);
             Model::Brush* parseBrush(const BBoxf& worldBounds, bool forceIntegerFacePoints, Utility::ProgressIndicator* indicator);
             Model::Face* parseFace(const BBoxf& worldBounds, bool forceIntegerFacePoints);
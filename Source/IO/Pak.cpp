@@ -19,11 +19,7 @@
 
 #include "Pak.h"
 
-#include "IO/FileManager.h"
 #include "IO/IOUtils.h"
-#include "Utility/List.h"
-
-#include <algorithm>
 
 namespace TrenchBroom {
     namespace IO {
@@ -51,7 +47,7 @@ namespace TrenchBroom {
 
                 char* entryBegin = m_file->begin() + entryAddress;
                 char* entryEnd = entryBegin + entryLength;
-                m_directory[Utility::toLower(entryName)] = PakEntry(entryName, entryBegin, entryEnd);
+                m_directory[Utility::toLower(entryName)] = PakEntry(entryName, m_file, entryBegin, entryEnd);
             }
         }
         
@@ -63,52 +59,5 @@ namespace TrenchBroom {
             const PakEntry& entry = it->second;
             return entry.data();
         }
-
-        PakManager* PakManager::sharedManager = NULL;
-        
-        bool PakManager::findPaks(const String& path, PakList& result) {
-            String lowerPath = Utility::toLower(path);
-            PakMap::iterator it = m_paks.find(lowerPath);
-            
-            if (it != m_paks.end()) {
-                result = it->second;
-                return true;
-            }
-            
-            FileManager fileManager;
-            const StringList pakNames = fileManager.directoryContents(path, "pak");
-            if (!pakNames.empty()) {
-                PakList newPaks;
-                for (unsigned int i = 0; i < pakNames.size(); i++) {
-                    String pakPath = fileManager.appendPath(path, pakNames[i]);
-                    if (!fileManager.isDirectory(pakPath)) {
-                        MappedFile::Ptr file = fileManager.mapFile(pakPath);
-                        assert(file.get() != NULL);
-                        newPaks.push_back(Pak(pakPath, file));
-                    }
-                }
-
-                std::sort(newPaks.begin(), newPaks.end(), ComparePaksByPath());
-                m_paks[lowerPath] = newPaks;
-                result = newPaks;
-                return true;
-            }
-            
-            return false;
-        }
-
-        MappedFile::Ptr PakManager::entry(const String& name, const String& searchPath) {
-            PakList paks;
-            if (findPaks(searchPath, paks)) {
-                PakList::reverse_iterator pak, endPak;
-                for (pak = paks.rbegin(), endPak = paks.rend(); pak != endPak; ++pak) {
-                    MappedFile::Ptr data = pak->entry(name);
-                    if (data.get() != NULL)
-                        return data;
-                }
-            }
-            
-            return MappedFile::Ptr();
-        }
     }
 }
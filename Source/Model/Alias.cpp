@@ -45,15 +45,12 @@ namespace TrenchBroom {
             assert(m_pictures.size() == m_times.size());
         }
 
-        AliasSkin::~AliasSkin() {
-            Utility::deleteAll(m_pictures);
-        }
-
-        AliasSingleFrame::AliasSingleFrame(const String& name, const AliasFrameTriangleList& triangles, const Vec3f& center, const BBoxf& bounds) :
+        AliasSingleFrame::AliasSingleFrame(const String& name, AliasFrameVertexList& vertices, const Vec3f& center, const BBoxf& bounds) :
         m_name(name),
-        m_triangles(triangles),
         m_center(center),
-        m_bounds(bounds) {}
+        m_bounds(bounds) {
+            m_vertices.swap(vertices);
+        }
 
         AliasSingleFrame* AliasSingleFrame::firstFrame() {
             return this;
@@ -81,96 +78,119 @@ namespace TrenchBroom {
             return m_frames[0];
         }
 
-        Vec3f Alias::unpackFrameVertex(const AliasPackedFrameVertex& packedVertex, const Vec3f& origin, const Vec3f& size) {
+        Vec3f Alias::unpackFrameVertex(const AliasPackedFrameVertex& packedVertex) const {
             Vec3f vertex;
             for (size_t i = 0; i < 3; i++)
-                vertex[i] = size[i] * packedVertex[i] + origin[i];
+                vertex[i] = m_scale[i] * packedVertex[i] + m_origin[i];
             return vertex;
         }
 
-        AliasSingleFrame* Alias::readFrame(char*& cursor, const Vec3f& origin, const Vec3f& scale, unsigned int skinWidth, unsigned int skinHeight, const AliasSkinVertexList& vertices, const AliasSkinTriangleList& triangles) {
+        AliasSingleFrame* Alias::readFrame(char*& cursor) const {
             using namespace IO;
             
             char name[AliasLayout::SimpleFrameLength];
             cursor += AliasLayout::SimpleFrameName;
             readBytes(cursor, name, AliasLayout::SimpleFrameLength);
 
-            std::vector<AliasPackedFrameVertex> packedFrameVertices(vertices.size());
-            readBytes(cursor, reinterpret_cast<char*>(&packedFrameVertices[0]), vertices.size() * 4);
+            const size_t vertexCount = m_skinVertices.size();
+            const AliasPackedFrameVertex* packedFrameVertices = reinterpret_cast<const AliasPackedFrameVertex*>(cursor);
+            cursor += vertexCount * AliasLayout::FrameVertexSize;
 
-            Vec3f::List frameVertices(vertices.size());
+            Vec3f::List frameVertices(vertexCount);
             Vec3f center;
             BBoxf bounds;
 
-            frameVertices[0] = unpackFrameVertex(packedFrameVertices[0], origin, scale);
+            frameVertices[0] = unpackFrameVertex(packedFrameVertices[0]);
             center = frameVertices[0];
             bounds.min = frameVertices[0];
             bounds.max = frameVertices[0];
 
-            for (unsigned int i = 1; i < vertices.size(); i++) {
-                frameVertices[i] = unpackFrameVertex(packedFrameVertices[i], origin, scale);
+            for (size_t i = 1; i < vertexCount; i++) {
+                frameVertices[i] = unpackFrameVertex(packedFrameVertices[i]);
                 center += frameVertices[i];
                 bounds.mergeWith(frameVertices[i]);
             }
 
-            center /= static_cast<float>(vertices.size());
+            center /= static_cast<float>(vertexCount);
 
-            AliasFrameTriangleList frameTriangles;
-            frameTriangles.reserve(triangles.size());
-            for (unsigned int i = 0; i < triangles.size(); i++) {
-                AliasFrameTriangle* frameTriangle = new AliasFrameTriangle();
-                for (unsigned int j = 0; j < 3; j++) {
-                    size_t index = triangles[i].vertices[j];
+            AliasFrameVertexList vertices(3 * m_skinTriangles.size());
+            size_t vertexIndex = 0;
+            for (size_t i = 0; i < m_skinTriangles.size(); i++) {
+                const AliasSkinTriangle& triangle = m_skinTriangles[i];
+                for (size_t j = 0; j < 3; j++) {
+                    const size_t index = triangle.vertices[j];
+                    const AliasSkinVertex& skinVertex = m_skinVertices[index];
 
                     Vec2f texCoords;
-                    texCoords[0] = static_cast<float>(vertices[index].s) / static_cast<float>(skinWidth);
-                    texCoords[1] = static_cast<float>(vertices[index].t) / static_cast<float>(skinHeight);
+                    texCoords[0] = static_cast<float>(skinVertex.s) / static_cast<float>(m_skinWidth);
+                    texCoords[1] = static_cast<float>(skinVertex.t) / static_cast<float>(m_skinHeight);
 
-                    if (vertices[index].onseam && !triangles[i].front)
+                    if (skinVertex.onseam && !triangle.front)
                         texCoords[0] += 0.5f;
 
-                    (*frameTriangle)[j].setPosition(frameVertices[index]);
-                    (*frameTriangle)[j].setNormal(AliasNormals[packedFrameVertices[index][3]]);
-                    (*frameTriangle)[j].setTexCoords(texCoords);
+                    AliasFrameVertex& vertex = vertices[vertexIndex++];
+                    vertex.setPosition(frameVertices[index]);
+                    vertex.setNormal(AliasNormals[packedFrameVertices[index][3]]);
+                    vertex.setTexCoords(texCoords);
                 }
-
-                frameTriangles.push_back(frameTriangle);
             }
 
-            return new AliasSingleFrame(name, frameTriangles, center, bounds);
+            return new AliasSingleFrame(name, vertices, center, bounds);
         }
 
-        AliasSingleFrame::~AliasSingleFrame() {
-            Utility::deleteAll(m_triangles);
+        AliasFrame* Alias::readFrameOrGroup(char* cursor) const {
+            using namespace IO;
+
+            const int type = readInt<int32_t>(cursor);
+            if (type == 0) // single frame
+                return readFrame(cursor);
+
+            // frame group
+            char* base = cursor;
+            const unsigned int groupFrameCount = readUnsignedInt<int32_t>(cursor);
+
+            char* timeCursor = base + AliasLayout::MultiFrameTimes;
+            char* frameCursor = base + AliasLayout::MultiFrameTimes + groupFrameCount * sizeof(float);
+
+            AliasTimeList groupFrameTimes(groupFrameCount);
+            AliasSingleFrameList groupFrames(groupFrameCount);
+            for (unsigned int i = 0; i < groupFrameCount; i++) {
+                groupFrameTimes[i] = readFloat<float>(timeCursor);
+                groupFrames[i] = readFrame(frameCursor);
+            }
+
+            return new AliasFrameGroup(groupFrameTimes, groupFrames);
         }
 
-        Alias::Alias(const String& name, char* begin, char* end) :
-        m_name(name) {
+        Alias::Alias(const String& name, IO::MappedFile::Ptr file) :
+        m_name(name),
+        m_file(file) {
             using namespace IO;
             
+            char* begin = m_file->begin();
             char* cursor = begin + AliasLayout::HeaderScale;
-            Vec3f scale = readVec3f(cursor);
-            Vec3f origin = readVec3f(cursor);
+            m_scale = readVec3f(cursor);
+            m_origin = readVec3f(cursor);
 
             cursor = begin + AliasLayout::HeaderNumSkins;
             unsigned int skinCount = readUnsignedInt<int32_t>(cursor);
-            unsigned int skinWidth = readUnsignedInt<int32_t>(cursor);
-            unsigned int skinHeight = readUnsignedInt<int32_t>(cursor);
-            unsigned int skinSize = skinWidth * skinHeight;
+            m_skinWidth = readUnsignedInt<int32_t>(cursor);
+            m_skinHeight = readUnsignedInt<int32_t>(cursor);
+            const size_t skinSize = m_skinWidth * m_skinHeight;
 
             unsigned int vertexCount = readUnsignedInt<int32_t>(cursor);
             unsigned int triangleCount = readUnsignedInt<int32_t>(cursor);
             unsigned int frameCount = readUnsignedInt<int32_t>(cursor);
-            frameCount = frameCount; // dummy to suppress "unused" warning
             
+            // the skin pictures are not copied, they point into the mapped file
             cursor = begin + AliasLayout::Skins;
             for (unsigned int i = 0; i < skinCount; i++) {
                 unsigned int skinGroup = readUnsignedInt<int32_t>(cursor);
                 if (skinGroup == 0) {
-                    unsigned char* skinPicture = new unsigned char[skinSize];
-                    readBytes(cursor, skinPicture, skinSize);
+                    const unsigned char* skinPicture = reinterpret_cast<const unsigned char*>(cursor);
+                    cursor += skinSize;
 
-                    AliasSkin* skin = new AliasSkin(skinPicture, skinWidth, skinHeight);
+                    AliasSkin* skin = new AliasSkin(skinPicture, m_skinWidth, m_skinHeight);
                     m_skins.push_back(skin);
                 } else {
                     unsigned int numPics = readUnsignedInt<int32_t>(cursor);
@@ -181,58 +201,47 @@ namespace TrenchBroom {
                     for (size_t j = 0; j < static_cast<size_t>(numPics); j++) {
                         cursor = base + j * sizeof(float);
                         times[j] = readFloat<float>(cursor);
-
-                        unsigned char* skinPicture = new unsigned char[skinSize];
-                        cursor = base + numPics * 4 + j * skinSize;
-                        readBytes(cursor, skinPicture, skinSize);
-
-                        skinPictures[j] = skinPicture;
+                        skinPictures[j] = reinterpret_cast<const unsigned char*>(base + numPics * 4 + j * skinSize);
                     }
+                    cursor = base + numPics * 4 + numPics * skinSize;
 
-                    AliasSkin* skin = new AliasSkin(skinPictures, times, numPics, skinWidth, skinHeight);
+                    AliasSkin* skin = new AliasSkin(skinPictures, times, numPics, m_skinWidth, m_skinHeight);
                     m_skins.push_back(skin);
                 }
             }
 
             // now cursor is at the first skin vertex
-            std::vector<AliasSkinVertex> vertices(vertexCount);
+            m_skinVertices.resize(vertexCount);
             for (unsigned int i = 0; i < vertexCount; i++) {
-                vertices[i].onseam = readBool<int32_t>(cursor);
-                vertices[i].s = readInt<int32_t>(cursor);
-                vertices[i].t = readInt<int32_t>(cursor);
+                m_skinVertices[i].onseam = readBool<int32_t>(cursor);
+                m_skinVertices[i].s = readInt<int32_t>(cursor);
+                m_skinVertices[i].t = readInt<int32_t>(cursor);
             }
 
             // now cursor is at the first skin triangle
-            std::vector<AliasSkinTriangle> triangles(triangleCount);
+            m_skinTriangles.resize(triangleCount);
             for (unsigned int i = 0; i < triangleCount; i++) {
-                triangles[i].front = readBool<int32_t>(cursor);
+                m_skinTriangles[i].front = readBool<int32_t>(cursor);
                 for (unsigned int j = 0; j < 3; j++)
-                    triangles[i].vertices[j] = readUnsignedInt<int32_t>(cursor);
+                    m_skinTriangles[i].vertices[j] = readUnsignedInt<int32_t>(cursor);
             }
 
-            // now cursor is at the first frame
+            // now cursor is at the first frame, remember where each frame starts so that it can be decoded later
+            const size_t frameSize = AliasLayout::SimpleFrameName + AliasLayout::SimpleFrameLength + vertexCount * AliasLayout::FrameVertexSize;
+            m_frameCursors.reserve(frameCount);
             for (unsigned int i = 0; i < frameCount; i++) {
+                m_frameCursors.push_back(cursor);
+
                 int type = readInt<int32_t>(cursor);
                 if (type == 0) { // single frame
-                    m_frames.push_back(readFrame(cursor, origin, scale, skinWidth, skinHeight, vertices, triangles));
+                    cursor += frameSize;
                 } else { // frame group
                     char* base = cursor;
                     unsigned int groupFrameCount = readUnsignedInt<int32_t>(cursor);
-
-                    char* timeCursor = base + AliasLayout::MultiFrameTimes;
-                    char* frameCursor = base + AliasLayout::MultiFrameTimes + groupFrameCount * sizeof(float);
-
-                    AliasTimeList groupFrameTimes(groupFrameCount);
-                    AliasSingleFrameList groupFrames(groupFrameCount);
-                    for (unsigned int j = 0; j < groupFrameCount; j++) {
-                        groupFrameTimes[i] = readFloat<float>(timeCursor);
-                        groupFrames[j] = readFrame(frameCursor, origin, scale, skinWidth, skinHeight, vertices, triangles);
-                    }
-
-                    m_frames.push_back(new AliasFrameGroup(groupFrameTimes, groupFrames));
-                    cursor = frameCursor;
+                    cursor = base + AliasLayout::MultiFrameTimes + groupFrameCount * (sizeof(float) + frameSize);
                 }
             }
+            m_frames.resize(frameCount, NULL);
         }
 
         Alias::~Alias() {
@@ -254,7 +263,7 @@ namespace TrenchBroom {
 
             IO::MappedFile::Ptr file = IO::findGameFile(name, paths);
             if (file.get() != NULL) {
-                Alias* alias = new Alias(name, file->begin(), file->end());
+                Alias* alias = new Alias(name, file);
                 m_aliases[key] = alias;
                 return alias;
             }
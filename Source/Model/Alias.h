@@ -116,22 +116,7 @@ namespace TrenchBroom {
             }
         };
         
-        class AliasFrameTriangle {
-        private:
-            AliasFrameVertex m_vertices[3];
-        public:
-            inline AliasFrameVertex& operator[] (const size_t index) {
-                assert(index < 3);
-                return m_vertices[index];
-            }
-            
-            inline const AliasFrameVertex& operator[] (const size_t index) const {
-                assert(index < 3);
-                return m_vertices[index];
-            }
-        };
-        
-        typedef std::vector<AliasFrameTriangle*> AliasFrameTriangleList;
+        typedef std::vector<AliasFrameVertex> AliasFrameVertexList;
         typedef std::vector<float> AliasTimeList;
         typedef std::vector<const unsigned char*> AliasPictureList;
         
@@ -146,7 +131,6 @@ namespace TrenchBroom {
         public:
             AliasSkin(const unsigned char* picture, unsigned int width, unsigned int height);
             AliasSkin(const AliasPictureList& pictures, const AliasTimeList& times, unsigned int count, unsigned int width, unsigned int height);
-            ~AliasSkin();
             
             inline unsigned int width() const {
                 return m_width;
@@ -176,19 +160,21 @@ namespace TrenchBroom {
         class AliasSingleFrame : public AliasFrame {
         private:
             String m_name;
-            AliasFrameTriangleList m_triangles;
+            AliasFrameVertexList m_vertices;
             Vec3f m_center;
             BBoxf m_bounds;
         public:
-            AliasSingleFrame(const String& name, const AliasFrameTriangleList& triangles, const Vec3f& center, const BBoxf& bounds);
-            ~AliasSingleFrame();
+            AliasSingleFrame(const String& name, AliasFrameVertexList& vertices, const Vec3f& center, const BBoxf& bounds);
             
             inline const String& name() const {
                 return m_name;
             }
             
-            inline const AliasFrameTriangleList& triangles() const {
-                return m_triangles;
+            /**
+             * Returns the vertices of this frame's triangles, three consecutive vertices per triangle.
+             */
+            inline const AliasFrameVertexList& vertices() const {
+                return m_vertices;
             }
             
             inline const Vec3f& center() const {
@@ -213,33 +199,49 @@ namespace TrenchBroom {
             AliasSingleFrame* firstFrame();
         };
         
+        /**
+         * An MDL model. Only the header, the skin vertices and the skin triangles are read when the model is created.
+         * The skin pictures point directly into the mapped file, and the frames are decoded when they are first
+         * accessed, so the file stays mapped for as long as the model exists.
+         */
         class Alias {
         private:
             String m_name;
-            AliasFrameList m_frames;
+            IO::MappedFile::Ptr m_file;
+            Vec3f m_origin;
+            Vec3f m_scale;
+            unsigned int m_skinWidth;
+            unsigned int m_skinHeight;
+            AliasSkinVertexList m_skinVertices;
+            AliasSkinTriangleList m_skinTriangles;
+            std::vector<char*> m_frameCursors;
+            mutable AliasFrameList m_frames;
             AliasSkinList m_skins;
             
-            Vec3f unpackFrameVertex(const AliasPackedFrameVertex& packedVertex, const Vec3f& origin, const Vec3f& size);
-            AliasSingleFrame* readFrame(char*& cursor, const Vec3f& origin, const Vec3f& scale, unsigned int skinWidth, unsigned int skinHeight, const AliasSkinVertexList& vertices, const AliasSkinTriangleList& triangles);
+            Vec3f unpackFrameVertex(const AliasPackedFrameVertex& packedVertex) const;
+            AliasSingleFrame* readFrame(char*& cursor) const;
+            AliasFrame* readFrameOrGroup(char* cursor) const;
         public:
-            Alias(const String& name, char* begin, char* end);
+            Alias(const String& name, IO::MappedFile::Ptr file);
             ~Alias();
             
             inline const String& name() const {
                 return m_name;
             }
             
-            inline const AliasFrameList& frames() const {
-                return m_frames;
+            inline size_t frameCount() const {
+                return m_frameCursors.size();
             }
             
             inline AliasSingleFrame& frame(size_t index) const {
                 assert(index < m_frames.size());
+                if (m_frames[index] == NULL)
+                    m_frames[index] = readFrameOrGroup(m_frameCursors[index]);
                 return *m_frames[index]->firstFrame();
             }
             
             inline AliasSingleFrame& firstFrame() const {
-                return *m_frames[0]->firstFrame();
+                return frame(0);
             }
             
             inline const AliasSkinList& skins() const {
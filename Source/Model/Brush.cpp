@@ -22,6 +22,7 @@
 #include "Model/Entity.h"
 #include "Model/Face.h"
 #include "Model/Filter.h"
+#include "Model/Map.h"
 #include "Model/Picker.h"
 #include "Model/Texture.h"
 #include "Utility/List.h"
@@ -131,6 +132,24 @@ namespace TrenchBroom {
             rebuildGeometry();
         }
 
+        Brush::Brush(const BBoxf& worldBounds, bool forceIntegerFacePoints, const FaceList& faces, BrushGeometry* geometry) :
+        MapObject(),
+        m_geometry(geometry),
+        m_worldBounds(worldBounds),
+        m_forceIntegerFacePoints(forceIntegerFacePoints) {
+            assert(m_geometry != NULL);
+            init();
+
+            FaceList::const_iterator it, end;
+            for (it = faces.begin(), end = faces.end(); it != end; ++it) {
+                Face* face = *it;
+                face->setBrush(this);
+                face->invalidateTexAxes();
+                face->invalidateVertexCache();
+                m_faces.push_back(face);
+            }
+        }
+
         Brush::~Brush() {
             setEntity(NULL);
             delete m_geometry;
@@ -176,6 +195,8 @@ namespace TrenchBroom {
                     m_entity->decSelectedBrushCount();
                 else if (hidden())
                     m_entity->decHiddenBrushCount();
+                if (m_entity->map() != NULL)
+                    m_entity->map()->removeBrushFaces(*this);
                 if (entity == NULL && m_geometry != NULL) {
                     delete m_geometry;
                     m_geometry = NULL;
@@ -191,6 +212,8 @@ namespace TrenchBroom {
                     m_entity->incSelectedBrushCount();
                 else if (hidden())
                     m_entity->incHiddenBrushCount();
+                if (m_entity->map() != NULL)
+                    m_entity->map()->addBrushFaces(*this);
             }
         }
 
@@ -222,7 +245,6 @@ namespace TrenchBroom {
 
         void Brush::rebuildGeometry() {
             delete m_geometry;
-            m_geometry = new BrushGeometry(m_worldBounds);
 
             // sort the faces by the weight of their plane normals like QBSP does
             Model::FaceList sortedFaces = m_faces;
@@ -230,8 +252,13 @@ namespace TrenchBroom {
             std::sort(sortedFaces.begin(), sortedFaces.end(), Model::Face::WeightOrder(Planef::WeightOrder(false)));
 
             FaceSet droppedFaces;
-            bool success = m_geometry->addFaces(sortedFaces, droppedFaces);
-            assert(success);
+            m_geometry = BrushGeometry::createFromFaces(m_worldBounds, sortedFaces, droppedFaces);
+            if (m_geometry == NULL) {
+                droppedFaces.clear();
+                m_geometry = new BrushGeometry(m_worldBounds);
+                bool success = m_geometry->addFaces(sortedFaces, droppedFaces);
+                assert(success);
+            }
 
             for (FaceSet::iterator it = droppedFaces.begin(); it != droppedFaces.end(); ++it) {
                 Face* face = *it;
@@ -251,12 +278,30 @@ namespace TrenchBroom {
         }
 
         void Brush::transform(const Mat4f& pointTransform, const Mat4f& vectorTransform, const bool lockTextures, const bool invertOrientation) {
+            // translations, 90 degree rotations and mirrorings cannot change the topology of the brush, so we can
+            // transform the existing geometry instead of rebuilding it from scratch
+            Mat4f axisTransform;
+            const bool keepTopology = (m_geometry != NULL &&
+                                       axisAlignedMatrix(pointTransform, axisTransform) &&
+                                       (matrixDeterminant(axisTransform) < 0.0f) == invertOrientation);
+
             FaceList::const_iterator faceIt, faceEnd;
             for (faceIt = m_faces.begin(), faceEnd = m_faces.end(); faceIt != faceEnd; ++faceIt) {
                 Face& face = **faceIt;
                 face.transform(pointTransform, vectorTransform, lockTextures, invertOrientation);
             }
 
+            if (keepTopology) {
+                m_geometry->transform(axisTransform, invertOrientation);
+
+                // the face points may have been snapped, in which case the boundaries no longer match the vertices
+                if (m_worldBounds.contains(m_geometry->bounds) && m_geometry->sidesOnBoundaries()) {
+                    if (m_entity != NULL)
+                        m_entity->invalidateGeometry();
+                    return;
+                }
+            }
+
             rebuildGeometry();
         }
 
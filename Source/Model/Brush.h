@@ -56,6 +56,13 @@ namespace TrenchBroom {
             Brush(const BBoxf& worldBounds, bool forceIntegerFacePoints, const FaceList& faces);
             Brush(const BBoxf& worldBounds, bool forceIntegerFacePoints, const Brush& brushTemplate);
             Brush(const BBoxf& worldBounds, bool forceIntegerFacePoints, const BBoxf& brushBounds, Texture* texture);
+
+            /**
+             * Creates a brush from faces and a geometry that was built from exactly these faces before, e.g. one that
+             * was restored from a map cache. The brush takes ownership of the geometry instead of rebuilding it, and
+             * the sides of the geometry must already refer to the given faces.
+             */
+            Brush(const BBoxf& worldBounds, bool forceIntegerFacePoints, const FaceList& faces, BrushGeometry* geometry);
             ~Brush();
 
             void restore(const Brush& brushTemplate, bool checkId = false);
@@ -99,6 +106,10 @@ namespace TrenchBroom {
             
             void setForceIntegerFacePoints(bool forceIntegerFacePoints);
             
+            inline const BrushGeometry& geometry() const {
+                return *m_geometry;
+            }
+
             inline const Vec3f& center() const {
                 return m_geometry->center;
             }
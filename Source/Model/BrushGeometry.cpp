@@ -22,6 +22,8 @@
 #include "Model/Face.h"
 #include "Utility/List.h"
 
+#include <algorithm>
+#include <cmath>
 #include <map>
 #include <cstdio>
 
@@ -1086,6 +1088,7 @@ namespace TrenchBroom {
             }
 
             bounds = original.bounds;
+            center = original.center;
         }
 
         bool BrushGeometry::sanityCheck() {
@@ -1295,6 +1298,40 @@ namespace TrenchBroom {
                 sides[i]->face->setSide(sides[i]);
         }
 
+        void BrushGeometry::transform(const Mat4f& pointTransform, bool invertOrientation) {
+            for (size_t i = 0; i < vertices.size(); i++)
+                vertices[i]->position = pointTransform * vertices[i]->position;
+
+            if (invertOrientation) {
+                // mirroring reverses the winding of every side, so each edge now has its sides swapped
+                for (size_t i = 0; i < edges.size(); i++)
+                    std::swap(edges[i]->left, edges[i]->right);
+                for (size_t i = 0; i < sides.size(); i++) {
+                    Side* side = sides[i];
+                    std::reverse(side->edges.begin(), side->edges.end());
+                    for (size_t j = 0; j < side->edges.size(); j++)
+                        side->vertices[j] = side->edges[j]->startVertex(side);
+                }
+            }
+
+            bounds = boundsOfVertices(vertices);
+            center = centerOfVertices(vertices);
+        }
+
+        bool BrushGeometry::sidesOnBoundaries(float epsilon) const {
+            for (size_t i = 0; i < sides.size(); i++) {
+                const Side* side = sides[i];
+                if (side->face == NULL)
+                    return false;
+                const Planef& boundary = side->face->boundary();
+                for (size_t j = 0; j < side->vertices.size(); j++) {
+                    if (boundary.pointStatus(side->vertices[j]->position, epsilon) != PointStatus::PSInside)
+                        return false;
+                }
+            }
+            return true;
+        }
+
         BrushGeometry::CutResult BrushGeometry::addFace(Face& face, FaceSet& droppedFaces) {
             // if all of the face's points are on a previous face, it's a duplicate
             for (size_t i = 0; i < sides.size(); i++) {
@@ -1460,6 +1497,246 @@ namespace TrenchBroom {
             return true;
         }
 
+        BrushGeometry* BrushGeometry::createFromFaces(const BBoxf& worldBounds, const FaceList& faces, FaceSet& droppedFaces) {
+            // the incidence of a vertex and the faces is stored in a bit mask, so we can handle at most 32 faces
+            static const size_t MaxFaceCount = 32;
+            static const double PointEpsilon = 0.1;
+            static const double ParallelEpsilon = 1e-10;
+
+            if (faces.size() < 4 || faces.size() > MaxFaceCount)
+                return NULL;
+
+            // if all of a face's points are on a previous face, it's a duplicate
+            Face* uniqueFaces[MaxFaceCount];
+            Vec3d normals[MaxFaceCount];
+            double distances[MaxFaceCount];
+            size_t faceCount = 0;
+            FaceSet duplicateFaces;
+
+            for (size_t i = 0; i < faces.size(); i++) {
+                Face* face = faces[i];
+                bool duplicate = false;
+                for (size_t j = 0; j < faceCount && !duplicate; j++) {
+                    const Planef& previous = uniqueFaces[j]->boundary();
+                    duplicate = (previous.pointStatus(face->point(0)) == PointStatus::PSInside &&
+                                 previous.pointStatus(face->point(1)) == PointStatus::PSInside &&
+                                 previous.pointStatus(face->point(2)) == PointStatus::PSInside);
+                }
+
+                if (duplicate) {
+                    duplicateFaces.insert(face);
+                } else {
+                    const Planef& boundary = face->boundary();
+                    uniqueFaces[faceCount] = face;
+                    normals[faceCount] = Vec3d(boundary.normal.x(), boundary.normal.y(), boundary.normal.z());
+                    distances[faceCount] = boundary.distance;
+                    faceCount++;
+                }
+            }
+
+            if (faceCount < 4)
+                return NULL;
+
+            // intersect every triple of planes and keep the points that are not above any plane
+            std::vector<Vec3d> positions;
+            std::vector<unsigned int> incidences;
+            positions.reserve(2 * faceCount);
+            incidences.reserve(2 * faceCount);
+
+            size_t cuttingPlane = 0;
+            for (size_t i = 0; i < faceCount; i++) {
+                for (size_t j = i + 1; j < faceCount; j++) {
+                    const Vec3d ij = crossed(normals[i], normals[j]);
+                    for (size_t k = j + 1; k < faceCount; k++) {
+                        const double det = ij.dot(normals[k]);
+                        if (std::abs(det) < ParallelEpsilon)
+                            continue;
+
+                        const Vec3d jk = crossed(normals[j], normals[k]);
+                        const Vec3d ki = crossed(normals[k], normals[i]);
+                        const Vec3d point = (distances[i] * jk + distances[j] * ki + distances[k] * ij) / det;
+
+                        // most candidates are cut off by the same few planes, so try the last one that did first
+                        if (point.dot(normals[cuttingPlane]) - distances[cuttingPlane] > PointEpsilon)
+                            continue;
+
+                        unsigned int incidence = 0;
+                        bool inside = true;
+                        for (size_t l = 0; l < faceCount && inside; l++) {
+                            const double distance = point.dot(normals[l]) - distances[l];
+                            if (distance > PointEpsilon) {
+                                cuttingPlane = l;
+                                inside = false;
+                            } else if (distance >= -PointEpsilon) {
+                                incidence |= (1u << l);
+                            }
+                        }
+                        if (!inside)
+                            continue;
+
+                        // vertices where more than three planes meet are found several times
+                        bool merged = false;
+                        for (size_t l = 0; l < positions.size() && !merged; l++) {
+                            if ((positions[l] - point).lengthSquared() <= PointEpsilon * PointEpsilon) {
+                                incidences[l] |= incidence;
+                                merged = true;
+                            }
+                        }
+                        if (!merged) {
+                            positions.push_back(point);
+                            incidences.push_back(incidence);
+                        }
+                    }
+                }
+            }
+
+            const size_t vertexCount = positions.size();
+            if (vertexCount < 4)
+                return NULL;
+
+            for (size_t i = 0; i < vertexCount; i++) {
+                const Vec3d& position = positions[i];
+                if (position.x() <= worldBounds.min.x() + PointEpsilon || position.x() >= worldBounds.max.x() - PointEpsilon ||
+                    position.y() <= worldBounds.min.y() + PointEpsilon || position.y() >= worldBounds.max.y() - PointEpsilon ||
+                    position.z() <= worldBounds.min.z() + PointEpsilon || position.z() >= worldBounds.max.z() - PointEpsilon)
+                    return NULL;
+            }
+
+            // faces which touch the polyhedron in less than three vertices are redundant, and every vertex must be
+            // incident to at least three of the remaining faces
+            unsigned int sideMask = 0;
+            for (size_t i = 0; i < faceCount; i++) {
+                size_t count = 0;
+                for (size_t j = 0; j < vertexCount; j++)
+                    if ((incidences[j] & (1u << i)) != 0)
+                        count++;
+                if (count >= 3)
+                    sideMask |= (1u << i);
+            }
+
+            for (size_t i = 0; i < vertexCount; i++) {
+                incidences[i] &= sideMask;
+                size_t count = 0;
+                for (unsigned int bits = incidences[i]; bits != 0; bits &= bits - 1)
+                    count++;
+                if (count < 3)
+                    return NULL;
+            }
+
+            // build the topology, every edge must be traversed once in each direction
+            VertexList newVertices(vertexCount);
+            for (size_t i = 0; i < vertexCount; i++)
+                newVertices[i] = new Vertex(static_cast<float>(positions[i].x()),
+                                            static_cast<float>(positions[i].y()),
+                                            static_cast<float>(positions[i].z()));
+
+            std::vector<Edge*> edgeMatrix(vertexCount * vertexCount, NULL);
+            EdgeList newEdges;
+            SideList newSides;
+            newEdges.reserve(3 * vertexCount / 2);
+            newSides.reserve(faceCount);
+            bool valid = true;
+
+            for (size_t i = 0; i < faceCount && valid; i++) {
+                if ((sideMask & (1u << i)) == 0)
+                    continue;
+
+                size_t indices[MaxFaceCount * 2];
+                double angles[MaxFaceCount * 2];
+                size_t count = 0;
+                Vec3d center = Vec3d::Null;
+                for (size_t j = 0; j < vertexCount && valid; j++) {
+                    if ((incidences[j] & (1u << i)) != 0) {
+                        if (count == MaxFaceCount * 2) {
+                            valid = false;
+                        } else {
+                            indices[count++] = j;
+                            center += positions[j];
+                        }
+                    }
+                }
+                if (!valid)
+                    break;
+                center /= static_cast<double>(count);
+
+                // sort the vertices clockwise when viewed from above the side
+                const Vec3d& normal = normals[i];
+                const Vec3d xAxis = (positions[indices[0]] - center).normalized();
+                const Vec3d yAxis = crossed(normal, xAxis);
+                for (size_t j = 0; j < count; j++) {
+                    const Vec3d offset = positions[indices[j]] - center;
+                    const double angle = -std::atan2(offset.dot(yAxis), offset.dot(xAxis));
+                    const size_t index = indices[j];
+                    size_t k = j;
+                    for (; k > 0 && angles[k - 1] > angle; k--) {
+                        angles[k] = angles[k - 1];
+                        indices[k] = indices[k - 1];
+                    }
+                    angles[k] = angle;
+                    indices[k] = index;
+                }
+
+                // reject sides that are not strictly convex
+                for (size_t j = 0; j < count && valid; j++) {
+                    const Vec3d& p0 = positions[indices[j]];
+                    const Vec3d& p1 = positions[indices[succ(j, count)]];
+                    const Vec3d& p2 = positions[indices[succ(j, count, 2)]];
+                    valid = crossed(p1 - p0, p2 - p1).dot(normal) < -Math<double>::AlmostZero;
+                }
+
+                Side* side = new Side();
+                side->face = uniqueFaces[i];
+                side->vertices.reserve(count);
+                side->edges.reserve(count);
+                newSides.push_back(side);
+
+                for (size_t j = 0; j < count && valid; j++) {
+                    const size_t startIndex = indices[j];
+                    const size_t endIndex = indices[succ(j, count)];
+
+                    Edge* edge = edgeMatrix[endIndex * vertexCount + startIndex];
+                    if (edge != NULL) {
+                        if (edge->left != NULL)
+                            valid = false;
+                        else
+                            edge->left = side;
+                    } else if (edgeMatrix[startIndex * vertexCount + endIndex] != NULL) {
+                        valid = false;
+                    } else {
+                        edge = new Edge(newVertices[startIndex], newVertices[endIndex]);
+                        edge->right = side;
+                        edgeMatrix[startIndex * vertexCount + endIndex] = edge;
+                        newEdges.push_back(edge);
+                    }
+
+                    side->vertices.push_back(newVertices[startIndex]);
+                    side->edges.push_back(edge);
+                }
+            }
+
+            for (size_t i = 0; i < newEdges.size() && valid; i++)
+                valid = newEdges[i]->left != NULL && newEdges[i]->right != NULL;
+            valid = valid && vertexCount + newSides.size() == newEdges.size() + 2;
+
+            if (!valid) {
+                Utility::deleteAll(newSides);
+                Utility::deleteAll(newEdges);
+                Utility::deleteAll(newVertices);
+                return NULL;
+            }
+
+            for (size_t i = 0; i < newSides.size(); i++)
+                newSides[i]->face->setSide(newSides[i]);
+            for (size_t i = 0; i < faceCount; i++)
+                if ((sideMask & (1u << i)) == 0)
+                    droppedFaces.insert(uniqueFaces[i]);
+            droppedFaces.insert(duplicateFaces.begin(), duplicateFaces.end());
+
+            for (size_t i = 0; i < vertexCount; i++)
+                newVertices[i]->position.correct();
+            return new BrushGeometry(newVertices, newEdges, newSides);
+        }
+
         void BrushGeometry::updateFacePoints(FaceManager& faceManager) {
             for (size_t i = 0; i < sides.size(); i++) {
                 try {
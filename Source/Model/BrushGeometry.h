@@ -337,6 +337,15 @@ namespace TrenchBroom {
             Vec3f center;
             BBoxf bounds;
 
+            /**
+             * Builds the geometry of the convex polyhedron bounded by the given faces directly from the intersections of
+             * their boundary planes instead of cutting a world sized cube. The faces must be sorted like they are for
+             * addFaces; faces which do not contribute a side are inserted into droppedFaces. Returns NULL if the faces
+             * cannot be handled this way, e.g. if the brush is open, touches the world bounds or is degenerate, in which
+             * case the caller should fall back to addFaces.
+             */
+            static BrushGeometry* createFromFaces(const BBoxf& worldBounds, const FaceList& faces, FaceSet& droppedFaces);
+
             BrushGeometry(const BBoxf& bounds);
             BrushGeometry(const BrushGeometry& original);
             BrushGeometry(const Model::VertexList& i_vertices, const Model::EdgeList& i_edges, const Model::SideList& i_sides);
@@ -345,6 +354,18 @@ namespace TrenchBroom {
             bool closed() const;
             void restoreFaceSides();
 
+            /**
+             * Transforms the vertices of this geometry in place, keeping its topology. This is only valid for
+             * transformations which keep the brush convex and its sides planar, e.g. those accepted by
+             * axisAlignedMatrix. If invertOrientation is true, the winding of every side is reversed.
+             */
+            void transform(const Mat4f& pointTransform, bool invertOrientation);
+
+            /**
+             * Checks whether the vertices of every side lie on the boundary plane of the side's face.
+             */
+            bool sidesOnBoundaries(float epsilon = Math<float>::PointStatusEpsilon) const;
+
             CutResult addFace(Face& face, FaceSet& droppedFaces);
             bool addFaces(const FaceList& faces, FaceSet& droppedFaces);
 
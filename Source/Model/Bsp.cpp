@@ -22,6 +22,7 @@
 #include "IO/IOUtils.h"
 #include "Utility/List.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <numeric>
@@ -34,253 +35,188 @@ namespace TrenchBroom {
         m_width(width),
         m_height(height) {}
 
-        BspTexture::~BspTexture() {
-            delete[] m_image;
-            m_image = NULL;
-        }
-
-        BspFace::BspFace(BspTextureInfo* textureInfo, const Vec3f::List& vertices) :
+        BspFace::BspFace(const BspTextureInfo* textureInfo, const Vec3f* vertices, size_t vertexCount) :
         m_textureInfo(textureInfo),
-        m_vertices(vertices) {
-            m_bounds.min = m_bounds.max = m_vertices.front();
+        m_vertices(vertices),
+        m_vertexCount(vertexCount) {}
 
-            for (unsigned int i = 1; i < m_vertices.size(); i++)
-                m_bounds.mergeWith(m_vertices[i]);
+        BspModel::BspModel(Vec3f::List& vertices, BspFaceList& faces, const Vec3f& center, const BBoxf& bounds) :
+        m_center(center),
+        m_bounds(bounds) {
+            // swapping keeps the vertex array in place, so the face pointers into it remain valid
+            m_vertices.swap(vertices);
+            m_faces.swap(faces);
         }
 
-        BspModel::BspModel(const BspFaceList& faces, unsigned int vertexCount, const Vec3f& center, const BBoxf& bounds) :
-        m_faces(faces),
-        m_vertexCount(vertexCount),
-        m_center(center),
-        m_bounds(bounds) {}
+        Bsp::Lump Bsp::readLump(unsigned int directoryAddress) const {
+            using namespace IO;
 
-        BspModel::~BspModel() {
-            Utility::deleteAll(m_faces);
+            char* cursor = m_file->begin() + directoryAddress;
+            Lump lump;
+            lump.address = m_file->begin() + readInt<int32_t>(cursor);
+            lump.length = readUnsignedInt<int32_t>(cursor);
+            return lump;
         }
 
-        void Bsp::readTextures(char*& cursor, unsigned int count) {
+        BspTexture* Bsp::texture(size_t index) const {
             using namespace IO;
-            
+
+            assert(index < m_textures.size());
+            if (m_textures[index] != NULL)
+                return m_textures[index];
+
+            char* base = m_texturesLump.address;
+            char* cursor = base + (index + 1) * sizeof(int32_t);
+            int textureOffset = readInt<int32_t>(cursor);
+
             char textureName[BspLayout::TextureNameLength + 1];
             textureName[BspLayout::TextureNameLength] = 0;
-            
-            char* base = cursor;
-            for (unsigned int i = 0; i < count; i++) {
-                cursor = base + (i + 1) * sizeof(int32_t);
-                int textureOffset = readInt<int32_t>(cursor);
-                
-                cursor = base + textureOffset;
-                readBytes(cursor, textureName, BspLayout::TextureNameLength);
-                unsigned int width = readUnsignedInt<uint32_t>(cursor);
-                unsigned int height = readUnsignedInt<uint32_t>(cursor);
-                unsigned int mip0Offset = readUnsignedInt<uint32_t>(cursor);
-
-                unsigned char* mip0 = new unsigned char[width * height];
-                cursor = base + textureOffset + mip0Offset;
-                readBytes(cursor, mip0, width * height);
-
-                BspTexture* texture = new BspTexture(textureName, mip0, width, height);
-                m_textures[i] = texture;
-            }
+
+            cursor = base + textureOffset;
+            readBytes(cursor, textureName, BspLayout::TextureNameLength);
+            unsigned int width = readUnsignedInt<uint32_t>(cursor);
+            unsigned int height = readUnsignedInt<uint32_t>(cursor);
+            unsigned int mip0Offset = readUnsignedInt<uint32_t>(cursor);
+
+            const unsigned char* mip0 = reinterpret_cast<const unsigned char*>(base + textureOffset + mip0Offset);
+            m_textures[index] = new BspTexture(textureName, mip0, width, height);
+            return m_textures[index];
         }
 
-        void Bsp::readTextureInfos(char*& cursor, unsigned int count, std::vector<BspTexture*>& textures) {
+        const BspTextureInfo* Bsp::textureInfo(size_t index) const {
             using namespace IO;
-            
-            for (unsigned int i = 0; i < count; i++) {
-                BspTextureInfo* textureInfo = new BspTextureInfo();
-                textureInfo->sAxis = readVec3f(cursor);
-                textureInfo->sOffset = readFloat<float>(cursor);
-                textureInfo->tAxis = readVec3f(cursor);
-                textureInfo->tOffset = readFloat<float>(cursor);
-
-                unsigned int textureIndex = readUnsignedInt<uint32_t>(cursor);
-                textureInfo->texture = textures[textureIndex];
-
-                m_textureInfos[i] = textureInfo;
-                cursor += BspLayout::TexInfoRest;
-            }
+
+            assert(index < m_textureInfos.size());
+            BspTextureInfo& textureInfo = m_textureInfos[index];
+            if (m_textureInfosRead[index])
+                return &textureInfo;
+
+            char* cursor = m_textureInfosLump.address + index * BspLayout::TexInfoSize;
+            textureInfo.sAxis = readVec3f(cursor);
+            textureInfo.sOffset = readFloat<float>(cursor);
+            textureInfo.tAxis = readVec3f(cursor);
+            textureInfo.tOffset = readFloat<float>(cursor);
+
+            unsigned int textureIndex = readUnsignedInt<uint32_t>(cursor);
+            textureInfo.texture = texture(textureIndex);
+
+            m_textureInfosRead[index] = true;
+            return &textureInfo;
         }
 
-        void Bsp::readVertices(char*& cursor, unsigned int count, Vec3f::List& vertices) {
+        unsigned int Bsp::faceVertexIndex(size_t faceEdgeIndex) const {
             using namespace IO;
-            
-            vertices.reserve(count);
-            for (unsigned int i = 0; i < count; i++) {
-                Vec3f vertex = readVec3f(cursor);
-                vertices.push_back(vertex);
-            }
+
+            char* cursor = m_faceEdgesLump.address + faceEdgeIndex * BspLayout::FaceEdgeSize;
+            int edgeIndex = readInt<int32_t>(cursor);
+
+            // an edge consists of two 16 bit vertex indices, a negative index means that the edge is reversed
+            if (edgeIndex < 0)
+                cursor = m_edgesLump.address + static_cast<size_t>(-edgeIndex) * 2 * sizeof(uint16_t) + sizeof(uint16_t);
+            else
+                cursor = m_edgesLump.address + static_cast<size_t>(edgeIndex) * 2 * sizeof(uint16_t);
+            return readUnsignedInt<uint16_t>(cursor);
         }
 
-        void Bsp::readEdges(char*& cursor, unsigned int count, BspEdgeInfoList& edges) {
+        Vec3f Bsp::vertex(unsigned int index) const {
             using namespace IO;
-            
-            edges.reserve(count);
-            BspEdgeInfo edgeInfo;
-            for (unsigned int i = 0; i < count; i++) {
-                edgeInfo.vertex0 = readUnsignedInt<uint16_t>(cursor);
-                edgeInfo.vertex1 = readUnsignedInt<uint16_t>(cursor);
-                edges.push_back(edgeInfo);
-            }
+
+            char* cursor = m_verticesLump.address + index * 3 * sizeof(float);
+            return readVec3f(cursor);
         }
 
-        void Bsp::readFaces(char*& cursor, unsigned int count, BspFaceInfoList& faces) {
+        BspModel* Bsp::readModel(size_t index) const {
             using namespace IO;
-            
-            faces.reserve(count);
-            BspFaceInfo face;
-            for (unsigned int i = 0; i < count; i++) {
-                cursor += BspLayout::FaceEdgeIndex;
-
-                face.edgeIndex = readUnsignedInt<int32_t>(cursor);
-                face.edgeCount = readUnsignedInt<uint16_t>(cursor);
-                face.textureInfoIndex = readUnsignedInt<uint16_t>(cursor);
-                faces.push_back(face);
-
-                cursor += BspLayout::FaceRest;
+
+            char* cursor = m_modelsLump.address + index * BspLayout::ModelSize + BspLayout::ModelFaceIndex;
+            unsigned int modelFaceIndex = readUnsignedInt<int32_t>(cursor);
+            unsigned int modelFaceCount = readUnsignedInt<int32_t>(cursor);
+
+            typedef std::vector<size_t> IndexList;
+            IndexList faceVertexCounts(modelFaceCount);
+            IndexList faceTextureInfos(modelFaceCount);
+            IndexList faceEdgeIndices(modelFaceCount);
+
+            size_t totalVertexCount = 0;
+            for (unsigned int i = 0; i < modelFaceCount; i++) {
+                cursor = m_facesLump.address + (modelFaceIndex + i) * BspLayout::FaceSize + BspLayout::FaceEdgeIndex;
+                faceEdgeIndices[i] = readUnsignedInt<int32_t>(cursor);
+                faceVertexCounts[i] = readUnsignedInt<uint16_t>(cursor);
+                faceTextureInfos[i] = readUnsignedInt<uint16_t>(cursor);
+                totalVertexCount += faceVertexCounts[i];
             }
-        }
 
-        void Bsp::readFaceEdges(char*& cursor, unsigned int count, BspFaceEdgeIndexList& indices) {
-            using namespace IO;
-            
-            indices.reserve(count);
-            for (unsigned int i = 0; i < count; i++) {
-                int index = readInt<int32_t>(cursor);
-                indices.push_back(index);
+            std::vector<unsigned int> vertexIndices;
+            vertexIndices.reserve(totalVertexCount);
+            for (unsigned int i = 0; i < modelFaceCount; i++) {
+                for (size_t j = 0; j < faceVertexCounts[i]; j++)
+                    vertexIndices.push_back(faceVertexIndex(faceEdgeIndices[i] + j));
             }
-        }
 
-        Bsp::Bsp(const String& name, char* begin, char* end) :
-        m_name(name) {
-            using namespace IO;
-            
-            char* cursor = begin;
-            readInt<int32_t>(cursor); // version
-            cursor = begin + BspLayout::DirTexturesAddress;
-            int textureAddr = readInt<int32_t>(cursor);
-            cursor = begin + textureAddr;
-            unsigned int textureCount = readUnsignedInt<int32_t>(cursor);
-            
-            cursor -= sizeof(int32_t);
-            m_textures.resize(size_t(textureCount));
-            readTextures(cursor, textureCount);
-
-            cursor = begin + BspLayout::DirTexInfosAddress;
-            int texInfosAddr = readInt<int32_t>(cursor);
-            unsigned int texInfosLength = readUnsignedInt<int32_t>(cursor);
-            unsigned int texInfoCount = texInfosLength / BspLayout::TexInfoSize;
-            m_textureInfos.resize(texInfoCount);
-            cursor = begin + texInfosAddr;
-            readTextureInfos(cursor, texInfoCount, m_textures);
-
-            cursor = begin + BspLayout::DirVerticesAddress;
-            int verticesAddr = readInt<int32_t>(cursor);
-            unsigned int verticesLength = readUnsignedInt<int32_t>(cursor);
-            unsigned int vertexCount = verticesLength / sizeof(Vec3f);
             Vec3f::List vertices;
-            cursor = begin + verticesAddr;
-            readVertices(cursor, vertexCount, vertices);
-
-            cursor = begin + BspLayout::DirEdgesAddress;
-            int edgesAddr = readInt<int32_t>(cursor);
-            unsigned int edgesLength = readUnsignedInt<int32_t>(cursor);
-            unsigned int edgeCount = edgesLength / (2 * sizeof(uint16_t));
-            BspEdgeInfoList edges;
-            cursor = begin + edgesAddr;
-            readEdges(cursor, edgeCount, edges);
-
-            cursor = begin + BspLayout::DirFacesAddress;
-            int facesAddr = readInt<int32_t>(cursor);
-            unsigned int facesLength = readUnsignedInt<int32_t>(cursor);
-            unsigned int faceCount = facesLength / BspLayout::FaceSize;
-            BspFaceInfoList faces;
-            cursor = begin + facesAddr;
-            readFaces(cursor, faceCount, faces);
-
-            cursor = begin + BspLayout::DirFaceEdgesAddress;
-            int faceEdgesAddr = readInt<int32_t>(cursor);
-            unsigned int faceEdgesLength = readUnsignedInt<int32_t>(cursor);
-            unsigned int faceEdgesCount = faceEdgesLength / BspLayout::FaceEdgeSize;
-            BspFaceEdgeIndexList faceEdges;
-            cursor = begin + faceEdgesAddr;
-            readFaceEdges(cursor, faceEdgesCount, faceEdges);
-
-            cursor = begin + BspLayout::DirModelAddress;
-            int modelsAddr = readInt<int32_t>(cursor);
-            unsigned int modelsLength = readUnsignedInt<int32_t>(cursor);
-            unsigned int modelCount = modelsLength / BspLayout::ModelSize;
-
-            typedef std::vector<bool> MarkList;
-            MarkList vertexMarks;
-            vertexMarks.resize(vertexCount);
-            for (unsigned int i = 0; i < vertexCount; i++) vertexMarks[i] = false;
-            
-            typedef std::vector<unsigned int> ModelVertexIndexList;
-            ModelVertexIndexList modelVertices;
-            modelVertices.resize(vertexCount);
-
-            cursor = begin + modelsAddr;
-            for (unsigned int i = 0; i < modelCount; i++) {
-                cursor += BspLayout::ModelFaceIndex;
-                unsigned int modelFaceIndex = readUnsignedInt<int32_t>(cursor);
-                unsigned int modelFaceCount = readUnsignedInt<int32_t>(cursor);
+            vertices.reserve(totalVertexCount);
+            for (size_t i = 0; i < vertexIndices.size(); i++)
+                vertices.push_back(vertex(vertexIndices[i]));
+
+            BspFaceList faces;
+            faces.reserve(modelFaceCount);
+            size_t vertexOffset = 0;
+            for (unsigned int i = 0; i < modelFaceCount; i++) {
+                // a face without edges has no vertices to point to, and it would point past the end for the last face
+                if (faceVertexCounts[i] == 0)
+                    continue;
                 
-                unsigned int totalVertexCount = 0;
-                unsigned int modelVertexCount = 0;
-
-                BspFaceList bspFaces;
-                for (unsigned int j = 0; j < static_cast<unsigned int>(modelFaceCount); j++) {
-                    BspFaceInfo& faceInfo = faces[modelFaceIndex + j];
-                    BspTextureInfo* textureInfo = m_textureInfos[faceInfo.textureInfoIndex];
-
-                    unsigned int faceVertexCount = faceInfo.edgeCount;
-                    std::vector<Vec3f> faceVertices;
-                    for (unsigned int k = 0; k < faceInfo.edgeCount; k++) {
-                        int faceEdgeIndex = faceEdges[faceInfo.edgeIndex + k];
-                        unsigned int vertexIndex;
-                        if (faceEdgeIndex < 0)
-                            vertexIndex = edges[static_cast<size_t>(-faceEdgeIndex)].vertex1;
-                        else
-                            vertexIndex = edges[static_cast<size_t>(faceEdgeIndex)].vertex0;
-                        
-                        faceVertices.push_back(vertices[vertexIndex]);
-                        if (!vertexMarks[vertexIndex]) {
-                            vertexMarks[vertexIndex] = true;
-                            modelVertices[modelVertexCount++] = vertexIndex;
-                        }
-                    }
-
-                    BspFace* bspFace = new BspFace(textureInfo, faceVertices);
-                    bspFaces.push_back(bspFace);
-                    totalVertexCount += static_cast<unsigned int>(faceVertexCount);
+                const BspTextureInfo* textureInfo = this->textureInfo(faceTextureInfos[i]);
+                faces.push_back(BspFace(textureInfo, &vertices[vertexOffset], faceVertexCounts[i]));
+                vertexOffset += faceVertexCounts[i];
+            }
+
+            // the center is the average of the distinct vertices, each of which is shared by several faces
+            Vec3f center;
+            BBoxf bounds;
+            if (!vertexIndices.empty()) {
+                std::sort(vertexIndices.begin(), vertexIndices.end());
+                vertexIndices.erase(std::unique(vertexIndices.begin(), vertexIndices.end()), vertexIndices.end());
+
+                center = bounds.min = bounds.max = vertex(vertexIndices[0]);
+                for (size_t i = 1; i < vertexIndices.size(); i++) {
+                    Vec3f modelVertex = vertex(vertexIndices[i]);
+                    center += modelVertex;
+                    bounds.mergeWith(modelVertex);
                 }
+                center /= static_cast<float>(vertexIndices.size());
+            }
 
-                Vec3f center;
-                BBoxf bounds;
+            return new BspModel(vertices, faces, center, bounds);
+        }
 
-                center = vertices[modelVertices[0]];
-                bounds.min = vertices[modelVertices[0]];
-                bounds.max = vertices[modelVertices[0]];
+        Bsp::Bsp(const String& name, IO::MappedFile::Ptr file) :
+        m_name(name),
+        m_file(file) {
+            using namespace IO;
 
-                for (unsigned int j = 1; j < modelVertexCount; j++) {
-                    unsigned int vertexIndex = modelVertices[j];
-                    center += vertices[vertexIndex];
-                    bounds.mergeWith(vertices[vertexIndex]);
-                    vertexMarks[vertexIndex] = false;
-                }
+            m_texturesLump = readLump(BspLayout::DirTexturesAddress);
+            m_textureInfosLump = readLump(BspLayout::DirTexInfosAddress);
+            m_verticesLump = readLump(BspLayout::DirVerticesAddress);
+            m_edgesLump = readLump(BspLayout::DirEdgesAddress);
+            m_facesLump = readLump(BspLayout::DirFacesAddress);
+            m_faceEdgesLump = readLump(BspLayout::DirFaceEdgesAddress);
+            m_modelsLump = readLump(BspLayout::DirModelAddress);
 
-                center /= static_cast<float>(modelVertexCount);
+            char* cursor = m_texturesLump.address;
+            unsigned int textureCount = readUnsignedInt<int32_t>(cursor);
+            m_textures.resize(textureCount, NULL);
 
-                BspModel* bspModel = new BspModel(bspFaces, totalVertexCount, center, bounds);
-                m_models.push_back(bspModel);
-            }
+            size_t textureInfoCount = m_textureInfosLump.length / BspLayout::TexInfoSize;
+            m_textureInfos.resize(textureInfoCount);
+            m_textureInfosRead.resize(textureInfoCount, false);
+
+            m_models.resize(m_modelsLump.length / BspLayout::ModelSize, NULL);
         }
 
         Bsp::~Bsp() {
-            Utility::deleteAll(m_textureInfos);
-            Utility::deleteAll(m_textures);
             Utility::deleteAll(m_models);
+            Utility::deleteAll(m_textures);
         }
 
         BspManager* BspManager::sharedManager = NULL;
@@ -297,7 +233,7 @@ namespace TrenchBroom {
 
             IO::MappedFile::Ptr file = IO::findGameFile(name, paths);
             if (file.get() != NULL) {
-                Bsp* bsp = new Bsp(name, file->begin(), file->end());
+                Bsp* bsp = new Bsp(name, file);
                 m_bsps[key] = bsp;
                 return bsp;
             }
@@ -70,12 +70,6 @@ namespace TrenchBroom {
             static const unsigned int ModelFaceCount        = 0x3c;
         }
         
-        class BspEdgeInfo {
-        public:
-            unsigned int vertex0;
-            unsigned int vertex1;
-        };
-        
         class BspTexture;
         class BspTextureInfo {
         public:
@@ -86,13 +80,6 @@ namespace TrenchBroom {
             BspTexture* texture;
         };
         
-        class BspFaceInfo {
-        public:
-            unsigned int edgeIndex;
-            unsigned int edgeCount;
-            unsigned int textureInfoIndex;
-        };
-        
         class BspTexture {
         private:
             String m_name;
@@ -101,7 +88,6 @@ namespace TrenchBroom {
             unsigned int m_height;
         public:
             BspTexture(const String& name, const unsigned char* image, unsigned int width, unsigned int height);
-            ~BspTexture();
             
             inline const String& name() const {
                 return m_name;
@@ -121,11 +107,11 @@ namespace TrenchBroom {
         };
         
         class BspFace {
-            BBoxf m_bounds;
-            BspTextureInfo* m_textureInfo;
-            Vec3f::List m_vertices;
+            const BspTextureInfo* m_textureInfo;
+            const Vec3f* m_vertices;
+            size_t m_vertexCount;
         public:
-            BspFace(BspTextureInfo* textureInfo, const Vec3f::List& vertices);
+            BspFace(const BspTextureInfo* textureInfo, const Vec3f* vertices, size_t vertexCount);
 
             inline void textureCoordinates(const Vec3f& vertex, Vec2f& result) const {
                 result[0] = (vertex.dot(m_textureInfo->sAxis) + m_textureInfo->sOffset) / m_textureInfo->texture->width();
@@ -140,25 +126,32 @@ namespace TrenchBroom {
                 return m_textureInfo->texture->name();
             }
             
-            inline const Vec3f::List& vertices() const {
+            inline const Vec3f* vertices() const {
                 return m_vertices;
             }
+            
+            inline size_t vertexCount() const {
+                return m_vertexCount;
+            }
         };
         
-        typedef std::vector<BspFace*> BspFaceList;
+        typedef std::vector<BspFace> BspFaceList;
 
         class BspModel {
         private:
+            Vec3f::List m_vertices;
             BspFaceList m_faces;
-            unsigned int m_vertexCount;
             Vec3f m_center;
             BBoxf m_bounds;
         public:
-            BspModel(const BspFaceList& faces, unsigned int vertexCount, const Vec3f& center, const BBoxf& bounds);
-            ~BspModel();
+            /**
+             * Creates a model from the vertices of all its faces, stored consecutively. The faces refer to the vertex
+             * array, which is taken over by the model.
+             */
+            BspModel(Vec3f::List& vertices, BspFaceList& faces, const Vec3f& center, const BBoxf& bounds);
             
             inline unsigned int vertexCount() const {
-                return m_vertexCount;
+                return static_cast<unsigned int>(m_vertices.size());
             }
             
             inline const BspFaceList& faces() const {
@@ -174,34 +167,62 @@ namespace TrenchBroom {
             }
         };
         
-
         typedef std::vector<BspModel*> BspModelList;
 
+        /**
+         * A BSP file used as an entity model. Only the lump directory is read when the file is loaded. A model is
+         * decoded from the mapped file when it is first accessed, together with the texture infos and textures that
+         * its faces use. The texture images point directly into the mapped file.
+         */
         class Bsp {
         private:
             typedef std::vector<BspTexture*> BspTextureList;
-            typedef std::vector<BspEdgeInfo> BspEdgeInfoList;
-            typedef std::vector<BspFaceInfo> BspFaceInfoList;
-            typedef std::vector<BspTextureInfo*> BspTextureInfoList;
-            typedef std::vector<int> BspFaceEdgeIndexList;
+            typedef std::vector<BspTextureInfo> BspTextureInfoList;
+
+            class Lump {
+            public:
+                char* address;
+                size_t length;
+
+                Lump() :
+                address(NULL),
+                length(0) {}
+            };
 
             String m_name;
-            BspModelList m_models;
-            BspTextureList m_textures;
-            BspTextureInfoList m_textureInfos;
-
-            void readTextures(char*& cursor, unsigned int count);
-            void readTextureInfos(char*& cursor, unsigned int count, BspTextureList& textures);
-            void readVertices(char*& cursor, unsigned int count, Vec3f::List& vertices);
-            void readEdges(char*& cursor, unsigned int count, BspEdgeInfoList& edges);
-            void readFaces(char*& cursor, unsigned int count, BspFaceInfoList& faces);
-            void readFaceEdges(char*& cursor, unsigned int count, BspFaceEdgeIndexList& indices);
+            IO::MappedFile::Ptr m_file;
+            Lump m_texturesLump;
+            Lump m_textureInfosLump;
+            Lump m_verticesLump;
+            Lump m_edgesLump;
+            Lump m_facesLump;
+            Lump m_faceEdgesLump;
+            Lump m_modelsLump;
+
+            mutable BspModelList m_models;
+            mutable BspTextureList m_textures;
+            mutable BspTextureInfoList m_textureInfos;
+            mutable std::vector<bool> m_textureInfosRead;
+
+            Lump readLump(unsigned int directoryAddress) const;
+            BspTexture* texture(size_t index) const;
+            const BspTextureInfo* textureInfo(size_t index) const;
+            unsigned int faceVertexIndex(size_t faceEdgeIndex) const;
+            Vec3f vertex(unsigned int index) const;
+            BspModel* readModel(size_t index) const;
         public:
-            Bsp(const String& name, char* begin, char* end);
+            Bsp(const String& name, IO::MappedFile::Ptr file);
             ~Bsp();
             
-            inline const BspModelList& models() const {
-                return m_models;
+            inline size_t modelCount() const {
+                return m_models.size();
+            }
+
+            inline const BspModel& model(size_t index) const {
+                assert(index < m_models.size());
+                if (m_models[index] == NULL)
+                    m_models[index] = readModel(index);
+                return *m_models[index];
             }
         };
         
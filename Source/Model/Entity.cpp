@@ -50,6 +50,16 @@ namespace TrenchBroom {
         String const Entity::DefKey              = "_def";
         String const Entity::DefaultDefinition   = "Quake.fgd";
         String const Entity::FacePointFormatKey  = "_point_format";
+        
+        PropertyKeyId const Entity::ClassnameKeyId  = PropertyKeyTable::id(Entity::ClassnameKey);
+        PropertyKeyId const Entity::SpawnFlagsKeyId = PropertyKeyTable::id(Entity::SpawnFlagsKey);
+        PropertyKeyId const Entity::TargetKeyId     = PropertyKeyTable::id(Entity::TargetKey);
+        PropertyKeyId const Entity::KillTargetKeyId = PropertyKeyTable::id(Entity::KillTargetKey);
+        PropertyKeyId const Entity::TargetnameKeyId = PropertyKeyTable::id(Entity::TargetnameKey);
+        PropertyKeyId const Entity::OriginKeyId     = PropertyKeyTable::id(Entity::OriginKey);
+        PropertyKeyId const Entity::AngleKeyId      = PropertyKeyTable::id(Entity::AngleKey);
+        PropertyKeyId const Entity::AnglesKeyId     = PropertyKeyTable::id(Entity::AnglesKey);
+        PropertyKeyId const Entity::MangleKeyId     = PropertyKeyTable::id(Entity::MangleKey);
 
         void Entity::addLinkTarget(Entity& entity) {
             m_linkTargets.push_back(&entity);
@@ -456,8 +466,18 @@ namespace TrenchBroom {
             removeAllLinkSources();
             removeAllKillSources();
             
+            if (m_map != NULL) {
+                for (size_t i = 0; i < m_brushes.size(); i++)
+                    m_map->removeBrushFaces(*m_brushes[i]);
+            }
+            
             m_map = map;
             
+            if (m_map != NULL) {
+                for (size_t i = 0; i < m_brushes.size(); i++)
+                    m_map->addBrushFaces(*m_brushes[i]);
+            }
+            
             addAllLinkTargets();
             addAllKillTargets();
 
@@ -500,8 +520,12 @@ namespace TrenchBroom {
 
         void Entity::renameProperty(const PropertyKey& oldKey, const PropertyKey& newKey) {
             const PropertyValue* value = propertyForKey(oldKey);
+            if (value == NULL)
+                return;
+            
+            const PropertyValue valueCopy = *value;
             removeProperty(oldKey);
-            setProperty(newKey, *value);
+            setProperty(newKey, valueCopy);
         }
         
         void Entity::removeProperty(const PropertyKey& key) {
@@ -514,6 +538,8 @@ namespace TrenchBroom {
         
         void Entity::setProperties(const PropertyList& properties, bool replace) {
             if (replace) {
+                if (m_map != NULL)
+                    m_map->removeEntityProperties(*this);
                 m_propertyStore.clear();
                 setProperty(SpawnFlagsKey, "0");
             }
@@ -586,6 +612,8 @@ namespace TrenchBroom {
                     m_map->updateEntityTargetname(*this, value, oldValue);
             }
             
+            if (m_map != NULL)
+                m_map->updateEntityProperty(*this, key, value, oldValue);
             if (value == NULL)
                 m_propertyStore.removeProperty(key);
             else
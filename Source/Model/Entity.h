@@ -60,6 +60,16 @@ namespace TrenchBroom {
             static String const DefKey;
             static String const DefaultDefinition;
             static String const FacePointFormatKey;
+            
+            static PropertyKeyId const ClassnameKeyId;
+            static PropertyKeyId const SpawnFlagsKeyId;
+            static PropertyKeyId const TargetKeyId;
+            static PropertyKeyId const KillTargetKeyId;
+            static PropertyKeyId const TargetnameKeyId;
+            static PropertyKeyId const OriginKeyId;
+            static PropertyKeyId const AngleKeyId;
+            static PropertyKeyId const AnglesKeyId;
+            static PropertyKeyId const MangleKeyId;
 
             inline static bool isNumberedProperty(const String& pattern, const String& key) {
                 if (key.size() < pattern.size())
@@ -161,6 +171,10 @@ namespace TrenchBroom {
             inline const PropertyValue* propertyForKey(const PropertyKey& key) const {
                 return m_propertyStore.propertyValue(key);
             }
+            
+            inline const PropertyValue* propertyForKey(const PropertyKeyId keyId) const {
+                return m_propertyStore.propertyValue(keyId);
+            }
 
             static bool propertyIsMutable(const PropertyKey& key);
             static bool propertyKeyIsMutable(const PropertyKey& key);
@@ -195,7 +209,7 @@ namespace TrenchBroom {
             }
 
             inline const PropertyValue* classname() const {
-                return propertyForKey(ClassnameKey);
+                return propertyForKey(ClassnameKeyId);
             }
             
             inline const PropertyValue& safeClassname() const {
@@ -210,7 +224,7 @@ namespace TrenchBroom {
             }
 
             inline const Vec3f origin() const {
-                const PropertyValue* value = propertyForKey(OriginKey);
+                const PropertyValue* value = propertyForKey(OriginKeyId);
                 if (value == NULL)
                     return Vec3f::Null;
                 return Vec3f(*value);
@@ -220,12 +234,12 @@ namespace TrenchBroom {
                 if (classname() == NULL)
                     return false;
                 if (Utility::startsWith(*classname(), "light")) {
-                    if (propertyForKey(MangleKey) != NULL)
+                    if (propertyForKey(MangleKeyId) != NULL)
                         return true;
                 } else {
-                    if (propertyForKey(AngleKey) != NULL)
+                    if (propertyForKey(AngleKeyId) != NULL)
                         return true;
-                    if (propertyForKey(AnglesKey) != NULL)
+                    if (propertyForKey(AnglesKeyId) != NULL)
                         return true;
                 }
                 return false;
@@ -83,6 +83,10 @@ namespace TrenchBroom {
                     clear();
                     m_entityDefinitions = newDefinitions;
                     m_path = path;
+                    
+                    EntityDefinitionMap::const_iterator it, end;
+                    for (it = m_entityDefinitions.begin(), end = m_entityDefinitions.end(); it != end; ++it)
+                        m_nameIndex.add(it->first, it->second);
                 } catch (IO::ParserException& e) {
                     Utility::deleteAll(newDefinitions);
                     m_console.error(e.what());
@@ -93,6 +97,7 @@ namespace TrenchBroom {
         }
         
         void EntityDefinitionManager::clear() {
+            m_nameIndex.clear();
             Utility::deleteAll(m_entityDefinitions);
         }
 
@@ -101,6 +106,10 @@ namespace TrenchBroom {
             return it != m_entityDefinitions.end() ? it->second : NULL;
         }
         
+        void EntityDefinitionManager::findDefinitions(const String& pattern, EntityDefinitionList& result) const {
+            m_nameIndex.find(pattern, result);
+        }
+        
         EntityDefinitionList EntityDefinitionManager::definitions(EntityDefinition::Type type, SortOrder order) {
             EntityDefinitionList result;
             EntityDefinitionMap::iterator it, end;
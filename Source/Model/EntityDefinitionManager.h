@@ -22,6 +22,7 @@
 #include "Model/EntityDefinitionTypes.h"
 #include "Model/EntityDefinition.h"
 #include "Utility/String.h"
+#include "Utility/TrigramIndex.h"
 
 #include <map>
 
@@ -70,6 +71,7 @@ namespace TrenchBroom {
             Utility::Console& m_console;
             String m_path;
             EntityDefinitionMap m_entityDefinitions;
+            Utility::TrigramIndex<EntityDefinition*> m_nameIndex;
         public:
             EntityDefinitionManager(Utility::Console& console);
             ~EntityDefinitionManager();
@@ -81,6 +83,12 @@ namespace TrenchBroom {
             
             EntityDefinition* definition(const String& name);
             EntityDefinitionList definitions(EntityDefinition::Type type, SortOrder order = Name);
+            
+            /**
+             * Appends all definitions whose names contain the given pattern, ignoring case, to the given list. The
+             * result is sorted by name.
+             */
+            void findDefinitions(const String& pattern, EntityDefinitionList& result) const;
             EntityDefinitionGroups groups(EntityDefinition::Type type, SortOrder order = Name);
         };
     }
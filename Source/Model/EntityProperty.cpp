@@ -23,13 +23,29 @@
 
 namespace TrenchBroom {
     namespace Model {
+        const PropertyKeyId PropertyKeyTable::NoId = static_cast<PropertyKeyId>(-1);
+        
+        PropertyKeyTable::PropertyKeyTable() {
+            intern("");
+        }
+        
+        PropertyKeyId PropertyKeyTable::intern(const PropertyKey& key) {
+            KeyIdMap::const_iterator it = m_ids.find(key);
+            if (it != m_ids.end())
+                return it->second;
+            
+            const PropertyKeyId keyId = static_cast<PropertyKeyId>(m_keys.size());
+            m_keys.push_back(key);
+            m_ids.insert(KeyIdMap::value_type(key, keyId));
+            return keyId;
+        }
+        
         bool PropertyStore::hasDuplicates() const {
-            PropertyKeySet keys;
+            std::set<PropertyKeyId> keys;
             PropertyList::const_iterator propIt, propEnd;
             for (propIt = m_properties.begin(), propEnd = m_properties.end(); propIt != propEnd; ++propIt) {
                 const Property& property = *propIt;
-                PropertyKeySetInsertResult result = keys.insert(property.key());
-                if (!result.second)
+                if (!keys.insert(property.keyId()).second)
                     return true;
             }
             return false;
@@ -39,10 +55,14 @@ namespace TrenchBroom {
             if (containsProperty(newKey))
                 return false;
             
+            const PropertyKeyId oldKeyId = PropertyKeyTable::table().find(oldKey);
+            if (oldKeyId == PropertyKeyTable::NoId)
+                return false;
+            
             PropertyList::iterator it, end;
             for (it = m_properties.begin(), end = m_properties.end(); it != end; ++it) {
                 Property& property = *it;
-                if (property.key() == oldKey) {
+                if (property.keyId() == oldKeyId) {
                     property.setKey(newKey);
                     assert(!hasDuplicates());
                     return true;
@@ -53,24 +73,30 @@ namespace TrenchBroom {
         }
 
         void PropertyStore::setPropertyValue(const PropertyKey& key, const PropertyValue& value) {
+            const PropertyKeyId keyId = PropertyKeyTable::id(key);
+            
             PropertyList::iterator it, end;
             for (it = m_properties.begin(), end = m_properties.end(); it != end; ++it) {
                 Property& property = *it;
-                if (property.key() == key) {
+                if (property.keyId() == keyId) {
                     property.setValue(value);
                     return;
                 }
             }
             
-            m_properties.push_back(Property(key, value));
+            m_properties.push_back(Property(keyId, value));
             assert(!hasDuplicates());
         }
         
         bool PropertyStore::removeProperty(const PropertyKey& key) {
+            const PropertyKeyId keyId = PropertyKeyTable::table().find(key);
+            if (keyId == PropertyKeyTable::NoId)
+                return false;
+            
             PropertyList::iterator it, end;
             for (it = m_properties.begin(), end = m_properties.end(); it != end; ++it) {
                 Property& property = *it;
-                if (property.key() == key) {
+                if (property.keyId() == keyId) {
                     m_properties.erase(it);
                     return true;
                 }
@@ -22,10 +22,18 @@
 
 #include "Utility/String.h"
 
+#include <cassert>
+#include <deque>
 #include <map>
 #include <set>
 #include <vector>
 
+#if defined _WIN32
+#include <unordered_map>
+#else
+#include <tr1/unordered_map>
+#endif
+
 namespace TrenchBroom {
     namespace Model {
         typedef String PropertyKey;
@@ -33,25 +41,77 @@ namespace TrenchBroom {
         typedef std::vector<PropertyKey> PropertyKeyList;
         typedef std::set<PropertyKey> PropertyKeySet;
         typedef std::pair<PropertyKeySet::iterator, bool> PropertyKeySetInsertResult;
-        typedef std::vector<PropertyValue> PropertyValueList;
+        typedef unsigned int PropertyKeyId;
+
+        /**
+         * Maps every property key that was ever used to a unique id, so that properties can be looked up by comparing
+         * integers instead of strings. Interned keys are never removed.
+         */
+        class PropertyKeyTable {
+        private:
+            typedef std::tr1::unordered_map<PropertyKey, PropertyKeyId> KeyIdMap;
+            
+            KeyIdMap m_ids;
+            std::deque<PropertyKey> m_keys;
+            
+            PropertyKeyTable();
+        public:
+            static const PropertyKeyId NoId;
+            
+            inline static PropertyKeyTable& table() {
+                static PropertyKeyTable table;
+                return table;
+            }
+            
+            inline static PropertyKeyId id(const PropertyKey& key) {
+                return table().intern(key);
+            }
+            
+            PropertyKeyId intern(const PropertyKey& key);
+            
+            inline PropertyKeyId find(const PropertyKey& key) const {
+                KeyIdMap::const_iterator it = m_ids.find(key);
+                if (it == m_ids.end())
+                    return NoId;
+                return it->second;
+            }
+            
+            inline const PropertyKey& key(const PropertyKeyId keyId) const {
+                assert(keyId < m_keys.size());
+                return m_keys[keyId];
+            }
+        };
 
         class Property {
         private:
-            PropertyKey m_key;
+            PropertyKeyId m_keyId;
             PropertyValue m_value;
         public:
-            Property() {}
+            Property() :
+            m_keyId(PropertyKeyTable::id("")) {}
             
             Property(const PropertyKey& key, const PropertyValue& value) :
-            m_key(key),
+            m_keyId(PropertyKeyTable::id(key)),
+            m_value(value) {}
+            
+            Property(const PropertyKeyId keyId, const PropertyValue& value) :
+            m_keyId(keyId),
             m_value(value) {}
             
+            inline PropertyKeyId keyId() const {
+                return m_keyId;
+            }
+            
             inline const PropertyKey& key() const {
-                return m_key;
+                return PropertyKeyTable::table().key(m_keyId);
             }
             
             inline void setKey(const PropertyKey& key) {
-                m_key = key;
+                m_keyId = PropertyKeyTable::id(key);
+            }
+            
+            inline void setKey(const PropertyKeyId keyId) {
+                m_keyId = keyId;
             }
             
             inline const PropertyValue& value() const {
@@ -75,28 +135,39 @@ namespace TrenchBroom {
             
             bool hasDuplicates() const;
         public:
+            inline bool containsProperty(const PropertyKeyId keyId) const {
+                return property(keyId) != NULL;
+            }
+            
             inline bool containsProperty(const PropertyKey& key) const {
-                PropertyList::const_iterator it, end;
-                for (it = m_properties.begin(), end = m_properties.end(); it != end; ++it) {
-                    const Property& property = *it;
-                    if (property.key() == key)
-                        return true;
-                }
-                
-                return false;
+                return property(key) != NULL;
             }
 
-            inline const Property* property(const PropertyKey& key) const {
+            inline const Property* property(const PropertyKeyId keyId) const {
                 PropertyList::const_iterator it, end;
                 for (it = m_properties.begin(), end = m_properties.end(); it != end; ++it) {
                     const Property& property = *it;
-                    if (property.key() == key)
+                    if (property.keyId() == keyId)
                         return &property;
                 }
                 
                 return NULL;
             }
             
+            inline const Property* property(const PropertyKey& key) const {
+                const PropertyKeyId keyId = PropertyKeyTable::table().find(key);
+                if (keyId == PropertyKeyTable::NoId)
+                    return NULL;
+                return property(keyId);
+            }
+            
+            inline const PropertyValue* propertyValue(const PropertyKeyId keyId) const {
+                const Property* prop = property(keyId);
+                if (prop == NULL)
+                    return NULL;
+                return &prop->value();
+            }
+            
             inline const PropertyValue* propertyValue(const PropertyKey& key) const {
                 const Property* prop = property(key);
                 if (prop == NULL)
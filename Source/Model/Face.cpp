@@ -21,6 +21,8 @@
 
 #include "Model/Brush.h"
 #include "Model/BrushGeometry.h"
+#include "Model/Entity.h"
+#include "Model/Map.h"
 #include "Model/Texture.h"
 
 namespace TrenchBroom {
@@ -428,6 +430,7 @@ namespace TrenchBroom {
             m_rotation = faceTemplate.rotation();
             m_xScale = faceTemplate.xScale();
             m_yScale = faceTemplate.yScale();
+            setTextureName(faceTemplate.textureName());
             setTexture(faceTemplate.texture());
             m_texAxesValid = false;
             m_vertexCacheValid = false;
@@ -441,11 +444,26 @@ namespace TrenchBroom {
             
             if (m_brush != NULL && m_selected)
                 m_brush->decSelectedFaceCount();
+            Map* oldMap = map();
             m_brush = brush;
+            Map* newMap = map();
             if (m_brush != NULL && m_selected)
                 m_brush->incSelectedFaceCount();
+
+            if (oldMap != newMap) {
+                if (oldMap != NULL)
+                    oldMap->removeFace(*this);
+                if (newMap != NULL)
+                    newMap->addFace(*this);
+            }
         }
         
+        Map* Face::map() const {
+            if (m_brush == NULL || m_brush->entity() == NULL)
+                return NULL;
+            return m_brush->entity()->map();
+        }
+
         void Face::updatePointsFromVertices() {
             Vec3f v1, v2;
             
@@ -510,6 +528,14 @@ namespace TrenchBroom {
             updatePointsFromBoundary();
         }
 
+        void Face::setTextureName(const String& textureName) {
+            Map* map = this->map();
+            if (map != NULL)
+                map->updateFaceTexture(*this, textureName, m_textureName);
+            m_textureName = textureName;
+            updateContentType();
+        }
+
         void Face::setTexture(Texture* texture) {
             if (texture == m_texture)
                 return;
@@ -518,8 +544,12 @@ namespace TrenchBroom {
                 m_texture->decUsageCount();
             
             m_texture = texture;
-            if (m_texture != NULL)
+            if (m_texture != NULL && m_textureName != texture->name()) {
+                Map* map = this->map();
+                if (map != NULL)
+                    map->updateFaceTexture(*this, texture->name(), m_textureName);
                 m_textureName = texture->name();
+            }
             
             if (m_texture != NULL)
                 m_texture->incUsageCount();
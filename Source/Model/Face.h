@@ -33,6 +33,7 @@ using namespace TrenchBroom::VecMath;
 namespace TrenchBroom {
     namespace Model {
         class Brush;
+        class Map;
         class Texture;
 
         class Face;
@@ -167,6 +168,7 @@ namespace TrenchBroom {
             }
 
             void setBrush(Brush* brush);
+            Map* map() const;
 
             inline Side* side() const {
                 return m_side;
@@ -235,10 +237,7 @@ namespace TrenchBroom {
                 return m_textureName;
             }
 
-            inline void setTextureName(const String& textureName) {
-                m_textureName = textureName;
-                updateContentType();
-            }
+            void setTextureName(const String& textureName);
 
             inline Texture* texture() const {
                 return m_texture;
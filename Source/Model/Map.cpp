@@ -21,8 +21,11 @@
 
 #include "Model/Brush.h"
 #include "Model/Entity.h"
+#include "Model/Face.h"
 #include "Utility/List.h"
 
+#include <cstdlib>
+
 namespace TrenchBroom {
     namespace Model {
         void Map::addEntityTargetname(Entity& entity, const String* targetname) {
@@ -104,6 +107,60 @@ namespace TrenchBroom {
                 removeEntityKillTarget(entity, &*it);
         }
 
+        bool Map::isIndexedProperty(const PropertyKeyId keyId) {
+            return (keyId == Entity::ClassnameKeyId ||
+                    keyId == Entity::SpawnFlagsKeyId ||
+                    keyId == Entity::TargetnameKeyId ||
+                    keyId == Entity::TargetKeyId ||
+                    keyId == Entity::KillTargetKeyId);
+        }
+        
+        void Map::addEntityProperty(Entity& entity, const PropertyKeyId keyId, const PropertyValue& value) {
+            if (isIndexedProperty(keyId))
+                m_entitiesWithProperty[keyId][value].insert(&entity);
+        }
+        
+        void Map::removeEntityProperty(Entity& entity, const PropertyKeyId keyId, const PropertyValue& value) {
+            if (!isIndexedProperty(keyId))
+                return;
+            
+            PropertyEntityMap::iterator keyIt = m_entitiesWithProperty.find(keyId);
+            if (keyIt == m_entitiesWithProperty.end())
+                return;
+            
+            ValueEntityMap& values = keyIt->second;
+            ValueEntityMap::iterator valueIt = values.find(value);
+            if (valueIt != values.end()) {
+                valueIt->second.erase(&entity);
+                if (valueIt->second.empty()) {
+                    values.erase(valueIt);
+                    if (values.empty())
+                        m_entitiesWithProperty.erase(keyIt);
+                }
+            }
+        }
+        
+        void Map::addEntityProperties(Entity& entity) {
+            const PropertyList& properties = entity.properties();
+            PropertyList::const_iterator it, end;
+            for (it = properties.begin(), end = properties.end(); it != end; ++it)
+                addEntityProperty(entity, it->keyId(), it->value());
+        }
+        
+        void Map::addFaceTexture(Face& face, const String& textureName) {
+            m_facesWithTexture[Utility::toLower(textureName)].insert(&face);
+        }
+        
+        void Map::removeFaceTexture(Face& face, const String& textureName) {
+            typedef TextureFaceMap::iterator MapIt;
+            MapIt it = m_facesWithTexture.find(Utility::toLower(textureName));
+            if (it != m_facesWithTexture.end()) {
+                it->second.erase(&face);
+                if (it->second.empty())
+                    m_facesWithTexture.erase(it);
+            }
+        }
+
         Map::Map(const BBoxf& worldBounds, bool forceIntegerFacePoints) :
         m_worldBounds(worldBounds),
         m_forceIntegerFacePoints(forceIntegerFacePoints),
@@ -134,6 +191,7 @@ namespace TrenchBroom {
                 addEntityTargetname(entity, entity.propertyForKey(Entity::TargetnameKey));
                 addEntityTargets(entity);
                 addEntityKillTargets(entity);
+                addEntityProperties(entity);
                 entity.setMap(this);
             }
         }
@@ -145,6 +203,7 @@ namespace TrenchBroom {
             removeEntityTargetname(entity, entity.propertyForKey(Entity::TargetnameKey));
             removeEntityTargets(entity);
             removeEntityKillTargets(entity);
+            removeEntityProperties(entity);
             Utility::erase(m_entities, &entity);
         }
 
@@ -188,6 +247,98 @@ namespace TrenchBroom {
             addEntityKillTarget(entity, newTargetname);
         }
 
+        const Map::ValueEntityMap* Map::entitiesWithProperty(const PropertyKey& key) const {
+            const PropertyKeyId keyId = PropertyKeyTable::table().find(key);
+            if (keyId == PropertyKeyTable::NoId)
+                return NULL;
+            
+            PropertyEntityMap::const_iterator it = m_entitiesWithProperty.find(keyId);
+            if (it == m_entitiesWithProperty.end())
+                return NULL;
+            return &it->second;
+        }
+        
+        EntityList Map::entitiesWithProperty(const PropertyKey& key, const PropertyValue& value) const {
+            const ValueEntityMap* values = entitiesWithProperty(key);
+            if (values == NULL)
+                return EmptyEntityList;
+            
+            ValueEntityMap::const_iterator it = values->find(value);
+            if (it == values->end())
+                return EmptyEntityList;
+            return Utility::makeList(it->second);
+        }
+        
+        EntityList Map::entitiesWithFlag(const PropertyKey& key, const int flag) const {
+            const ValueEntityMap* values = entitiesWithProperty(key);
+            if (values == NULL)
+                return EmptyEntityList;
+            
+            EntityList result;
+            ValueEntityMap::const_iterator it, end;
+            for (it = values->begin(), end = values->end(); it != end; ++it) {
+                const int flags = std::atoi(it->first.c_str());
+                if ((flags & flag) != 0)
+                    result.insert(result.end(), it->second.begin(), it->second.end());
+            }
+            return result;
+        }
+        
+        void Map::updateEntityProperty(Entity& entity, const PropertyKey& key, const PropertyValue* newValue, const PropertyValue* oldValue) {
+            const PropertyKeyId keyId = PropertyKeyTable::table().find(key);
+            if (!isIndexedProperty(keyId))
+                return;
+            
+            if (oldValue != NULL)
+                removeEntityProperty(entity, keyId, *oldValue);
+            if (newValue != NULL)
+                addEntityProperty(entity, keyId, *newValue);
+        }
+        
+        void Map::removeEntityProperties(Entity& entity) {
+            const PropertyList& properties = entity.properties();
+            PropertyList::const_iterator it, end;
+            for (it = properties.begin(), end = properties.end(); it != end; ++it)
+                removeEntityProperty(entity, it->keyId(), it->value());
+        }
+        
+        void Map::addFace(Face& face) {
+            addFaceTexture(face, face.textureName());
+        }
+        
+        void Map::removeFace(Face& face) {
+            removeFaceTexture(face, face.textureName());
+        }
+        
+        void Map::addBrushFaces(Brush& brush) {
+            const FaceList& faces = brush.faces();
+            FaceList::const_iterator it, end;
+            for (it = faces.begin(), end = faces.end(); it != end; ++it)
+                addFace(**it);
+        }
+        
+        void Map::removeBrushFaces(Brush& brush) {
+            const FaceList& faces = brush.faces();
+            FaceList::const_iterator it, end;
+            for (it = faces.begin(), end = faces.end(); it != end; ++it)
+                removeFace(**it);
+        }
+        
+        FaceList Map::facesWithTexture(const String& textureName) const {
+            typedef TextureFaceMap::const_iterator MapIt;
+            MapIt it = m_facesWithTexture.find(Utility::toLower(textureName));
+            if (it == m_facesWithTexture.end())
+                return EmptyFaceList;
+            return Utility::makeList(it->second);
+        }
+        
+        void Map::updateFaceTexture(Face& face, const String& newTextureName, const String& oldTextureName) {
+            if (Utility::equalsString(newTextureName, oldTextureName, false))
+                return;
+            removeFaceTexture(face, oldTextureName);
+            addFaceTexture(face, newTextureName);
+        }
+
         Entity* Map::worldspawn() {
             for (unsigned int i = 0; i < m_entities.size() && m_worldspawn == NULL; i++) {
                 Entity* entity = m_entities[i];
@@ -202,7 +353,9 @@ namespace TrenchBroom {
             m_entitiesWithTargetname.clear();
             m_entitiesWithTarget.clear();
             m_entitiesWithKillTarget.clear();
+            m_entitiesWithProperty.clear();
             Utility::deleteAll(m_entities);
+            m_facesWithTexture.clear();
             m_worldspawn = NULL;
         }
     }
@@ -20,7 +20,9 @@
 #ifndef __TrenchBroom__Map__
 #define __TrenchBroom__Map__
 
+#include "Model/EntityProperty.h"
 #include "Model/EntityTypes.h"
+#include "Model/FaceTypes.h"
 #include "Utility/VecMath.h"
 
 #include <map>
@@ -29,10 +31,16 @@ using namespace TrenchBroom::VecMath;
 
 namespace TrenchBroom {
     namespace Model {
+        class Brush;
         class Entity;
+        class Face;
         
         class Map {
+        public:
+            typedef std::map<String, FaceSet> TextureFaceMap;
+            typedef std::map<PropertyValue, EntitySet> ValueEntityMap;
         protected:
+            typedef std::map<PropertyKeyId, ValueEntityMap> PropertyEntityMap;
             typedef std::map<String, EntitySet> TargetnameEntityMap;
             
             BBoxf m_worldBounds;
@@ -41,6 +49,8 @@ namespace TrenchBroom {
             TargetnameEntityMap m_entitiesWithTargetname;
             TargetnameEntityMap m_entitiesWithTarget;
             TargetnameEntityMap m_entitiesWithKillTarget;
+            PropertyEntityMap m_entitiesWithProperty;
+            TextureFaceMap m_facesWithTexture;
             Entity* m_worldspawn;
             
             void addEntityTargetname(Entity& entity, const String* targetname);
@@ -55,6 +65,14 @@ namespace TrenchBroom {
             void removeEntityKillTarget(Entity& entity, const String* targetname);
             void addEntityKillTargets(Entity& entity);
             void removeEntityKillTargets(Entity& entity);
+            
+            static bool isIndexedProperty(PropertyKeyId keyId);
+            void addEntityProperty(Entity& entity, PropertyKeyId keyId, const PropertyValue& value);
+            void removeEntityProperty(Entity& entity, PropertyKeyId keyId, const PropertyValue& value);
+            void addEntityProperties(Entity& entity);
+
+            void addFaceTexture(Face& face, const String& textureName);
+            void removeFaceTexture(Face& face, const String& textureName);
         public:
             Map(const BBoxf& worldBounds, bool forceIntegerFacePoints);
             ~Map();
@@ -81,6 +99,34 @@ namespace TrenchBroom {
             EntityList entitiesWithKillTarget(const String& targetname) const;
             void updateEntityKillTarget(Entity& entity, const String* newTargetname, const String* oldTargetname);
             
+            /**
+             * Maps the values of the given property key to the entities of this map which have that property set to
+             * the respective value. Returns NULL if no entity has the property. Only the classname, spawnflags,
+             * targetname, target and killtarget properties are indexed, since their values are shared by many
+             * entities. Returns NULL for all other keys.
+             */
+            const ValueEntityMap* entitiesWithProperty(const PropertyKey& key) const;
+            EntityList entitiesWithProperty(const PropertyKey& key, const PropertyValue& value) const;
+            EntityList entitiesWithFlag(const PropertyKey& key, int flag) const;
+            void updateEntityProperty(Entity& entity, const PropertyKey& key, const PropertyValue* newValue, const PropertyValue* oldValue);
+            void removeEntityProperties(Entity& entity);
+            
+            void addFace(Face& face);
+            void removeFace(Face& face);
+            void addBrushFaces(Brush& brush);
+            void removeBrushFaces(Brush& brush);
+            
+            /**
+             * Maps lower case texture names to the faces of this map which use them, regardless of whether the
+             * texture is loaded or not.
+             */
+            inline const TextureFaceMap& facesWithTexture() const {
+                return m_facesWithTexture;
+            }
+            
+            FaceList facesWithTexture(const String& textureName) const;
+            void updateFaceTexture(Face& face, const String& newTextureName, const String& oldTextureName);
+            
             inline const EntityList& entities() const {
                 return m_entities;
             }
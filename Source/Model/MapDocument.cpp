@@ -22,7 +22,9 @@
 #include "Controller/Autosaver.h"
 #include "Controller/Command.h"
 #include "IO/FileManager.h"
+#include "IO/GameFileSystem.h"
 #include "IO/IOException.h"
+#include "IO/MapCache.h"
 #include "IO/MapParser.h"
 #include "IO/MapWriter.h"
 #include "IO/Wad.h"
@@ -76,7 +78,7 @@ namespace TrenchBroom {
                 console().info("Loading file %s", file.mbc_str().data());
                 
                 View::ProgressIndicatorDialog progressIndicator;
-                loadMap(mappedFile->begin(), mappedFile->end(), progressIndicator);
+                loadMap(path, mappedFile->begin(), mappedFile->end(), progressIndicator);
                 loadTextures();
                 loadEntityDefinitionFile();
 
@@ -96,10 +98,15 @@ namespace TrenchBroom {
 
         bool MapDocument::DoSaveDocument(const wxString& file) {
             try {
+                const String path = file.ToStdString();
                 wxStopWatch watch;
                 IO::MapWriter mapWriter;
-                mapWriter.writeToFileAtPath(*m_map, file.ToStdString(), true);
-                console().info("Saved map file to %s in %f seconds", file.ToStdString().c_str(), watch.Time() / 1000.0f);
+                mapWriter.writeToFileAtPath(*m_map, path, true);
+                console().info("Saved map file to %s in %f seconds", path.c_str(), watch.Time() / 1000.0f);
+
+                Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
+                if (prefs.getBool(Preferences::UseMapCache))
+                    writeMapCache(path);
                 return true;
             } catch (IO::IOException& e) {
                 console().error(e.what());
@@ -128,40 +135,73 @@ namespace TrenchBroom {
             m_sharedResources->loadPalette(palettePath);
         }
 
-        void MapDocument::loadMap(char* begin, char* end, Utility::ProgressIndicator& progressIndicator) {
+        void MapDocument::loadMap(const String& path, char* begin, char* end, Utility::ProgressIndicator& progressIndicator) {
             progressIndicator.setText("Loading map file...");
             
+            Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
+            const bool useCache = prefs.getBool(Preferences::UseMapCache);
+            IO::MapCache cache(path);
+
             wxStopWatch watch;
+            if (useCache && cache.read(*m_map, begin, end)) {
+                console().info("Loaded map file from cache in %f seconds", watch.Time() / 1000.0f);
+                return;
+            }
+
             IO::MapParser parser(begin, end, console());
-            parser.parseMap(*m_map, &progressIndicator);
+            const bool parsed = parser.parseMap(*m_map, &progressIndicator);
             
             console().info("Loaded map file in %f seconds", watch.Time() / 1000.0f);
+
+            // the map was just parsed from this file, so its contents are exactly what the cache must restore; if the
+            // parser stopped at an error, the map is incomplete and must be parsed again next time to report it
+            if (useCache && parsed && !cache.write(*m_map, begin, end, false))
+                console().warn("Could not write map cache %s", cache.path().c_str());
+        }
+
+        void MapDocument::writeMapCache(const String& path) {
+            IO::FileManager fileManager;
+            IO::MappedFile::Ptr mappedFile = fileManager.mapFile(path);
+            if (mappedFile.get() == NULL)
+                return;
+
+            IO::MapCache cache(path);
+            if (!cache.write(*m_map, mappedFile->begin(), mappedFile->end(), true)) {
+                // don't leave a cache behind that belongs to an older version of the file
+                if (fileManager.exists(cache.path()))
+                    fileManager.deleteFile(cache.path());
+                console().warn("Could not write map cache %s", cache.path().c_str());
+            }
         }
 
         void MapDocument::setAllTexturesToNull() {
-            const Model::EntityList& entities = m_map->entities();
-            for (size_t i = 0; i < entities.size(); i++) {
-                const Model::BrushList& brushes = entities[i]->brushes();
-                for (size_t j = 0; j < brushes.size(); j++) {
-                    const Model::FaceList& faces = brushes[j]->faces();
-                    for (size_t k = 0; k < faces.size(); k++) {
-                        faces[k]->setTexture(NULL);
-                    }
-                }
+            const Model::Map::TextureFaceMap& facesWithTexture = m_map->facesWithTexture();
+            Model::Map::TextureFaceMap::const_iterator textureIt, textureEnd;
+            for (textureIt = facesWithTexture.begin(), textureEnd = facesWithTexture.end(); textureIt != textureEnd; ++textureIt) {
+                const Model::FaceSet& faces = textureIt->second;
+                Model::FaceSet::const_iterator faceIt, faceEnd;
+                for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt)
+                    (*faceIt)->setTexture(NULL);
             }
         }
 
         void MapDocument::refreshAllTextures() {
-            const Model::EntityList& entities = m_map->entities();
-            for (size_t i = 0; i < entities.size(); i++) {
-                const Model::BrushList& brushes = entities[i]->brushes();
-                for (size_t j = 0; j < brushes.size(); j++) {
-                    const Model::FaceList& faces = brushes[j]->faces();
-                    for (size_t k = 0; k < faces.size(); k++) {
-                        const String& textureName = faces[k]->textureName();
-                        Model::Texture* newTexture = m_textureManager->texture(textureName);
-                        faces[k]->setTexture(newTexture);
+            // the faces are grouped by their lower case texture name, so the texture lookup can mostly be shared
+            const Model::Map::TextureFaceMap& facesWithTexture = m_map->facesWithTexture();
+            Model::Map::TextureFaceMap::const_iterator textureIt, textureEnd;
+            for (textureIt = facesWithTexture.begin(), textureEnd = facesWithTexture.end(); textureIt != textureEnd; ++textureIt) {
+                const Model::FaceSet& faces = textureIt->second;
+                String textureName;
+                Model::Texture* texture = NULL;
+
+                Model::FaceSet::const_iterator faceIt, faceEnd;
+                for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt) {
+                    Model::Face& face = **faceIt;
+                    if (faceIt == faces.begin() || face.textureName() != textureName) {
+                        textureName = face.textureName();
+                        texture = m_textureManager->texture(textureName);
                     }
+                    face.setTexture(texture);
                 }
             }
             
@@ -500,6 +540,8 @@ namespace TrenchBroom {
         
         void MapDocument::invalidateSearchPaths() {
             m_searchPathsValid = false;
+            // the search paths or the mod changed, so the paks may have been added, removed or replaced
+            IO::GameFileSystem::sharedFileSystem->refresh();
         }
 
         bool MapDocument::pointFileExists() {
@@ -511,7 +553,9 @@ namespace TrenchBroom {
 
             if (m_pointFile != NULL)
                 unloadPointFile();
-            m_pointFile = new PointFile(GetFilename().ToStdString());
+
+            View::ProgressIndicatorDialog progressIndicator;
+            m_pointFile = new PointFile(GetFilename().ToStdString(), &progressIndicator);
         }
         
         void MapDocument::unloadPointFile() {
@@ -582,12 +626,17 @@ namespace TrenchBroom {
             m_definitionManager->clear();
             m_definitionManager->load(definitionPath);
 
-            for (unsigned int i = 0; i < entities.size(); i++) {
-                Entity& entity = *entities[i];
-                const PropertyValue* classname = entity.classname();
-                if (classname != NULL) {
-                    EntityDefinition* definition = m_definitionManager->definition(*classname);
-                    entity.setDefinition(definition);
+            const Map::ValueEntityMap* classnames = m_map->entitiesWithProperty(Entity::ClassnameKey);
+            if (classnames != NULL) {
+                Map::ValueEntityMap::const_iterator classnameIt, classnameEnd;
+                for (classnameIt = classnames->begin(), classnameEnd = classnames->end(); classnameIt != classnameEnd; ++classnameIt) {
+                    EntityDefinition* definition = m_definitionManager->definition(classnameIt->first);
+                    const EntitySet& classnameEntities = classnameIt->second;
+                    EntitySet::const_iterator entityIt, entityEnd;
+                    for (entityIt = classnameEntities.begin(), entityEnd = classnameEntities.end(); entityIt != entityEnd; ++entityIt) {
+                        Entity& entity = **entityIt;
+                        entity.setDefinition(definition);
+                    }
                 }
             }
             
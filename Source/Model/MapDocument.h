@@ -86,7 +86,8 @@ namespace TrenchBroom {
             void clear();
 
             void loadPalette();
-            void loadMap(char* begin, char* end, Utility::ProgressIndicator& progressIndicator);
+            void loadMap(const String& path, char* begin, char* end, Utility::ProgressIndicator& progressIndicator);
+            void writeMapCache(const String& path);
 
             void setAllTexturesToNull();
             void refreshAllTextures();
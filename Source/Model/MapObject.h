@@ -144,6 +144,10 @@ namespace TrenchBroom {
                 return m_fileFirstLine;
             }
             
+            inline size_t fileLineCount() const {
+                return m_fileLineCount;
+            }
+            
             inline bool occupiesFileLine(size_t line) const {
                 return line >= m_fileFirstLine && line < m_fileFirstLine + m_fileLineCount;
             }
@@ -23,6 +23,7 @@
 #include "Model/Entity.h"
 #include "Model/Map.h"
 #include "Model/MapObject.h"
+#include "Utility/Profiler.h"
 
 #include <algorithm>
 #include <cmath>
@@ -120,6 +121,7 @@ namespace TrenchBroom {
                     if (addObject(object, i))
                         return true;
             m_objects.push_back(&object);
+            m_objectBounds.add(object.bounds());
             return true;
         }
         
@@ -140,7 +142,10 @@ namespace TrenchBroom {
             if (it == m_objects.end())
                 return false;
 
-            m_objects.erase(it);
+            const size_t index = static_cast<size_t>(std::distance(m_objects.begin(), it));
+            m_objects[index] = m_objects.back();
+            m_objects.pop_back();
+            m_objectBounds.swapRemove(index);
             return true;
         }
         
@@ -162,12 +167,19 @@ namespace TrenchBroom {
             return count;
         }
 
-        void OctreeNode::intersect(const Rayf& ray, MapObjectList& objects) {
+        void OctreeNode::intersect(const Rayf& ray, MapObjectList& objects, std::vector<float>& distances) {
+            Utility::Profiler::profiler().count(Utility::Profiler::OctreeNodesVisited);
             if (m_bounds.contains(ray.origin) || !Math<float>::isnan(m_bounds.intersectWithRay(ray))) {
-                objects.insert(objects.end(), m_objects.begin(), m_objects.end());
+                if (!m_objects.empty()) {
+                    distances.resize(m_objects.size());
+                    m_objectBounds.intersectWithRay(ray, &distances[0]);
+                    for (size_t i = 0; i < m_objects.size(); i++)
+                        if (!Math<float>::isnan(distances[i]))
+                            objects.push_back(m_objects[i]);
+                }
                 for (unsigned int i = 0; i < 8; i++)
                     if (m_children[i] != NULL)
-                        m_children[i]->intersect(ray, objects);
+                        m_children[i]->intersect(ray, objects, distances);
             }
         }
         
@@ -233,7 +245,8 @@ namespace TrenchBroom {
 
         MapObjectList Octree::intersect(const Rayf& ray) {
             MapObjectList result;
-            m_root->intersect(ray, result);
+            std::vector<float> distances;
+            m_root->intersect(ray, result, distances);
             return result;
         }
     }
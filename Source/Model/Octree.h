@@ -24,6 +24,7 @@
 #include "Model/BrushTypes.h"
 #include "Model/EntityTypes.h"
 #include "Model/MapObjectTypes.h"
+#include "Utility/IntersectionBatch.h"
 #include "Utility/VecMath.h"
 
 using namespace TrenchBroom::VecMath;
@@ -48,6 +49,7 @@ namespace TrenchBroom {
             unsigned int m_minSize;
             BBoxf m_bounds;
             MapObjectList m_objects;
+            BBoxBatch m_objectBounds;
             OctreeNode* m_children[8];
             bool addObject(MapObject& object, unsigned int childIndex);
         public:
@@ -57,7 +59,7 @@ namespace TrenchBroom {
             bool removeObject(MapObject& object);
             bool empty() const;
             size_t count() const;
-            void intersect(const Rayf& ray, MapObjectList& objects);
+            void intersect(const Rayf& ray, MapObjectList& objects, std::vector<float>& distances);
         };
         
         class Octree {
@@ -78,6 +80,9 @@ namespace TrenchBroom {
             
             size_t count() const;
 
+            /**
+             * Returns the objects whose bounds are hit by the given ray.
+             */
             MapObjectList intersect(const Rayf& ray);
         };
     }
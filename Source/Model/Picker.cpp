@@ -21,6 +21,7 @@
 #include "Model/Face.h"
 #include "Model/MapObject.h"
 #include "Model/Octree.h"
+#include "Utility/Profiler.h"
 
 #include <algorithm>
 
@@ -114,6 +115,7 @@ namespace TrenchBroom {
         Picker::Picker(Octree& octree) : m_octree(octree) {}
 
         PickResult* Picker::pick(const Rayf& ray) {
+            Utility::Profiler::ScopedTimer timer(Utility::Profiler::PickTime);
             PickResult* pickResults = new PickResult();
 
             MapObjectList objects = m_octree.intersect(ray);
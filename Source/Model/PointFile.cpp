@@ -21,8 +21,9 @@
 
 #include "Controller/CameraEvent.h"
 #include "IO/FileManager.h"
+#include "Utility/ProgressIndicator.h"
 
-#include <fstream>
+#include <cmath>
 
 namespace TrenchBroom {
     namespace Model {
@@ -32,42 +33,107 @@ namespace TrenchBroom {
             return fileManager.appendExtension(mapFileBasePath, ".pts");
         }
 
-        void PointFile::load(const String& mapFilePath) {
-            static const float threshold = Math<float>::radians(15.0f);
-            
-            String pointFilePath = path(mapFilePath);
-            std::fstream stream(pointFilePath.c_str(), std::ios_base::in);
-            assert(stream.is_open());
+        bool PointFile::parseFloat(const char*& cur, const char* end, float& value) {
+            while (cur < end && (*cur == ' ' || *cur == '\t' || *cur == '\r' || *cur == '\n'))
+                ++cur;
+            if (cur == end)
+                return false;
+
+            bool negative = false;
+            if (*cur == '-' || *cur == '+')
+                negative = *cur++ == '-';
+
+            const char* digits = cur;
+            double mantissa = 0.0;
+            while (cur < end && *cur >= '0' && *cur <= '9')
+                mantissa = 10.0 * mantissa + (*cur++ - '0');
+
+            if (cur < end && *cur == '.') {
+                ++cur;
+                double scale = 0.1;
+                while (cur < end && *cur >= '0' && *cur <= '9') {
+                    mantissa += scale * (*cur++ - '0');
+                    scale *= 0.1;
+                }
+            }
+
+            if (cur == digits || (cur == digits + 1 && *digits == '.'))
+                return false;
+
+            if (cur < end && (*cur == 'e' || *cur == 'E')) {
+                ++cur;
+                bool negativeExponent = false;
+                if (cur < end && (*cur == '-' || *cur == '+'))
+                    negativeExponent = *cur++ == '-';
+                int exponent = 0;
+                while (cur < end && *cur >= '0' && *cur <= '9')
+                    exponent = 10 * exponent + (*cur++ - '0');
+                mantissa *= std::pow(10.0, negativeExponent ? -exponent : exponent);
+            }
+
+            value = static_cast<float>(negative ? -mantissa : mantissa);
+            return true;
+        }
+
+        bool PointFile::parsePoint(const char*& cur, const char* end, Vec3f& point) {
+            return (parseFloat(cur, end, point[0]) &&
+                    parseFloat(cur, end, point[1]) &&
+                    parseFloat(cur, end, point[2]));
+        }
+
+        void PointFile::load(const String& mapFilePath, Utility::ProgressIndicator* indicator) {
+            // a point is kept if the trace turns by more than 15 degrees there
+            static const float threshold = std::cos(Math<float>::radians(15.0f));
+            static const size_t ProgressInterval = 0x10000;
+
+            IO::FileManager fileManager;
+            IO::MappedFile::Ptr file = fileManager.mapFile(path(mapFilePath));
+            assert(file.get() != NULL);
+
+            const char* begin = file->begin();
+            const char* cur = begin;
+            const char* end = file->end();
+            const size_t size = file->size();
+
+            if (indicator != NULL) {
+                indicator->setText("Loading point file...");
+                indicator->reset(100);
+            }
 
             Vec3f::List points;
-            
-            String line;
-            if (!stream.eof()) {
-                std::getline(stream, line);
-                points.push_back(Vec3f(line));
-                Vec3f lastPoint = points.back();
-                
-                if (!stream.eof()) {
-                    std::getline(stream, line);
-                    Vec3f curPoint(line);
-                    Vec3f refDir = (curPoint - lastPoint).normalized();
-                    
-                    while (!stream.eof()) {
-                        lastPoint = curPoint;
-                        std::getline(stream, line);
-                        curPoint = Vec3f(line);
-                        
-                        Vec3f dir = (curPoint - lastPoint).normalized();
-                        if (std::acos(dir.dot(refDir)) > threshold) {
+
+            Vec3f lastPoint, curPoint;
+            if (parsePoint(cur, end, curPoint)) {
+                points.push_back(curPoint);
+
+                Vec3f refDir;
+                bool hasRefDir = false;
+                size_t count = 1;
+
+                lastPoint = curPoint;
+                while (parsePoint(cur, end, curPoint)) {
+                    Vec3f dir = curPoint - lastPoint;
+                    const float length = dir.length();
+                    if (length > 0.0f) {
+                        dir /= length;
+                        if (!hasRefDir) {
+                            refDir = dir;
+                            hasRefDir = true;
+                        } else if (dir.dot(refDir) < threshold) {
                             points.push_back(lastPoint);
                             refDir = dir;
                         }
+                        lastPoint = curPoint;
                     }
-                    
-                    points.push_back(curPoint);
+
+                    if (indicator != NULL && ++count % ProgressInterval == 0)
+                        indicator->update(static_cast<int>(100 * static_cast<size_t>(cur - begin) / size));
                 }
+
+                if (!points.back().equals(lastPoint))
+                    points.push_back(lastPoint);
             }
-            
+
             if (points.size() > 1) {
                 for (size_t i = 0; i < points.size() - 1; i++) {
                     const Vec3f& curPoint = points[i];
@@ -81,13 +147,18 @@ namespace TrenchBroom {
                         m_points.push_back(curPoint + dir * static_cast<float>(j) * 64.0f);
                 }
                 m_points.push_back(points.back());
+            } else {
+                m_points = points;
             }
+
+            if (indicator != NULL)
+                indicator->update(100);
         }
         
-        PointFile::PointFile(const String& mapFilePath) :
+        PointFile::PointFile(const String& mapFilePath, Utility::ProgressIndicator* indicator) :
         m_current(0) {
             assert(exists(mapFilePath));
-            load(mapFilePath);
+            load(mapFilePath, indicator);
         }
         
         bool PointFile::exists(const String& mapFilePath) {
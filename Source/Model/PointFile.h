@@ -28,6 +28,10 @@
 using namespace TrenchBroom::VecMath;
 
 namespace TrenchBroom {
+    namespace Utility {
+        class ProgressIndicator;
+    }
+
     namespace Model {
         class PointFile {
         private:
@@ -35,9 +39,11 @@ namespace TrenchBroom {
             size_t m_current;
             
             static String path(const String& mapFilePath);
-            void load(const String& mapFilePath);
+            static bool parseFloat(const char*& cur, const char* end, float& value);
+            static bool parsePoint(const char*& cur, const char* end, Vec3f& point);
+            void load(const String& mapFilePath, Utility::ProgressIndicator* indicator);
         public:
-            PointFile(const String& mapFilePath);
+            PointFile(const String& mapFilePath, Utility::ProgressIndicator* indicator = NULL);
             static bool exists(const String& mapFilePath);
             
             inline bool hasNextPoint() const {
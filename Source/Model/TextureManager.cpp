@@ -87,6 +87,8 @@ namespace TrenchBroom {
             m_texturesCaseInsensitive.clear();
             m_texturesByName.clear();
             m_texturesByUsage.clear();
+            m_nameIndex.clear();
+            m_nameIndexValid = false;
 
             typedef std::pair<TextureMap::iterator, bool> InsertResult;
 
@@ -118,6 +120,9 @@ namespace TrenchBroom {
             std::sort(m_texturesByName.begin(), m_texturesByName.end(), CompareTexturesByName());
         }
 
+        TextureManager::TextureManager() :
+        m_nameIndexValid(false) {}
+        
         TextureManager::~TextureManager() {
             clear();
         }
@@ -162,7 +167,22 @@ namespace TrenchBroom {
             m_texturesByName.clear();
             m_texturesByUsage.clear();
             m_collectionMap.clear();
+            m_nameIndex.clear();
+            m_nameIndexValid = false;
             Utility::deleteAll(m_collections);
         }
+
+        void TextureManager::findTextures(const String& pattern, TextureList& result) const {
+            if (!m_nameIndexValid) {
+                for (size_t i = 0; i < m_collections.size(); i++) {
+                    const TextureList& textures = m_collections[i]->textures();
+                    for (size_t j = 0; j < textures.size(); j++)
+                        m_nameIndex.add(textures[j]->name(), textures[j]);
+                }
+                m_nameIndexValid = true;
+            }
+            
+            m_nameIndex.find(pattern, result);
+        }
     }
 }
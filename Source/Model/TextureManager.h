@@ -25,6 +25,7 @@
 #include "Model/TextureTypes.h"
 #include "Utility/Color.h"
 #include "Utility/String.h"
+#include "Utility/TrigramIndex.h"
 
 #include <algorithm>
 #include <map>
@@ -63,6 +64,20 @@ namespace TrenchBroom {
             }
         };
 
+        /**
+         * Sorts the given textures by usage unless they already are. The usage counts are maintained incrementally
+         * and rarely change between two requests for this order, so the linear check usually suffices.
+         */
+        inline void sortTexturesByUsage(TextureList& textures) {
+            CompareTexturesByUsage compare;
+            for (size_t i = 1; i < textures.size(); i++) {
+                if (compare(textures[i], textures[i - 1])) {
+                    std::sort(textures.begin(), textures.end(), compare);
+                    return;
+                }
+            }
+        }
+
         class TextureCollectionLoader {
         protected:
             IO::Wad m_wad;
@@ -91,7 +106,7 @@ namespace TrenchBroom {
             inline TextureList textures(TextureSortOrder::Type order) const {
                 if (order == TextureSortOrder::Name)
                     return m_texturesByName;
-                std::sort(m_texturesByUsage.begin(), m_texturesByUsage.end(), CompareTexturesByUsage());
+                sortTexturesByUsage(m_texturesByUsage);
                 return m_texturesByUsage;
             }
             
@@ -117,8 +132,11 @@ namespace TrenchBroom {
             TextureMap m_texturesCaseInsensitive;
             TextureList m_texturesByName;
             mutable TextureList m_texturesByUsage;
+            mutable Utility::TrigramIndex<Texture*> m_nameIndex;
+            mutable bool m_nameIndexValid;
             void reloadTextures();
         public:
+            TextureManager();
             ~TextureManager();
             
             void addCollection(TextureCollection* collection, size_t index);
@@ -133,10 +151,16 @@ namespace TrenchBroom {
             inline const TextureList textures(TextureSortOrder::Type order) {
                 if (order == TextureSortOrder::Name)
                     return m_texturesByName;
-                std::sort(m_texturesByUsage.begin(), m_texturesByUsage.end(), CompareTexturesByUsage());
+                sortTexturesByUsage(m_texturesByUsage);
                 return m_texturesByUsage;
             }
             
+            /**
+             * Appends all textures of all collections whose names contain the given pattern, ignoring case, to the
+             * given list. The result is not sorted.
+             */
+            void findTextures(const String& pattern, TextureList& result) const;
+            
             inline Texture* texture(const std::string& name) {
                 TextureMap::iterator it = m_texturesCaseSensitive.find(name);
                 if (it == m_texturesCaseSensitive.end()) {
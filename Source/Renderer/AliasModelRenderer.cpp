@@ -52,27 +52,24 @@ namespace TrenchBroom {
         void AliasModelRenderer::render(ShaderProgram& shaderProgram) {
             if (m_vertexArray == NULL) {
                 assert(m_skinIndex < m_alias.skins().size());
-                assert(m_frameIndex < m_alias.frames().size());
+                assert(m_frameIndex < m_alias.frameCount());
                 
                 Model::AliasSkin& skin = *m_alias.skins()[m_skinIndex];
                 m_texture = TextureRendererPtr(new TextureRenderer(skin, 0, m_palette));
 
                 Model::AliasSingleFrame& frame = m_alias.frame(m_frameIndex);
-                const Model::AliasFrameTriangleList& triangles = frame.triangles();
-                unsigned int vertexCount = static_cast<unsigned int>(3 * triangles.size());
+                const Model::AliasFrameVertexList& vertices = frame.vertices();
+                unsigned int vertexCount = static_cast<unsigned int>(vertices.size());
                 
                 m_vertexArray = new VertexArray(m_vbo, GL_TRIANGLES, vertexCount,
                                                 Attribute::position3f(),
                                                 Attribute::texCoord02f());
 
                 SetVboState mapVbo(m_vbo, Vbo::VboMapped);
-                for (unsigned int i = 0; i < triangles.size(); i++) {
-                    Model::AliasFrameTriangle& triangle = *triangles[i];
-                    for (unsigned int j = 0; j < 3; j++) {
-                        Model::AliasFrameVertex& vertex = triangle[j];
-                        m_vertexArray->addAttribute(vertex.position());
-                        m_vertexArray->addAttribute(vertex.texCoords());
-                    }
+                for (unsigned int i = 0; i < vertexCount; i++) {
+                    const Model::AliasFrameVertex& vertex = vertices[i];
+                    m_vertexArray->addAttribute(vertex.position());
+                    m_vertexArray->addAttribute(vertex.texCoords());
                 }
             }
 
@@ -95,18 +92,13 @@ namespace TrenchBroom {
 
         BBoxf AliasModelRenderer::boundsAfterTransformation(const Mat4f& transformation) const {
             Model::AliasSingleFrame& frame = m_alias.frame(m_frameIndex);
-            const Model::AliasFrameTriangleList& triangles = frame.triangles();
+            const Model::AliasFrameVertexList& vertices = frame.vertices();
 
             BBoxf bounds;
-            bounds.min = bounds.max = transformation * (*triangles[0])[0].position();
+            bounds.min = bounds.max = transformation * vertices[0].position();
             
-            for (unsigned int i = 1; i < triangles.size(); i++) {
-                Model::AliasFrameTriangle& triangle = *triangles[i];
-                for (unsigned int j = 0; j < 3; j++) {
-                    Model::AliasFrameVertex& vertex = triangle[j];
-                    bounds.mergeWith(transformation * vertex.position());
-                }
-            }
+            for (unsigned int i = 1; i < vertices.size(); i++)
+                bounds.mergeWith(transformation * vertices[i].position());
             
             return bounds;
         }
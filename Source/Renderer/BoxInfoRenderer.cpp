@@ -189,7 +189,12 @@ namespace TrenchBroom {
                 maxBuffer << "Max: " << m_bounds.max.asString();
                 m_textRenderer->addString(4, maxBuffer.str(), Text::TextAnchor::Ptr(new BoxInfoMinMaxTextAnchor(m_bounds, BoxInfoMinMaxTextAnchor::BoxMax, context.camera())));
                 
+                m_cameraPosition = context.camera().position();
                 m_initialized = true;
+            } else if (context.camera().position() != m_cameraPosition) {
+                // the size labels move to the box edges facing the camera
+                m_cameraPosition = context.camera().position();
+                m_textRenderer->invalidatePositions();
             }
             
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
@@ -69,6 +69,7 @@ namespace TrenchBroom {
             BBoxf m_bounds;
             Text::TextRenderer<unsigned int>* m_textRenderer;
             Text::TextRenderer<unsigned int>::SimpleTextRendererFilter m_textFilter;
+            Vec3f m_cameraPosition;
             bool m_initialized;
             
             // prevent copying
@@ -51,6 +51,22 @@ namespace TrenchBroom {
             m_faceRenderer = NULL;
         }
         
+        void BrushFigure::setBrushes(const Model::BrushList& brushes) {
+            if (brushes == m_brushes)
+                return;
+            
+            m_brushes = brushes;
+            m_faceRendererValid = false;
+            
+            // update the edge renderer right away so that it never refers to brushes that were deleted in between
+            if (m_edgeRenderer != NULL)
+                m_edgeRenderer->setBrushes(m_brushes);
+        }
+        
+        void BrushFigure::setBrush(Model::Brush& brush) {
+            setBrushes(Model::BrushList(1, &brush));
+        }
+        
         void BrushFigure::renderFaces(Vbo& vbo, RenderContext& context) {
             if (!m_faceRendererValid) {
                 SetVboState mapVbo(vbo, Vbo::VboMapped);
@@ -89,22 +105,17 @@ namespace TrenchBroom {
         
         void BrushFigure::renderEdges(Vbo& vbo, RenderContext& context) {
             if (!m_edgeRendererValid) {
-                SetVboState mapVbo(vbo, Vbo::VboMapped);
-
                 delete m_edgeRenderer;
-                m_edgeRenderer = NULL;
-                
-                if (!m_brushes.empty()) {
-                    if (m_edgeMode == EMDefault)
-                        m_edgeRenderer = new EdgeRenderer(vbo, m_brushes, Model::EmptyFaceList, m_edgeColor);
-                    else
-                        m_edgeRenderer = new EdgeRenderer(vbo, m_brushes, Model::EmptyFaceList);
-                }
+                if (m_edgeMode == EMDefault)
+                    m_edgeRenderer = new EdgeRenderer(m_edgeColor);
+                else
+                    m_edgeRenderer = new EdgeRenderer();
+                m_edgeRenderer->setBrushes(m_brushes);
                 m_edgeRendererValid = true;
             }
-
-            if (m_edgeRenderer != NULL) {
-                SetVboState activateVbo(vbo, Vbo::VboActive);
+            
+            m_edgeRenderer->validate();
+            if (!m_brushes.empty()) {
                 glSetEdgeOffset(0.02f);
                 if (m_edgeMode == EMDefault) {
                     m_edgeRenderer->render(context);
@@ -60,15 +60,14 @@ namespace TrenchBroom {
             BrushFigure(TextureRendererManager& textureRendererManager);
             ~BrushFigure();
 
-            inline void setBrushes(const Model::BrushList& brushes) {
-                m_brushes = brushes;
-                m_edgeRendererValid = false;
-                m_faceRendererValid = false;
-            }
+            /**
+             * Sets the brushes to render. Only the edges of brushes that were not rendered before are rebuilt, so
+             * brushes must not be modified while this figure renders them unless invalidate is called.
+             */
+            void setBrushes(const Model::BrushList& brushes);
+            void setBrush(Model::Brush& brush);
             
-            inline void setBrush(Model::Brush& brush) {
-                m_brushes.clear();
-                m_brushes.push_back(&brush);
+            inline void invalidate() {
                 m_edgeRendererValid = false;
                 m_faceRendererValid = false;
             }
@@ -32,16 +32,16 @@
 namespace TrenchBroom {
     namespace Renderer {
         void BspModelRenderer::buildVertexArrays() {
-            typedef TexturedPolygonSorter<const Model::BspTexture, Model::BspFace*> FaceSorter;
+            typedef TexturedPolygonSorter<const Model::BspTexture, const Model::BspFace*> FaceSorter;
             typedef FaceSorter::PolygonCollection FaceCollection;
             typedef FaceSorter::PolygonCollectionMap FaceCollectionMap;
             
-            Model::BspModel& model = *m_bsp.models()[0];
+            const Model::BspModel& model = m_bsp.model(0);
             FaceSorter faceSorter;
             
             const Model::BspFaceList& faces = model.faces();
             for (unsigned int i = 0; i < faces.size(); i++) {
-                Model::BspFace* face = faces[i];
+                const Model::BspFace* face = &faces[i];
                 const Model::BspTexture& texture = face->texture();
                 TextureRenderer* textureRenderer = NULL;
                 
@@ -51,7 +51,7 @@ namespace TrenchBroom {
                     m_textures[&texture] = textureRenderer;
                 }
                 
-                faceSorter.addPolygon(&texture, face, face->vertices().size());
+                faceSorter.addPolygon(&texture, face, face->vertexCount());
             }
             
             const FaceCollectionMap& faceCollectionMap = faceSorter.collections();
@@ -63,7 +63,7 @@ namespace TrenchBroom {
                 const Model::BspTexture* texture = it->first;
                 Renderer::TextureRenderer* textureRenderer = m_textures[texture];
                 const FaceCollection& faceCollection = it->second;
-                const Model::BspFaceList& collectedFaces = faceCollection.polygons();
+                const FaceSorter::PolygonList& collectedFaces = faceCollection.polygons();
                 unsigned int vertexCount = static_cast<unsigned int>(3 * faceCollection.vertexCount() - 6 * collectedFaces.size());
                 
                 VertexArray* vertexArray = new VertexArray(m_vbo, GL_TRIANGLES, vertexCount,
@@ -71,9 +71,9 @@ namespace TrenchBroom {
                                                            Attribute::texCoord02f());
                 
                 for (unsigned int i = 0; i < collectedFaces.size(); i++) {
-                    Model::BspFace* face = collectedFaces[i];
-                    const Vec3f::List& vertices = face->vertices();
-                    for (unsigned int j = 1; j < vertices.size() - 1; j++) {
+                    const Model::BspFace* face = collectedFaces[i];
+                    const Vec3f* vertices = face->vertices();
+                    for (unsigned int j = 1; j < face->vertexCount() - 1; j++) {
                         face->textureCoordinates(vertices[0], texCoords);
                         vertexArray->addAttribute(vertices[0]);
                         vertexArray->addAttribute(texCoords);
@@ -120,24 +120,24 @@ namespace TrenchBroom {
         }
         
         const Vec3f& BspModelRenderer::center() const {
-            return m_bsp.models()[0]->center();
+            return m_bsp.model(0).center();
         }
         
         const BBoxf& BspModelRenderer::bounds() const {
-            return m_bsp.models()[0]->bounds();
+            return m_bsp.model(0).bounds();
         }
 
         BBoxf BspModelRenderer::boundsAfterTransformation(const Mat4f& transformation) const {
-            Model::BspModel& model = *m_bsp.models()[0];
+            const Model::BspModel& model = m_bsp.model(0);
             const Model::BspFaceList& faces = model.faces();
 
             BBoxf bounds;
-            bounds.min = bounds.max = transformation * faces[0]->vertices()[0];
+            bounds.min = bounds.max = transformation * faces[0].vertices()[0];
             
             for (unsigned int i = 0; i < faces.size(); i++) {
-                Model::BspFace* face = faces[i];
-                const Vec3f::List& vertices = face->vertices();
-                for (unsigned int j = 0; j < vertices.size(); j++)
+                const Model::BspFace& face = faces[i];
+                const Vec3f* vertices = face.vertices();
+                for (unsigned int j = 0; j < face.vertexCount(); j++)
                     bounds.mergeWith(transformation * vertices[j]);
             }
             
@@ -189,12 +189,14 @@ namespace TrenchBroom {
 
         void Camera::moveTo(Vec3f position) {
             m_position = position;
+            m_valid = false;
         }
         
         void Camera::moveBy(float forward, float right, float up) {
             m_position += m_direction * forward;
             m_position += m_right * right;
             m_position += m_up * up;
+            m_valid = false;
         }
         
         void Camera::lookAt(Vec3f point, Vec3f up) {
@@ -205,6 +207,7 @@ namespace TrenchBroom {
             m_direction = direction;
             m_right = crossed(m_direction, up).normalized();
             m_up = crossed(m_right, m_direction);
+            m_valid = false;
         }
         
         void Camera::rotate(float yawAngle, float pitchAngle) {
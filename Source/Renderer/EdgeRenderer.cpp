@@ -19,143 +19,389 @@
 
 #include "EdgeRenderer.h"
 
-#include "GL/glew.h"
 #include "Model/Brush.h"
+#include "Model/BrushGeometry.h"
 #include "Model/Entity.h"
 #include "Model/EntityDefinition.h"
 #include "Model/Face.h"
 #include "Renderer/RenderContext.h"
-#include "Renderer/VertexArray.h"
+#include "Renderer/RenderStatistics.h"
+#include "Renderer/Vbo.h"
 #include "Renderer/Shader/ShaderManager.h"
 #include "Renderer/Shader/ShaderProgram.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+
 namespace TrenchBroom {
     namespace Renderer {
-        unsigned int EdgeRenderer::vertexCount(const Model::BrushList& brushes, const Model::FaceList& faces) {
-            Model::BrushList::const_iterator brushIt, brushEnd;
-            Model::FaceList::const_iterator faceIt, faceEnd;
-            unsigned int vertexCount = 0;
+        inline bool lexicographicLess(const Vec3f& lhs, const Vec3f& rhs) {
+            if (lhs.x() != rhs.x())
+                return lhs.x() < rhs.x();
+            if (lhs.y() != rhs.y())
+                return lhs.y() < rhs.y();
+            return lhs.z() < rhs.z();
+        }
+
+        EdgeRenderer::EdgeKey::EdgeKey(const Vec3f& i_start, const Vec3f& i_end, const Color& i_color) :
+        start(lexicographicLess(i_start, i_end) ? i_start : i_end),
+        end(lexicographicLess(i_start, i_end) ? i_end : i_start),
+        color(i_color) {}
+        
+        size_t EdgeRenderer::EdgeKeyHash::operator()(const EdgeKey& key) const {
+            const float values[] = {
+                key.start.x(), key.start.y(), key.start.z(),
+                key.end.x(), key.end.y(), key.end.z()
+            };
             
-            for (brushIt = brushes.begin(), brushEnd = brushes.end(); brushIt != brushEnd; ++brushIt) {
-                const Model::Brush& brush = **brushIt;
-                vertexCount += brush.edges().size();
+            size_t hash = 0;
+            for (size_t i = 0; i < 6; i++) {
+                // +0.0 and -0.0 compare equal and must hash equally
+                unsigned int bits = 0;
+                if (values[i] != 0.0f)
+                    memcpy(&bits, &values[i], sizeof(float));
+                hash ^= bits + 0x9e3779b9 + (hash << 6) + (hash >> 2);
             }
+            return hash;
+        }
+
+        const Color& EdgeRenderer::edgeColor(const Model::Brush& brush) const {
+            static const Color NoColor;
+            if (!m_colored)
+                return NoColor;
             
-            for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt) {
-                const Model::Face& face = **faceIt;
-                vertexCount += face.edges().size();
+            const Model::Entity* entity = brush.entity();
+            const Model::EntityDefinition* definition = entity != NULL ? entity->definition() : NULL;
+            if (entity != NULL && !entity->worldspawn() && definition != NULL && definition->type() == Model::EntityDefinition::BrushEntity)
+                return definition->color();
+            return m_defaultColor;
+        }
+
+        void EdgeRenderer::releaseEdge(Slot& slot, EdgeEntry& entry) {
+            EdgeInfo& info = entry.second;
+            if (info.owner == &slot) {
+                if (info.sharers.empty()) {
+                    m_edges.erase(entry.first);
+                } else {
+                    // pass the edge on to another slot that contains it
+                    info.owner = info.sharers.back();
+                    info.sharers.pop_back();
+                    m_invalidSlots.insert(info.owner);
+                }
+            } else {
+                std::vector<Slot*>::iterator it = std::find(info.sharers.begin(), info.sharers.end(), &slot);
+                assert(it != info.sharers.end());
+                info.sharers.erase(it);
             }
+        }
+
+        void EdgeRenderer::releaseSlot(Slot& slot) {
+            EdgeEntryList::const_iterator it, end;
+            for (it = slot.edges.begin(), end = slot.edges.end(); it != end; ++it)
+                releaseEdge(slot, **it);
+            slot.edges.clear();
             
-            return 2 * vertexCount;
+            if (slot.block != NULL) {
+                slot.block->freeBlock();
+                slot.block = NULL;
+                m_rangesValid = false;
+            }
+            m_invalidSlots.erase(&slot);
+        }
+
+        void EdgeRenderer::validateSlot(Slot& slot) {
+            const Model::Brush& brush = slot.brush != NULL ? *slot.brush : *slot.face->brush();
+            const Model::EdgeList& edges = slot.brush != NULL ? slot.brush->edges() : slot.face->edges();
+            const Color& color = edgeColor(brush);
+            
+            EdgeEntryList newEdges;
+            newEdges.reserve(edges.size());
+            
+            Model::EdgeList::const_iterator edgeIt, edgeEnd;
+            for (edgeIt = edges.begin(), edgeEnd = edges.end(); edgeIt != edgeEnd; ++edgeIt) {
+                const Model::Edge& edge = **edgeIt;
+                const EdgeKey key(edge.start->position, edge.end->position, color);
+                newEdges.push_back(&*m_edges.insert(EdgeMap::value_type(key, EdgeInfo())).first);
+            }
+            std::sort(newEdges.begin(), newEdges.end());
+            newEdges.erase(std::unique(newEdges.begin(), newEdges.end()), newEdges.end());
+            
+            // the ownership of the edges this slot already contained does not change
+            EdgeEntryList::const_iterator it, end;
+            for (it = newEdges.begin(), end = newEdges.end(); it != end; ++it) {
+                EdgeInfo& info = (*it)->second;
+                if (!std::binary_search(slot.edges.begin(), slot.edges.end(), *it)) {
+                    if (info.owner == NULL)
+                        info.owner = &slot;
+                    else
+                        info.sharers.push_back(&slot);
+                }
+            }
+            
+            // release the edges that this slot no longer contains
+            EdgeEntryList oldEdges;
+            std::set_difference(slot.edges.begin(), slot.edges.end(), newEdges.begin(), newEdges.end(), std::back_inserter(oldEdges));
+            slot.edges.swap(newEdges);
+            
+            for (it = oldEdges.begin(), end = oldEdges.end(); it != end; ++it)
+                releaseEdge(slot, **it);
+            
+            writeSlot(slot);
         }
         
-        void EdgeRenderer::writeEdgeData(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces) {
-            m_vertexArray = new VertexArray(vbo, GL_LINES, vertexCount(brushes, faces),
-                                            Attribute::position3f());
+        void EdgeRenderer::writeSlot(Slot& slot) {
+            size_t ownedEdgeCount = 0;
+            EdgeEntryList::const_iterator it, end;
+            for (it = slot.edges.begin(), end = slot.edges.end(); it != end; ++it)
+                if ((*it)->second.owner == &slot)
+                    ownedEdgeCount++;
+            
+            const size_t capacity = 2 * ownedEdgeCount * vertexSize();
+            if (slot.block != NULL && slot.block->capacity() != capacity) {
+                slot.block->freeBlock();
+                slot.block = NULL;
+                m_rangesValid = false;
+            }
+            
+            if (capacity == 0)
+                return;
+            
+            if (slot.block == NULL) {
+                slot.block = m_vbo->allocBlock(capacity);
+                m_rangesValid = false;
+            }
+            
+            size_t offset = 0;
+            for (it = slot.edges.begin(), end = slot.edges.end(); it != end; ++it) {
+                const EdgeEntry& entry = **it;
+                if (entry.second.owner == &slot) {
+                    const EdgeKey& key = entry.first;
+                    offset = slot.block->writeVec(key.start, offset);
+                    if (m_colored)
+                        offset = slot.block->writeVec(static_cast<const Vec4f&>(key.color), offset);
+                    offset = slot.block->writeVec(key.end, offset);
+                    if (m_colored)
+                        offset = slot.block->writeVec(static_cast<const Vec4f&>(key.color), offset);
+                }
+            }
+            assert(offset == capacity);
+        }
 
-            Model::BrushList::const_iterator brushIt, brushEnd;
-            for (brushIt = brushes.begin(), brushEnd = brushes.end(); brushIt != brushEnd; ++brushIt) {
-                const Model::Brush& brush = **brushIt;
-                const Model::EdgeList& edges = brush.edges();
-                Model::EdgeList::const_iterator edgeIt, edgeEnd;
-                for (edgeIt = edges.begin(), edgeEnd = edges.end(); edgeIt != edgeEnd; ++edgeIt) {
-                    const Model::Edge& edge = **edgeIt;
-                    m_vertexArray->addAttribute(edge.start->position);
-                    m_vertexArray->addAttribute(edge.end->position);
+        void EdgeRenderer::validateRanges() {
+            typedef std::pair<GLint, GLsizei> Range;
+            std::vector<Range> ranges;
+            ranges.reserve(m_brushSlots.size() + m_faceSlots.size());
+            
+            const size_t size = vertexSize();
+            BrushSlotMap::const_iterator brushIt, brushEnd;
+            for (brushIt = m_brushSlots.begin(), brushEnd = m_brushSlots.end(); brushIt != brushEnd; ++brushIt) {
+                const VboBlock* block = brushIt->second.block;
+                if (block != NULL) {
+                    assert(block->address() % size == 0);
+                    ranges.push_back(Range(static_cast<GLint>(block->address() / size), static_cast<GLsizei>(block->capacity() / size)));
                 }
             }
             
-            Model::FaceList::const_iterator faceIt, faceEnd;
-            for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt) {
-                const Model::Face& face = **faceIt;
-                const Model::EdgeList& edges = face.edges();
-                Model::EdgeList::const_iterator edgeIt, edgeEnd;
-                for (edgeIt = edges.begin(), edgeEnd = edges.end(); edgeIt != edgeEnd; ++edgeIt) {
-                    const Model::Edge& edge = **edgeIt;
-                    m_vertexArray->addAttribute(edge.start->position);
-                    m_vertexArray->addAttribute(edge.end->position);
+            FaceSlotMap::const_iterator faceIt, faceEnd;
+            for (faceIt = m_faceSlots.begin(), faceEnd = m_faceSlots.end(); faceIt != faceEnd; ++faceIt) {
+                const VboBlock* block = faceIt->second.block;
+                if (block != NULL) {
+                    assert(block->address() % size == 0);
+                    ranges.push_back(Range(static_cast<GLint>(block->address() / size), static_cast<GLsizei>(block->capacity() / size)));
                 }
             }
+            
+            // merge the blocks that are adjacent in the VBO
+            std::sort(ranges.begin(), ranges.end());
+            m_firsts.clear();
+            m_counts.clear();
+            for (size_t i = 0; i < ranges.size(); i++) {
+                if (!m_firsts.empty() && m_firsts.back() + m_counts.back() == ranges[i].first) {
+                    m_counts.back() += ranges[i].second;
+                } else {
+                    m_firsts.push_back(ranges[i].first);
+                    m_counts.push_back(ranges[i].second);
+                }
+            }
+            
+            m_rangesValid = true;
+        }
+        
+        void EdgeRenderer::renderRanges() {
+            SetVboState activateVbo(*m_vbo, Vbo::VboActive);
+            const GLsizei stride = static_cast<GLsizei>(vertexSize());
+            
+            glEnableClientState(GL_VERTEX_ARRAY);
+            glVertexPointer(3, GL_FLOAT, stride, reinterpret_cast<GLvoid*>(0));
+            if (m_colored) {
+                glEnableClientState(GL_COLOR_ARRAY);
+                glColorPointer(4, GL_FLOAT, stride, reinterpret_cast<GLvoid*>(3 * sizeof(float)));
+            }
+            
+            RenderStatistics::countDrawCall();
+            glMultiDrawArrays(GL_LINES, &m_firsts.front(), &m_counts.front(), static_cast<GLsizei>(m_firsts.size()));
+            
+            if (m_colored)
+                glDisableClientState(GL_COLOR_ARRAY);
+            glDisableClientState(GL_VERTEX_ARRAY);
         }
+
+        EdgeRenderer::EdgeRenderer() :
+        m_vbo(NULL),
+        m_colored(false),
+        m_rangesValid(true) {}
         
-        void EdgeRenderer::writeEdgeData(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces, const Color& defaultColor) {
-            m_vertexArray = new VertexArray(vbo, GL_LINES, vertexCount(brushes, faces),
-                                            Attribute::position3f(),
-                                            Attribute::color4f());
+        EdgeRenderer::EdgeRenderer(const Color& defaultColor) :
+        m_vbo(NULL),
+        m_colored(true),
+        m_defaultColor(defaultColor),
+        m_rangesValid(true) {}
 
+        EdgeRenderer::~EdgeRenderer() {
+            delete m_vbo;
+            m_vbo = NULL;
+        }
+
+        void EdgeRenderer::setDefaultColor(const Color& defaultColor) {
+            if (defaultColor == m_defaultColor)
+                return;
+            
+            m_defaultColor = defaultColor;
+            if (m_colored)
+                invalidateAll();
+        }
+
+        void EdgeRenderer::setBrushes(const Model::BrushList& brushes) {
+            Model::BrushList sortedBrushes(brushes);
+            std::sort(sortedBrushes.begin(), sortedBrushes.end());
+            
+            BrushSlotMap::iterator slotIt = m_brushSlots.begin();
+            while (slotIt != m_brushSlots.end()) {
+                if (!std::binary_search(sortedBrushes.begin(), sortedBrushes.end(), slotIt->first)) {
+                    releaseSlot(slotIt->second);
+                    m_brushSlots.erase(slotIt++);
+                } else {
+                    ++slotIt;
+                }
+            }
+            
             Model::BrushList::const_iterator brushIt, brushEnd;
-            for (brushIt = brushes.begin(), brushEnd = brushes.end(); brushIt != brushEnd; ++brushIt) {
-                const Model::Brush& brush = **brushIt;
-                const Model::Entity* entity = brush.entity();
-                const Model::EntityDefinition* definition = entity != NULL ? entity->definition() : NULL;
-                const Color& color = (entity != NULL && !entity->worldspawn() && definition != NULL && definition->type() == Model::EntityDefinition::BrushEntity) ? definition->color() : defaultColor;
-                
-                const Model::EdgeList& edges = brush.edges();
-                Model::EdgeList::const_iterator edgeIt, edgeEnd;
-                for (edgeIt = edges.begin(), edgeEnd = edges.end(); edgeIt != edgeEnd; ++edgeIt) {
-                    const Model::Edge& edge = **edgeIt;
-                    m_vertexArray->addAttribute(edge.start->position);
-                    m_vertexArray->addAttribute(color);
-                    m_vertexArray->addAttribute(edge.end->position);
-                    m_vertexArray->addAttribute(color);
+            for (brushIt = sortedBrushes.begin(), brushEnd = sortedBrushes.end(); brushIt != brushEnd; ++brushIt) {
+                Model::Brush* brush = *brushIt;
+                std::pair<BrushSlotMap::iterator, bool> result = m_brushSlots.insert(BrushSlotMap::value_type(brush, Slot()));
+                if (result.second) {
+                    result.first->second.brush = brush;
+                    m_invalidSlots.insert(&result.first->second);
                 }
             }
-
+        }
+        
+        void EdgeRenderer::setFaces(const Model::FaceList& faces) {
+            Model::FaceList sortedFaces(faces);
+            std::sort(sortedFaces.begin(), sortedFaces.end());
+            
+            FaceSlotMap::iterator slotIt = m_faceSlots.begin();
+            while (slotIt != m_faceSlots.end()) {
+                if (!std::binary_search(sortedFaces.begin(), sortedFaces.end(), slotIt->first)) {
+                    releaseSlot(slotIt->second);
+                    m_faceSlots.erase(slotIt++);
+                } else {
+                    ++slotIt;
+                }
+            }
+            
             Model::FaceList::const_iterator faceIt, faceEnd;
-            for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt) {
-                const Model::Face& face = **faceIt;
-                const Model::Brush* brush = face.brush();
-                const Model::Entity* entity = brush->entity();
-                const Model::EntityDefinition* definition = entity != NULL ? entity->definition() : NULL;
-                const Color& color = (entity != NULL && !entity->worldspawn() && definition != NULL && definition->type() == Model::EntityDefinition::BrushEntity) ? definition->color() : defaultColor;
-                
-                const Model::EdgeList& edges = face.edges();
-                Model::EdgeList::const_iterator edgeIt, edgeEnd;
-                for (edgeIt = edges.begin(), edgeEnd = edges.end(); edgeIt != edgeEnd; ++edgeIt) {
-                    const Model::Edge& edge = **edgeIt;
-                    m_vertexArray->addAttribute(edge.start->position);
-                    m_vertexArray->addAttribute(color);
-                    m_vertexArray->addAttribute(edge.end->position);
-                    m_vertexArray->addAttribute(color);
+            for (faceIt = sortedFaces.begin(), faceEnd = sortedFaces.end(); faceIt != faceEnd; ++faceIt) {
+                Model::Face* face = *faceIt;
+                std::pair<FaceSlotMap::iterator, bool> result = m_faceSlots.insert(FaceSlotMap::value_type(face, Slot()));
+                if (result.second) {
+                    result.first->second.face = face;
+                    m_invalidSlots.insert(&result.first->second);
                 }
             }
         }
 
-        EdgeRenderer::EdgeRenderer(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces) :
-        m_vertexArray(NULL) {
-            writeEdgeData(vbo, brushes, faces);
+        void EdgeRenderer::invalidateBrushes(const Model::BrushList& brushes) {
+            Model::BrushList::const_iterator it, end;
+            for (it = brushes.begin(), end = brushes.end(); it != end; ++it) {
+                BrushSlotMap::iterator slotIt = m_brushSlots.find(*it);
+                if (slotIt != m_brushSlots.end())
+                    m_invalidSlots.insert(&slotIt->second);
+            }
         }
-        
-        EdgeRenderer::EdgeRenderer(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces, const Color& defaultColor) :
-        m_vertexArray(NULL) {
-            writeEdgeData(vbo, brushes, faces, defaultColor);
+
+        void EdgeRenderer::invalidateAll() {
+            BrushSlotMap::iterator brushIt, brushEnd;
+            for (brushIt = m_brushSlots.begin(), brushEnd = m_brushSlots.end(); brushIt != brushEnd; ++brushIt)
+                m_invalidSlots.insert(&brushIt->second);
+            
+            FaceSlotMap::iterator faceIt, faceEnd;
+            for (faceIt = m_faceSlots.begin(), faceEnd = m_faceSlots.end(); faceIt != faceEnd; ++faceIt)
+                m_invalidSlots.insert(&faceIt->second);
         }
 
-        EdgeRenderer::~EdgeRenderer() {
-            delete m_vertexArray;
-            m_vertexArray = NULL;
+        void EdgeRenderer::clear() {
+            if (m_vbo != NULL)
+                m_vbo->freeAllBlocks();
+            m_brushSlots.clear();
+            m_faceSlots.clear();
+            m_edges.clear();
+            m_invalidSlots.clear();
+            m_firsts.clear();
+            m_counts.clear();
+            m_rangesValid = true;
         }
 
+        void EdgeRenderer::validate() {
+            if (!m_invalidSlots.empty()) {
+                if (m_vbo == NULL)
+                    m_vbo = new Vbo(GL_ARRAY_BUFFER, InitialVertexCapacity * vertexSize());
+                
+                SetVboState mapVbo(*m_vbo, Vbo::VboMapped);
+                
+                // validating a slot may pass shared edges on to other slots, which are then invalidated as well
+                while (!m_invalidSlots.empty()) {
+                    Slot* slot = *m_invalidSlots.begin();
+                    m_invalidSlots.erase(m_invalidSlots.begin());
+                    validateSlot(*slot);
+                }
+            }
+            
+            // compact the VBO a little in every frame until most of its free space is in one block again
+            if (m_vbo != NULL && m_vbo->fragmentation() > 0.5f) {
+                Vbo::MoveList moves;
+                m_vbo->compact(CompactionBudget, moves);
+                if (m_rangesValid)
+                    Vbo::shiftRanges(moves, vertexSize(), m_firsts, m_counts);
+            }
+            
+            if (!m_rangesValid)
+                validateRanges();
+        }
 
         void EdgeRenderer::render(RenderContext& context) {
-            assert(m_vertexArray != NULL);
+            if (m_firsts.empty())
+                return;
             
             ShaderManager& shaderManager = context.shaderManager();
             ShaderProgram& coloredEdgeProgram = shaderManager.shaderProgram(Shaders::ColoredEdgeShader);
             if (coloredEdgeProgram.activate()) {
-                m_vertexArray->render();
+                renderRanges();
                 coloredEdgeProgram.deactivate();
             }
         }
         
         void EdgeRenderer::render(RenderContext& context, const Color& color) {
-            assert(m_vertexArray != NULL);
-
+            if (m_firsts.empty())
+                return;
+            
             ShaderManager& shaderManager = context.shaderManager();
             ShaderProgram& edgeProgram = shaderManager.shaderProgram(Shaders::EdgeShader);
             if (edgeProgram.activate()) {
                 edgeProgram.setUniformVariable("Color", color);
-                m_vertexArray->render();
+                renderRanges();
                 edgeProgram.deactivate();
             }
         }
@@ -20,28 +20,137 @@
 #ifndef __TrenchBroom__EdgeRenderer__
 #define __TrenchBroom__EdgeRenderer__
 
+#include <GL/glew.h>
 #include "Model/BrushTypes.h"
 #include "Model/FaceTypes.h"
 #include "Utility/Color.h"
+#include "Utility/VecMath.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+#if defined _WIN32
+#include <unordered_map>
+#else
+#include <tr1/unordered_map>
+#endif
+
+using namespace TrenchBroom::VecMath;
 
 namespace TrenchBroom {
     namespace Renderer {
         class RenderContext;
         class Vbo;
-        class VertexArray;
+        class VboBlock;
         
+        /**
+         * Renders the edges of a set of brushes and faces. The edges are kept in a VBO of their own, where every brush
+         * and every face owns a block that is only rewritten when it is invalidated, so that the amount of data written
+         * depends on the number of changed brushes and not on the total number of brushes.
+         *
+         * Edges shared by several brushes (or faces) are only stored once: every distinct edge has exactly one owner,
+         * and only the owner writes it. When the owner of a shared edge is removed or changes its geometry, the edge
+         * is passed on to one of the remaining sharers, which is then rewritten.
+         */
         class EdgeRenderer {
-        protected:
-            VertexArray* m_vertexArray;
+        private:
+            struct Slot;
+            
+            class EdgeKey {
+            public:
+                Vec3f start;
+                Vec3f end;
+                Color color;
+                
+                EdgeKey(const Vec3f& i_start, const Vec3f& i_end, const Color& i_color);
+                
+                inline bool operator== (const EdgeKey& other) const {
+                    return start == other.start && end == other.end && color == other.color;
+                }
+            };
+            
+            struct EdgeKeyHash {
+                size_t operator()(const EdgeKey& key) const;
+            };
+            
+            struct EdgeInfo {
+                Slot* owner;
+                std::vector<Slot*> sharers;
+                
+                EdgeInfo() :
+                owner(NULL) {}
+            };
+            
+            typedef std::tr1::unordered_map<EdgeKey, EdgeInfo, EdgeKeyHash> EdgeMap;
+            typedef EdgeMap::value_type EdgeEntry;
+            typedef std::vector<EdgeEntry*> EdgeEntryList;
+            
+            struct Slot {
+                Model::Brush* brush;
+                Model::Face* face;
+                VboBlock* block;
+                EdgeEntryList edges;
+                
+                Slot() :
+                brush(NULL),
+                face(NULL),
+                block(NULL) {}
+            };
+            
+            typedef std::map<Model::Brush*, Slot> BrushSlotMap;
+            typedef std::map<Model::Face*, Slot> FaceSlotMap;
+            typedef std::set<Slot*> SlotSet;
+            
+            static const size_t InitialVertexCapacity = 0x1000;
+            static const size_t CompactionBudget = 0x10000;
             
-            unsigned int vertexCount(const Model::BrushList& brushes, const Model::FaceList& faces);
-            void writeEdgeData(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces);
-            void writeEdgeData(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces, const Color& defaultColor);
+            Vbo* m_vbo;
+            bool m_colored;
+            Color m_defaultColor;
+            
+            BrushSlotMap m_brushSlots;
+            FaceSlotMap m_faceSlots;
+            EdgeMap m_edges;
+            SlotSet m_invalidSlots;
+            
+            std::vector<GLint> m_firsts;
+            std::vector<GLsizei> m_counts;
+            bool m_rangesValid;
+            
+            inline size_t vertexSize() const {
+                return m_colored ? 7 * sizeof(float) : 3 * sizeof(float);
+            }
+            
+            const Color& edgeColor(const Model::Brush& brush) const;
+            void releaseEdge(Slot& slot, EdgeEntry& entry);
+            void releaseSlot(Slot& slot);
+            void validateSlot(Slot& slot);
+            void writeSlot(Slot& slot);
+            void validateRanges();
+            void renderRanges();
+            
+            // prevent copying
+            EdgeRenderer(const EdgeRenderer& other);
+            void operator= (const EdgeRenderer& other);
         public:
-            EdgeRenderer(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces);
-            EdgeRenderer(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces, const Color& defaultColor);
+            EdgeRenderer();
+            EdgeRenderer(const Color& defaultColor);
             ~EdgeRenderer();
-
+            
+            inline const Vbo* vbo() const {
+                return m_vbo;
+            }
+            
+            void setDefaultColor(const Color& defaultColor);
+            
+            void setBrushes(const Model::BrushList& brushes);
+            void setFaces(const Model::FaceList& faces);
+            void invalidateBrushes(const Model::BrushList& brushes);
+            void invalidateAll();
+            void clear();
+            
+            void validate();
             void render(RenderContext& context);
             void render(RenderContext& context, const Color& color);
         };
@@ -0,0 +1,214 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "EntityBoundsArray.h"
+
+#include "Model/Entity.h"
+#include "Model/EntityDefinition.h"
+#include "Model/Filter.h"
+#include "Renderer/RenderStatistics.h"
+#include "Renderer/Vbo.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace TrenchBroom {
+    namespace Renderer {
+        void EntityBoundsArray::writeBounds(Model::Entity& entity, VboBlock& block) {
+            Vec3f::List vertices(VertexCount);
+            entity.bounds().vertices(vertices);
+            
+            size_t offset = 0;
+            if (m_colored) {
+                Color color = m_defaultColor;
+                const Model::EntityDefinition* definition = entity.definition();
+                if (definition != NULL) {
+                    color = definition->color();
+                    color[3] = m_defaultColor.a();
+                }
+                
+                for (size_t i = 0; i < VertexCount; i++) {
+                    offset = block.writeVec(vertices[i], offset);
+                    offset = block.writeVec(static_cast<const Vec4f&>(color), offset);
+                }
+            } else {
+                offset = block.writeVecs(vertices, offset);
+            }
+        }
+
+        void EntityBoundsArray::validateRanges(const Model::Filter& filter) {
+            std::vector<GLint> firsts;
+            firsts.reserve(m_blocks.size());
+            
+            EntityBlockMap::const_iterator it, end;
+            for (it = m_blocks.begin(), end = m_blocks.end(); it != end; ++it) {
+                const Model::Entity& entity = *it->first;
+                const VboBlock* block = it->second;
+                if (block != NULL && filter.entityVisible(entity)) {
+                    assert(block->address() % vertexSize() == 0);
+                    firsts.push_back(static_cast<GLint>(block->address() / vertexSize()));
+                }
+            }
+            
+            // merge the blocks of adjacent entities into a single range
+            std::sort(firsts.begin(), firsts.end());
+            m_firsts.clear();
+            m_counts.clear();
+            for (size_t i = 0; i < firsts.size(); i++) {
+                if (!m_firsts.empty() && m_firsts.back() + m_counts.back() == firsts[i]) {
+                    m_counts.back() += static_cast<GLsizei>(VertexCount);
+                } else {
+                    m_firsts.push_back(firsts[i]);
+                    m_counts.push_back(static_cast<GLsizei>(VertexCount));
+                }
+            }
+            
+            m_rangesValid = true;
+        }
+
+        EntityBoundsArray::EntityBoundsArray() :
+        m_vbo(NULL),
+        m_colored(true),
+        m_rangesValid(true) {}
+        
+        EntityBoundsArray::~EntityBoundsArray() {
+            delete m_vbo;
+            m_vbo = NULL;
+        }
+
+        void EntityBoundsArray::setColored(const bool colored) {
+            if (colored == m_colored)
+                return;
+            
+            // the vertex size changes, so all blocks must be reallocated
+            delete m_vbo;
+            m_vbo = NULL;
+            
+            EntityBlockMap::iterator it, end;
+            for (it = m_blocks.begin(), end = m_blocks.end(); it != end; ++it) {
+                it->second = NULL;
+                m_invalidEntities.insert(it->first);
+            }
+            
+            m_colored = colored;
+            m_rangesValid = false;
+        }
+        
+        void EntityBoundsArray::setDefaultColor(const Color& defaultColor) {
+            if (defaultColor == m_defaultColor)
+                return;
+            
+            m_defaultColor = defaultColor;
+            if (m_colored)
+                invalidateAll();
+        }
+
+        void EntityBoundsArray::addEntity(Model::Entity& entity) {
+            if (!m_blocks.insert(EntityBlockMap::value_type(&entity, NULL)).second)
+                return;
+            m_invalidEntities.insert(&entity);
+        }
+        
+        void EntityBoundsArray::removeEntity(Model::Entity& entity) {
+            EntityBlockMap::iterator it = m_blocks.find(&entity);
+            if (it == m_blocks.end())
+                return;
+            
+            if (it->second != NULL) {
+                it->second->freeBlock();
+                m_rangesValid = false;
+            }
+            m_blocks.erase(it);
+            m_invalidEntities.erase(&entity);
+        }
+        
+        void EntityBoundsArray::invalidateEntity(Model::Entity& entity) {
+            if (m_blocks.count(&entity) > 0)
+                m_invalidEntities.insert(&entity);
+        }
+        
+        void EntityBoundsArray::invalidateEntities(const Model::EntityList& entities) {
+            Model::EntityList::const_iterator it, end;
+            for (it = entities.begin(), end = entities.end(); it != end; ++it)
+                invalidateEntity(**it);
+        }
+
+        void EntityBoundsArray::invalidateAll() {
+            EntityBlockMap::const_iterator it, end;
+            for (it = m_blocks.begin(), end = m_blocks.end(); it != end; ++it)
+                m_invalidEntities.insert(it->first);
+        }
+
+        void EntityBoundsArray::clear() {
+            if (m_vbo != NULL)
+                m_vbo->freeAllBlocks();
+            m_blocks.clear();
+            m_invalidEntities.clear();
+            m_firsts.clear();
+            m_counts.clear();
+            m_rangesValid = true;
+        }
+        
+        void EntityBoundsArray::validate(const Model::Filter& filter) {
+            if (!m_invalidEntities.empty()) {
+                const size_t blockSize = VertexCount * vertexSize();
+                if (m_vbo == NULL)
+                    m_vbo = new Vbo(GL_ARRAY_BUFFER, InitialEntityCapacity * blockSize);
+                
+                SetVboState mapVbo(*m_vbo, Vbo::VboMapped);
+                Model::EntitySet::const_iterator it, end;
+                for (it = m_invalidEntities.begin(), end = m_invalidEntities.end(); it != end; ++it) {
+                    Model::Entity& entity = **it;
+                    VboBlock*& block = m_blocks[&entity];
+                    if (block == NULL)
+                        block = m_vbo->allocBlock(blockSize);
+                    writeBounds(entity, *block);
+                }
+                
+                m_invalidEntities.clear();
+                m_rangesValid = false;
+            }
+            
+            if (!m_rangesValid)
+                validateRanges(filter);
+        }
+
+        void EntityBoundsArray::render() {
+            if (m_firsts.empty())
+                return;
+            
+            SetVboState activateVbo(*m_vbo, Vbo::VboActive);
+            const GLsizei stride = static_cast<GLsizei>(vertexSize());
+            
+            glEnableClientState(GL_VERTEX_ARRAY);
+            glVertexPointer(3, GL_FLOAT, stride, reinterpret_cast<GLvoid*>(0));
+            if (m_colored) {
+                glEnableClientState(GL_COLOR_ARRAY);
+                glColorPointer(4, GL_FLOAT, stride, reinterpret_cast<GLvoid*>(3 * sizeof(float)));
+            }
+            
+            RenderStatistics::countDrawCall();
+            glMultiDrawArrays(GL_LINES, &m_firsts.front(), &m_counts.front(), static_cast<GLsizei>(m_firsts.size()));
+            
+            if (m_colored)
+                glDisableClientState(GL_COLOR_ARRAY);
+            glDisableClientState(GL_VERTEX_ARRAY);
+        }
+    }
+}
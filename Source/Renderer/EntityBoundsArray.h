@@ -0,0 +1,106 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__EntityBoundsArray__
+#define __TrenchBroom__EntityBoundsArray__
+
+#include <GL/glew.h>
+#include "Model/EntityTypes.h"
+#include "Utility/Color.h"
+
+#include <map>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Model {
+        class Entity;
+        class Filter;
+    }
+    
+    namespace Renderer {
+        class Vbo;
+        class VboBlock;
+        
+        /**
+         * Stores the bounding box edges of a set of entities in a VBO of its own. Every entity owns a block of exactly
+         * 24 vertices, which is only rewritten if the entity was invalidated, so the amount of data written to the VBO
+         * depends on the number of changed entities only. The visible entities are rendered with a single call to
+         * glMultiDrawArrays.
+         */
+        class EntityBoundsArray {
+        private:
+            typedef std::map<Model::Entity*, VboBlock*> EntityBlockMap;
+            
+            static const size_t VertexCount = 24;
+            static const size_t InitialEntityCapacity = 256;
+
+            Vbo* m_vbo;
+            EntityBlockMap m_blocks;
+            Model::EntitySet m_invalidEntities;
+            bool m_colored;
+            Color m_defaultColor;
+            
+            std::vector<GLint> m_firsts;
+            std::vector<GLsizei> m_counts;
+            bool m_rangesValid;
+            
+            inline size_t vertexSize() const {
+                return m_colored ? 7 * sizeof(float) : 3 * sizeof(float);
+            }
+            
+            void writeBounds(Model::Entity& entity, VboBlock& block);
+            void validateRanges(const Model::Filter& filter);
+
+            // prevent copying
+            EntityBoundsArray(const EntityBoundsArray& other);
+            void operator= (const EntityBoundsArray& other);
+        public:
+            EntityBoundsArray();
+            ~EntityBoundsArray();
+            
+            inline bool colored() const {
+                return m_colored;
+            }
+            
+            void setColored(bool colored);
+            void setDefaultColor(const Color& defaultColor);
+
+            inline const Vbo* vbo() const {
+                return m_vbo;
+            }
+            
+            void addEntity(Model::Entity& entity);
+            void removeEntity(Model::Entity& entity);
+            void invalidateEntity(Model::Entity& entity);
+            void invalidateEntities(const Model::EntityList& entities);
+            void invalidateAll();
+            
+            inline void invalidateVisibility() {
+                m_rangesValid = false;
+            }
+            
+            void clear();
+            
+            void validate(const Model::Filter& filter);
+            void render();
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__EntityBoundsArray__) */
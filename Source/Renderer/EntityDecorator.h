@@ -20,6 +20,8 @@
 #ifndef TrenchBroom_EntityDecorator_h
 #define TrenchBroom_EntityDecorator_h
 
+#include "Model/EntityTypes.h"
+
 #include <vector>
 
 namespace TrenchBroom {
@@ -45,6 +47,22 @@ namespace TrenchBroom {
             virtual ~EntityDecorator() {}
 
             virtual void invalidate() = 0;
+            
+            /**
+             * Called when only the given entities have changed, e.g. because they were moved or their properties were
+             * changed. Decorators that cache per entity data may override this to update only the affected entities.
+             */
+            virtual void invalidateEntities(const Model::EntityList& entities) {
+                invalidate();
+            }
+            
+            /**
+             * Called when the selection, the visibility or the filter has changed, but no entity was modified.
+             */
+            virtual void invalidateEditState() {
+                invalidate();
+            }
+            
             virtual void render(Vbo& vbo, RenderContext& context) = 0;
         };
     }
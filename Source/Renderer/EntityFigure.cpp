@@ -44,7 +44,7 @@ namespace TrenchBroom {
             if (m_entityRenderer == NULL) {
                 Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
 
-                m_entityRenderer = new EntityRenderer(vbo, m_document);
+                m_entityRenderer = new EntityRenderer(m_document);
                 m_entityRenderer->setClassnameFadeDistance(99999.0f);
                 m_entityRenderer->setClassnameColor(prefs.getColor(Preferences::InfoOverlayTextColor), prefs.getColor(Preferences::InfoOverlayBackgroundColor));
                 m_entityRenderer->setOccludedClassnameColor(prefs.getColor(Preferences::InfoOverlayTextColor), prefs.getColor(Preferences::InfoOverlayBackgroundColor));
@@ -24,11 +24,11 @@
 #include "Model/Filter.h"
 #include "Model/Map.h"
 #include "Model/MapDocument.h"
+#include "Renderer/AttributeArray.h"
 #include "Renderer/RenderContext.h"
 #include "Renderer/Shader/Shader.h"
 #include "Renderer/Shader/ShaderManager.h"
 #include "Renderer/Vbo.h"
-#include "Renderer/VertexArray.h"
 #include "Utility/Console.h"
 #include "Utility/List.h"
 #include "Utility/Preferences.h"
@@ -39,126 +39,241 @@ using namespace TrenchBroom::VecMath;
 namespace TrenchBroom {
     namespace Renderer {
         void EntityLinkDecorator::clear() {
-            delete m_selectedLinkArray;
-            m_selectedLinkArray = NULL;
-            delete m_unselectedLinkArray;
-            m_unselectedLinkArray = NULL;
-            delete m_selectedKillLinkArray;
-            m_selectedKillLinkArray = NULL;
-            delete m_unselectedKillLinkArray;
-            m_unselectedKillLinkArray = NULL;
+            m_vbo->freeAllBlocks();
+            m_slots.clear();
+            m_sources.clear();
+            m_invalidEntities.clear();
         }
         
-        void EntityLinkDecorator::makeLink(Model::Entity& source, Model::Entity& target, Vec3f::List& vertices) const {
-            vertices.push_back(source.center());
-            vertices.push_back(target.center());
+        void EntityLinkDecorator::addLinkSources(Model::Entity& entity, const Model::EntityList& targets) {
+            Model::EntityList::const_iterator it, end;
+            for (it = targets.begin(), end = targets.end(); it != end; ++it)
+                m_sources[*it].insert(&entity);
         }
-
-        void EntityLinkDecorator::buildLinks(RenderContext& context, Model::Entity& entity, size_t depth, Model::EntitySet& visitedEntities, Vec3f::List& selectedLinks, Vec3f::List& unselectedLinks, Vec3f::List& selectedKillLinks, Vec3f::List& unselectedKillLinks) const {
-            if (context.viewOptions().linkDisplayMode() == View::ViewOptions::LinkDisplayLocal && depth > 1)
+        
+        void EntityLinkDecorator::removeLinkSources(Model::Entity& entity, const Model::EntityList& targets) {
+            Model::EntityList::const_iterator it, end;
+            for (it = targets.begin(), end = targets.end(); it != end; ++it) {
+                LinkSourceMap::iterator sourceIt = m_sources.find(*it);
+                if (sourceIt != m_sources.end()) {
+                    sourceIt->second.erase(&entity);
+                    if (sourceIt->second.empty())
+                        m_sources.erase(sourceIt);
+                }
+            }
+        }
+        
+        void EntityLinkDecorator::removeSlot(Model::Entity& entity) {
+            LinkSlotMap::iterator it = m_slots.find(&entity);
+            if (it == m_slots.end())
                 return;
+            
+            LinkSlot& slot = it->second;
+            removeLinkSources(entity, slot.linkTargets);
+            removeLinkSources(entity, slot.killTargets);
+            if (slot.block != NULL)
+                slot.block->freeBlock();
+            m_slots.erase(it);
+        }
+        
+        void EntityLinkDecorator::updateSlot(Model::Entity& entity) {
+            const Model::EntityList& linkTargets = entity.linkTargets();
+            const Model::EntityList& killTargets = entity.killTargets();
+            if (linkTargets.empty() && killTargets.empty()) {
+                removeSlot(entity);
+                return;
+            }
+            
+            LinkSlotMap::iterator it = m_slots.find(&entity);
+            if (it == m_slots.end())
+                it = m_slots.insert(LinkSlotMap::value_type(&entity, LinkSlot())).first;
+            
+            LinkSlot& slot = it->second;
+            removeLinkSources(entity, slot.linkTargets);
+            removeLinkSources(entity, slot.killTargets);
+            slot.linkTargets = linkTargets;
+            slot.killTargets = killTargets;
+            addLinkSources(entity, slot.linkTargets);
+            addLinkSources(entity, slot.killTargets);
+            
+            const size_t capacity = 2 * (linkTargets.size() + killTargets.size()) * VertexSize;
+            if (slot.block != NULL && slot.block->capacity() != capacity) {
+                slot.block->freeBlock();
+                slot.block = NULL;
+            }
+            if (slot.block == NULL)
+                slot.block = m_vbo->allocBlock(capacity);
+            
+            const Vec3f center = entity.center();
+            size_t offset = 0;
+            Model::EntityList::const_iterator targetIt, targetEnd;
+            for (targetIt = linkTargets.begin(), targetEnd = linkTargets.end(); targetIt != targetEnd; ++targetIt) {
+                offset = slot.block->writeVec((*targetIt)->center(), offset);
+                offset = slot.block->writeVec(center, offset);
+            }
+            for (targetIt = killTargets.begin(), targetEnd = killTargets.end(); targetIt != targetEnd; ++targetIt) {
+                offset = slot.block->writeVec((*targetIt)->center(), offset);
+                offset = slot.block->writeVec(center, offset);
+            }
+        }
+        
+        void EntityLinkDecorator::validateGraph() {
+            if (!m_graphValid) {
+                const Model::EntityList& entities = document().map().entities();
+                m_invalidEntities.insert(entities.begin(), entities.end());
+                m_graphValid = true;
+            }
+            
+            if (!m_invalidEntities.empty()) {
+                SetVboState mapVbo(*m_vbo, Vbo::VboMapped);
+                Model::EntitySet::const_iterator it, end;
+                for (it = m_invalidEntities.begin(), end = m_invalidEntities.end(); it != end; ++it)
+                    updateSlot(**it);
+                m_invalidEntities.clear();
+                m_rangesValid = false;
+            }
+            
+            if (m_vbo->fragmentation() > 0.5f) {
+                Vbo::MoveList moves;
+                m_vbo->compact(CompactionBudget, moves);
+                if (m_rangesValid) {
+                    m_selectedLinks.shift(moves);
+                    m_unselectedLinks.shift(moves);
+                    m_selectedKillLinks.shift(moves);
+                    m_unselectedKillLinks.shift(moves);
+                }
+            }
+        }
 
+        void EntityLinkDecorator::addLinks(RenderContext& context, Model::Entity& entity, const Model::EntityList& targets, size_t firstVertex, LinkRanges& selectedLinks, LinkRanges& unselectedLinks) const {
+            const bool localOnly = context.viewOptions().linkDisplayMode() == View::ViewOptions::LinkDisplayLocal;
+            const bool entitySelected = entity.selected() || entity.partiallySelected();
+            
+            for (size_t i = 0; i < targets.size(); i++) {
+                Model::Entity& target = *targets[i];
+                const bool selected = entitySelected || target.selected() || target.partiallySelected();
+                if (context.filter().entityVisible(target) && (!localOnly || selected))
+                    (selected ? selectedLinks : unselectedLinks).add(static_cast<GLint>(firstVertex + 2 * i), 2);
+            }
+        }
+        
+        void EntityLinkDecorator::buildRanges(RenderContext& context, Model::Entity& entity, size_t depth, Model::EntitySet& visitedEntities) {
+            const bool localOnly = context.viewOptions().linkDisplayMode() == View::ViewOptions::LinkDisplayLocal;
+            if (localOnly && depth > 1)
+                return;
+            
             Model::EntitySet::iterator visitedIt = visitedEntities.lower_bound(&entity);
             if (visitedIt != visitedEntities.end() && *visitedIt == &entity)
                 return;
-
             visitedEntities.insert(visitedIt, &entity);
-            const bool entityVisible = context.filter().entityVisible(entity);
-
-            Model::EntityList::const_iterator entityIt, entityEnd;
             
-            const Model::EntityList& linkTargets = entity.linkTargets();
-            for (entityIt = linkTargets.begin(), entityEnd = linkTargets.end(); entityIt != entityEnd; ++entityIt) {
-                Model::Entity& target = **entityIt;
-                if (entityVisible && context.filter().entityVisible(target) &&
-                    (context.viewOptions().linkDisplayMode() != View::ViewOptions::LinkDisplayLocal || entity.selected() || entity.partiallySelected() || target.selected() || target.partiallySelected()))
-                    makeLink(target, entity, entity.selected() || entity.partiallySelected() || target.selected() || target.partiallySelected() ? selectedLinks : unselectedLinks);
-                if (context.viewOptions().linkDisplayMode() != View::ViewOptions::LinkDisplayLocal || depth == 0)
-                    buildLinks(context, target, depth + 1, visitedEntities, selectedLinks, unselectedLinks, selectedKillLinks, unselectedKillLinks);
+            LinkSlotMap::const_iterator slotIt = m_slots.find(&entity);
+            if (slotIt != m_slots.end()) {
+                const LinkSlot& slot = slotIt->second;
+                if (context.filter().entityVisible(entity)) {
+                    assert(slot.block->address() % VertexSize == 0);
+                    const size_t firstVertex = slot.block->address() / VertexSize;
+                    addLinks(context, entity, slot.linkTargets, firstVertex, m_selectedLinks, m_unselectedLinks);
+                    addLinks(context, entity, slot.killTargets, firstVertex + 2 * slot.linkTargets.size(), m_selectedKillLinks, m_unselectedKillLinks);
+                }
+                
+                if (!localOnly || depth == 0) {
+                    Model::EntityList::const_iterator targetIt, targetEnd;
+                    for (targetIt = slot.linkTargets.begin(), targetEnd = slot.linkTargets.end(); targetIt != targetEnd; ++targetIt)
+                        buildRanges(context, **targetIt, depth + 1, visitedEntities);
+                    for (targetIt = slot.killTargets.begin(), targetEnd = slot.killTargets.end(); targetIt != targetEnd; ++targetIt)
+                        buildRanges(context, **targetIt, depth + 1, visitedEntities);
+                }
             }
             
-            const Model::EntityList& linkSources = entity.linkSources();
-            for (entityIt = linkSources.begin(), entityEnd = linkSources.end(); entityIt != entityEnd; ++entityIt) {
-                Model::Entity& source = **entityIt;
-                if (context.viewOptions().linkDisplayMode() != View::ViewOptions::LinkDisplayLocal || depth <= 1)
-                    buildLinks(context, source, depth + 1, visitedEntities, selectedLinks, unselectedLinks, selectedKillLinks, unselectedKillLinks);
+            if (!localOnly || depth <= 1) {
+                LinkSourceMap::const_iterator sourceIt = m_sources.find(&entity);
+                if (sourceIt != m_sources.end()) {
+                    const Model::EntitySet& sources = sourceIt->second;
+                    Model::EntitySet::const_iterator it, end;
+                    for (it = sources.begin(), end = sources.end(); it != end; ++it)
+                        buildRanges(context, **it, depth + 1, visitedEntities);
+                }
             }
+        }
+        
+        void EntityLinkDecorator::validateRanges(RenderContext& context) {
+            if (m_rangesValid && m_linkDisplayMode == context.viewOptions().linkDisplayMode())
+                return;
             
-            const Model::EntityList& killTargets = entity.killTargets();
-            for (entityIt = killTargets.begin(), entityEnd = killTargets.end(); entityIt != entityEnd; ++entityIt) {
-                Model::Entity& target = **entityIt;
-                if (entityVisible && context.filter().entityVisible(target) &&
-                    (context.viewOptions().linkDisplayMode() != View::ViewOptions::LinkDisplayLocal || entity.selected() || entity.partiallySelected() || target.selected() || target.partiallySelected()))
-                    makeLink(target, entity, entity.selected() || entity.partiallySelected() || target.selected() || target.partiallySelected() ? selectedKillLinks : unselectedKillLinks);
-                if (context.viewOptions().linkDisplayMode() != View::ViewOptions::LinkDisplayLocal || depth == 0)
-                    buildLinks(context, target, depth + 1, visitedEntities, selectedLinks, unselectedLinks, selectedKillLinks, unselectedKillLinks);
-            }
+            m_selectedLinks.clear();
+            m_unselectedLinks.clear();
+            m_selectedKillLinks.clear();
+            m_unselectedKillLinks.clear();
             
-            const Model::EntityList& killSources = entity.killSources();
-            for (entityIt = killSources.begin(), entityEnd = killSources.end(); entityIt != entityEnd; ++entityIt) {
-                Model::Entity& source = **entityIt;
-                if (context.viewOptions().linkDisplayMode() != View::ViewOptions::LinkDisplayLocal || depth <= 1)
-                    buildLinks(context, source, depth + 1, visitedEntities, selectedLinks, unselectedLinks, selectedKillLinks, unselectedKillLinks);
+            Model::EntitySet visitedEntities;
+            if (context.viewOptions().linkDisplayMode() == View::ViewOptions::LinkDisplayAll) {
+                LinkSlotMap::const_iterator it, end;
+                for (it = m_slots.begin(), end = m_slots.end(); it != end; ++it)
+                    buildRanges(context, *it->first, 0, visitedEntities);
+            } else {
+                const Model::EntityList entities = document().editStateManager().allSelectedEntities();
+                Model::EntityList::const_iterator it, end;
+                for (it = entities.begin(), end = entities.end(); it != end; ++it)
+                    buildRanges(context, **it, 0, visitedEntities);
             }
+            
+            m_linkDisplayMode = context.viewOptions().linkDisplayMode();
+            m_rangesValid = true;
         }
 
         EntityLinkDecorator::EntityLinkDecorator(const Model::MapDocument& document, const Color& color) :
         EntityDecorator(document),
         m_color(color),
-        m_selectedLinkArray(NULL),
-        m_unselectedLinkArray(NULL),
-        m_selectedKillLinkArray(NULL),
-        m_unselectedKillLinkArray(NULL),
-        m_valid(false) {}
+        m_vbo(new Vbo(GL_ARRAY_BUFFER, 0x1000 * VertexSize)),
+        m_graphValid(false),
+        m_linkDisplayMode(View::ViewOptions::LinkDisplayNone),
+        m_rangesValid(false) {}
 
         EntityLinkDecorator::~EntityLinkDecorator() {
             clear();
+            delete m_vbo;
+            m_vbo = NULL;
+        }
+        
+        void EntityLinkDecorator::invalidate() {
+            clear();
+            m_graphValid = false;
+            m_rangesValid = false;
+        }
+        
+        void EntityLinkDecorator::invalidateEntities(const Model::EntityList& entities) {
+            Model::EntityList::const_iterator it, end;
+            for (it = entities.begin(), end = entities.end(); it != end; ++it) {
+                Model::Entity& entity = **it;
+                
+                // the entities linking to this entity must rewrite the end points of their links
+                LinkSourceMap::const_iterator sourceIt = m_sources.find(&entity);
+                if (sourceIt != m_sources.end())
+                    m_invalidEntities.insert(sourceIt->second.begin(), sourceIt->second.end());
+                
+                if (entity.map() == NULL) {
+                    // removed entities may be deleted before the next render pass, so we must forget them now
+                    removeSlot(entity);
+                    m_invalidEntities.erase(&entity);
+                } else {
+                    m_invalidEntities.insert(&entity);
+                    m_invalidEntities.insert(entity.linkSources().begin(), entity.linkSources().end());
+                    m_invalidEntities.insert(entity.killSources().begin(), entity.killSources().end());
+                }
+            }
+            m_rangesValid = false;
         }
 
         void EntityLinkDecorator::render(Vbo& vbo, RenderContext& context) {
             if (context.viewOptions().linkDisplayMode() == View::ViewOptions::LinkDisplayNone)
                 return;
 
-            SetVboState activateVbo(vbo, Vbo::VboActive);
+            validateGraph();
+            validateRanges(context);
             
-            if (!m_valid) {
-                clear();
-                
-                Vec3f::List selectedLinks, unselectedLinks, selectedKillLinks, unselectedKillLinks;
-                Model::EntitySet visitedEntities;
-
-                const Model::EntityList& entities = context.viewOptions().linkDisplayMode() == View::ViewOptions::LinkDisplayAll ? document().map().entities() : document().editStateManager().allSelectedEntities();
-                Model::EntityList::const_iterator it, end;
-                for (it = entities.begin(), end = entities.end(); it != end; ++it) {
-                    Model::Entity& entity = **it;
-                    buildLinks(context, entity, 0, visitedEntities, selectedLinks, unselectedLinks, selectedKillLinks, unselectedKillLinks);
-                }
-                
-                SetVboState mapVbo(vbo, Vbo::VboMapped);
-                if (!selectedLinks.empty()) {
-                    m_selectedLinkArray = new VertexArray(vbo, GL_LINES, static_cast<unsigned int>(selectedLinks.size()), Attribute::position3f(), 0);
-                    m_selectedLinkArray->addAttributes(selectedLinks);
-                }
-                
-                if (!unselectedLinks.empty()) {
-                    m_unselectedLinkArray = new VertexArray(vbo, GL_LINES, static_cast<unsigned int>(unselectedLinks.size()), Attribute::position3f(), 0);
-                    m_unselectedLinkArray->addAttributes(unselectedLinks);
-                }
-
-                if (!selectedKillLinks.empty()) {
-                    m_selectedKillLinkArray = new VertexArray(vbo, GL_LINES, static_cast<unsigned int>(selectedKillLinks.size()), Attribute::position3f(), 0);
-                    m_selectedKillLinkArray->addAttributes(selectedKillLinks);
-                }
-                
-                if (!unselectedKillLinks.empty()) {
-                    m_unselectedKillLinkArray = new VertexArray(vbo, GL_LINES, static_cast<unsigned int>(unselectedKillLinks.size()), Attribute::position3f(), 0);
-                    m_unselectedKillLinkArray->addAttributes(unselectedKillLinks);
-                }
-
-                m_valid = true;
-            }
-
-            if (m_selectedLinkArray == NULL && m_unselectedLinkArray == NULL)
+            if (m_selectedLinks.empty() && m_unselectedLinks.empty() &&
+                m_selectedKillLinks.empty() && m_unselectedKillLinks.empty())
                 return;
 
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
@@ -172,48 +287,53 @@ namespace TrenchBroom {
             glDepthMask(GL_FALSE);
             glDisable(GL_DEPTH_TEST);
 
-            if (m_unselectedLinkArray != NULL) {
+            SetVboState activateVbo(*m_vbo, Vbo::VboActive);
+            Attribute position = Attribute::position3f();
+            position.setGLState(0, VertexSize, 0);
+
+            if (!m_unselectedLinks.empty()) {
                 shader.setUniformVariable("Color", prefs.getColor(Preferences::OccludedEntityLinkColor));
-                m_unselectedLinkArray->render();
+                m_unselectedLinks.render(GL_LINES);
             }
             
-            if (m_selectedLinkArray != NULL) {
+            if (!m_selectedLinks.empty()) {
                 shader.setUniformVariable("Color", prefs.getColor(Preferences::OccludedSelectedEntityLinkColor));
-                m_selectedLinkArray->render();
+                m_selectedLinks.render(GL_LINES);
             }
             
-            if (m_unselectedKillLinkArray != NULL) {
+            if (!m_unselectedKillLinks.empty()) {
                 shader.setUniformVariable("Color", prefs.getColor(Preferences::OccludedEntityKillLinkColor));
-                m_unselectedKillLinkArray->render();
+                m_unselectedKillLinks.render(GL_LINES);
             }
             
-            if (m_selectedKillLinkArray != NULL) {
+            if (!m_selectedKillLinks.empty()) {
                 shader.setUniformVariable("Color", prefs.getColor(Preferences::OccludedSelectedEntityKillLinkColor));
-                m_selectedKillLinkArray->render();
+                m_selectedKillLinks.render(GL_LINES);
             }
             
             glEnable(GL_DEPTH_TEST);
 
-            if (m_unselectedLinkArray != NULL) {
+            if (!m_unselectedLinks.empty()) {
                 shader.setUniformVariable("Color", prefs.getColor(Preferences::EntityLinkColor));
-                m_unselectedLinkArray->render();
+                m_unselectedLinks.render(GL_LINES);
             }
 
-            if (m_selectedLinkArray != NULL) {
+            if (!m_selectedLinks.empty()) {
                 shader.setUniformVariable("Color", prefs.getColor(Preferences::SelectedEntityLinkColor));
-                m_selectedLinkArray->render();
+                m_selectedLinks.render(GL_LINES);
             }
             
-            if (m_unselectedKillLinkArray != NULL) {
+            if (!m_unselectedKillLinks.empty()) {
                 shader.setUniformVariable("Color", prefs.getColor(Preferences::EntityKillLinkColor));
-                m_unselectedKillLinkArray->render();
+                m_unselectedKillLinks.render(GL_LINES);
             }
             
-            if (m_selectedKillLinkArray != NULL) {
+            if (!m_selectedKillLinks.empty()) {
                 shader.setUniformVariable("Color", prefs.getColor(Preferences::SelectedEntityKillLinkColor));
-                m_selectedKillLinkArray->render();
+                m_selectedKillLinks.render(GL_LINES);
             }
 
+            position.clearGLState(0);
             glDepthMask(GL_TRUE);
             glLineWidth(1.0f);
         }
@@ -21,37 +21,116 @@
 #define __TrenchBroom__EntityLinkDecorator__
 
 #include "Renderer/EntityDecorator.h"
+#include "Renderer/RenderStatistics.h"
+#include "Renderer/Vbo.h"
 
 #include "Model/Entity.h"
 #include "Utility/Color.h"
 #include "View/ViewOptions.h"
 
+#include <GL/glew.h>
+
+#include <map>
+#include <vector>
+
 namespace TrenchBroom {
     namespace Model {
         class MapDocument;
     }
     
     namespace Renderer {
-        class VertexArray;
-        
+        /**
+         * Renders the target and killtarget links between entities. The decorator maintains a link graph of the
+         * entire map where every entity with outgoing links owns a block of its own in the decorator's VBO. That
+         * block contains the line vertices of the entity's links, first its targets, then its killtargets. If an
+         * entity changes, only its own block and the blocks of the entities linking to it are rewritten. Selection
+         * and visibility changes only recompute the ranges of vertices which are drawn.
+         */
         class EntityLinkDecorator : public EntityDecorator {
         private:
+            struct LinkSlot {
+                VboBlock* block;
+                Model::EntityList linkTargets;
+                Model::EntityList killTargets;
+                
+                LinkSlot() :
+                block(NULL) {}
+            };
+            
+            class LinkRanges {
+            private:
+                std::vector<GLint> m_firsts;
+                std::vector<GLsizei> m_counts;
+            public:
+                inline void add(GLint first, GLsizei count) {
+                    if (!m_firsts.empty() && m_firsts.back() + m_counts.back() == first) {
+                        m_counts.back() += count;
+                    } else {
+                        m_firsts.push_back(first);
+                        m_counts.push_back(count);
+                    }
+                }
+                
+                inline void clear() {
+                    m_firsts.clear();
+                    m_counts.clear();
+                }
+                
+                inline void shift(const Vbo::MoveList& moves) {
+                    Vbo::shiftRanges(moves, VertexSize, m_firsts, m_counts);
+                }
+                
+                inline bool empty() const {
+                    return m_firsts.empty();
+                }
+                
+                inline void render(GLenum primType) const {
+                    if (!m_firsts.empty()) {
+                        RenderStatistics::countDrawCall();
+                        glMultiDrawArrays(primType, &m_firsts.front(), &m_counts.front(), static_cast<GLsizei>(m_firsts.size()));
+                    }
+                }
+            };
+            
+            typedef std::map<Model::Entity*, LinkSlot> LinkSlotMap;
+            typedef std::map<Model::Entity*, Model::EntitySet> LinkSourceMap;
+            
+            static const size_t VertexSize = 3 * sizeof(float);
+            static const size_t CompactionBudget = 0x4000;
+            
             Color m_color;
-            VertexArray* m_selectedLinkArray;
-            VertexArray* m_unselectedLinkArray;
-            VertexArray* m_selectedKillLinkArray;
-            VertexArray* m_unselectedKillLinkArray;
-            bool m_valid;
+            Vbo* m_vbo;
+            LinkSlotMap m_slots;
+            LinkSourceMap m_sources;
+            Model::EntitySet m_invalidEntities;
+            bool m_graphValid;
+            
+            LinkRanges m_selectedLinks;
+            LinkRanges m_unselectedLinks;
+            LinkRanges m_selectedKillLinks;
+            LinkRanges m_unselectedKillLinks;
+            View::ViewOptions::LinkDisplayMode m_linkDisplayMode;
+            bool m_rangesValid;
             
             void clear();
-            void makeLink(Model::Entity& source, Model::Entity& target, Vec3f::List& vertices) const;
-            void buildLinks(RenderContext& context, Model::Entity& entity, size_t depth, Model::EntitySet& visitedEntities, Vec3f::List& selectedLinks, Vec3f::List& unselectedLinks, Vec3f::List& selectedKillLinks, Vec3f::List& unselectedKillLinks) const;
+            void addLinkSources(Model::Entity& entity, const Model::EntityList& targets);
+            void removeLinkSources(Model::Entity& entity, const Model::EntityList& targets);
+            void removeSlot(Model::Entity& entity);
+            void updateSlot(Model::Entity& entity);
+            void validateGraph();
+            
+            void addLinks(RenderContext& context, Model::Entity& entity, const Model::EntityList& targets, size_t firstVertex, LinkRanges& selectedLinks, LinkRanges& unselectedLinks) const;
+            void buildRanges(RenderContext& context, Model::Entity& entity, size_t depth, Model::EntitySet& visitedEntities);
+            void validateRanges(RenderContext& context);
         public:
             EntityLinkDecorator(const Model::MapDocument& document, const Color& color);
             ~EntityLinkDecorator();
             
-            inline void invalidate() {
-                m_valid = false;
+            void invalidate();
+            void invalidateEntities(const Model::EntityList& entities);
+            
+            inline void invalidateEditState() {
+                m_rangesValid = false;
             }
 
             void render(Vbo& vbo, RenderContext& context);
@@ -73,7 +73,7 @@ namespace TrenchBroom {
                 Model::AliasManager& aliasManager = *Model::AliasManager::sharedManager;
                 const Model::Alias* alias = aliasManager.alias(modelName, searchPaths, m_console);
 
-                if (alias != NULL && skinIndex < alias->skins().size() && frameIndex < alias->frames().size()) {
+                if (alias != NULL && skinIndex < alias->skins().size() && frameIndex < alias->frameCount()) {
                     Renderer::EntityModelRenderer* renderer = new AliasModelRenderer(*alias, frameIndex, skinIndex, *m_vbo, *m_palette);
                     m_modelRenderers[key] = renderer;
                     return renderer;
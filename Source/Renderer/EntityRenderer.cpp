@@ -53,79 +53,10 @@ namespace TrenchBroom {
             return context.filter().entityVisible(*entity);
         }
 
-        void EntityRenderer::writeColoredBounds(RenderContext& context, const Model::EntityList& entities) {
-            if (entities.empty())
-                return;
-
-            Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
-            Vec3f::List vertices(24);
-
-            for (unsigned int i = 0; i < entities.size(); i++) {
-                Model::Entity* entity = entities[i];
-                const BBoxf& bounds = entity->bounds();
-                const Model::EntityDefinition* definition = entity->definition();
-                Color entityColor;
-                if (definition != NULL) {
-                    entityColor = definition->color();
-                    entityColor[3] = prefs.getColor(Preferences::EntityBoundsColor).a();
-                } else {
-                    entityColor = prefs.getColor(Preferences::EntityBoundsColor);
-                }
-
-                bounds.vertices(vertices);
-                for (unsigned int j = 0; j < vertices.size(); j++) {
-                    m_boundsVertexArray->addAttribute(vertices[j]);
-                    m_boundsVertexArray->addAttribute(entityColor);
-                }
-            }
-        }
-
-        void EntityRenderer::writeBounds(RenderContext& context, const Model::EntityList& entities) {
-            if (entities.empty())
-                return;
-
-            Vec3f::List vertices(24);
-            for (unsigned int i = 0; i < entities.size(); i++) {
-                Model::Entity* entity = entities[i];
-                const BBoxf& bounds = entity->bounds();
-                bounds.vertices(vertices);
-
-                for (unsigned int j = 0; j < vertices.size(); j++)
-                    m_boundsVertexArray->addAttribute(vertices[j]);
-            }
-        }
-
         void EntityRenderer::validateBounds(RenderContext& context) {
-            delete m_boundsVertexArray;
-            m_boundsVertexArray = NULL;
-
-            Model::EntityList entities;
-            Model::EntitySet::iterator entityIt, entityEnd;
-            for (entityIt = m_entities.begin(), entityEnd = m_entities.end(); entityIt != entityEnd; ++entityIt) {
-                Model::Entity* entity = *entityIt;
-                if (context.filter().entityVisible(*entity))
-                    entities.push_back(entity);
-            }
-
-            if (entities.empty())
-                return;
-
-            SetVboState mapVbo(m_boundsVbo, Vbo::VboMapped);
-
-            if (m_overrideBoundsColor) {
-                unsigned int vertexCount = 2 * 4 * 6 * static_cast<unsigned int>(entities.size());
-                m_boundsVertexArray = new VertexArray(m_boundsVbo, GL_LINES, vertexCount,
-                                                      Attribute::position3f());
-                writeBounds(context, entities);
-            } else {
-                unsigned int vertexCount = 2 * 4 * 6 * static_cast<unsigned int>(entities.size());
-                m_boundsVertexArray = new VertexArray(m_boundsVbo, GL_LINES, vertexCount,
-                                                      Attribute::position3f(),
-                                                      Attribute::color4f());
-                writeColoredBounds(context, entities);
-            }
-
-            m_boundsValid = true;
+            Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
+            m_boundsArray.setDefaultColor(prefs.getColor(Preferences::EntityBoundsColor));
+            m_boundsArray.validate(context.filter());
         }
 
         void EntityRenderer::validateModels(RenderContext& context) {
@@ -147,33 +78,28 @@ namespace TrenchBroom {
         }
 
         void EntityRenderer::renderBounds(RenderContext& context) {
-            if (m_boundsVertexArray == NULL)
-                return;
-
             ShaderManager& shaderManager = m_document.sharedResources().shaderManager();
 
-            m_boundsVbo.activate();
             if (m_overrideBoundsColor) {
                 ShaderProgram& edgeProgram = shaderManager.shaderProgram(Shaders::EdgeShader);
                 if (edgeProgram.activate()) {
                     if (m_renderOccludedBounds) {
                         glDisable(GL_DEPTH_TEST);
                         edgeProgram.setUniformVariable("Color", m_occludedBoundsColor);
-                        m_boundsVertexArray->render();
+                        m_boundsArray.render();
                         glEnable(GL_DEPTH_TEST);
                     }
                     edgeProgram.setUniformVariable("Color", m_boundsColor);
-                    m_boundsVertexArray->render();
+                    m_boundsArray.render();
                     edgeProgram.deactivate();
                 }
             } else {
                 ShaderProgram& coloredEdgeProgram = shaderManager.shaderProgram(Shaders::ColoredEdgeShader);
                 if (coloredEdgeProgram.activate()) {
-                    m_boundsVertexArray->render();
+                    m_boundsArray.render();
                     coloredEdgeProgram.deactivate();
                 }
             }
-            m_boundsVbo.deactivate();
         }
 
         void EntityRenderer::renderClassnames(RenderContext& context) {
@@ -230,11 +156,8 @@ namespace TrenchBroom {
             }
         }
 
-        EntityRenderer::EntityRenderer(Vbo& boundsVbo, Model::MapDocument& document) :
-        m_boundsVbo(boundsVbo),
+        EntityRenderer::EntityRenderer(Model::MapDocument& document) :
         m_document(document),
-        m_boundsVertexArray(NULL),
-        m_boundsValid(true),
         m_modelRendererCacheValid(true),
         m_classnameRenderer(NULL),
         m_classnameColor(1.0f, 1.0f, 1.0f, 1.0f),
@@ -258,8 +181,6 @@ namespace TrenchBroom {
         }
 
         EntityRenderer::~EntityRenderer() {
-            delete m_boundsVertexArray;
-            m_boundsVertexArray = NULL;
             delete m_classnameRenderer;
             m_classnameRenderer = NULL;
         }
@@ -286,8 +207,7 @@ namespace TrenchBroom {
             }
 
 
-            m_entities.insert(&entity);
-            m_boundsValid = false;
+            m_boundsArray.addEntity(entity);
         }
 
         void EntityRenderer::addEntities(const Model::EntityList& entities) {
@@ -308,23 +228,34 @@ namespace TrenchBroom {
 
                     m_classnameRenderer->addString(entity, *classname, Text::TextAnchor::Ptr(new EntityClassnameAnchor(*entity, renderer)));
                 }
+                m_boundsArray.addEntity(*entity);
             }
 
             m_entities.insert(entities.begin(), entities.end());
-            m_boundsValid = false;
         }
 
         void EntityRenderer::invalidateBounds() {
-            m_boundsValid = false;
+            m_boundsArray.invalidateAll();
+            m_classnameRenderer->invalidatePositions();
+        }
+        
+        void EntityRenderer::invalidateBounds(const Model::EntityList& entities) {
+            m_boundsArray.invalidateEntities(entities);
+            m_classnameRenderer->invalidatePositions();
+        }
+        
+        void EntityRenderer::invalidateVisibility() {
+            m_boundsArray.invalidateVisibility();
         }
 
         void EntityRenderer::invalidateModels() {
             m_modelRendererCacheValid = false;
+            m_classnameRenderer->invalidatePositions();
         }
 
         void EntityRenderer::clear() {
             m_entities.clear();
-            m_boundsValid = false;
+            m_boundsArray.clear();
             m_modelRenderers.clear();
             m_modelRendererCacheValid = true;
             m_classnameRenderer->clear();
@@ -334,7 +265,7 @@ namespace TrenchBroom {
             m_modelRenderers.erase(&entity);
             m_classnameRenderer->removeString(&entity);
             m_entities.erase(&entity);
-            m_boundsValid = false;
+            m_boundsArray.removeEntity(entity);
         }
 
         void EntityRenderer::removeEntities(const Model::EntityList& entities) {
@@ -346,13 +277,12 @@ namespace TrenchBroom {
                 m_modelRenderers.erase(entity);
                 m_classnameRenderer->removeString(entity);
                 m_entities.erase(entity);
+                m_boundsArray.removeEntity(*entity);
             }
-            m_boundsValid = false;
         }
 
         void EntityRenderer::render(RenderContext& context) {
-            if (!m_boundsValid)
-                validateBounds(context);
+            validateBounds(context);
             if (!m_modelRendererCacheValid)
                 validateModels(context);
 
@@ -21,6 +21,7 @@
 #define __TrenchBroom__EntityRenderer__
 
 #include "Model/EntityTypes.h"
+#include "Renderer/EntityBoundsArray.h"
 #include "Renderer/RenderContext.h"
 #include "Renderer/Shader/Shader.h"
 #include "Renderer/Text/TextRenderer.h"
@@ -39,8 +40,6 @@ namespace TrenchBroom {
     
     namespace Renderer {
         class EntityModelRenderer;
-        class Vbo;
-        class VertexArray;
         
         class EntityRenderer {
         private:
@@ -76,12 +75,10 @@ namespace TrenchBroom {
                 inline bool stringVisible(RenderContext& context, const EntityKey& entity) const;
             };
             
-            Vbo& m_boundsVbo;
             Model::MapDocument& m_document;
             
             Model::EntitySet m_entities;
-            VertexArray* m_boundsVertexArray;
-            bool m_boundsValid;
+            EntityBoundsArray m_boundsArray;
             EntityModelRenderers m_modelRenderers;
             bool m_modelRendererCacheValid;
             EntityClassnameRenderer* m_classnameRenderer;
@@ -99,8 +96,6 @@ namespace TrenchBroom {
             Color m_tintColor;
             bool m_grayscale;
             
-            void writeColoredBounds(RenderContext& context, const Model::EntityList& entities);
-            void writeBounds(RenderContext& context, const Model::EntityList& entities);
             void validateBounds(RenderContext& context);
             void validateModels(RenderContext& context);
             
@@ -113,7 +108,7 @@ namespace TrenchBroom {
             EntityRenderer(const EntityRenderer& other);
             void operator= (const EntityRenderer& other);
         public:
-            EntityRenderer(Vbo& boundsVbo, Model::MapDocument& document);
+            EntityRenderer(Model::MapDocument& document);
             ~EntityRenderer();
             
             void setClassnameFadeDistance(float classnameFadeDistance);
@@ -136,10 +131,12 @@ namespace TrenchBroom {
             inline void setBoundsColor(const Color& boundsColor) {
                 m_boundsColor = boundsColor;
                 m_overrideBoundsColor = true;
+                m_boundsArray.setColored(false);
             }
             
             inline void disableOverrideBoundsColor() {
                 m_overrideBoundsColor = false;
+                m_boundsArray.setColored(true);
             }
             
             inline void setOccludedBoundsColor(const Color& occludedBoundsColor) {
@@ -169,6 +166,8 @@ namespace TrenchBroom {
             void removeEntity(Model::Entity& entity);
             void removeEntities(const Model::EntityList& entities);
             void invalidateBounds();
+            void invalidateBounds(const Model::EntityList& entities);
+            void invalidateVisibility();
             void invalidateModels();
             void clear();
             
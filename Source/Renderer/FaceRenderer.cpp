@@ -95,35 +95,36 @@ namespace TrenchBroom {
                 faceProgram.setUniformVariable("ShadeFaces", context.viewOptions().shadeFaces() );
                 faceProgram.setUniformVariable("UseFog", context.viewOptions().useFog() );
                 
-                renderOpaqueFaces(faceProgram, applyTexture);
+                const TextureUniforms uniforms(faceProgram);
+                renderOpaqueFaces(faceProgram, uniforms, applyTexture);
                 glDepthMask(GL_FALSE);
                 faceProgram.setUniformVariable("Alpha", prefs.getFloat(Preferences::TransparentFaceAlpha));
-                renderTransparentFaces(faceProgram, applyTexture);
+                renderTransparentFaces(faceProgram, uniforms, applyTexture);
                 glDepthMask(GL_TRUE);
 
                 faceProgram.deactivate();
             }
         }
 
-        void FaceRenderer::renderOpaqueFaces(ShaderProgram& shader, const bool applyTexture) {
-            renderFaces(m_vertexArrays, shader, applyTexture);
+        void FaceRenderer::renderOpaqueFaces(ShaderProgram& shader, const TextureUniforms& uniforms, const bool applyTexture) {
+            renderFaces(m_vertexArrays, shader, uniforms, applyTexture);
         }
         
-        void FaceRenderer::renderTransparentFaces(ShaderProgram& shader, const bool applyTexture) {
-            renderFaces(m_transparentVertexArrays, shader, applyTexture);
+        void FaceRenderer::renderTransparentFaces(ShaderProgram& shader, const TextureUniforms& uniforms, const bool applyTexture) {
+            renderFaces(m_transparentVertexArrays, shader, uniforms, applyTexture);
         }
 
-        void FaceRenderer::renderFaces(const TextureVertexArrayList& vertexArrays, ShaderProgram& shader, const bool applyTexture) {
+        void FaceRenderer::renderFaces(const TextureVertexArrayList& vertexArrays, ShaderProgram& shader, const TextureUniforms& uniforms, const bool applyTexture) {
             for (size_t i = 0; i < vertexArrays.size(); i++) {
                 const TextureVertexArray& textureVertexArray = vertexArrays[i];
                 if (textureVertexArray.texture != NULL) {
                     textureVertexArray.texture->activate();
-                    shader.setUniformVariable("ApplyTexture", applyTexture);
-                    shader.setUniformVariable("FaceTexture", 0);
-                    shader.setUniformVariable("Color", textureVertexArray.texture->averageColor());
+                    shader.setUniformVariable(uniforms.applyTexture, applyTexture);
+                    shader.setUniformVariable(uniforms.faceTexture, 0);
+                    shader.setUniformVariable(uniforms.color, textureVertexArray.texture->averageColor());
                 } else {
-                    shader.setUniformVariable("ApplyTexture", false);
-                    shader.setUniformVariable("Color", m_faceColor);
+                    shader.setUniformVariable(uniforms.applyTexture, false);
+                    shader.setUniformVariable(uniforms.color, m_faceColor);
                 }
                 
                 textureVertexArray.vertexArray->render();
@@ -21,6 +21,7 @@
 #define __TrenchBroom__FaceRenderer__
 
 #include "Renderer/TexturedPolygonSorter.h"
+#include "Renderer/Shader/ShaderProgram.h"
 #include "Renderer/TextureVertexArray.h"
 #include "Utility/Color.h"
 
@@ -41,6 +42,21 @@ namespace TrenchBroom {
         protected:
             typedef Sorter::PolygonCollection FaceCollection;
             typedef Sorter::PolygonCollectionMap FaceCollectionMap;
+            
+            /**
+             * The uniforms that are set once per texture.
+             */
+            class TextureUniforms {
+            public:
+                ShaderProgram::UniformHandle applyTexture;
+                ShaderProgram::UniformHandle faceTexture;
+                ShaderProgram::UniformHandle color;
+                
+                TextureUniforms(ShaderProgram& shader) :
+                applyTexture(shader.uniformHandle("ApplyTexture")),
+                faceTexture(shader.uniformHandle("FaceTexture")),
+                color(shader.uniformHandle("Color")) {}
+            };
 
             Color m_faceColor;
             TextureVertexArrayList m_vertexArrays;
@@ -61,9 +77,9 @@ namespace TrenchBroom {
             
             void writeFaceData(Vbo& vbo, TextureRendererManager& textureRendererManager, const Sorter& faceSorter);
             void render(RenderContext& context, bool grayScale, const Color* tintColor);
-            void renderOpaqueFaces(ShaderProgram& shader, const bool applyTexture);
-            void renderTransparentFaces(ShaderProgram& shader, const bool applyTexture);
-            void renderFaces(const TextureVertexArrayList& vertexArrays, ShaderProgram& shader, const bool applyTexture);
+            void renderOpaqueFaces(ShaderProgram& shader, const TextureUniforms& uniforms, const bool applyTexture);
+            void renderTransparentFaces(ShaderProgram& shader, const TextureUniforms& uniforms, const bool applyTexture);
+            void renderFaces(const TextureVertexArrayList& vertexArrays, ShaderProgram& shader, const TextureUniforms& uniforms, const bool applyTexture);
         public:
             FaceRenderer(Vbo& vbo, TextureRendererManager& textureRendererManager, const Sorter& faceSorter, const Color& faceColor);
             
@@ -23,6 +23,7 @@
 #include "Renderer/AttributeArray.h"
 
 #include <GL/glew.h>
+#include "Renderer/RenderStatistics.h"
 #include "Renderer/Vbo.h"
 #include "Renderer/Shader/Shader.h"
 #include "Utility/String.h"
@@ -96,6 +97,7 @@ namespace TrenchBroom {
                 GLsizei* countArray = &m_primVertexCounts[0];
                 
                 setup();
+                RenderStatistics::countDrawCall();
                 glMultiDrawArrays(m_primType, indexArray, countArray, static_cast<GLint>(m_primCount));
                 cleanup();
             }
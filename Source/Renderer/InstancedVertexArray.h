@@ -21,6 +21,7 @@
 #define TrenchBroom_InstancedVertexArray_h
 
 #include "Renderer/AttributeArray.h"
+#include "Renderer/RenderStatistics.h"
 #include "Utility/List.h"
 #include "Utility/String.h"
 
@@ -78,6 +79,7 @@ namespace TrenchBroom {
                 } else {
                     glBindTexture(GL_TEXTURE_2D, m_textureId);
                 }
+                RenderStatistics::countTextureBind();
             }
             
             inline void cleanup() {
@@ -171,6 +173,7 @@ namespace TrenchBroom {
                     textureNum++;
                 }
                 
+                RenderStatistics::countDrawCall();
                 glDrawArraysInstancedARB(m_primType, 0, static_cast<GLsizei>(m_vertexCount), static_cast<GLsizei>(m_instanceCount));
                 
                 textureNum = GL_TEXTURE0;
@@ -54,6 +54,7 @@
 #include "Utility/Grid.h"
 #include "Utility/List.h"
 #include "Utility/Preferences.h"
+#include "Utility/Profiler.h"
 
 namespace TrenchBroom {
     namespace Renderer {
@@ -63,27 +64,21 @@ namespace TrenchBroom {
         static const int ColorSize = 4;
         static const int TexCoordSize = 2 * sizeof(GLfloat);
         static const int FaceVertexSize = VertexSize + NormalSize + TexCoordSize;
-        static const int EdgeVertexSize = VertexSize;
         static const int EntityBoundsVertexSize = ColorSize + VertexSize;
 
         void MapRenderer::rebuildGeometryData(RenderContext& context) {
+            Utility::Profiler::ScopedTimer timer(Utility::Profiler::GeometryTime);
             if (!m_geometryDataValid) {
                 delete m_faceRenderer;
                 m_faceRenderer = NULL;
-                delete m_edgeRenderer;
-                m_edgeRenderer = NULL;
             }
             if (!m_selectedGeometryDataValid) {
                 delete m_selectedFaceRenderer;
                 m_selectedFaceRenderer = NULL;
-                delete m_selectedEdgeRenderer;
-                m_selectedEdgeRenderer = NULL;
             }
             if (!m_lockedGeometryDataValid) {
                 delete m_lockedFaceRenderer;
                 m_lockedFaceRenderer = NULL;
-                delete m_lockedEdgeRenderer;
-                m_lockedEdgeRenderer = NULL;
             }
             
             FaceSorter unselectedFaceSorter;
@@ -175,29 +170,17 @@ namespace TrenchBroom {
             m_faceVbo->unmap();
             m_faceVbo->deactivate();
             
-            // write edges
-            m_edgeVbo->activate();
-            m_edgeVbo->map();
+            // update the edge renderers, which only write the edges of brushes they did not contain before
+            if (!m_geometryDataValid)
+                m_edgeRenderer->setBrushes(unselectedBrushes);
             
-            const Color& edgeColor = prefs.getColor(Preferences::EdgeColor);
-
-            if (!m_geometryDataValid && !unselectedBrushes.empty()) {
-                assert(m_edgeRenderer == NULL);
-                m_edgeRenderer = new EdgeRenderer(*m_edgeVbo, unselectedBrushes, Model::EmptyFaceList, edgeColor);
-            }
-            
-            if (!m_selectedGeometryDataValid && (!selectedBrushes.empty() || !partiallySelectedBrushFaces.empty())) {
-                assert(m_selectedEdgeRenderer == NULL);
-                m_selectedEdgeRenderer = new EdgeRenderer(*m_edgeVbo, selectedBrushes, partiallySelectedBrushFaces);
-            }
-            
-            if (!m_lockedGeometryDataValid && !lockedBrushes.empty()) {
-                assert(m_lockedEdgeRenderer == NULL);
-                m_lockedEdgeRenderer = new EdgeRenderer(*m_edgeVbo, lockedBrushes, Model::EmptyFaceList);
+            if (!m_selectedGeometryDataValid) {
+                m_selectedEdgeRenderer->setBrushes(selectedBrushes);
+                m_selectedEdgeRenderer->setFaces(partiallySelectedBrushFaces);
             }
             
-            m_edgeVbo->unmap();
-            m_edgeVbo->deactivate();
+            if (!m_lockedGeometryDataValid)
+                m_lockedEdgeRenderer->setBrushes(lockedBrushes);
             
             m_geometryDataValid = true;
             m_selectedGeometryDataValid = true;
@@ -207,6 +190,12 @@ namespace TrenchBroom {
         void MapRenderer::validate(RenderContext& context) {
             if (!m_geometryDataValid || !m_selectedGeometryDataValid || !m_lockedGeometryDataValid)
                 rebuildGeometryData(context);
+            
+            Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
+            m_edgeRenderer->setDefaultColor(prefs.getColor(Preferences::EdgeColor));
+            m_edgeRenderer->validate();
+            m_selectedEdgeRenderer->validate();
+            m_lockedEdgeRenderer->validate();
         }
         
         void MapRenderer::invalidateDecorators() {
@@ -216,6 +205,22 @@ namespace TrenchBroom {
                 decorator.invalidate();
             }
         }
+        
+        void MapRenderer::invalidateDecorators(const Model::EntityList& entities) {
+            EntityDecorator::List::const_iterator decoratorIt, decoratorEnd;
+            for (decoratorIt = m_entityDecorators.begin(), decoratorEnd = m_entityDecorators.end(); decoratorIt != decoratorEnd; ++decoratorIt) {
+                EntityDecorator& decorator = **decoratorIt;
+                decorator.invalidateEntities(entities);
+            }
+        }
+        
+        void MapRenderer::invalidateDecoratorEditState() {
+            EntityDecorator::List::const_iterator decoratorIt, decoratorEnd;
+            for (decoratorIt = m_entityDecorators.begin(), decoratorEnd = m_entityDecorators.end(); decoratorIt != decoratorEnd; ++decoratorIt) {
+                EntityDecorator& decorator = **decoratorIt;
+                decorator.invalidateEditState();
+            }
+        }
 
         void MapRenderer::renderFaces(RenderContext& context) {
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
@@ -235,18 +240,12 @@ namespace TrenchBroom {
         void MapRenderer::renderEdges(RenderContext& context) {
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
             
-            m_edgeVbo->activate();
             if (context.viewOptions().renderEdges()) {
-                if (m_edgeRenderer != NULL) {
-                    glSetEdgeOffset(0.02f);
-                    m_edgeRenderer->render(context);
-                }
-                if (m_lockedEdgeRenderer != NULL) {
-                    glSetEdgeOffset(0.02f);
-                    m_lockedEdgeRenderer->render(context, prefs.getColor(Preferences::LockedEdgeColor));
-                }
+                glSetEdgeOffset(0.02f);
+                m_edgeRenderer->render(context);
+                m_lockedEdgeRenderer->render(context, prefs.getColor(Preferences::LockedEdgeColor));
             }
-            if (context.viewOptions().renderSelection() && m_selectedEdgeRenderer != NULL) {
+            if (context.viewOptions().renderSelection()) {
                 const Color& edgeColor = m_overrideSelectionColors ? m_selectedEdgeColor : prefs.getColor(Preferences::SelectedEdgeColor);
                 const Color& occludedEdgeColor = m_overrideSelectionColors ? m_occludedSelectedEdgeColor : prefs.getColor(Preferences::OccludedSelectedEdgeColor);
                 
@@ -258,7 +257,6 @@ namespace TrenchBroom {
                 glSetEdgeOffset(0.025f);
                 m_selectedEdgeRenderer->render(context, edgeColor);
             }
-            m_edgeVbo->deactivate();
             glResetEdgeOffset();
         }
         
@@ -282,7 +280,7 @@ namespace TrenchBroom {
                 changeSet.brushStateChangedTo(Model::EditState::Default) ||
                 changeSet.faceSelectionChanged()) {
                 m_geometryDataValid = false;
-                invalidateDecorators();
+                invalidateDecoratorEditState();
             }
             
             if (changeSet.brushStateChangedFrom(Model::EditState::Selected) ||
@@ -313,7 +311,7 @@ namespace TrenchBroom {
             
             if (changeSet.entityStateChangedFrom(Model::EditState::Hidden) ||
                 changeSet.entityStateChangedTo(Model::EditState::Hidden)) {
-                invalidateDecorators();
+                invalidateDecoratorEditState();
             }
             
             if (changeSet.brushStateChangedFrom(Model::EditState::Hidden) ||
@@ -335,7 +333,7 @@ namespace TrenchBroom {
                         m_entityRenderer->addEntity(*entity);
                 }
                 
-                invalidateDecorators();
+                invalidateDecoratorEditState();
             }
             
             if (changeSet.brushStateChangedFrom(Model::EditState::Locked) ||
@@ -348,12 +346,23 @@ namespace TrenchBroom {
             m_entityRenderer->invalidateBounds();
             m_selectedEntityRenderer->invalidateBounds();
             m_lockedEntityRenderer->invalidateBounds();
-            invalidateDecorators();
+        }
+        
+        void MapRenderer::invalidateEntities(const Model::EntityList& entities) {
+            m_entityRenderer->invalidateBounds(entities);
+            m_selectedEntityRenderer->invalidateBounds(entities);
+            m_lockedEntityRenderer->invalidateBounds(entities);
+        }
+        
+        void MapRenderer::invalidateEntityVisibility() {
+            m_entityRenderer->invalidateVisibility();
+            m_selectedEntityRenderer->invalidateVisibility();
+            m_lockedEntityRenderer->invalidateVisibility();
         }
         
         void MapRenderer::invalidateSelectedEntities() {
             m_selectedEntityRenderer->invalidateBounds();
-            invalidateDecorators();
+            invalidateDecorators(m_document.editStateManager().allSelectedEntities());
         }
         
         void MapRenderer::invalidateBrushes() {
@@ -364,11 +373,33 @@ namespace TrenchBroom {
         
         void MapRenderer::invalidateSelectedBrushes() {
             m_selectedGeometryDataValid = false;
+            m_selectedEdgeRenderer->invalidateAll();
+        }
+        
+        void MapRenderer::invalidateEdges(const Model::BrushList& brushes) {
+            m_edgeRenderer->invalidateBrushes(brushes);
+            m_selectedEdgeRenderer->invalidateBrushes(brushes);
+            m_lockedEdgeRenderer->invalidateBrushes(brushes);
+        }
+        
+        void MapRenderer::invalidateEdgeColors(const Model::EntityList& entities) {
+            // only the unselected edges are rendered in the colors of their entity definitions
+            Model::EntityList::const_iterator it, end;
+            for (it = entities.begin(), end = entities.end(); it != end; ++it) {
+                const Model::Entity& entity = **it;
+                m_edgeRenderer->invalidateBrushes(entity.brushes());
+            }
+        }
+        
+        void MapRenderer::invalidateEdgeColors() {
+            m_edgeRenderer->invalidateAll();
         }
         
         void MapRenderer::invalidateAll() {
             invalidateEntities();
             invalidateBrushes();
+            invalidateEdgeColors();
+            invalidateDecorators();
         }
         
         void MapRenderer::invalidateEntityModelRendererCache() {
@@ -389,12 +420,9 @@ namespace TrenchBroom {
             delete m_lockedFaceRenderer;
             m_lockedFaceRenderer = NULL;
             
-            delete m_edgeRenderer;
-            m_edgeRenderer = NULL;
-            delete m_selectedEdgeRenderer;
-            m_selectedEdgeRenderer = NULL;
-            delete m_lockedEdgeRenderer;
-            m_lockedEdgeRenderer = NULL;
+            m_edgeRenderer->clear();
+            m_selectedEdgeRenderer->clear();
+            m_lockedEdgeRenderer->clear();
             
             m_entityRenderer->clear();
             m_selectedEntityRenderer->clear();
@@ -410,11 +438,9 @@ namespace TrenchBroom {
         m_faceRenderer(NULL),
         m_selectedFaceRenderer(NULL),
         m_lockedFaceRenderer(NULL),
-        m_edgeVbo(NULL),
         m_edgeRenderer(NULL),
         m_selectedEdgeRenderer(NULL),
         m_lockedEdgeRenderer(NULL),
-        m_entityVbo(NULL),
         m_entityRenderer(NULL),
         m_selectedEntityRenderer(NULL),
         m_lockedEntityRenderer(NULL),
@@ -428,15 +454,17 @@ namespace TrenchBroom {
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
 
             m_faceVbo = new Vbo(GL_ARRAY_BUFFER, 0xFFFF);
-            m_edgeVbo = new Vbo(GL_ARRAY_BUFFER, 0xFFFF);
-            m_entityVbo = new Vbo(GL_ARRAY_BUFFER, 0xFFFF);
             m_utilityVbo = new Vbo(GL_ARRAY_BUFFER, 0xFFFF);
             
-            m_entityRenderer = new EntityRenderer(*m_entityVbo, m_document);
+            m_edgeRenderer = new EdgeRenderer(prefs.getColor(Preferences::EdgeColor));
+            m_selectedEdgeRenderer = new EdgeRenderer();
+            m_lockedEdgeRenderer = new EdgeRenderer();
+            
+            m_entityRenderer = new EntityRenderer(m_document);
             m_entityRenderer->setClassnameFadeDistance(prefs.getFloat(Preferences::InfoOverlayFadeDistance));
             m_entityRenderer->setClassnameColor(prefs.getColor(Preferences::InfoOverlayTextColor), prefs.getColor(Preferences::InfoOverlayBackgroundColor));
             
-            m_selectedEntityRenderer = new EntityRenderer(*m_entityVbo, m_document);
+            m_selectedEntityRenderer = new EntityRenderer(m_document);
             m_selectedEntityRenderer->setClassnameFadeDistance(prefs.getFloat(Preferences::SelectedInfoOverlayFadeDistance));
             m_selectedEntityRenderer->setClassnameColor(prefs.getColor(Preferences::SelectedInfoOverlayTextColor), prefs.getColor(Preferences::SelectedInfoOverlayBackgroundColor));
             m_selectedEntityRenderer->setOccludedClassnameColor(prefs.getColor(Preferences::SelectedInfoOverlayTextColor), prefs.getColor(Preferences::SelectedInfoOverlayBackgroundColor));
@@ -444,7 +472,7 @@ namespace TrenchBroom {
             m_selectedEntityRenderer->setOccludedBoundsColor(prefs.getColor(Preferences::OccludedSelectedEntityBoundsColor));
             m_selectedEntityRenderer->setTintColor(prefs.getColor(Preferences::SelectedEntityColor));
             
-            m_lockedEntityRenderer = new EntityRenderer(*m_entityVbo, m_document);
+            m_lockedEntityRenderer = new EntityRenderer(m_document);
             m_lockedEntityRenderer->setClassnameFadeDistance(prefs.getFloat(Preferences::InfoOverlayFadeDistance));
             m_lockedEntityRenderer->setClassnameColor(prefs.getColor(Preferences::LockedInfoOverlayTextColor), prefs.getColor(Preferences::LockedInfoOverlayBackgroundColor));
             m_lockedEntityRenderer->setBoundsColor(prefs.getColor(Preferences::LockedEntityBoundsColor));
@@ -466,16 +494,12 @@ namespace TrenchBroom {
             m_selectedEntityRenderer = NULL;
             delete m_entityRenderer;
             m_entityRenderer = NULL;
-            delete m_entityVbo;
-            m_entityVbo = NULL;
             delete m_lockedEdgeRenderer;
             m_lockedEdgeRenderer = NULL;
             delete m_selectedEdgeRenderer;
             m_selectedEdgeRenderer = NULL;
             delete m_edgeRenderer;
             m_edgeRenderer = NULL;
-            delete m_edgeVbo;
-            m_edgeVbo = NULL;
             delete m_lockedFaceRenderer;
             m_lockedFaceRenderer = NULL;
             delete m_selectedFaceRenderer;
@@ -502,12 +526,13 @@ namespace TrenchBroom {
                 case Controller::Command::ChangeEditState: {
                     const Controller::ChangeEditStateCommand& changeEditStateCommand = static_cast<const Controller::ChangeEditStateCommand&>(command);
                     changeEditState(changeEditStateCommand.changeSet());
-                    invalidateDecorators();
+                    invalidateDecoratorEditState();
                     break;
                 }
                 case Controller::Command::ViewFilterChange: {
-                    invalidateEntities();
+                    invalidateEntityVisibility();
                     invalidateBrushes();
+                    invalidateDecoratorEditState();
                     break;
                 }
                 case Controller::Command::PreferenceChange: {
@@ -516,6 +541,13 @@ namespace TrenchBroom {
                         invalidateEntityModelRendererCache();
                     break;
                 }
+                case Controller::Command::SetEntityDefinitionFile: {
+                    invalidateEdgeColors();
+                    invalidateEntities();
+                    invalidateDecorators();
+                    invalidateEntityModelRendererCache();
+                    break;
+                }
                 case Controller::Command::SetFaceAttributes:
                 case Controller::Command::MoveTextures:
                 case Controller::Command::RotateTextures: {
@@ -526,10 +558,16 @@ namespace TrenchBroom {
                 case Controller::Command::SetEntityPropertyValue:
                 case Controller::Command::RemoveEntityProperty: {
                     const Controller::EntityPropertyCommand& entityPropertyCommand = static_cast<const Controller::EntityPropertyCommand&>(command);
-                    if (entityPropertyCommand.isEntityAffected(m_document.worldspawn()) &&
-                        entityPropertyCommand.isPropertyAffected(Model::Entity::WadKey))
+                    if (entityPropertyCommand.isEntityAffected(m_document.worldspawn())) {
+                        if (entityPropertyCommand.isPropertyAffected(Model::Entity::WadKey))
                             invalidateBrushes();
-                    invalidateEntities();
+                        // the entity definitions were reloaded, so the edge colors of all brush entities may change
+                        if (entityPropertyCommand.isPropertyAffected(Model::Entity::DefKey))
+                            invalidateEdgeColors();
+                    }
+                    invalidateEdgeColors(entityPropertyCommand.entities());
+                    invalidateEntities(entityPropertyCommand.entities());
+                    invalidateDecorators(entityPropertyCommand.entities());
                     invalidateSelectedEntityModelRendererCache();
                     break;
                 }
@@ -539,8 +577,11 @@ namespace TrenchBroom {
                         m_entityRenderer->addEntities(addObjectsCommand.addedEntities());
                     else
                         m_entityRenderer->removeEntities(addObjectsCommand.addedEntities());
-                    if (addObjectsCommand.hasAddedBrushes())
+                    invalidateDecorators(addObjectsCommand.addedEntities());
+                    if (addObjectsCommand.hasAddedBrushes()) {
                         invalidateBrushes();
+                        invalidateEdges(addObjectsCommand.addedBrushes());
+                    }
                     break;
                 }
                 case Controller::Command::RebuildBrushGeometry:
@@ -558,6 +599,7 @@ namespace TrenchBroom {
                         m_entityRenderer->removeEntities(removeObjectsCommand.removedEntities());
                     else
                         m_entityRenderer->addEntities(removeObjectsCommand.removedEntities());
+                    invalidateDecorators(removeObjectsCommand.removedEntities());
                     if (!removeObjectsCommand.removedBrushes().empty())
                         invalidateBrushes();
                     break;
@@ -566,6 +608,7 @@ namespace TrenchBroom {
                     invalidateSelectedBrushes();
                     invalidateEntities();
                     invalidateSelectedEntities();
+                    invalidateDecorators();
                     break;
                 }
                 default:
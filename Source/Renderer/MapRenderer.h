@@ -77,12 +77,10 @@ namespace TrenchBroom {
             FaceRenderer* m_selectedFaceRenderer;
             FaceRenderer* m_lockedFaceRenderer;
             
-            Vbo* m_edgeVbo;
             EdgeRenderer* m_edgeRenderer;
             EdgeRenderer* m_selectedEdgeRenderer;
             EdgeRenderer* m_lockedEdgeRenderer;
             
-            Vbo* m_entityVbo;
             EntityRenderer* m_entityRenderer;
             EntityRenderer* m_selectedEntityRenderer;
             EntityRenderer* m_lockedEntityRenderer;
@@ -112,13 +110,20 @@ namespace TrenchBroom {
 
             void changeEditState(const Model::EditStateChangeSet& changeSet);
             void invalidateEntities();
+            void invalidateEntities(const Model::EntityList& entities);
+            void invalidateEntityVisibility();
             void invalidateSelectedEntities();
             void invalidateBrushes();
             void invalidateSelectedBrushes();
+            void invalidateEdges(const Model::BrushList& brushes);
+            void invalidateEdgeColors();
+            void invalidateEdgeColors(const Model::EntityList& entities);
             void invalidateAll();
             void invalidateEntityModelRendererCache();
             void invalidateSelectedEntityModelRendererCache();
             void invalidateDecorators();
+            void invalidateDecorators(const Model::EntityList& entities);
+            void invalidateDecoratorEditState();
             void clear();
 
             // prevent copying
@@ -20,32 +20,127 @@
 #include "OverlayRenderer.h"
 
 #include "Renderer/ApplyMatrix.h"
+#include "Renderer/Camera.h"
 #include "Renderer/CompassRenderer.h"
 #include "Renderer/RenderContext.h"
 #include "Renderer/Vbo.h"
+#include "Renderer/Shader/Shader.h"
+#include "Renderer/Shader/ShaderManager.h"
+#include "Renderer/Text/FontManager.h"
+#include "Utility/Preferences.h"
+#include "Utility/Profiler.h"
+#include "Utility/String.h"
 #include "Utility/VecMath.h"
 
+#include <cassert>
+#include <cstdio>
+
 using namespace TrenchBroom::VecMath;
 
 namespace TrenchBroom {
     namespace Renderer {
-        OverlayRenderer::OverlayRenderer() :
+        const Vec3f ScreenTextAnchor::basePosition() const {
+            // halfway into the depth range keeps the position close to the camera and in front of the near plane
+            return m_camera.unproject(m_x, m_y, 0.5f);
+        }
+        
+        const Text::Alignment::Type ScreenTextAnchor::alignment() const {
+            return Text::Alignment::Top | Text::Alignment::Left;
+        }
+        
+        ScreenTextAnchor::ScreenTextAnchor(const Camera& camera, float x, float y) :
+        m_camera(camera),
+        m_x(x),
+        m_y(y) {}
+        
+        void OverlayRenderer::renderProfile(RenderContext& context) {
+            const Utility::Profiler& profiler = Utility::Profiler::profiler();
+            if (profiler.frameCount() == 0)
+                return;
+            
+            Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
+            if (m_profileText == NULL) {
+                const String& fontName = prefs.getString(Preferences::RendererFontName);
+                int fontSize = prefs.getInt(Preferences::RendererFontSize);
+                Text::FontDescriptor fontDescriptor(fontName, static_cast<unsigned int>(fontSize));
+                
+                Text::TexturedFont* font = m_fontManager.font(fontDescriptor);
+                assert(font != NULL);
+                m_profileText = new ProfileTextRenderer(*font);
+            }
+            
+            const Utility::Profiler::Frame& last = profiler.lastFrame();
+            const Utility::Profiler::Frame average = profiler.average();
+            
+            char buffer[256];
+            StringList lines;
+            std::sprintf(buffer, "Frame %lu: %.2f ms (avg %.2f ms over %lu frames)",
+                         static_cast<unsigned long>(last.number),
+                         last.times[Utility::Profiler::FrameTime],
+                         average.times[Utility::Profiler::FrameTime],
+                         static_cast<unsigned long>(profiler.frameCount()));
+            lines.push_back(buffer);
+            std::sprintf(buffer, "Pick: %.2f ms (avg %.2f ms), Geometry: %.2f ms (avg %.2f ms)",
+                         last.times[Utility::Profiler::PickTime],
+                         average.times[Utility::Profiler::PickTime],
+                         last.times[Utility::Profiler::GeometryTime],
+                         average.times[Utility::Profiler::GeometryTime]);
+            lines.push_back(buffer);
+            std::sprintf(buffer, "Draw calls: %lu, Texture binds: %lu, Shader changes: %lu",
+                         static_cast<unsigned long>(last.counts[Utility::Profiler::DrawCalls]),
+                         static_cast<unsigned long>(last.counts[Utility::Profiler::TextureBinds]),
+                         static_cast<unsigned long>(last.counts[Utility::Profiler::ShaderChanges]));
+            lines.push_back(buffer);
+            std::sprintf(buffer, "Buffer uploads: %lu (%lu bytes), Octree nodes visited: %lu",
+                         static_cast<unsigned long>(last.counts[Utility::Profiler::BufferUploads]),
+                         static_cast<unsigned long>(last.counts[Utility::Profiler::UploadedBytes]),
+                         static_cast<unsigned long>(last.counts[Utility::Profiler::OctreeNodesVisited]));
+            lines.push_back(buffer);
+            std::sprintf(buffer, "Render requests: %lu (%lu coalesced, %lu dropped)",
+                         static_cast<unsigned long>(last.counts[Utility::Profiler::RenderRequests]),
+                         static_cast<unsigned long>(last.counts[Utility::Profiler::CoalescedRenders]),
+                         static_cast<unsigned long>(last.counts[Utility::Profiler::DroppedRenders]));
+            lines.push_back(buffer);
+            
+            // every line is a separate string so that it gets its own background
+            const float lineHeight = static_cast<float>(prefs.getInt(Preferences::RendererFontSize)) + 12.0f;
+            for (unsigned int i = 0; i < lines.size(); i++)
+                m_profileText->addString(i, lines[i], Text::TextAnchor::Ptr(new ScreenTextAnchor(context.camera(), 10.0f, 10.0f + i * lineHeight)));
+            
+            const Color& textColor = prefs.getColor(Preferences::InfoOverlayTextColor);
+            const Color& backgroundColor = prefs.getColor(Preferences::InfoOverlayBackgroundColor);
+            ShaderProgram& textShader = context.shaderManager().shaderProgram(Shaders::TextShader);
+            ShaderProgram& backgroundShader = context.shaderManager().shaderProgram(Shaders::TextBackgroundShader);
+            
+            glDisable(GL_DEPTH_TEST);
+            m_profileText->render(context, m_profileTextFilter, textShader, textColor, backgroundShader, backgroundColor);
+            glEnable(GL_DEPTH_TEST);
+        }
+        
+        OverlayRenderer::OverlayRenderer(Text::FontManager& fontManager) :
+        m_fontManager(fontManager),
         m_vbo(NULL),
-        m_compass(NULL) {}
+        m_compass(NULL),
+        m_profileText(NULL) {}
 
         OverlayRenderer::~OverlayRenderer() {
+            delete m_profileText;
+            m_profileText = NULL;
             delete m_compass;
             m_compass = NULL;
             delete m_vbo;
             m_vbo = NULL;
         }
 
-        void OverlayRenderer::render(RenderContext& context, const float viewWidth, const float viewHeight) {
+        void OverlayRenderer::render(RenderContext& context, const float viewWidth, const float viewHeight, const bool showProfile) {
             if (m_vbo == NULL)
                 m_vbo = new Vbo(GL_ARRAY_BUFFER, 0xFFFF);
             if (m_compass == NULL)
                 m_compass = new CompassRenderer();
 
+            if (showProfile)
+                renderProfile(context);
+            
             glClear(GL_DEPTH_BUFFER_BIT);
 
             const Mat4f projection = orthoMatrix(0.0f, 1000.0f, -viewWidth / 2.0f, viewHeight / 2.0f, viewWidth / 2.0f, -viewHeight / 2.0f);
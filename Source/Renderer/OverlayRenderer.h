@@ -20,23 +20,55 @@
 #ifndef __TrenchBroom__OverlayRenderer__
 #define __TrenchBroom__OverlayRenderer__
 
+#include "Renderer/Text/TextRenderer.h"
+#include "Utility/VecMath.h"
+
 #include <iostream>
 
+using namespace TrenchBroom::VecMath;
+
 namespace TrenchBroom {
     namespace Renderer {
+        namespace Text {
+            class FontManager;
+        }
+
+        class Camera;
         class CompassRenderer;
         class RenderContext;
         class Vbo;
         
+        /**
+         * Anchors a string at a fixed position in window coordinates, measured from the top left corner of the viewport.
+         */
+        class ScreenTextAnchor : public Text::TextAnchor {
+        private:
+            const Camera& m_camera;
+            float m_x;
+            float m_y;
+        protected:
+            const Vec3f basePosition() const;
+            const Text::Alignment::Type alignment() const;
+        public:
+            ScreenTextAnchor(const Camera& camera, float x, float y);
+        };
+
         class OverlayRenderer {
         private:
+            typedef Text::TextRenderer<unsigned int> ProfileTextRenderer;
+            
+            Text::FontManager& m_fontManager;
             Vbo* m_vbo;
             CompassRenderer* m_compass;
+            ProfileTextRenderer* m_profileText;
+            ProfileTextRenderer::SimpleTextRendererFilter m_profileTextFilter;
+            
+            void renderProfile(RenderContext& context);
         public:
-            OverlayRenderer();
+            OverlayRenderer(Text::FontManager& fontManager);
             ~OverlayRenderer();
             
-            void render(RenderContext& context, const float viewWidth, const float viewHeight);
+            void render(RenderContext& context, const float viewWidth, const float viewHeight, const bool showProfile);
         };
     }
 }
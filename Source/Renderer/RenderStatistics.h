@@ -0,0 +1,88 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_RenderStatistics_h
+#define TrenchBroom_RenderStatistics_h
+
+#include <cstddef>
+
+namespace TrenchBroom {
+    namespace Renderer {
+        /**
+         * Counts the OpenGL calls that dominate the cost of a frame. The renderers increment the counters of the shared
+         * instance wherever they issue such a call, and whoever measures a frame resets them before rendering it. The
+         * counters are only updated while counting is enabled.
+         */
+        class RenderStatistics {
+        public:
+            size_t drawCalls;
+            size_t bufferUploads;
+            size_t uploadedBytes;
+            size_t textureBinds;
+            size_t shaderChanges;
+            bool enabled;
+
+            RenderStatistics() :
+            enabled(false) {
+                reset();
+            }
+
+            inline void reset() {
+                drawCalls = 0;
+                bufferUploads = 0;
+                uploadedBytes = 0;
+                textureBinds = 0;
+                shaderChanges = 0;
+            }
+
+            static inline RenderStatistics& statistics() {
+                static RenderStatistics statistics;
+                return statistics;
+            }
+
+            static inline void countDrawCall() {
+                RenderStatistics& current = statistics();
+                if (current.enabled)
+                    current.drawCalls++;
+            }
+
+            static inline void countBufferUpload(const size_t bytes) {
+                RenderStatistics& current = statistics();
+                if (current.enabled) {
+                    current.bufferUploads++;
+                    current.uploadedBytes += bytes;
+                }
+            }
+
+            static inline void countTextureBind() {
+                RenderStatistics& current = statistics();
+                if (current.enabled)
+                    current.textureBinds++;
+            }
+
+            static inline void countShaderChange() {
+                RenderStatistics& current = statistics();
+                if (current.enabled)
+                    current.shaderChanges++;
+            }
+        };
+    }
+}
+
+#endif
@@ -21,6 +21,7 @@
 
 #include "IO/FileManager.h"
 #include "Model/Texture.h"
+#include "Renderer/RenderStatistics.h"
 #include "Renderer/Shader/Shader.h"
 #include "Utility/Console.h"
 
@@ -29,23 +30,13 @@
 
 namespace TrenchBroom {
     namespace Renderer {
-        GLint ShaderProgram::uniformLocation(const String& name) {
-            UniformVariableMap::iterator it = m_uniformVariables.find(name);
-            if (it == m_uniformVariables.end()) {
-                GLint index = glGetUniformLocation(m_programId, name.c_str());
-                if (index == -1)
-                    m_console.warn("Location of uniform variable '%s' could not be found in %s", name.c_str(), m_name.c_str());
-                m_uniformVariables[name] = index;
-                return index;
-            }
-
-            return it->second;
-        }
-
-        bool ShaderProgram::checkActive() {
-            GLint currentProgramId = -1;
-            glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgramId);
-            return static_cast<GLuint>(currentProgramId) == m_programId;
+        GLuint ShaderProgram::activeProgramId = 0;
+        
+        void ShaderProgram::resolveLocation(UniformVariable& variable) {
+            variable.location = glGetUniformLocation(m_programId, variable.name.c_str());
+            variable.resetValue();
+            if (variable.location == -1)
+                m_console.warn("Location of uniform variable '%s' could not be found in %s", variable.name.c_str(), m_name.c_str());
         }
 
         ShaderProgram::ShaderProgram(const String& name, Utility::Console& console) :
@@ -86,8 +77,6 @@ namespace TrenchBroom {
                 return false;
 
             if (m_needsLinking) {
-                m_uniformVariables.clear();
-
                 glLinkProgram(m_programId);
 
                 GLint linkStatus = 0;
@@ -111,90 +100,165 @@ namespace TrenchBroom {
 
                 // always set to false to prevent console spam
                 m_needsLinking = false;
+                
+                // linking resets all uniforms and may move them
+                UniformVariableList::iterator it, end;
+                for (it = m_uniformVariables.begin(), end = m_uniformVariables.end(); it != end; ++it)
+                    resolveLocation(*it);
             }
 
             glUseProgram(m_programId);
+            activeProgramId = m_programId;
+            RenderStatistics::countShaderChange();
             return true;
         }
 
         void ShaderProgram::deactivate() {
             glUseProgram(0);
+            activeProgramId = 0;
         }
 
-        bool ShaderProgram::setUniformVariable(const String& name, const bool value) {
-            return setUniformVariable(name, static_cast<int>(value));
+        ShaderProgram::UniformHandle ShaderProgram::uniformHandle(const String& name) {
+            UniformHandleMap::iterator it = m_uniformHandles.lower_bound(name);
+            if (it != m_uniformHandles.end() && it->first == name)
+                return it->second;
+            
+            const UniformHandle handle = m_uniformVariables.size();
+            m_uniformVariables.push_back(UniformVariable(name));
+            m_uniformHandles.insert(it, UniformHandleMap::value_type(name, handle));
+            
+            // otherwise, the location is resolved when the program is linked
+            if (!m_needsLinking)
+                resolveLocation(m_uniformVariables.back());
+            return handle;
         }
 
-        bool ShaderProgram::setUniformVariable(const String& name, const int value) {
+        bool ShaderProgram::setUniformVariable(const UniformHandle handle, const bool value) {
+            return setUniformVariable(handle, static_cast<int>(value));
+        }
+
+        bool ShaderProgram::setUniformVariable(const UniformHandle handle, const int value) {
             assert(checkActive());
-            GLint location = uniformLocation(name);
-            if (location == -1)
+            assert(handle < m_uniformVariables.size());
+            UniformVariable& variable = m_uniformVariables[handle];
+            if (variable.location == -1)
                 return false;
-            glUniform1i(location, value);
+            if (variable.updateValue(&value, sizeof(value)))
+                glUniform1i(variable.location, value);
             return true;
         }
 
-        bool ShaderProgram::setUniformVariable(const String& name, const float value) {
+        bool ShaderProgram::setUniformVariable(const UniformHandle handle, const float value) {
             assert(checkActive());
-            GLint location = uniformLocation(name);
-            if (location == -1)
+            assert(handle < m_uniformVariables.size());
+            UniformVariable& variable = m_uniformVariables[handle];
+            if (variable.location == -1)
                 return false;
-            glUniform1f(location, value);
+            if (variable.updateValue(&value, sizeof(value)))
+                glUniform1f(variable.location, value);
             return true;
         }
 
-        bool ShaderProgram::setUniformVariable(const String& name, const Vec2f& value) {
-            GLint location = uniformLocation(name);
-            if (location == -1)
+        bool ShaderProgram::setUniformVariable(const UniformHandle handle, const Vec2f& value) {
+            assert(checkActive());
+            assert(handle < m_uniformVariables.size());
+            UniformVariable& variable = m_uniformVariables[handle];
+            if (variable.location == -1)
                 return false;
-            glUniform2f(location, value.x(), value.y());
+            if (variable.updateValue(value.v, sizeof(value.v)))
+                glUniform2f(variable.location, value.x(), value.y());
             return true;
         }
 
-        bool ShaderProgram::setUniformVariable(const String& name, const Vec3f& value) {
+        bool ShaderProgram::setUniformVariable(const UniformHandle handle, const Vec3f& value) {
             assert(checkActive());
-            GLint location = uniformLocation(name);
-            if (location == -1)
+            assert(handle < m_uniformVariables.size());
+            UniformVariable& variable = m_uniformVariables[handle];
+            if (variable.location == -1)
                 return false;
-            glUniform3f(location, value.x(), value.y(), value.z());
+            if (variable.updateValue(value.v, sizeof(value.v)))
+                glUniform3f(variable.location, value.x(), value.y(), value.z());
             return true;
         }
 
-        bool ShaderProgram::setUniformVariable(const String& name, const Vec4f& value) {
+        bool ShaderProgram::setUniformVariable(const UniformHandle handle, const Vec4f& value) {
             assert(checkActive());
-            checkActive();
-            GLint location = uniformLocation(name);
-            if (location == -1)
+            assert(handle < m_uniformVariables.size());
+            UniformVariable& variable = m_uniformVariables[handle];
+            if (variable.location == -1)
                 return false;
-            glUniform4f(location, value.x(), value.y(), value.z(), value.w());
+            if (variable.updateValue(value.v, sizeof(value.v)))
+                glUniform4f(variable.location, value.x(), value.y(), value.z(), value.w());
             return true;
         }
 
-        bool ShaderProgram::setUniformVariable(const String& name, const Mat2f& value) {
+        bool ShaderProgram::setUniformVariable(const UniformHandle handle, const Mat2f& value) {
             assert(checkActive());
-            GLint location = uniformLocation(name);
-            if (location == -1)
+            assert(handle < m_uniformVariables.size());
+            UniformVariable& variable = m_uniformVariables[handle];
+            if (variable.location == -1)
                 return false;
-            glUniformMatrix2fv(location, 1, false, reinterpret_cast<const float*>(value.v));
+            if (variable.updateValue(value.v, sizeof(value.v)))
+                glUniformMatrix2fv(variable.location, 1, false, reinterpret_cast<const float*>(value.v));
             return true;
         }
 
-        bool ShaderProgram::setUniformVariable(const String& name, const Mat3f& value) {
+        bool ShaderProgram::setUniformVariable(const UniformHandle handle, const Mat3f& value) {
             assert(checkActive());
-            GLint location = uniformLocation(name);
-            if (location == -1)
+            assert(handle < m_uniformVariables.size());
+            UniformVariable& variable = m_uniformVariables[handle];
+            if (variable.location == -1)
                 return false;
-            glUniformMatrix3fv(location, 1, false, reinterpret_cast<const float*>(value.v));
+            if (variable.updateValue(value.v, sizeof(value.v)))
+                glUniformMatrix3fv(variable.location, 1, false, reinterpret_cast<const float*>(value.v));
             return true;
         }
 
-        bool ShaderProgram::setUniformVariable(const String& name, const Mat4f& value) {
+        bool ShaderProgram::setUniformVariable(const UniformHandle handle, const Mat4f& value) {
             assert(checkActive());
-            GLint location = uniformLocation(name);
-            if (location == -1)
+            assert(handle < m_uniformVariables.size());
+            UniformVariable& variable = m_uniformVariables[handle];
+            if (variable.location == -1)
                 return false;
-            glUniformMatrix4fv(location, 1, false, reinterpret_cast<const float*>(value.v));
+            if (variable.updateValue(value.v, sizeof(value.v)))
+                glUniformMatrix4fv(variable.location, 1, false, reinterpret_cast<const float*>(value.v));
             return true;
         }
+
+        bool ShaderProgram::setUniformVariable(const String& name, const bool value) {
+            return setUniformVariable(uniformHandle(name), value);
+        }
+
+        bool ShaderProgram::setUniformVariable(const String& name, const int value) {
+            return setUniformVariable(uniformHandle(name), value);
+        }
+
+        bool ShaderProgram::setUniformVariable(const String& name, const float value) {
+            return setUniformVariable(uniformHandle(name), value);
+        }
+
+        bool ShaderProgram::setUniformVariable(const String& name, const Vec2f& value) {
+            return setUniformVariable(uniformHandle(name), value);
+        }
+
+        bool ShaderProgram::setUniformVariable(const String& name, const Vec3f& value) {
+            return setUniformVariable(uniformHandle(name), value);
+        }
+
+        bool ShaderProgram::setUniformVariable(const String& name, const Vec4f& value) {
+            return setUniformVariable(uniformHandle(name), value);
+        }
+
+        bool ShaderProgram::setUniformVariable(const String& name, const Mat2f& value) {
+            return setUniformVariable(uniformHandle(name), value);
+        }
+
+        bool ShaderProgram::setUniformVariable(const String& name, const Mat3f& value) {
+            return setUniformVariable(uniformHandle(name), value);
+        }
+
+        bool ShaderProgram::setUniformVariable(const String& name, const Mat4f& value) {
+            return setUniformVariable(uniformHandle(name), value);
+        }
     }
 }
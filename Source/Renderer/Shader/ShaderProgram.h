@@ -24,7 +24,10 @@
 #include "Utility/String.h"
 #include "Utility/VecMath.h"
 
+#include <cassert>
+#include <cstring>
 #include <map>
+#include <vector>
 
 using namespace TrenchBroom::VecMath;
 
@@ -41,17 +44,60 @@ namespace TrenchBroom {
         class Shader;
         
         class ShaderProgram {
+        public:
+            typedef size_t UniformHandle;
         private:
-            typedef std::map<String, GLint> UniformVariableMap;
+            /**
+             * A uniform variable along with the value that was last uploaded for it. Uniform values are part of the
+             * program state, so the shadowed value stays valid until the program is linked again.
+             */
+            class UniformVariable {
+            private:
+                float m_value[16];
+                size_t m_valueSize;
+            public:
+                String name;
+                GLint location;
+                
+                UniformVariable(const String& i_name) :
+                m_valueSize(0),
+                name(i_name),
+                location(-1) {}
+                
+                inline void resetValue() {
+                    m_valueSize = 0;
+                }
+                
+                /**
+                 * Stores the given value and returns whether it differs from the stored one.
+                 */
+                inline bool updateValue(const void* value, size_t size) {
+                    assert(size > 0 && size <= sizeof(m_value));
+                    if (size == m_valueSize && std::memcmp(m_value, value, size) == 0)
+                        return false;
+                    std::memcpy(m_value, value, size);
+                    m_valueSize = size;
+                    return true;
+                }
+            };
+            
+            typedef std::vector<UniformVariable> UniformVariableList;
+            typedef std::map<String, UniformHandle> UniformHandleMap;
+            
+            static GLuint activeProgramId;
             
             String m_name;
             GLuint m_programId;
-            UniformVariableMap m_uniformVariables;
+            UniformVariableList m_uniformVariables;
+            UniformHandleMap m_uniformHandles;
             bool m_needsLinking;
             Utility::Console& m_console;
             
-            GLint uniformLocation(const String& name);
-            bool checkActive();
+            void resolveLocation(UniformVariable& variable);
+            
+            inline bool checkActive() const {
+                return activeProgramId == m_programId;
+            }
         public:
             ShaderProgram(const String& name, Utility::Console& console);
             ~ShaderProgram();
@@ -67,6 +113,22 @@ namespace TrenchBroom {
             bool activate();
             void deactivate();
             
+            /**
+             * Returns a handle for the uniform variable with the given name. Handles remain valid for the lifetime of
+             * this program, even if it is linked again, and allow setting a uniform without looking up its name.
+             */
+            UniformHandle uniformHandle(const String& name);
+            
+            bool setUniformVariable(UniformHandle handle, bool value);
+            bool setUniformVariable(UniformHandle handle, int value);
+            bool setUniformVariable(UniformHandle handle, float value);
+            bool setUniformVariable(UniformHandle handle, const Vec2f& value);
+            bool setUniformVariable(UniformHandle handle, const Vec3f& value);
+            bool setUniformVariable(UniformHandle handle, const Vec4f& value);
+            bool setUniformVariable(UniformHandle handle, const Mat2f& value);
+            bool setUniformVariable(UniformHandle handle, const Mat3f& value);
+            bool setUniformVariable(UniformHandle handle, const Mat4f& value);
+            
             bool setUniformVariable(const String& name, bool value);
             bool setUniformVariable(const String& name, int value);
             bool setUniformVariable(const String& name, float value);
@@ -33,7 +33,9 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <map>
+#include <vector>
 
 using namespace TrenchBroom::VecMath;
 
@@ -138,11 +140,13 @@ namespace TrenchBroom {
                 class TextEntry {
                 private:
                     Vec2f::List m_vertices;
+                    Vec2f::List m_rectVertices;
                     Vec2f m_size;
                     TextAnchor::Ptr m_textAnchor;
                 public:
-                    TextEntry(const Vec2f::List& vertices, const Vec2f& size, TextAnchor::Ptr textAnchor) :
+                    TextEntry(const Vec2f::List& vertices, const Vec2f::List& rectVertices, const Vec2f& size, TextAnchor::Ptr textAnchor) :
                     m_vertices(vertices),
+                    m_rectVertices(rectVertices),
                     m_size(size),
                     m_textAnchor(textAnchor) {}
                     
@@ -150,9 +154,8 @@ namespace TrenchBroom {
                         return m_vertices;
                     }
 
-                    inline void update(const Vec2f::List& vertices, const Vec2f& size) {
-                        m_vertices = vertices;
-                        m_size = size;
+                    inline const Vec2f::List& rectVertices() const {
+                        return m_rectVertices;
                     }
 
                     inline const Vec2f& size() const {
@@ -162,11 +165,53 @@ namespace TrenchBroom {
                     inline const TextAnchor& textAnchor() const {
                         return *m_textAnchor.get();
                     }
+
+                    inline TextAnchor::Ptr textAnchorPtr() const {
+                        return m_textAnchor;
+                    }
                 };
 
                 typedef std::map<Key, TextEntry, Comparator> TextMap;
                 typedef std::pair<Key, TextEntry> TextMapItem;
-                typedef std::vector<TextEntry> EntryList;
+
+                class VisibleEntry {
+                public:
+                    const TextEntry* entry;
+                    Vec3f offset;
+                    
+                    VisibleEntry(const TextEntry* i_entry, const Vec3f& i_offset) :
+                    entry(i_entry),
+                    offset(i_offset) {}
+                };
+                
+                typedef std::vector<VisibleEntry> VisibleEntryList;
+                
+                /*
+                 * The entries are bucketed into a uniform grid whose cells are as large as the fade cutoff distance,
+                 * so that only the 27 cells around the camera need to be visited when collecting the visible entries.
+                 * The grid is built lazily and rebuilt whenever the anchor positions may have changed.
+                 */
+                class GridCell {
+                public:
+                    int x, y, z;
+                    
+                    GridCell(int i_x, int i_y, int i_z) :
+                    x(i_x),
+                    y(i_y),
+                    z(i_z) {}
+                    
+                    inline bool operator<(const GridCell& other) const {
+                        if (x != other.x)
+                            return x < other.x;
+                        if (y != other.y)
+                            return y < other.y;
+                        return z < other.z;
+                    }
+                };
+                
+                typedef std::pair<Key, const TextEntry*> GridEntry;
+                typedef std::vector<GridEntry> GridEntryList;
+                typedef std::map<GridCell, GridEntryList> Grid;
 
                 TexturedFont& m_font;
                 float m_fadeDistance;
@@ -174,32 +219,91 @@ namespace TrenchBroom {
                 float m_vInset;
 
                 TextMap m_entries;
+                Grid m_grid;
+                bool m_gridValid;
+                VisibleEntryList m_visibleEntries;
                 Vbo* m_vbo;
 
+                inline float cutoffDistance() const {
+                    return m_fadeDistance + 100.0f;
+                }
+                
+                inline GridCell gridCell(const Vec3f& position) const {
+                    const float cellSize = cutoffDistance();
+                    return GridCell(static_cast<int>(std::floor(position.x() / cellSize)),
+                                    static_cast<int>(std::floor(position.y() / cellSize)),
+                                    static_cast<int>(std::floor(position.z() / cellSize)));
+                }
+                
                 inline void addString(Key key, const Vec2f::List& vertices, const Vec2f& size, TextAnchor::Ptr anchor) {
                     removeString(key);
-                    m_entries.insert(TextMapItem(key, TextEntry(vertices, size, anchor)));
+                    
+                    const Vec2f roundedSize = size.rounded();
+                    Vec2f::List rectVertices;
+                    rectVertices.reserve(3 * 16);
+                    roundedRect(roundedSize.x() + 2.0f * m_hInset, roundedSize.y() + 2.0f * m_vInset, 3.0f, 3, rectVertices);
+                    
+                    typename TextMap::iterator it = m_entries.insert(TextMapItem(key, TextEntry(vertices, rectVertices, size, anchor))).first;
+                    if (m_gridValid) {
+                        const TextEntry& entry = it->second;
+                        m_grid[gridCell(entry.textAnchor().position())].push_back(GridEntry(key, &entry));
+                    }
                 }
 
-                EntryList visibleEntries(RenderContext& context, const TextRendererFilter& filter) {
-                    float cutoff = (m_fadeDistance + 100) * (m_fadeDistance + 100);
-                    EntryList result;
-
-                    typename TextMap::iterator it, end;
+                void validateGrid() {
+                    m_grid.clear();
+                    
+                    typename TextMap::const_iterator it, end;
                     for (it = m_entries.begin(), end = m_entries.end(); it != end; ++it) {
-                        Key key = it->first;
-                        if (filter.stringVisible(context, key)) {
-                            const TextEntry& entry = it->second;
-                            const TextAnchor& anchor = entry.textAnchor();
-                            const Vec3f position = anchor.position();
-
-                            float dist2 = context.camera().squaredDistanceTo(position);
-                            if (dist2 <= cutoff)
-                                result.push_back(entry);
+                        const TextEntry& entry = it->second;
+                        m_grid[gridCell(entry.textAnchor().position())].push_back(GridEntry(it->first, &entry));
+                    }
+                    m_gridValid = true;
+                }
+                
+                void collectVisibleEntries(RenderContext& context, const TextRendererFilter& filter) {
+                    m_visibleEntries.clear();
+                    if (!m_gridValid)
+                        validateGrid();
+                    
+                    const Camera& camera = context.camera();
+                    const Camera::Viewport& viewport = camera.viewport();
+                    const float cutoff = cutoffDistance();
+                    const float cutoff2 = cutoff * cutoff;
+                    const GridCell center = gridCell(camera.position());
+                    
+                    for (int x = center.x - 1; x <= center.x + 1; x++) {
+                        for (int y = center.y - 1; y <= center.y + 1; y++) {
+                            for (int z = center.z - 1; z <= center.z + 1; z++) {
+                                typename Grid::const_iterator cellIt = m_grid.find(GridCell(x, y, z));
+                                if (cellIt == m_grid.end())
+                                    continue;
+                                
+                                const GridEntryList& cellEntries = cellIt->second;
+                                for (size_t i = 0; i < cellEntries.size(); i++) {
+                                    const GridEntry& gridEntry = cellEntries[i];
+                                    const TextEntry& entry = *gridEntry.second;
+                                    const TextAnchor& anchor = entry.textAnchor();
+                                    
+                                    if (camera.squaredDistanceTo(anchor.position()) > cutoff2 ||
+                                        !filter.stringVisible(context, gridEntry.first))
+                                        continue;
+                                    
+                                    // cull the entries behind the camera or outside of the viewport
+                                    const Vec2f size = entry.size().rounded();
+                                    const Vec3f offset = anchor.offset(camera, size);
+                                    if (offset.z() < 0.0f || offset.z() > 1.0f ||
+                                        offset.x() + size.x() + m_hInset < viewport.x ||
+                                        offset.x() - m_hInset > viewport.x + viewport.width ||
+                                        offset.y() + size.y() + m_vInset < viewport.y ||
+                                        offset.y() - m_vInset > viewport.y + viewport.height)
+                                        continue;
+                                    
+                                    m_visibleEntries.push_back(VisibleEntry(&entry, offset));
+                                }
+                            }
                         }
                     }
-
-                    return result;
                 }
             public:
                 TextRenderer(TexturedFont& font) :
@@ -207,6 +311,7 @@ namespace TrenchBroom {
                 m_fadeDistance(100.0f),
                 m_hInset(4.0f),
                 m_vInset(4.0f),
+                m_gridValid(false),
                 m_vbo(NULL) {}
 
                 ~TextRenderer() {
@@ -224,6 +329,21 @@ namespace TrenchBroom {
                 inline void removeString(Key key)  {
                     typename TextMap::iterator it = m_entries.find(key);
                     if (it != m_entries.end()) {
+                        if (m_gridValid) {
+                            const TextEntry* entry = &it->second;
+                            typename Grid::iterator cellIt = m_grid.find(gridCell(entry->textAnchor().position()));
+                            if (cellIt != m_grid.end()) {
+                                GridEntryList& cellEntries = cellIt->second;
+                                typename GridEntryList::iterator gridIt, gridEnd;
+                                for (gridIt = cellEntries.begin(), gridEnd = cellEntries.end(); gridIt != gridEnd && gridIt->second != entry; ++gridIt);
+                                if (gridIt != gridEnd)
+                                    cellEntries.erase(gridIt);
+                                else
+                                    m_gridValid = false; // the anchor has moved since the grid was built
+                            } else {
+                                m_gridValid = false;
+                            }
+                        }
                         m_entries.erase(it);
                     }
                 }
@@ -231,8 +351,8 @@ namespace TrenchBroom {
                 inline void updateString(Key key, const String& string) {
                     typename TextMap::iterator it = m_entries.find(key);
                     if (it != m_entries.end()) {
-                        TextEntry& entry = it->second;
-                        entry.setVertices(m_font.quads(string, true));
+                        TextAnchor::Ptr anchor = it->second.textAnchorPtr();
+                        addString(key, string, anchor);
                     }
                 }
 
@@ -240,8 +360,8 @@ namespace TrenchBroom {
                     typename TextMap::iterator it = m_entries.find(key);
                     if (it != m_entries.end()) {
                         TextEntry& entry = it->second;
-                        destination.addString(key, entry.vertices(), entry.textAnchor());
-                        m_entries.erase(it);
+                        destination.addString(key, entry.vertices(), entry.size(), entry.textAnchorPtr());
+                        removeString(key);
                     }
                 }
 
@@ -251,43 +371,52 @@ namespace TrenchBroom {
 
                 inline void clear()  {
                     m_entries.clear();
+                    m_grid.clear();
+                    m_gridValid = false;
                 }
 
+                inline void invalidatePositions() {
+                    m_gridValid = false;
+                }
+                
                 inline void setFadeDistance(float fadeDistance)  {
+                    if (fadeDistance == m_fadeDistance)
+                        return;
                     m_fadeDistance = fadeDistance;
+                    m_gridValid = false;
                 }
 
                 void render(RenderContext& context, const TextRendererFilter& filter, ShaderProgram& textProgram, const Color& textColor, ShaderProgram& backgroundProgram, const Color& backgroundColor) {
                     if (m_entries.empty())
                         return;
 
-                    EntryList entries = visibleEntries(context, filter);
-                    if (entries.empty())
+                    collectVisibleEntries(context, filter);
+                    if (m_visibleEntries.empty())
                         return;
 
                     if (m_vbo == NULL)
                         m_vbo = new Vbo(GL_ARRAY_BUFFER, 0xFFFF);
 
                     size_t textVertexCount = 0;
-                    for (size_t i = 0; i < entries.size(); i++) {
-                        const TextEntry& entry = entries[i];
+                    size_t rectVertexCount = 0;
+                    for (size_t i = 0; i < m_visibleEntries.size(); i++) {
+                        const TextEntry& entry = *m_visibleEntries[i].entry;
                         textVertexCount += entry.vertices().size() / 2;
+                        rectVertexCount += entry.rectVertices().size();
                     }
 
                     VertexArray textArray(*m_vbo, GL_QUADS, static_cast<unsigned int>(textVertexCount),
                                           Attribute::position3f(),
                                           Attribute::texCoord02f());
 
-                    size_t rectVertexCount = 3 * 16 * entries.size(); // 16 triangles (for a rounded rect with 3 triangles per corner: 3 * 4 + 4 = 16)
                     VertexArray rectArray(*m_vbo, GL_TRIANGLES, static_cast<unsigned int>(rectVertexCount),
                                           Attribute::position3f());
 
                     SetVboState mapVbo(*m_vbo, Vbo::VboMapped);
-                    for (size_t i = 0; i < entries.size(); i++) {
-                        const TextEntry& entry = entries[i];
-                        const Vec2f& size = entry.size().rounded();
-                        const TextAnchor& anchor = entry.textAnchor();
-                        const Vec3f offset = anchor.offset(context.camera(), size);
+                    for (size_t i = 0; i < m_visibleEntries.size(); i++) {
+                        const TextEntry& entry = *m_visibleEntries[i].entry;
+                        const Vec3f& offset = m_visibleEntries[i].offset;
+                        const Vec2f size = entry.size().rounded();
 
                         const Vec2f::List& textVertices = entry.vertices();
                         for (size_t j = 0; j < textVertices.size() / 2; j++) {
@@ -298,9 +427,7 @@ namespace TrenchBroom {
                             textArray.addAttribute(texCoords);
                         }
 
-                        Vec2f::List rectVertices;
-                        rectVertices.reserve(3 * 16);
-                        roundedRect(size.x() + 2.0f * m_hInset, size.y() + 2.0f * m_vInset, 3.0f, 3, rectVertices);
+                        const Vec2f::List& rectVertices = entry.rectVertices();
                         for (size_t j = 0; j < rectVertices.size(); j++) {
                             const Vec2f& vertex = rectVertices[j];
                             rectArray.addAttribute(Vec3f(vertex.x() + offset.x() + size.x() / 2.0f, vertex.y() + offset.y() + size.y() / 2.0f, -offset.z()));
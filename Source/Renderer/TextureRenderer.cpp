@@ -23,6 +23,7 @@
 #include "Model/Bsp.h"
 #include "Model/Alias.h"
 #include "Renderer/Palette.h"
+#include "Renderer/RenderStatistics.h"
 
 namespace TrenchBroom {
     namespace Renderer {
@@ -85,6 +86,7 @@ namespace TrenchBroom {
             }
             
             glBindTexture(GL_TEXTURE_2D, m_textureId);
+            RenderStatistics::countTextureBind();
         }
         
         void TextureRenderer::deactivate() {
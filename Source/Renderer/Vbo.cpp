@@ -18,10 +18,22 @@
  */
 
 #include "Vbo.h"
+
+#include "Renderer/RenderStatistics.h"
+
 #include <algorithm>
+#include <cstddef>
+#include <limits>
 
 namespace TrenchBroom {
     namespace Renderer {
+        class CompareMoveAddresses {
+        public:
+            inline bool operator()(size_t address, const Vbo::Move& move) const {
+                return address < move.address;
+            }
+        };
+        
         void VboBlock::insertBetween(VboBlock* previousBlock, VboBlock* nextBlock) {
             if (previousBlock != NULL) previousBlock->m_next = this;
             m_previous = previousBlock;
@@ -33,46 +45,16 @@ namespace TrenchBroom {
             m_vbo.freeBlock(*this);
         }
         
-        size_t Vbo::findFreeBlockInRange(size_t address, size_t capacity, size_t start, size_t length) {
-            assert(length > 0);
-            
-            size_t pivot = start + length / 2;
-            VboBlock* block = m_freeBlocks[pivot];
-
-            int order = block->compare(address, capacity);
-            if (order == 0)
-                return pivot;
-            if (length == 1) {
-                if (order > 0)
-                    return pivot;
-                return pivot + 1;
-            }
-            
-            if (order > 0)
-                return findFreeBlockInRange(address, capacity, start, length / 2);
-            return findFreeBlockInRange(address, capacity, pivot, (length + 1) / 2);
-        }
-        
-        size_t Vbo::findFreeBlock(size_t address, size_t capacity) {
-            if (m_freeBlocks.empty()) return 0;
-            size_t index = findFreeBlockInRange(address, capacity, 0, static_cast<size_t>(m_freeBlocks.size()));
-            assert(index == m_freeBlocks.size() ||
-                   capacity < m_freeBlocks[index]->capacity() ||
-                   (capacity == m_freeBlocks[index]->capacity() && address <= m_freeBlocks[index]->address()));
-            return index;
+        Vbo::FreeBlockSet::iterator Vbo::findFreeBlock(size_t capacity) {
+            VboBlock key(*this, 0, capacity);
+            return m_freeBlocks.lower_bound(&key);
         }
 
         void Vbo::insertFreeBlock(VboBlock& block) {
             assert(block.free());
-            size_t index = findFreeBlock(block.address(), block.capacity());
-            assert(index <= m_freeBlocks.size());
-            if (index < m_freeBlocks.size()) {
-                std::vector<VboBlock*>::iterator it = m_freeBlocks.begin();
-                std::advance(it, index);
-                m_freeBlocks.insert(it, &block);
-            } else {
-                m_freeBlocks.push_back(&block);
-            }
+            assert(m_freeBlocks.count(&block) == 0);
+            m_freeBlocks.insert(&block);
+            m_freeBlockAddresses.insert(&block);
 #ifdef _DEBUG_VBO
             checkFreeBlocks();
 #endif
@@ -80,67 +62,77 @@ namespace TrenchBroom {
         
         void Vbo::removeFreeBlock(VboBlock& block) {
             assert(block.free());
-            size_t index = findFreeBlock(block.address(), block.capacity());
-            assert(index < m_freeBlocks.size());
-            assert(m_freeBlocks[index] == &block);
-            std::vector<VboBlock*>::iterator it = m_freeBlocks.begin();
-            std::advance(it, index);
-            m_freeBlocks.erase(it);
+            assert(m_freeBlocks.count(&block) == 1);
+            m_freeBlocks.erase(&block);
+            m_freeBlockAddresses.erase(&block);
 #ifdef _DEBUG_VBO
             checkFreeBlocks();
 #endif
         }
         
+        void Vbo::clearFreeBlocks() {
+            m_freeBlocks.clear();
+            m_freeBlockAddresses.clear();
+        }
+        
+        void Vbo::mapForReading() {
+            if (m_state == VboMapped && m_access == GL_READ_WRITE)
+                return;
+            if (m_state == VboMapped)
+                unmap();
+            if (m_state < VboActive)
+                activate();
+            map(GL_READ_WRITE);
+        }
+        
         void Vbo::resizeVbo(size_t newCapacity) {
+            const size_t usedCapacity = m_totalCapacity - m_freeCapacity;
+            assert(newCapacity > usedCapacity);
+            
             VboState oldState = m_state;
             
+            // the allocated blocks are copied anyway, so they are packed in the process
             unsigned char* temp = NULL;
-            MemBlock::List memBlocks;
-            if (m_vboId != 0 && m_freeCapacity < m_totalCapacity) {
-                VboBlock* currentBlock = m_first;
-                size_t totalLength = 0;
-                
-                while (currentBlock != NULL) {
-                    while (currentBlock != NULL && currentBlock->free())
-                        currentBlock = currentBlock->m_next;
-                    if (currentBlock != NULL) {
-                        size_t start = currentBlock->address();
-                        size_t length = 0;
-                        while (currentBlock != NULL && !currentBlock->free()) {
-                            length += currentBlock->capacity();
-                            currentBlock = currentBlock->m_next;
-                        }
-                        memBlocks.push_back(MemBlock(start, length));
-                        totalLength += length;
+            if (m_vboId != 0 && usedCapacity > 0) {
+                mapForReading();
+                temp = new unsigned char[usedCapacity];
+            }
+            
+            clearFreeBlocks();
+            size_t address = 0;
+            VboBlock* first = NULL;
+            VboBlock* previous = NULL;
+            VboBlock* block = m_first;
+            while (block != NULL) {
+                VboBlock* next = block->m_next;
+                if (block->free()) {
+                    delete block;
+                } else {
+                    if (temp != NULL)
+                        memcpy(temp + address, m_buffer + block->address(), block->capacity());
+                    if (block->address() != address) {
+                        m_counters.movedBlocks++;
+                        m_counters.movedBytes += block->capacity();
                     }
+                    block->m_address = address;
+                    block->insertBetween(previous, NULL);
+                    address += block->capacity();
+                    if (first == NULL)
+                        first = block;
+                    previous = block;
                 }
-                
-                if (m_state < VboActive)
-                    activate();
-                if (m_state < VboMapped)
-                    map();
-
-                temp = new unsigned char[totalLength];
-                size_t offset = 0;
-                MemBlock::List::const_iterator it, end;
-                for (it = memBlocks.begin(), end = memBlocks.end(); it != end; ++it) {
-                    const MemBlock& memBlock = *it;
-                    memcpy(temp + offset, m_buffer + memBlock.start, memBlock.length);
-                    offset += memBlock.length;
-                }
+                block = next;
             }
+            assert(address == usedCapacity);
             
-            size_t addedCapacity = newCapacity - m_totalCapacity;
-            m_freeCapacity = newCapacity - (m_totalCapacity - m_freeCapacity);
-            m_totalCapacity = newCapacity;
+            m_last = new VboBlock(*this, usedCapacity, newCapacity - usedCapacity);
+            m_last->insertBetween(previous, NULL);
+            insertFreeBlock(*m_last);
+            m_first = first != NULL ? first : m_last;
             
-            if (m_last->free()) {
-                resizeBlock(*m_last, m_last->capacity() + addedCapacity);
-            } else {
-                VboBlock* block = new VboBlock(*this, m_last->address() + m_last->capacity(), addedCapacity);
-                block->insertBetween(m_last, NULL);
-                insertFreeBlock(*block);
-            }
+            m_totalCapacity = newCapacity;
+            m_freeCapacity = newCapacity - usedCapacity;
+            m_counters.resizes++;
             
             if (m_vboId != 0) {
                 if (m_state == VboMapped)
@@ -152,23 +144,14 @@ namespace TrenchBroom {
             }
             
             if (temp != NULL) {
-                assert(!memBlocks.empty());
-                
                 if (m_state < VboActive)
                     activate();
                 if (m_state < VboMapped)
                     map();
                 
-                size_t offset = 0;
-                MemBlock::List::const_iterator it, end;
-                for (it = memBlocks.begin(), end = memBlocks.end(); it != end; ++it) {
-                    const MemBlock& memBlock = *it;
-                    memcpy(m_buffer + memBlock.start, temp + offset, memBlock.length);
-                }
-                
+                memcpy(m_buffer, temp, usedCapacity);
                 delete [] temp;
                 temp = NULL;
-                memBlocks.clear();
                 
                 if (oldState < VboMapped)
                     unmap();
@@ -196,49 +179,58 @@ namespace TrenchBroom {
             }
         }
         
-        VboBlock* Vbo::packBlock(VboBlock& block) {
-            VboBlock* first = block.m_next;
-            if (first == NULL)
+        VboBlock* Vbo::firstFreeBlock() const {
+            if (m_freeBlockAddresses.empty())
                 return NULL;
+            return *m_freeBlockAddresses.begin();
+        }
+        
+        VboBlock* Vbo::moveNextBlock(VboBlock& block, MoveList* moves) {
+            assert(block.free());
+            assert(m_access == GL_READ_WRITE);
+            VboBlock* used = block.m_next;
+            assert(used != NULL && !used->free());
             
-            VboBlock* previous = NULL;
-            VboBlock* last = first;
-            size_t size = 0;
-            size_t address = first->address();
-            
-            do {
-                last->m_address -= block.capacity();
-                size += last->capacity();
-                previous = last;
-                last = last->m_next;
-            } while (last != NULL && !last->free());
-            
-            memmove(m_buffer + block.address(), m_buffer + address, size);
-            
-            if (last != NULL) {
-                last->m_address -= block.capacity();
-                resizeBlock(*last, last->capacity() + block.capacity());
-            } else {
-                VboBlock* newBlock = new VboBlock(*this, previous->address() + previous->capacity(), block.capacity());
-                insertFreeBlock(*newBlock);
-                newBlock->insertBetween(previous, NULL);
-                m_last = newBlock;
-            }
+            memmove(m_buffer + block.address(), m_buffer + used->address(), used->capacity());
+            m_counters.movedBlocks++;
+            m_counters.movedBytes += used->capacity();
             
-            if (m_first == &block) m_first = block.m_next;
+            if (moves != NULL) {
+                // consecutive blocks moved by the same distance form one span
+                if (!moves->empty() && moves->back().distance == block.capacity() && moves->back().address + moves->back().size == used->address())
+                    moves->back().size += used->capacity();
+                else
+                    moves->push_back(Move(used->address(), used->capacity(), block.capacity()));
+            }
             
+            // swap the free block with the allocated block that follows it
             removeFreeBlock(block);
-            if (block.m_previous != NULL) block.m_previous->m_next = block.m_next;
-            if (block.m_next != NULL) block.m_next->m_previous = block.m_previous;
-            delete &block;
-
-            return last;
+            VboBlock* previous = block.m_previous;
+            VboBlock* next = used->m_next;
+            used->m_address = block.address();
+            block.m_address = used->address() + used->capacity();
+            used->insertBetween(previous, &block);
+            block.insertBetween(used, next);
+            if (m_first == &block) m_first = used;
+            if (m_last == used) m_last = &block;
+            
+            // free blocks are never adjacent, so the free block can only meet another one after the swap
+            if (next != NULL && next->free()) {
+                removeFreeBlock(*next);
+                block.m_capacity += next->capacity();
+                block.insertBetween(used, next->m_next);
+                if (m_last == next) m_last = &block;
+                delete next;
+            }
+            
+            insertFreeBlock(block);
+            return &block;
         }
         
-        Vbo::Vbo(GLenum type, size_t capacity) : m_type(type), m_totalCapacity(capacity), m_freeCapacity(capacity), m_buffer(NULL), m_vboId(0), m_state(VboInactive) {
+        Vbo::Vbo(GLenum type, size_t capacity) : m_type(type), m_totalCapacity(capacity), m_freeCapacity(capacity), m_buffer(NULL), m_vboId(0), m_state(VboInactive), m_access(GL_WRITE_ONLY), m_writtenBytes(0), m_writtenBytesWhenMapped(0) {
             m_first = new VboBlock(*this, 0, m_totalCapacity);
             m_last = m_first;
-            m_freeBlocks.push_back(m_first);
+            insertFreeBlock(*m_first);
 #ifdef _DEBUG_VBO
             checkBlockChain();
             checkFreeBlocks();
@@ -256,7 +248,7 @@ namespace TrenchBroom {
                 deactivate();
             if (m_vboId != 0)
                 glDeleteBuffers(1, &m_vboId);
-            m_freeBlocks.clear();
+            clearFreeBlocks();
             VboBlock* block = m_first;
             while (block != NULL) {
                 VboBlock* next = block->m_next;
@@ -290,14 +282,16 @@ namespace TrenchBroom {
             m_state = VboInactive;
         }
         
-        void Vbo::map() {
+        void Vbo::map(GLenum access) {
             assert(m_state == VboActive);
             
-            m_buffer = (unsigned char *)glMapBuffer(m_type, GL_WRITE_ONLY);
+            m_buffer = (unsigned char *)glMapBuffer(m_type, access);
             GLenum error = glGetError();
 			if (m_buffer == NULL || error != GL_NO_ERROR)
 				throw VboException(*this, "Vbo could not be mapped", error);
 
+            m_access = access;
+            m_writtenBytesWhenMapped = m_writtenBytes;
             m_state = VboMapped;
         }
         
@@ -305,6 +299,11 @@ namespace TrenchBroom {
             assert(m_state == VboMapped);
             
             glUnmapBuffer(m_type);
+            
+            // a mapping that nothing was written to costs no upload
+            const size_t uploadedBytes = m_writtenBytes - m_writtenBytesWhenMapped;
+            if (uploadedBytes > 0)
+                RenderStatistics::countBufferUpload(uploadedBytes);
 
             GLenum error = glGetError();
 			if (error != GL_NO_ERROR)
@@ -314,6 +313,18 @@ namespace TrenchBroom {
             m_state = VboActive;
         }
         
+        size_t Vbo::largestFreeBlockCapacity() const {
+            if (m_freeBlocks.empty())
+                return 0;
+            return (*m_freeBlocks.rbegin())->capacity();
+        }
+        
+        float Vbo::fragmentation() const {
+            if (m_freeCapacity == 0)
+                return 0.0f;
+            return 1.0f - static_cast<float>(largestFreeBlockCapacity()) / static_cast<float>(m_freeCapacity);
+        }
+        
         void Vbo::ensureFreeCapacity(size_t capacity) {
             pack();
             if (m_freeCapacity < capacity)
@@ -328,30 +339,28 @@ namespace TrenchBroom {
             checkFreeBlocks();
 #endif
 
-            size_t index = findFreeBlock(0, capacity);
-            if (index >= m_freeBlocks.size()) {
-                SetVboState mapVbo(*this, VboMapped);
-                pack();
-
-                if (capacity > m_freeCapacity) {
-                    const size_t usedCapacity = m_totalCapacity - m_freeCapacity;
-                    size_t newCapacity = m_totalCapacity;
-                    size_t newFreeCapacity = m_freeCapacity;
-                    while (capacity > newFreeCapacity) {
-                        newCapacity *= 2;
-                        newFreeCapacity = newCapacity - usedCapacity;
-                    }
-                    resizeVbo(newCapacity);
-                }
+            FreeBlockSet::iterator it = findFreeBlock(capacity);
+            if (it == m_freeBlocks.end() && m_freeCapacity >= capacity) {
+                // merging the free blocks is cheaper than growing as long as few blocks must be moved for it
+                compact(AllocationCompactionBudget, capacity, NULL);
+                it = findFreeBlock(capacity);
+            }
+            
+            if (it == m_freeBlocks.end()) {
+                // growing the VBO packs it, and growing it geometrically keeps the cost of packing amortized
+                const size_t usedCapacity = m_totalCapacity - m_freeCapacity;
+                size_t newCapacity = std::max(m_totalCapacity, capacity);
+                do {
+                    newCapacity *= 2;
+                } while (capacity > newCapacity - usedCapacity);
+                resizeVbo(newCapacity);
                 
-                index = findFreeBlock(0, capacity);
-                assert(index < m_freeBlocks.size());
+                it = findFreeBlock(capacity);
+                assert(it != m_freeBlocks.end());
             }
             
-            VboBlock* block = m_freeBlocks[index];
-            std::vector<VboBlock*>::iterator it = m_freeBlocks.begin();
-            std::advance(it, index);
-            m_freeBlocks.erase(it);
+            VboBlock* block = *it;
+            removeFreeBlock(*block);
             
             // split block
             if (capacity < block->capacity()) {
@@ -364,6 +373,7 @@ namespace TrenchBroom {
             
             m_freeCapacity -= block->capacity();
             block->m_free = false;
+            m_counters.allocations++;
 
 #ifdef _DEBUG_VBO
             checkBlockChain();
@@ -384,6 +394,7 @@ namespace TrenchBroom {
             
             m_freeCapacity += block.capacity();
             block.m_free = true;
+            m_counters.frees++;
             
             if (previous != NULL && previous->free() && next != NULL && next->free()) {
                 resizeBlock(*previous, previous->capacity() + block.capacity() + next->capacity());
@@ -425,7 +436,7 @@ namespace TrenchBroom {
         }
 
         void Vbo::freeAllBlocks() {
-            m_freeBlocks.clear();
+            clearFreeBlocks();
             VboBlock* block = m_first;
             while (block != NULL) {
                 VboBlock* next = block->m_next;
@@ -433,31 +444,48 @@ namespace TrenchBroom {
                 block = next;
             }
             m_first = m_last = new VboBlock(*this, 0, m_totalCapacity);
-            m_freeBlocks.push_back(m_first);
+            insertFreeBlock(*m_first);
             m_freeCapacity = m_totalCapacity;
         }
 
-        void Vbo::pack() {
-            assert(m_state == VboMapped);
-            
+        size_t Vbo::compact(size_t maxBytes, size_t capacity, MoveList* moves) {
 #ifdef _DEBUG_VBO
             checkBlockChain();
             checkFreeBlocks();
 #endif
 
-            if (m_totalCapacity == m_freeCapacity || (m_last->free() && m_last->capacity() == m_freeCapacity)) return;
+            const VboState oldState = m_state;
+            size_t movedBytes = 0;
+            VboBlock* block = firstFreeBlock();
+            while (block != NULL && block->m_next != NULL && block->capacity() < capacity && movedBytes < maxBytes) {
+                mapForReading();
+                movedBytes += block->m_next->capacity();
+                block = moveNextBlock(*block, moves);
+            }
             
-            // find first free block
-            VboBlock* block = m_first;
-            while (block != NULL && !block->free())
-                block = block->m_next;
-            while (block != NULL && block->m_next != NULL)
-                block = packBlock(*block);
+            if (oldState < VboMapped && m_state == VboMapped)
+                unmap();
+            if (oldState < VboActive && m_state == VboActive)
+                deactivate();
 
 #ifdef _DEBUG_VBO
             checkBlockChain();
             checkFreeBlocks();
 #endif
+            
+            return movedBytes;
+        }
+
+        size_t Vbo::compact(size_t maxBytes, MoveList& moves) {
+            return compact(maxBytes, std::numeric_limits<size_t>::max(), &moves);
+        }
+        
+        size_t Vbo::compact(size_t maxBytes) {
+            return compact(maxBytes, std::numeric_limits<size_t>::max(), NULL);
+        }
+        
+        void Vbo::pack() {
+            compact(std::numeric_limits<size_t>::max());
         }
 
 #ifdef _DEBUG_VBO
@@ -477,18 +505,58 @@ namespace TrenchBroom {
         }
         
         void Vbo::checkFreeBlocks() {
-            for (size_t i = 0; i < m_freeBlocks.size(); i++) {
-                VboBlock* block = m_freeBlocks[i];
-                assert(block->free());
-                if (i < m_freeBlocks.size() - 1)
-                    assert((block->capacity() < m_freeBlocks[i + 1]->capacity()) || 
-                           (block->capacity() == m_freeBlocks[i + 1]->capacity() && block->address() < m_freeBlocks[i + 1]->address()));
-            }
+            FreeBlockSet::const_iterator it, end;
+            for (it = m_freeBlocks.begin(), end = m_freeBlocks.end(); it != end; ++it)
+                assert((*it)->free());
+            assert(m_freeBlockAddresses.size() == m_freeBlocks.size());
         }
 #endif
         
         bool Vbo::ownsBlock(VboBlock& block) {
             return &block.m_vbo == this;
         }
+        
+        void Vbo::shiftRanges(const MoveList& moves, size_t vertexSize, std::vector<GLint>& firsts, std::vector<GLsizei>& counts) {
+            assert(firsts.size() == counts.size());
+            if (moves.empty())
+                return;
+            
+            for (size_t i = 0; i < firsts.size(); i++) {
+                const size_t start = static_cast<size_t>(firsts[i]) * vertexSize;
+                const size_t end = start + static_cast<size_t>(counts[i]) * vertexSize;
+                
+                // find the move that contains the start of the range or the first one after it
+                MoveList::const_iterator move = std::upper_bound(moves.begin(), moves.end(), start, CompareMoveAddresses());
+                if (move != moves.begin() && start < (move - 1)->address + (move - 1)->size)
+                    --move;
+                
+                size_t position = start;
+                bool replaced = false;
+                while (position < end) {
+                    size_t pieceEnd = end;
+                    size_t distance = 0;
+                    if (move != moves.end() && move->address <= position) {
+                        pieceEnd = std::min(end, move->address + move->size);
+                        distance = move->distance;
+                        ++move;
+                    } else if (move != moves.end()) {
+                        pieceEnd = std::min(end, move->address);
+                    }
+                    
+                    const GLint first = static_cast<GLint>((position - distance) / vertexSize);
+                    const GLsizei count = static_cast<GLsizei>((pieceEnd - position) / vertexSize);
+                    if (!replaced) {
+                        firsts[i] = first;
+                        counts[i] = count;
+                        replaced = true;
+                    } else {
+                        ++i;
+                        firsts.insert(firsts.begin() + static_cast<std::ptrdiff_t>(i), first);
+                        counts.insert(counts.begin() + static_cast<std::ptrdiff_t>(i), count);
+                    }
+                    position = pieceEnd;
+                }
+            }
+        }
     }
 }
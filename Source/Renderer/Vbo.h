@@ -27,6 +27,7 @@
 #include <cassert>
 #include <cstring>
 #include <exception>
+#include <set>
 #include <sstream>
 #include <vector>
 
@@ -45,38 +46,92 @@ namespace TrenchBroom {
                 VboActive   = 1,
                 VboMapped   = 2
             } VboState;
-        private:
-            struct MemBlock {
-                typedef std::vector<MemBlock> List;
-                
-                size_t start;
-                size_t length;
+            
+            /**
+             * Counts the block operations and the resulting data movement since the last call to resetCounters.
+             */
+            class Counters {
+            public:
+                size_t allocations;
+                size_t frees;
+                size_t resizes;
+                size_t movedBlocks;
+                size_t movedBytes;
                 
-                MemBlock(size_t i_start, size_t i_length) :
-                start(i_start),
-                length(i_length) {}
+                Counters() :
+                allocations(0),
+                frees(0),
+                resizes(0),
+                movedBlocks(0),
+                movedBytes(0) {}
+            };
+            
+            /**
+             * A span of allocated bytes that was moved towards the start of the VBO by compact. The address is the
+             * address of the span before it was moved.
+             */
+            class Move {
+            public:
+                size_t address;
+                size_t size;
+                size_t distance;
                 
-                MemBlock() :
-                start(0),
-                length(0) {}
+                Move(size_t i_address, size_t i_size, size_t i_distance) :
+                address(i_address),
+                size(i_size),
+                distance(i_distance) {}
+            };
+            
+            typedef std::vector<Move> MoveList;
+        private:
+            class CompareFreeBlocks {
+            public:
+                inline bool operator()(const VboBlock* left, const VboBlock* right) const;
+            };
+            
+            class CompareFreeBlockAddresses {
+            public:
+                inline bool operator()(const VboBlock* left, const VboBlock* right) const;
             };
+            
+            /**
+             * The free blocks ordered by capacity and address, so that the best fitting block for an allocation is
+             * found in logarithmic time. A block must be removed from the set before its capacity or address change.
+             */
+            typedef std::set<VboBlock*, CompareFreeBlocks> FreeBlockSet;
+            
+            /**
+             * The same free blocks ordered by address only, so that compaction finds the first free block without
+             * walking the block chain.
+             */
+            typedef std::set<VboBlock*, CompareFreeBlockAddresses> FreeBlockAddressSet;
+            
+            static const size_t AllocationCompactionBudget = 0x40000;
 
             GLenum m_type;
             size_t m_totalCapacity;
             size_t m_freeCapacity;
-            std::vector<VboBlock*> m_freeBlocks;
+            FreeBlockSet m_freeBlocks;
+            FreeBlockAddressSet m_freeBlockAddresses;
             VboBlock* m_first;
             VboBlock* m_last;
             unsigned char* m_buffer;
             GLuint m_vboId;
             VboState m_state;
-            size_t findFreeBlockInRange(size_t address, size_t capacity, size_t start, size_t length);
-            size_t findFreeBlock(size_t address, size_t capacity);
+            GLenum m_access;
+            size_t m_writtenBytes;
+            size_t m_writtenBytesWhenMapped;
+            Counters m_counters;
+            FreeBlockSet::iterator findFreeBlock(size_t capacity);
             void insertFreeBlock(VboBlock& block);
             void removeFreeBlock(VboBlock& block);
+            void clearFreeBlocks();
+            void mapForReading();
             void resizeVbo(size_t newCapacity);
             void resizeBlock(VboBlock& block, size_t newCapacity);
-            VboBlock* packBlock(VboBlock& block);
+            VboBlock* firstFreeBlock() const;
+            VboBlock* moveNextBlock(VboBlock& block, MoveList* moves);
+            size_t compact(size_t maxBytes, size_t capacity, MoveList* moves);
 #ifdef _DEBUG_VBO
             void checkBlockChain();
             void checkFreeBlocks();
@@ -91,19 +146,88 @@ namespace TrenchBroom {
             ~Vbo();
             void activate();
             void deactivate();
-            void map();
+            
+            /**
+             * Maps the VBO with the given access. Compaction and growing remap the VBO for reading and writing when
+             * they need to move blocks.
+             */
+            void map(GLenum access = GL_WRITE_ONLY);
             void unmap();
             
             inline VboState state() const {
                 return m_state;
             }
             
+            /**
+             * Returns the number of bytes that were written to this VBO through its blocks since the last call to
+             * resetWrittenBytes.
+             */
+            inline size_t writtenBytes() const {
+                return m_writtenBytes;
+            }
+            
+            inline void resetWrittenBytes() {
+                m_writtenBytes = 0;
+                m_writtenBytesWhenMapped = 0;
+            }
+            
+            inline const Counters& counters() const {
+                return m_counters;
+            }
+            
+            inline void resetCounters() {
+                m_counters = Counters();
+            }
+            
+            inline size_t totalCapacity() const {
+                return m_totalCapacity;
+            }
+            
+            inline size_t freeCapacity() const {
+                return m_freeCapacity;
+            }
+            
+            inline size_t freeBlockCount() const {
+                return m_freeBlocks.size();
+            }
+            
+            size_t largestFreeBlockCapacity() const;
+            
+            /**
+             * Returns the share of the free capacity that lies outside of the largest free block, between 0 (not
+             * fragmented) and 1.
+             */
+            float fragmentation() const;
+            
             void ensureFreeCapacity(size_t capacity);
+            
+            /**
+             * Allocates a block of the given capacity from the smallest free block that can hold it. If there is no
+             * such block but the total free capacity suffices, the VBO is compacted within a budget until a free block
+             * is large enough. Only if that fails, the VBO is grown, which also packs all allocated blocks. Either way,
+             * allocated blocks may move, so their owners must reread their addresses after an allocation.
+             */
             VboBlock* allocBlock(size_t capacity);
             VboBlock* freeBlock(VboBlock& block);
             void freeAllBlocks();
+            
+            /**
+             * Moves allocated blocks towards the start of the VBO, one at a time, until all free capacity is at its
+             * end or at least the given number of bytes have been moved. Returns the number of moved bytes. Moved
+             * blocks keep their identity, but their addresses change; the moved spans are appended to the given list
+             * in the order of their addresses. If any blocks must be moved, the VBO is mapped for reading and writing
+             * while they are moved.
+             */
+            size_t compact(size_t maxBytes, MoveList& moves);
+            size_t compact(size_t maxBytes);
             void pack();
             bool ownsBlock(VboBlock& block);
+            
+            /**
+             * Applies the given moves to draw ranges of vertices of the given size in this VBO. A range that was only
+             * partially moved is split.
+             */
+            static void shiftRanges(const MoveList& moves, size_t vertexSize, std::vector<GLint>& firsts, std::vector<GLsizei>& counts);
         };
 
         class SetVboState {
@@ -195,24 +319,28 @@ namespace TrenchBroom {
             inline size_t writeBuffer(const unsigned char* buffer, size_t offset, size_t length) {
                 assert(offset + length <= m_capacity);
                 memcpy(m_vbo.m_buffer + m_address + offset, buffer, length);
+                m_vbo.m_writtenBytes += length;
                 return offset + length;
             }
 
             inline size_t writeByte(unsigned char b, size_t offset) {
                 assert(offset < m_capacity);
                 m_vbo.m_buffer[m_address + offset] = b;
+                m_vbo.m_writtenBytes += 1;
                 return offset + 1;
             }
 
             inline size_t writeFloat(float f, size_t offset) {
                 assert(offset + sizeof(float) <= m_capacity);
                 memcpy(m_vbo.m_buffer + m_address + offset, &f, sizeof(float));
+                m_vbo.m_writtenBytes += sizeof(float);
                 return offset + sizeof(float);
             }
 
             inline size_t writeUInt32(size_t i, size_t offset) {
                 assert(offset + sizeof(size_t) <= m_capacity);
                 memcpy(m_vbo.m_buffer + m_address + offset, &i, sizeof(size_t));
+                m_vbo.m_writtenBytes += sizeof(size_t);
                 return offset + sizeof(size_t);
             }
 
@@ -222,6 +350,7 @@ namespace TrenchBroom {
                 m_vbo.m_buffer[m_address + offset + 1] = static_cast<unsigned char>(color.g() * 0xFF);
                 m_vbo.m_buffer[m_address + offset + 2] = static_cast<unsigned char>(color.b() * 0xFF);
                 m_vbo.m_buffer[m_address + offset + 3] = static_cast<unsigned char>(color.a() * 0xFF);
+                m_vbo.m_writtenBytes += 4;
                 return offset + 4;
             }
 
@@ -229,6 +358,7 @@ namespace TrenchBroom {
             inline size_t writeVec(const T& vec, size_t offset) {
                 assert(offset + sizeof(T) <= m_capacity);
                 memcpy(m_vbo.m_buffer + m_address + offset, &vec, sizeof(T));
+                m_vbo.m_writtenBytes += sizeof(T);
                 return offset + sizeof(T);
             }
 
@@ -237,12 +367,13 @@ namespace TrenchBroom {
                 size_t size = static_cast<size_t>(vecs.size() * sizeof(T));
                 assert(offset + size <= m_capacity);
                 memcpy(m_vbo.m_buffer + m_address + offset, &(vecs[0]), size);
+                m_vbo.m_writtenBytes += size;
                 return offset + size;
             }
 
             void freeBlock();
 
-            inline int compare(size_t address, size_t capacity) {
+            inline int compare(size_t address, size_t capacity) const {
                 if (m_capacity < capacity) return -1;
                 if (m_capacity > capacity) return 1;
                 if (m_address < address) return -1;
@@ -250,6 +381,14 @@ namespace TrenchBroom {
                 return 0;
             }
         };
+        
+        inline bool Vbo::CompareFreeBlocks::operator()(const VboBlock* left, const VboBlock* right) const {
+            return left->compare(right->address(), right->capacity()) < 0;
+        }
+        
+        inline bool Vbo::CompareFreeBlockAddresses::operator()(const VboBlock* left, const VboBlock* right) const {
+            return left->address() < right->address();
+        }
 
 		class VboException : public std::exception {
 		protected:
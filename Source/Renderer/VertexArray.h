@@ -23,6 +23,7 @@
 #include "Renderer/AttributeArray.h"
 
 #include <GL/glew.h>
+#include "Renderer/RenderStatistics.h"
 #include "Renderer/Vbo.h"
 #include "Renderer/Shader/Shader.h"
 #include "Utility/String.h"
@@ -54,11 +55,13 @@ namespace TrenchBroom {
             RenderArray(vbo, primType, vertexCapacity, attributes, padTo) {}
             
             inline void renderPrimitives(size_t index, size_t vertexCount) {
+                RenderStatistics::countDrawCall();
                 glDrawArrays(m_primType, static_cast<GLint>(index), static_cast<GLsizei>(vertexCount));
             }
 
             inline void render() {
                 setup();
+                RenderStatistics::countDrawCall();
                 glDrawArrays(m_primType, 0, static_cast<GLsizei>(m_vertexCount));
                 cleanup();
             }
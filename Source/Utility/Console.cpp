@@ -25,23 +25,137 @@
 #include "NSLog.h"
 #endif
 
+#include <cassert>
 #include <cstdarg>
 #include <fstream>
 #include <wx/datetime.h>
+#include <wx/thread.h>
 #include <wx/wx.h>
 
 namespace TrenchBroom {
     namespace Utility {
+        /**
+         * Appends lines to the log file on a background thread so that logging does not block on file I/O. All
+         * consoles share one sink, which is started by the first console and stopped by the last one.
+         */
+        class LogFileSink : public wxThread {
+        private:
+            static LogFileSink* sharedSink;
+            static size_t sharedSinkUsers;
+            
+            String m_path;
+            wxMutex m_mutex;
+            wxCondition m_condition;
+            StringList m_lines;
+            bool m_exit;
+        protected:
+            ExitCode Entry() {
+                std::fstream logStream(m_path.c_str(), std::ios::out | std::ios::app);
+                StringList lines;
+                
+                m_mutex.Lock();
+                while (true) {
+                    while (m_lines.empty() && !m_exit)
+                        m_condition.Wait();
+                    
+                    lines.swap(m_lines);
+                    const bool exit = m_exit;
+                    m_mutex.Unlock();
+                    
+                    if (logStream.is_open()) {
+                        for (size_t i = 0; i < lines.size(); i++)
+                            logStream << lines[i] << '\n';
+                        logStream.flush();
+                    }
+                    lines.clear();
+                    
+                    m_mutex.Lock();
+                    if (exit && m_lines.empty())
+                        break;
+                }
+                m_mutex.Unlock();
+                
+                return static_cast<ExitCode>(0);
+            }
+        public:
+            LogFileSink(const String& path) :
+            wxThread(wxTHREAD_JOINABLE),
+            m_path(path),
+            m_condition(m_mutex),
+            m_exit(false) {}
+            
+            void write(const String& line) {
+                wxMutexLocker lock(m_mutex);
+                m_lines.push_back(line);
+                m_condition.Signal();
+            }
+            
+            void stop() {
+                m_mutex.Lock();
+                m_exit = true;
+                m_condition.Signal();
+                m_mutex.Unlock();
+                Wait();
+            }
+            
+            /**
+             * Returns the shared sink, starting it if necessary, or NULL if there is no log file to write to. Every
+             * call must be matched by a call to release.
+             */
+            static LogFileSink* acquire() {
+                sharedSinkUsers++;
+                if (sharedSink != NULL)
+                    return sharedSink;
+                
+                IO::FileManager fileManager;
+                const String logDirectory = fileManager.logDirectory();
+                if (logDirectory.empty())
+                    return NULL;
+                if (!fileManager.exists(logDirectory))
+                    fileManager.makeDirectory(logDirectory);
+                
+                sharedSink = new LogFileSink(fileManager.appendPath(logDirectory, "TrenchBroom.log"));
+                if (sharedSink->Run() != wxTHREAD_NO_ERROR) {
+                    delete sharedSink;
+                    sharedSink = NULL;
+                }
+                return sharedSink;
+            }
+            
+            static void release() {
+                assert(sharedSinkUsers > 0);
+                sharedSinkUsers--;
+                if (sharedSinkUsers == 0 && sharedSink != NULL) {
+                    sharedSink->stop();
+                    delete sharedSink;
+                    sharedSink = NULL;
+                }
+            }
+        };
+        
+        LogFileSink* LogFileSink::sharedSink = NULL;
+        size_t LogFileSink::sharedSinkUsers = 0;
+        
         void Console::logToDebug(const LogMessage& message) {
             // wxLogDebug(message.string().c_str());
         }
 
         void Console::logToConsole(const LogMessage& message) {
+            if (message.count() == 1) {
+                logToConsole(message.level(), message.string());
+            } else {
+                StringStream buffer;
+                buffer << message.string() << " (" << message.count() << " times)";
+                logToConsole(message.level(), buffer.str());
+            }
+        }
+        
+        void Console::logToConsole(const LogLevel level, const String& string) {
             long start = m_textCtrl->GetLastPosition();
-            m_textCtrl->AppendText(message.string());
+            m_textCtrl->AppendText(string);
             m_textCtrl->AppendText("\n");
             long end = m_textCtrl->GetLastPosition();
-            switch (message.level()) {
+            switch (level) {
                 case LLDebug:
                     m_textCtrl->SetStyle(start, end, wxTextAttr(*wxLIGHT_GREY, *wxBLACK)); // SetDefaultStyle doesn't work on OS X / Cocoa
                     break;
@@ -61,42 +175,86 @@ namespace TrenchBroom {
 #if defined __APPLE__
             NSLogWrapper(message.string());
 #else
-            IO::FileManager fileManager;
-            const String logDirectory = fileManager.logDirectory();
-            if (logDirectory.empty())
+            if (m_fileSink == NULL)
                 return;
-            if (!fileManager.exists(logDirectory))
-                fileManager.makeDirectory(logDirectory);
-            const String logFilePath = fileManager.appendPath(logDirectory, "TrenchBroom.log");
-            std::fstream logStream(logFilePath.c_str(), std::ios::out | std::ios::app);
-            if (logStream.is_open()) {
-                wxDateTime now = wxDateTime::Now();
-                logStream << wxGetProcessId() << " " << now.FormatISOCombined(' ') << ": " << message.string() << std::endl;
-            }
+            
+            wxDateTime now = wxDateTime::Now();
+            StringStream line;
+            line << wxGetProcessId() << " " << now.FormatISOCombined(' ') << ": " << message.string();
+            m_fileSink->write(line.str());
 #endif
         }
 
+        Console::Console() :
+        m_droppedMessageCount(0),
+        m_textCtrl(NULL),
+        m_fileSink(NULL) {
+#if !defined __APPLE__
+            m_fileSink = LogFileSink::acquire();
+#endif
+        }
+        
+        Console::~Console() {
+#if !defined __APPLE__
+            LogFileSink::release();
+            m_fileSink = NULL;
+#endif
+        }
+        
         void Console::setTextCtrl(wxTextCtrl* textCtrl) {
             m_textCtrl = textCtrl;
-            if (m_textCtrl != NULL) {
-                for (unsigned int i = 0; i < m_buffer.size(); i++) {
-                    const LogMessage& message = m_buffer[i];
-                    logToConsole(message);
-                }
-                m_buffer.clear();
-            }
+            flush();
         }
 
+        void Console::flush() {
+            if (m_textCtrl == NULL || (m_pendingMessages.empty() && m_droppedMessageCount == 0))
+                return;
+            
+            m_textCtrl->Freeze();
+            if (m_droppedMessageCount > 0) {
+                StringStream buffer;
+#if defined __APPLE__
+                // all messages are passed to NSLog
+                buffer << m_droppedMessageCount << " messages omitted, see the system log for details";
+#else
+                if (m_fileSink != NULL)
+                    buffer << m_droppedMessageCount << " messages omitted, see log file for details";
+                else
+                    buffer << m_droppedMessageCount << " messages omitted";
+#endif
+                logToConsole(LLWarn, buffer.str());
+                m_droppedMessageCount = 0;
+            }
+            
+            LogMessageQueue::const_iterator it, end;
+            for (it = m_pendingMessages.begin(), end = m_pendingMessages.end(); it != end; ++it)
+                logToConsole(*it);
+            m_pendingMessages.clear();
+            
+            const long length = m_textCtrl->GetLastPosition();
+            if (length > MaxConsoleLength)
+                m_textCtrl->Remove(0, length - MaxConsoleLength);
+            
+            m_textCtrl->ShowPosition(m_textCtrl->GetLastPosition());
+            m_textCtrl->Thaw();
+        }
+        
         void Console::log(const LogMessage& message) {
             if (message.string().empty())
                 return;
 
             logToDebug(message);
             logToFile(message);
-            if (m_textCtrl != NULL)
-                logToConsole(message);
-            else
-                m_buffer.push_back(message);
+            
+            if (!m_pendingMessages.empty() && m_pendingMessages.back().isRepeatOf(message)) {
+                m_pendingMessages.back().repeat();
+            } else {
+                if (m_pendingMessages.size() == MaxPendingMessages) {
+                    m_pendingMessages.pop_front();
+                    m_droppedMessageCount++;
+                }
+                m_pendingMessages.push_back(message);
+            }
         }
 
         void Console::debug(const String& message) {
@@ -24,10 +24,18 @@
 
 #include <wx/textctrl.h>
 
-#include <vector>
+#include <deque>
 
 namespace TrenchBroom {
     namespace Utility {
+        class LogFileSink;
+        
+        /**
+         * Collects log messages and appends them to the log view in batches. Messages are queued until flush is
+         * called (once per idle event), consecutive duplicates are collapsed into one message with their count,
+         * and if more than MaxPendingMessages messages are queued between two flushes, the oldest ones are dropped.
+         * Messages are written to the log file by a background thread that is shared by all consoles.
+         */
         class Console {
         protected:
             typedef enum {
@@ -41,26 +49,23 @@ namespace TrenchBroom {
             protected:
                 LogLevel m_level;
                 String m_string;
+                size_t m_count;
             public:
                 LogMessage(const LogLevel level, const String& string) :
-                m_level(level) {
-                    String trimmed = Utility::trim(string);
-                    StringStream buffer;
+                m_level(level),
+                m_count(1) {
+                    const String trimmed = Utility::trim(string);
+                    m_string.reserve(trimmed.length());
+                    
                     bool previousWasNewline = false;
-                    for (unsigned int i = 0; i < trimmed.length(); i++) {
-                        char c = trimmed[i];
+                    for (size_t i = 0; i < trimmed.length(); i++) {
+                        const char c = trimmed[i];
                         if (c == '\r')
                             continue;
-                        if (c == '\n') {
-                            if (!previousWasNewline)
-                                buffer << c;
-                            previousWasNewline = true;
-                        } else {
-                            buffer << c;
-                            previousWasNewline = false;
-                        }
+                        if (c != '\n' || !previousWasNewline)
+                            m_string.push_back(c);
+                        previousWasNewline = c == '\n';
                     }
-                    m_string = buffer.str();
                 }
                 
                 inline const LogLevel level() const {
@@ -70,21 +75,48 @@ namespace TrenchBroom {
                 inline const String& string() const {
                     return m_string;
                 }
+                
+                /**
+                 * Returns how many times this message was logged in a row.
+                 */
+                inline size_t count() const {
+                    return m_count;
+                }
+                
+                inline bool isRepeatOf(const LogMessage& other) const {
+                    return m_level == other.m_level && m_string == other.m_string;
+                }
+                
+                inline void repeat() {
+                    m_count++;
+                }
             };
             
-            typedef std::vector<LogMessage> LogMessageList;
+            typedef std::deque<LogMessage> LogMessageQueue;
 
-            LogMessageList m_buffer;
+            static const size_t MaxPendingMessages = 500;
+            static const long MaxConsoleLength = 1 << 20;
+            
+            LogMessageQueue m_pendingMessages;
+            size_t m_droppedMessageCount;
             
             wxTextCtrl* m_textCtrl;
+            LogFileSink* m_fileSink;
             
             void logToDebug(const LogMessage& message);
             void logToConsole(const LogMessage& message);
+            void logToConsole(const LogLevel level, const String& string);
             void logToFile(const LogMessage& message);
+            
+            // prevent copying
+            Console(const Console& other);
+            void operator= (const Console& other);
         public:
-            Console() : m_textCtrl(NULL) {}
+            Console();
+            ~Console();
             
             void setTextCtrl(wxTextCtrl* textCtrl);
+            void flush();
             
             void log(const LogMessage& message);
             
@@ -0,0 +1,183 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_IntersectionBatch_h
+#define TrenchBroom_IntersectionBatch_h
+
+#include "Utility/BBox.h"
+#include "Utility/Math.h"
+#include "Utility/Ray.h"
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#if defined __SSE__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 1)
+#define TrenchBroom_IntersectionBatch_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace TrenchBroom {
+    namespace VecMath {
+        /**
+         * Stores axis aligned boxes as a structure of arrays so that a ray can be intersected with all of them at once.
+         * Four boxes are tested per iteration if SSE is available.
+         */
+        class BBoxBatch {
+        private:
+            std::vector<float> m_min[3];
+            std::vector<float> m_max[3];
+
+            /*
+             Components of the ray direction that are almost zero are treated like Ray::intersectWithPlane does: the ray
+             is parallel to the slab, so it either misses the box or never leaves the slab. A huge finite reciprocal
+             gives exactly that result without producing infinities or NaNs.
+             */
+            static inline float reciprocal(const float d) {
+                static const float Huge = 1e30f;
+                if (Math<float>::zero(d))
+                    return d < 0.0f ? -Huge : Huge;
+                return 1.0f / d;
+            }
+
+            inline float intersectScalar(const size_t index, const Rayf& ray, const Vec3f& inverseDirection) const {
+                float tMin = -std::numeric_limits<float>::max();
+                float tMax = std::numeric_limits<float>::max();
+                for (size_t i = 0; i < 3; i++) {
+                    const float t0 = (m_min[i][index] - ray.origin[i]) * inverseDirection[i];
+                    const float t1 = (m_max[i][index] - ray.origin[i]) * inverseDirection[i];
+                    tMin = std::max(tMin, std::min(t0, t1));
+                    tMax = std::min(tMax, std::max(t0, t1));
+                }
+                if (tMax < tMin || tMax < 0.0f)
+                    return Math<float>::nan();
+                return tMin >= 0.0f ? tMin : tMax;
+            }
+        public:
+            inline size_t size() const {
+                return m_min[0].size();
+            }
+
+            inline bool empty() const {
+                return m_min[0].empty();
+            }
+
+            inline void clear() {
+                for (size_t i = 0; i < 3; i++) {
+                    m_min[i].clear();
+                    m_max[i].clear();
+                }
+            }
+
+            inline void reserve(const size_t capacity) {
+                for (size_t i = 0; i < 3; i++) {
+                    m_min[i].reserve(capacity);
+                    m_max[i].reserve(capacity);
+                }
+            }
+
+            inline void add(const BBoxf& bounds) {
+                for (size_t i = 0; i < 3; i++) {
+                    m_min[i].push_back(bounds.min[i]);
+                    m_max[i].push_back(bounds.max[i]);
+                }
+            }
+
+            inline void set(const size_t index, const BBoxf& bounds) {
+                assert(index < size());
+                for (size_t i = 0; i < 3; i++) {
+                    m_min[i][index] = bounds.min[i];
+                    m_max[i][index] = bounds.max[i];
+                }
+            }
+
+            /**
+             * Removes the box at the given index by moving the last box into its place.
+             */
+            inline void swapRemove(const size_t index) {
+                assert(index < size());
+                for (size_t i = 0; i < 3; i++) {
+                    m_min[i][index] = m_min[i].back();
+                    m_max[i][index] = m_max[i].back();
+                    m_min[i].pop_back();
+                    m_max[i].pop_back();
+                }
+            }
+
+            /**
+             * Writes the distance from the ray origin to the point where the ray enters each box into the given array,
+             * which must hold size() values. If the ray origin is inside a box, the distance to the point where the ray
+             * leaves it is written instead, and NaN is written for boxes that the ray misses. This is the same result
+             * that BBox::intersectWithRay returns, up to its tolerance at the box edges.
+             */
+            void intersectWithRay(const Rayf& ray, float* distances) const {
+                const Vec3f inverseDirection(reciprocal(ray.direction.x()),
+                                             reciprocal(ray.direction.y()),
+                                             reciprocal(ray.direction.z()));
+                const size_t count = size();
+                size_t index = 0;
+
+#if defined TrenchBroom_IntersectionBatch_SSE
+                const __m128 zero = _mm_setzero_ps();
+                const __m128 nan = _mm_set1_ps(Math<float>::nan());
+                __m128 origin[3];
+                __m128 inverse[3];
+                for (size_t i = 0; i < 3; i++) {
+                    origin[i] = _mm_set1_ps(ray.origin[i]);
+                    inverse[i] = _mm_set1_ps(inverseDirection[i]);
+                }
+
+                for (; index + 4 <= count; index += 4) {
+                    __m128 tMin = _mm_set1_ps(-std::numeric_limits<float>::max());
+                    __m128 tMax = _mm_set1_ps(std::numeric_limits<float>::max());
+                    for (size_t i = 0; i < 3; i++) {
+                        const __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_min[i][index]), origin[i]), inverse[i]);
+                        const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_max[i][index]), origin[i]), inverse[i]);
+                        tMin = _mm_max_ps(tMin, _mm_min_ps(t0, t1));
+                        tMax = _mm_min_ps(tMax, _mm_max_ps(t0, t1));
+                    }
+
+                    const __m128 hit = _mm_and_ps(_mm_cmpge_ps(tMax, tMin), _mm_cmpge_ps(tMax, zero));
+                    const __m128 entering = _mm_cmpge_ps(tMin, zero);
+                    const __m128 distance = _mm_or_ps(_mm_and_ps(entering, tMin), _mm_andnot_ps(entering, tMax));
+                    _mm_storeu_ps(distances + index, _mm_or_ps(_mm_and_ps(hit, distance), _mm_andnot_ps(hit, nan)));
+                }
+#endif
+
+                for (; index < count; index++)
+                    distances[index] = intersectScalar(index, ray, inverseDirection);
+            }
+
+            /**
+             * Same as intersectWithRay, but tests one box at a time even if SSE is available.
+             */
+            void intersectWithRayScalar(const Rayf& ray, float* distances) const {
+                const Vec3f inverseDirection(reciprocal(ray.direction.x()),
+                                             reciprocal(ray.direction.y()),
+                                             reciprocal(ray.direction.z()));
+                const size_t count = size();
+                for (size_t index = 0; index < count; index++)
+                    distances[index] = intersectScalar(index, ray, inverseDirection);
+            }
+        };
+    }
+}
+
+#endif
@@ -559,6 +559,45 @@ namespace TrenchBroom {
             return scalingMatrix(Vec<T,3>(f, f, f));
         }
 
+        /**
+         * Checks whether the given affine transformation maps every coordinate axis onto a coordinate axis, that is,
+         * whether it is a translation combined with 90 degree rotations and mirrorings. If so, the transformation is
+         * stored in result with its linear part rounded to exactly -1, 0 and 1.
+         */
+        template <typename T>
+        inline bool axisAlignedMatrix(const Mat<T,4,4>& mat, Mat<T,4,4>& result, const T epsilon = Math<T>::AlmostZero) {
+            result = mat;
+            for (size_t c = 0; c < 3; c++) {
+                if (!Math<T>::zero(mat[c][3], epsilon))
+                    return false;
+            }
+            if (!Math<T>::eq(mat[3][3], static_cast<T>(1.0), epsilon))
+                return false;
+            result[3][3] = static_cast<T>(1.0);
+
+            bool rowUsed[3] = { false, false, false };
+            for (size_t c = 0; c < 3; c++) {
+                size_t count = 0;
+                for (size_t r = 0; r < 3; r++) {
+                    const T value = mat[c][r];
+                    if (Math<T>::zero(value, epsilon)) {
+                        result[c][r] = static_cast<T>(0.0);
+                    } else if (Math<T>::eq(value, static_cast<T>(1.0), epsilon) || Math<T>::eq(value, static_cast<T>(-1.0), epsilon)) {
+                        if (rowUsed[r])
+                            return false;
+                        rowUsed[r] = true;
+                        result[c][r] = value > static_cast<T>(0.0) ? static_cast<T>(1.0) : static_cast<T>(-1.0);
+                        count++;
+                    } else {
+                        return false;
+                    }
+                }
+                if (count != 1)
+                    return false;
+            }
+            return true;
+        }
+
         template <typename T, size_t R, size_t C>
         const Mat<T,R,C> Mat<T,R,C>::Identity = Mat<T,R,C>().setIdentity();
 
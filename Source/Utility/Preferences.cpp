@@ -158,6 +158,7 @@ namespace TrenchBroom {
         const int               RendererInstancingModeAutodetect    = 0;
         const int               RendererInstancingModeForceOn       = 1;
         const int               RendererInstancingModeForceOff      = 2;
+        const Preference<bool>  UseMapCache = Preference<bool>(                                 "General/Use map cache",                                        false);
 
         const Preference<KeyboardShortcut>  CameraMoveForward = Preference<KeyboardShortcut>(   "Controls/Camera/Move Forward",     KeyboardShortcut(View::CommandIds::Menu::ViewMoveCameraForward, 'W', KeyboardShortcut::SCAny, "Move Camera Forward"));
         const Preference<KeyboardShortcut>  CameraMoveBackward = Preference<KeyboardShortcut>(  "Controls/Camera/Move Backward",    KeyboardShortcut(View::CommandIds::Menu::ViewMoveCameraForward, 'S', KeyboardShortcut::SCAny, "Move Camera Backward"));
@@ -306,6 +307,7 @@ namespace TrenchBroom {
             editMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::EditSelectSiblings, WXK_CONTROL, WXK_ALT, 'A', KeyboardShortcut::SCAny, "Select Siblings"));
             editMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::EditSelectTouching, WXK_CONTROL, 'T', KeyboardShortcut::SCAny, "Select Touching"));
             editMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::EditSelectByFilePosition, KeyboardShortcut::SCAny, "Select by Line Number"));
+            editMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::EditSelectFacesWithTexture, KeyboardShortcut::SCAny, "Select Faces with Current Texture"));
             editMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::EditSelectNone, WXK_CONTROL, WXK_SHIFT, 'A', KeyboardShortcut::SCAny, "Select None"));
             editMenu->addSeparator();
             editMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::EditHideSelected, WXK_CONTROL, 'H', KeyboardShortcut::SCAny, "Hide Selected"));
@@ -413,6 +415,7 @@ namespace TrenchBroom {
 
             editMenu->addSeparator();
             editMenu->addCheckItem(KeyboardShortcut(View::CommandIds::Menu::EditToggleTextureLock, KeyboardShortcut::SCAny, "Texture Lock"));
+            editMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::EditReplaceTexture, KeyboardShortcut::SCAny, "Replace Texture..."));
 #ifdef __linux__ // escape key is not allowed as a menu accelerator on GTK
             editMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::EditNavigateUp, KeyboardShortcut::SCAny, "Navigate Up"));
 #else
@@ -447,6 +450,9 @@ namespace TrenchBroom {
             viewMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::ViewSwitchToEntityTab, '1', KeyboardShortcut::SCAny, "Switch to Entity Inspector"));
             viewMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::ViewSwitchToFaceTab, '2', KeyboardShortcut::SCAny, "Switch to Face Inspector"));
             viewMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::ViewSwitchToViewTab, '3', KeyboardShortcut::SCAny, "Switch to View Inspector"));
+            viewMenu->addSeparator();
+            viewMenu->addCheckItem(KeyboardShortcut(View::CommandIds::Menu::ViewToggleShowProfiler, KeyboardShortcut::SCAny, "Show Profiler"));
+            viewMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::ViewSaveProfile, KeyboardShortcut::SCAny, "Save Profile..."));
             return menus;
         }
 
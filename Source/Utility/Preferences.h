@@ -363,6 +363,7 @@ namespace TrenchBroom {
         extern const int                RendererInstancingModeAutodetect;
         extern const int                RendererInstancingModeForceOn;
         extern const int                RendererInstancingModeForceOff;
+        extern const Preference<bool>   UseMapCache;
 
         extern const Preference<KeyboardShortcut>   CameraMoveForward;
         extern const Preference<KeyboardShortcut>   CameraMoveBackward;
@@ -0,0 +1,295 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_Profiler_h
+#define TrenchBroom_Profiler_h
+
+#include <cassert>
+#include <cstddef>
+#include <ctime>
+#include <ostream>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Utility {
+        /**
+         * Collects timings and counters per rendered frame. The subsystems add to the current frame through the shared
+         * instance, and the view that paints a frame closes it by calling endFrame, which moves it into a ring buffer
+         * holding the most recent frames. While the profiler is disabled, all of this reduces to testing a flag.
+         *
+         * Only one view is profiled at a time. The view that enables the profiler owns it, and the other views suspend
+         * it while they work so that their timings and counters don't end up in the owner's frames.
+         */
+        class Profiler {
+        public:
+            typedef enum {
+                FrameTime       = 0,
+                PickTime        = 1,
+                GeometryTime    = 2,
+                TimerCount      = 3
+            } Timer;
+
+            typedef enum {
+                DrawCalls           = 0,
+                TextureBinds        = 1,
+                ShaderChanges       = 2,
+                BufferUploads       = 3,
+                UploadedBytes       = 4,
+                OctreeNodesVisited  = 5,
+                RenderRequests      = 6,
+                CoalescedRenders    = 7,
+                DroppedRenders      = 8,
+                CounterCount        = 9
+            } Counter;
+
+            static const size_t HistorySize = 256;
+
+            class Frame {
+            public:
+                size_t number;
+                double times[TimerCount];
+                size_t counts[CounterCount];
+
+                Frame() {
+                    reset(0);
+                }
+
+                inline void reset(const size_t i_number) {
+                    number = i_number;
+                    for (size_t i = 0; i < TimerCount; i++)
+                        times[i] = 0.0;
+                    for (size_t i = 0; i < CounterCount; i++)
+                        counts[i] = 0;
+                }
+            };
+
+            /**
+             * Adds the CPU time spent in its scope to a timer of the current frame.
+             */
+            class ScopedTimer {
+            private:
+                Timer m_timer;
+                bool m_active;
+                clock_t m_start;
+            public:
+                ScopedTimer(const Timer timer) :
+                m_timer(timer),
+                m_active(Profiler::profiler().recording()),
+                m_start(m_active ? clock() : 0) {}
+
+                ~ScopedTimer() {
+                    if (m_active)
+                        Profiler::profiler().addTime(m_timer, clock() - m_start);
+                }
+            };
+
+            /**
+             * Suspends the profiler in its scope unless the given view owns it.
+             */
+            class Suspension {
+            private:
+                bool m_active;
+            public:
+                Suspension(const void* view) :
+                m_active(Profiler::profiler().enabled() && !Profiler::profiler().profiles(view)) {
+                    if (m_active)
+                        Profiler::profiler().suspend();
+                }
+
+                ~Suspension() {
+                    if (m_active)
+                        Profiler::profiler().resume();
+                }
+            };
+        private:
+            bool m_enabled;
+            const void* m_owner;
+            size_t m_suspensions;
+            Frame m_currentFrame;
+            clock_t m_frameStart;
+            std::vector<Frame> m_history;
+            size_t m_nextSlot;
+            size_t m_frameCount;
+        public:
+            Profiler() :
+            m_enabled(false),
+            m_owner(NULL),
+            m_suspensions(0),
+            m_frameStart(0),
+            m_nextSlot(0),
+            m_frameCount(0) {}
+
+            static inline Profiler& profiler() {
+                static Profiler profiler;
+                return profiler;
+            }
+
+            static inline const char* timerName(const Timer timer) {
+                static const char* names[] = { "frame_ms", "pick_ms", "geometry_ms" };
+                return names[timer];
+            }
+
+            static inline const char* counterName(const Counter counter) {
+                static const char* names[] = { "draw_calls", "texture_binds", "shader_changes", "buffer_uploads", "uploaded_bytes", "octree_nodes_visited", "render_requests", "coalesced_renders", "dropped_renders" };
+                return names[counter];
+            }
+
+            inline bool enabled() const {
+                return m_enabled;
+            }
+
+            inline bool profiles(const void* view) const {
+                return m_enabled && m_owner == view;
+            }
+
+            inline bool recording() const {
+                return m_enabled && m_suspensions == 0;
+            }
+
+            /**
+             * Enabling the profiler for a view discards the frames collected previously, even if they were collected
+             * for another view.
+             */
+            inline void setEnabled(const bool enabled, const void* view = NULL) {
+                if (!enabled)
+                    view = NULL;
+                if (enabled == m_enabled && view == m_owner)
+                    return;
+                m_enabled = enabled;
+                m_owner = view;
+                if (m_enabled)
+                    clear();
+            }
+
+            inline void suspend() {
+                m_suspensions++;
+            }
+
+            inline void resume() {
+                assert(m_suspensions > 0);
+                m_suspensions--;
+            }
+
+            inline void clear() {
+                m_history.clear();
+                m_nextSlot = 0;
+                m_frameCount = 0;
+                m_currentFrame.reset(0);
+                m_frameStart = clock();
+            }
+
+            inline void addTime(const Timer timer, const clock_t ticks) {
+                if (recording())
+                    m_currentFrame.times[timer] += 1000.0 * static_cast<double>(ticks) / CLOCKS_PER_SEC;
+            }
+
+            inline void count(const Counter counter, const size_t amount = 1) {
+                if (recording())
+                    m_currentFrame.counts[counter] += amount;
+            }
+
+            inline void beginFrame() {
+                if (m_enabled)
+                    m_frameStart = clock();
+            }
+
+            /**
+             * Closes the current frame and stores it in the history, replacing the oldest frame once the history is
+             * full. Everything counted between two frames is attributed to the next one.
+             */
+            inline void endFrame() {
+                if (!m_enabled)
+                    return;
+
+                addTime(FrameTime, clock() - m_frameStart);
+                m_currentFrame.number = m_frameCount++;
+                if (m_history.size() < HistorySize) {
+                    m_history.push_back(m_currentFrame);
+                } else {
+                    m_history[m_nextSlot] = m_currentFrame;
+                }
+                m_nextSlot = (m_nextSlot + 1) % HistorySize;
+                m_currentFrame.reset(m_frameCount);
+            }
+
+            inline size_t frameCount() const {
+                return m_history.size();
+            }
+
+            /**
+             * Returns the frame with the given index in the history, starting with the oldest one.
+             */
+            inline const Frame& frame(const size_t index) const {
+                if (m_history.size() < HistorySize)
+                    return m_history[index];
+                return m_history[(m_nextSlot + index) % HistorySize];
+            }
+
+            inline const Frame& lastFrame() const {
+                return frame(m_history.size() - 1);
+            }
+
+            Frame average() const {
+                Frame result;
+                if (m_history.empty())
+                    return result;
+
+                for (size_t i = 0; i < m_history.size(); i++) {
+                    for (size_t j = 0; j < TimerCount; j++)
+                        result.times[j] += m_history[i].times[j];
+                    for (size_t j = 0; j < CounterCount; j++)
+                        result.counts[j] += m_history[i].counts[j];
+                }
+
+                const size_t count = m_history.size();
+                for (size_t j = 0; j < TimerCount; j++)
+                    result.times[j] /= count;
+                for (size_t j = 0; j < CounterCount; j++)
+                    result.counts[j] /= count;
+                result.number = lastFrame().number;
+                return result;
+            }
+
+            /**
+             * Writes the frames in the history to the given stream as comma separated values, one line per frame and
+             * preceded by a header line.
+             */
+            void writeCSV(std::ostream& stream) const {
+                stream << "frame";
+                for (size_t i = 0; i < TimerCount; i++)
+                    stream << "," << timerName(static_cast<Timer>(i));
+                for (size_t i = 0; i < CounterCount; i++)
+                    stream << "," << counterName(static_cast<Counter>(i));
+                stream << std::endl;
+
+                for (size_t i = 0; i < frameCount(); i++) {
+                    const Frame& current = frame(i);
+                    stream << current.number;
+                    for (size_t j = 0; j < TimerCount; j++)
+                        stream << "," << current.times[j];
+                    for (size_t j = 0; j < CounterCount; j++)
+                        stream << "," << current.counts[j];
+                    stream << std::endl;
+                }
+            }
+        };
+    }
+}
+
+#endif
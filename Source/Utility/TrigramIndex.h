@@ -0,0 +1,151 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_TrigramIndex_h
+#define TrenchBroom_TrigramIndex_h
+
+#include "Utility/String.h"
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#if defined _WIN32
+#include <unordered_map>
+#else
+#include <tr1/unordered_map>
+#endif
+
+namespace TrenchBroom {
+    namespace Utility {
+        /**
+         * Finds the items whose names contain a given string, ignoring case. For every trigram (sequence of three
+         * characters) that occurs in the names, the index stores the sorted list of items whose names contain it. A
+         * query intersects the lists of the trigrams of the pattern, starting with the shortest one, and verifies only
+         * the remaining candidates. Patterns shorter than three characters are matched against all names.
+         *
+         * The index is built by adding items and cannot be updated otherwise; clear and rebuild it when the set of
+         * items changes.
+         */
+        template <typename T>
+        class TrigramIndex {
+        private:
+            typedef unsigned int Trigram;
+            typedef std::vector<size_t> PostingList;
+            typedef std::tr1::unordered_map<Trigram, PostingList> PostingMap;
+            typedef std::vector<const PostingList*> PostingListPtrList;
+            
+            class Entry {
+            public:
+                String name;
+                T item;
+                
+                Entry(const String& i_name, T i_item) :
+                name(i_name),
+                item(i_item) {}
+            };
+            
+            typedef std::vector<Entry> EntryList;
+            
+            struct CompareSize {
+                inline bool operator()(const PostingList* left, const PostingList* right) const {
+                    return left->size() < right->size();
+                }
+            };
+            
+            EntryList m_entries;
+            PostingMap m_postings;
+            
+            static inline Trigram trigram(const String& str, size_t index) {
+                return (static_cast<Trigram>(static_cast<unsigned char>(str[index])) << 16) |
+                       (static_cast<Trigram>(static_cast<unsigned char>(str[index + 1])) << 8) |
+                        static_cast<Trigram>(static_cast<unsigned char>(str[index + 2]));
+            }
+        public:
+            inline void add(const String& name, T item) {
+                const size_t index = m_entries.size();
+                m_entries.push_back(Entry(toLower(name), item));
+                
+                const String& key = m_entries.back().name;
+                for (size_t i = 0; i + 2 < key.size(); i++) {
+                    PostingList& postings = m_postings[trigram(key, i)];
+                    // a name may contain the same trigram more than once
+                    if (postings.empty() || postings.back() != index)
+                        postings.push_back(index);
+                }
+            }
+            
+            inline void clear() {
+                m_entries.clear();
+                m_postings.clear();
+            }
+            
+            inline bool empty() const {
+                return m_entries.empty();
+            }
+            
+            inline size_t size() const {
+                return m_entries.size();
+            }
+            
+            /**
+             * Appends the items whose names contain the given pattern to the given list, in the order in which they
+             * were added.
+             */
+            inline void find(const String& pattern, std::vector<T>& result) const {
+                const String key = toLower(pattern);
+                
+                if (key.size() < 3) {
+                    typename EntryList::const_iterator it, end;
+                    for (it = m_entries.begin(), end = m_entries.end(); it != end; ++it)
+                        if (it->name.find(key) != String::npos)
+                            result.push_back(it->item);
+                    return;
+                }
+                
+                PostingListPtrList postingLists;
+                for (size_t i = 0; i + 2 < key.size(); i++) {
+                    typename PostingMap::const_iterator it = m_postings.find(trigram(key, i));
+                    if (it == m_postings.end())
+                        return;
+                    postingLists.push_back(&it->second);
+                }
+                
+                std::sort(postingLists.begin(), postingLists.end(), CompareSize());
+                PostingList candidates(*postingLists.front());
+                for (size_t i = 1; i < postingLists.size() && !candidates.empty(); i++) {
+                    const PostingList& postings = *postingLists[i];
+                    PostingList intersection;
+                    std::set_intersection(candidates.begin(), candidates.end(), postings.begin(), postings.end(), std::back_inserter(intersection));
+                    candidates.swap(intersection);
+                }
+                
+                // the trigrams of a name may occur in a different arrangement than in the pattern
+                PostingList::const_iterator it, end;
+                for (it = candidates.begin(), end = candidates.end(); it != end; ++it) {
+                    const Entry& entry = m_entries[*it];
+                    if (key.size() == 3 || entry.name.find(key) != String::npos)
+                        result.push_back(entry.item);
+                }
+            }
+        };
+    }
+}
+
+#endif
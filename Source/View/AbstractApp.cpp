@@ -25,8 +25,8 @@
 #include <wx/generic/helpext.h>
 #include <wx/fs_mem.h>
 
+#include "IO/DiskGameFileSystem.h"
 #include "IO/FileManager.h"
-#include "IO/Pak.h"
 #include "Model/Alias.h"
 #include "Model/Bsp.h"
 #include "Model/MapDocument.h"
@@ -212,7 +212,7 @@ bool AbstractApp::OnInit() {
     m_preferencesFrame = NULL;
 
     // initialize globals
-    TrenchBroom::IO::PakManager::sharedManager = new TrenchBroom::IO::PakManager();
+    TrenchBroom::IO::GameFileSystem::sharedFileSystem = new TrenchBroom::IO::DiskGameFileSystem();
     TrenchBroom::Model::AliasManager::sharedManager = new TrenchBroom::Model::AliasManager();
     TrenchBroom::Model::BspManager::sharedManager = new TrenchBroom::Model::BspManager();
 
@@ -256,8 +256,8 @@ int AbstractApp::OnExit() {
     wxDELETE(m_docManager);
     wxDELETE(m_helpController);
 
-    delete TrenchBroom::IO::PakManager::sharedManager;
-    TrenchBroom::IO::PakManager::sharedManager = NULL;
+    delete TrenchBroom::IO::GameFileSystem::sharedFileSystem;
+    TrenchBroom::IO::GameFileSystem::sharedFileSystem = NULL;
     delete TrenchBroom::Model::AliasManager::sharedManager;
     TrenchBroom::Model::AliasManager::sharedManager = NULL;
     delete TrenchBroom::Model::BspManager::sharedManager;
@@ -88,7 +88,7 @@ namespace TrenchBroom {
             }
 
             inline bool intersectsY(float y, float height) const {
-                return bottom() >= y || top() <= y + height;
+                return bottom() >= y && top() <= y + height;
             }
         };
 
@@ -298,6 +298,12 @@ namespace TrenchBroom {
 
             RowList m_rows;
             float m_maxWidth;
+            
+            struct RowBottomLess {
+                inline bool operator()(float y, const Row& row) const {
+                    return y < row.bounds().bottom();
+                }
+            };
         public:
             inline const Row& operator[] (const size_t index) const {
                 assert(index >= 0 && index < m_rows.size());
@@ -352,15 +358,13 @@ namespace TrenchBroom {
                 }
             }
 
+            /**
+             * Returns the index of the first row whose bottom is below the given y coordinate, or the number of rows
+             * if there is no such row. The rows are ordered by their position, so this is a binary search.
+             */
             size_t indexOfRowAt(float y) const {
-                for (size_t i = 0; i < m_rows.size(); i++) {
-                    const Row& row = m_rows[i];
-                    const LayoutBounds& rowBounds = row.bounds();
-                    if (y < rowBounds.bottom())
-                        return i;
-                }
-                
-                return m_rows.size();
+                typename RowList::const_iterator it = std::upper_bound(m_rows.begin(), m_rows.end(), y, RowBottomLess());
+                return static_cast<size_t>(it - m_rows.begin());
             }
             
             bool rowAt(float y, const Row** result) const {
@@ -373,12 +377,10 @@ namespace TrenchBroom {
             }
             
             bool cellAt(float x, float y, const typename Row::Cell** result) const {
-                for (unsigned int i = 0; i < m_rows.size(); i++) {
+                for (size_t i = indexOfRowAt(y); i < m_rows.size(); i++) {
                     const Row& row = m_rows[i];
                     const LayoutBounds& rowBounds = row.bounds();
-                    if (y > rowBounds.bottom())
-                        continue;
-                    else if (y < rowBounds.top())
+                    if (y < rowBounds.top())
                         break;
                     if (row.cellAt(x, y, result))
                         return true;
@@ -430,7 +432,15 @@ namespace TrenchBroom {
         public:
             typedef LayoutGroup<CellType, GroupType> Group;
             typedef std::vector<Group> GroupList;
+            typedef std::vector<const Group*> GroupPtrList;
+            typedef std::vector<const typename Group::Row::Cell*> CellPtrList;
         private:
+            struct GroupBottomLess {
+                inline bool operator()(const Group& group, float y) const {
+                    return group.bounds().bottom() < y;
+                }
+            };
+
             float m_width;
             float m_cellMargin;
             float m_rowMargin;
@@ -563,16 +573,40 @@ namespace TrenchBroom {
                 invalidate();
             }
 
-            bool cellAt(float x, float y, const typename Group::Row::Cell** result) {
+            /**
+             * Returns the index of the first group whose bottom is not above the given y coordinate, or the number of
+             * groups if there is no such group.
+             */
+            size_t indexOfGroupAt(float y) {
                 if (!m_valid)
                     validate();
-
-                for (unsigned int i = 0; i < m_groups.size(); i++) {
+                
+                typename GroupList::const_iterator it = std::lower_bound(m_groups.begin(), m_groups.end(), y, GroupBottomLess());
+                return static_cast<size_t>(it - m_groups.begin());
+            }
+            
+            /**
+             * Collects the groups and the cells that intersect the given vertical range. Only the rows within the range
+             * are visited, so the cost depends on the number of visible cells and not on the size of the layout.
+             */
+            void visibleItems(float y, float height, GroupPtrList& groups, CellPtrList& cells) {
+                for (size_t i = indexOfGroupAt(y); i < m_groups.size() && m_groups[i].bounds().top() <= y + height; i++) {
+                    const Group& group = m_groups[i];
+                    groups.push_back(&group);
+                    
+                    for (size_t j = group.indexOfRowAt(y); j < group.size() && group[j].bounds().top() <= y + height; j++) {
+                        const typename Group::Row& row = group[j];
+                        for (size_t k = 0; k < row.size(); k++)
+                            cells.push_back(&row[k]);
+                    }
+                }
+            }
+            
+            bool cellAt(float x, float y, const typename Group::Row::Cell** result) {
+                for (size_t i = indexOfGroupAt(y); i < m_groups.size(); i++) {
                     const Group& group = m_groups[i];
                     const LayoutBounds groupBounds = group.bounds();
-                    if (y > groupBounds.bottom())
-                        continue;
-                    else if (y < groupBounds.top())
+                    if (y < groupBounds.top())
                         break;
                     if (group.cellAt(x, y, result))
                         return true;
@@ -724,7 +758,7 @@ namespace TrenchBroom {
             }
             
             inline float outerMargin() const {
-                return m_outerMargin();
+                return m_outerMargin;
             }
             
             inline float groupMargin() const {
@@ -736,7 +770,7 @@ namespace TrenchBroom {
             }
             
             inline float cellMargin() const {
-                return m_cellMargin();
+                return m_cellMargin;
             }
         };
     }
@@ -0,0 +1,151 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ClipboardCache.h"
+
+#include "Model/Brush.h"
+#include "Model/BrushGeometry.h"
+#include "Model/Entity.h"
+#include "Model/Face.h"
+#include "Utility/List.h"
+
+#include <cassert>
+#include <map>
+
+namespace TrenchBroom {
+    namespace View {
+        bool ClipboardCache::sameText(const String& text1, const String& text2) {
+            // the system clipboard may have converted the line endings
+            size_t i = 0;
+            size_t j = 0;
+            while (true) {
+                while (i < text1.size() && text1[i] == '\r')
+                    i++;
+                while (j < text2.size() && text2[j] == '\r')
+                    j++;
+                if (i == text1.size() || j == text2.size())
+                    return i == text1.size() && j == text2.size();
+                if (text1[i++] != text2[j++])
+                    return false;
+            }
+        }
+
+        Model::Brush* ClipboardCache::copyBrush(const Model::Brush& original, const BBoxf& worldBounds, bool forceIntegerFacePoints) {
+            const Model::FaceList& originalFaces = original.faces();
+            Model::FaceList faces;
+            faces.reserve(originalFaces.size());
+
+            Model::FaceList::const_iterator faceIt, faceEnd;
+            for (faceIt = originalFaces.begin(), faceEnd = originalFaces.end(); faceIt != faceEnd; ++faceIt) {
+                Model::Face* face = new Model::Face(worldBounds, forceIntegerFacePoints, **faceIt);
+                // textures are resolved by name when the objects are added to a map
+                face->setTexture(NULL);
+                face->setSelected(false);
+                faces.push_back(face);
+            }
+
+            // the copied sides still refer to the original faces
+            Model::BrushGeometry* geometry = new Model::BrushGeometry(original.geometry());
+            Model::SideList::const_iterator sideIt, sideEnd;
+            for (sideIt = geometry->sides.begin(), sideEnd = geometry->sides.end(); sideIt != sideEnd; ++sideIt) {
+                Model::Side* side = *sideIt;
+                if (side->face != NULL) {
+                    const size_t index = Model::findElement(originalFaces, side->face);
+                    assert(index < faces.size());
+                    side->face = faces[index];
+                    side->face->setSide(side);
+                }
+            }
+
+            return new Model::Brush(worldBounds, forceIntegerFacePoints, faces, geometry);
+        }
+
+        Model::Entity* ClipboardCache::copyEntity(const Model::Entity& original, const Model::BrushList& brushes, const BBoxf& worldBounds, bool forceIntegerFacePoints) {
+            Model::Entity* entity = new Model::Entity(worldBounds, original);
+            Model::BrushList::const_iterator it, end;
+            for (it = brushes.begin(), end = brushes.end(); it != end; ++it)
+                entity->addBrush(*copyBrush(**it, worldBounds, forceIntegerFacePoints));
+            return entity;
+        }
+
+        ClipboardCache::ClipboardCache() :
+        m_forceIntegerFacePoints(false) {}
+
+        ClipboardCache::~ClipboardCache() {
+            clear();
+        }
+
+        void ClipboardCache::clear() {
+            m_text.clear();
+            Utility::deleteAll(m_entities);
+        }
+
+        void ClipboardCache::setObjects(const String& text, const BBoxf& worldBounds, bool forceIntegerFacePoints, const Model::EntityList& pointEntities, const Model::BrushList& brushes) {
+            clear();
+            m_text = text;
+            m_worldBounds = worldBounds;
+            m_forceIntegerFacePoints = forceIntegerFacePoints;
+
+            // group the brushes by their containing entities like the map writer does
+            typedef std::map<Model::Entity*, Model::BrushList> EntityBrushMap;
+            EntityBrushMap entityToBrushes;
+            Model::Entity* worldspawn = NULL;
+
+            Model::BrushList::const_iterator brushIt, brushEnd;
+            for (brushIt = brushes.begin(), brushEnd = brushes.end(); brushIt != brushEnd; ++brushIt) {
+                Model::Brush* brush = *brushIt;
+                Model::Entity* entity = brush->entity();
+                entityToBrushes[entity].push_back(brush);
+                if (entity->worldspawn())
+                    worldspawn = entity;
+            }
+
+            if (worldspawn != NULL)
+                m_entities.push_back(copyEntity(*worldspawn, entityToBrushes[worldspawn], m_worldBounds, m_forceIntegerFacePoints));
+
+            Model::EntityList::const_iterator entityIt, entityEnd;
+            for (entityIt = pointEntities.begin(), entityEnd = pointEntities.end(); entityIt != entityEnd; ++entityIt) {
+                const Model::Entity& entity = **entityIt;
+                m_entities.push_back(copyEntity(entity, entity.brushes(), m_worldBounds, m_forceIntegerFacePoints));
+            }
+
+            EntityBrushMap::const_iterator it, end;
+            for (it = entityToBrushes.begin(), end = entityToBrushes.end(); it != end; ++it) {
+                if (it->first != worldspawn)
+                    m_entities.push_back(copyEntity(*it->first, it->second, m_worldBounds, m_forceIntegerFacePoints));
+            }
+        }
+
+        bool ClipboardCache::getObjects(const String& text, const BBoxf& worldBounds, bool forceIntegerFacePoints, Model::EntityList& entities) const {
+            if (m_entities.empty() ||
+                !(worldBounds == m_worldBounds) ||
+                forceIntegerFacePoints != m_forceIntegerFacePoints ||
+                !sameText(text, m_text))
+                return false;
+
+            entities.reserve(entities.size() + m_entities.size());
+            Model::EntityList::const_iterator it, end;
+            for (it = m_entities.begin(), end = m_entities.end(); it != end; ++it) {
+                const Model::Entity& entity = **it;
+                entities.push_back(copyEntity(entity, entity.brushes(), worldBounds, forceIntegerFacePoints));
+            }
+            return true;
+        }
+    }
+}
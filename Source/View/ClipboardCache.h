@@ -0,0 +1,76 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__ClipboardCache__
+#define __TrenchBroom__ClipboardCache__
+
+#include "Model/BrushTypes.h"
+#include "Model/EntityTypes.h"
+#include "Utility/String.h"
+#include "Utility/VecMath.h"
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace View {
+        /**
+         * Keeps copies of the objects that were last put on the clipboard by this process, together with the text
+         * they were written as. As long as the clipboard still holds exactly that text, pasting can use copies of the
+         * cached objects instead of parsing the text and rebuilding the brush geometry. The cached objects are
+         * structured like the entities the map parser would return for the text.
+         */
+        class ClipboardCache {
+        private:
+            String m_text;
+            BBoxf m_worldBounds;
+            bool m_forceIntegerFacePoints;
+            Model::EntityList m_entities;
+
+            static bool sameText(const String& text1, const String& text2);
+            static Model::Brush* copyBrush(const Model::Brush& original, const BBoxf& worldBounds, bool forceIntegerFacePoints);
+            static Model::Entity* copyEntity(const Model::Entity& original, const Model::BrushList& brushes, const BBoxf& worldBounds, bool forceIntegerFacePoints);
+
+            ClipboardCache();
+        public:
+            static inline ClipboardCache& sharedCache() {
+                static ClipboardCache cache;
+                return cache;
+            }
+
+            ~ClipboardCache();
+
+            void clear();
+
+            /**
+             * Caches copies of the given objects, which were written to the clipboard as the given text by
+             * IO::MapWriter::writeObjectsToStream.
+             */
+            void setObjects(const String& text, const BBoxf& worldBounds, bool forceIntegerFacePoints, const Model::EntityList& pointEntities, const Model::BrushList& brushes);
+
+            /**
+             * Returns new copies of the cached objects in the given list if the clipboard text matches the cached text
+             * and the objects are pasted into a map with the same settings as the map they were copied from. The
+             * caller takes ownership of the returned entities.
+             */
+            bool getObjects(const String& text, const BBoxf& worldBounds, bool forceIntegerFacePoints, Model::EntityList& entities) const;
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__ClipboardCache__) */
@@ -126,6 +126,10 @@ namespace TrenchBroom {
                 static const int EditFaceActions                    = Lowest + 100;
                 static const int EditPrintFilePositions             = Lowest + 101;
                 static const int EditToggleAxisRestriction          = Lowest + 102;
+                static const int EditSelectFacesWithTexture         = Lowest + 103;
+                static const int EditReplaceTexture                 = Lowest + 104;
+                static const int ViewToggleShowProfiler             = Lowest + 105;
+                static const int ViewSaveProfile                    = Lowest + 106;
                 static const int Highest                            = Lowest + 199;
             }
             
@@ -175,6 +179,7 @@ namespace TrenchBroom {
                 static const int EnableAltMoveCheckBoxId            = Lowest +  13;
                 static const int MoveCameraInCursorDirCheckBoxId    = Lowest +  14;
                 static const int TextureBrowserIconSideChoiceId     = Lowest +  15;
+                static const int UseMapCacheCheckBoxId              = Lowest +  16;
                 static const int Highest                            = Lowest +  99;
             }
 
@@ -60,8 +60,10 @@
 #include "Utility/Grid.h"
 #include "Utility/List.h"
 #include "Utility/Preferences.h"
+#include "Utility/Profiler.h"
 #include "View/AbstractApp.h"
 #include "View/CameraAnimation.h"
+#include "View/ClipboardCache.h"
 #include "View/CommandIds.h"
 #include "View/EditorFrame.h"
 #include "View/EntityInspector.h"
@@ -74,8 +76,11 @@
 
 #include <wx/clipbrd.h>
 #include <wx/dataobj.h>
+#include <wx/filedlg.h>
 #include <wx/tokenzr.h>
 
+#include <fstream>
+
 namespace TrenchBroom {
     namespace View {
         BEGIN_EVENT_TABLE(EditorView, wxView)
@@ -105,6 +110,8 @@ namespace TrenchBroom {
         EVT_MENU(CommandIds::Menu::EditSelectSiblings, EditorView::OnEditSelectSiblings)
         EVT_MENU(CommandIds::Menu::EditSelectTouching, EditorView::OnEditSelectTouching)
         EVT_MENU(CommandIds::Menu::EditSelectByFilePosition, EditorView::OnEditSelectByFilePosition)
+        EVT_MENU(CommandIds::Menu::EditSelectFacesWithTexture, EditorView::OnEditSelectFacesWithTexture)
+        EVT_MENU(CommandIds::Menu::EditReplaceTexture, EditorView::OnEditReplaceTexture)
         EVT_MENU(CommandIds::Menu::EditSelectNone, EditorView::OnEditSelectNone)
 
         EVT_MENU(CommandIds::Menu::EditHideSelected, EditorView::OnEditHideSelected)
@@ -194,6 +201,8 @@ namespace TrenchBroom {
         EVT_MENU(CommandIds::Menu::ViewSwitchToEntityTab, EditorView::OnViewSwitchToEntityInspector)
         EVT_MENU(CommandIds::Menu::ViewSwitchToFaceTab, EditorView::OnViewSwitchToFaceInspector)
         EVT_MENU(CommandIds::Menu::ViewSwitchToViewTab, EditorView::OnViewSwitchToViewInspector)
+        EVT_MENU(CommandIds::Menu::ViewToggleShowProfiler, EditorView::OnViewToggleShowProfiler)
+        EVT_MENU(CommandIds::Menu::ViewSaveProfile, EditorView::OnViewSaveProfile)
 
         EVT_UPDATE_UI(wxID_SAVE, EditorView::OnUpdateMenuItem)
         EVT_UPDATE_UI(wxID_UNDO, EditorView::OnUpdateMenuItem)
@@ -692,7 +701,7 @@ namespace TrenchBroom {
             }
 
             EditorFrame* frame = static_cast<EditorFrame*>(GetFrame());
-            frame->mapCanvas().Refresh();
+            frame->mapCanvas().requestRender();
         }
 
         void EditorView::OnChangeFilename() {
@@ -841,9 +850,12 @@ namespace TrenchBroom {
                     if (editStateManager.selectionMode() == Model::EditStateManager::SMFaces) {
                         mapWriter.writeFacesToStream(editStateManager.selectedFaces(), clipboardData);
                         wxTheClipboard->SetData(new wxTextDataObject(clipboardData.str()));
+                        ClipboardCache::sharedCache().clear();
                     } else {
                         mapWriter.writeObjectsToStream(editStateManager.selectedEntities(), editStateManager.selectedBrushes(), clipboardData);
                         wxTheClipboard->SetData(new wxTextDataObject(clipboardData.str()));
+                        ClipboardCache::sharedCache().setObjects(clipboardData.str(), mapDocument().map().worldBounds(), mapDocument().map().forceIntegerFacePoints(),
+                                                                 editStateManager.selectedEntities(), editStateManager.selectedBrushes());
                     }
 
                     wxTheClipboard->Close();
@@ -867,8 +879,11 @@ namespace TrenchBroom {
                         if (wxTheClipboard->GetData(textData))
                             text = textData.GetText();
 
+                        // objects copied by this process can be pasted without parsing them again
+                        const bool cached = ClipboardCache::sharedCache().getObjects(text, mapDocument().map().worldBounds(), mapDocument().map().forceIntegerFacePoints(), entities);
+
                         IO::MapParser mapParser(text, console());
-                        if (mapParser.parseFaces(mapDocument().map().worldBounds(), mapDocument().map().forceIntegerFacePoints(), faces)) {
+                        if (!cached && mapParser.parseFaces(mapDocument().map().worldBounds(), mapDocument().map().forceIntegerFacePoints(), faces)) {
                             assert(!faces.empty());
 
                             Model::Face& face = *faces.back();
@@ -889,7 +904,8 @@ namespace TrenchBroom {
                             } else {
                                 mapDocument().console().warn("Could not paste faces because no faces are selected");
                             }
-                        } else if (mapParser.parseEntities(mapDocument().map().worldBounds(), mapDocument().map().forceIntegerFacePoints(), entities) ||
+                        } else if (cached ||
+                                   mapParser.parseEntities(mapDocument().map().worldBounds(), mapDocument().map().forceIntegerFacePoints(), entities) ||
                                    mapParser.parseBrushes(mapDocument().map().worldBounds(), mapDocument().map().forceIntegerFacePoints(), brushes)) {
                             assert(entities.empty() != brushes.empty());
 
@@ -943,7 +959,8 @@ namespace TrenchBroom {
                             text = textData.GetText();
 
                         IO::MapParser mapParser(text, console());
-                        if (mapParser.parseEntities(mapDocument().map().worldBounds(), mapDocument().map().forceIntegerFacePoints(), entities) ||
+                        if (ClipboardCache::sharedCache().getObjects(text, mapDocument().map().worldBounds(), mapDocument().map().forceIntegerFacePoints(), entities) ||
+                            mapParser.parseEntities(mapDocument().map().worldBounds(), mapDocument().map().forceIntegerFacePoints(), entities) ||
                             mapParser.parseBrushes(mapDocument().map().worldBounds(), mapDocument().map().forceIntegerFacePoints(), brushes)) {
                             assert(entities.empty() != brushes.empty());
 
@@ -1111,6 +1128,48 @@ namespace TrenchBroom {
             }
         }
 
+        void EditorView::OnEditSelectFacesWithTexture(wxCommandEvent& event) {
+            Model::Texture* texture = mapDocument().mruTexture();
+            assert(texture != NULL);
+
+            const Model::FaceList faces = mapDocument().map().facesWithTexture(texture->name());
+            Model::FaceList selectFaces;
+
+            Model::FaceList::const_iterator faceIt, faceEnd;
+            for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt) {
+                Model::Face* face = *faceIt;
+                if (face->texture() == texture && m_filter->brushSelectable(*face->brush()))
+                    selectFaces.push_back(face);
+            }
+
+            if (!selectFaces.empty()) {
+                wxCommand* command = Controller::ChangeEditStateCommand::replace(mapDocument(), selectFaces);
+                submit(command);
+            }
+        }
+
+        void EditorView::OnEditReplaceTexture(wxCommandEvent& event) {
+            Model::Texture* texture = mapDocument().mruTexture();
+            assert(texture != NULL);
+
+            wxString message;
+            message << "Enter the name of the texture to replace with " << texture->name() << ".";
+            wxString textureName = wxGetTextFromUser(message, wxT("Replace Texture"), wxT(""), GetFrame());
+            textureName.Trim(true).Trim(false);
+            if (textureName.empty())
+                return;
+
+            const Model::FaceList faces = mapDocument().map().facesWithTexture(textureName.ToStdString());
+            if (faces.empty()) {
+                mapDocument().console().info("No faces use texture %s", textureName.ToStdString().c_str());
+                return;
+            }
+
+            Controller::SetFaceAttributesCommand* command = new Controller::SetFaceAttributesCommand(mapDocument(), faces, wxT("Replace Texture"));
+            command->setTexture(texture);
+            submit(command);
+        }
+
         void EditorView::OnEditSelectNone(wxCommandEvent& event) {
             wxCommand* command = Controller::ChangeEditStateCommand::deselectAll(mapDocument());
             submit(command);
@@ -1717,6 +1776,31 @@ namespace TrenchBroom {
             inspector().switchToInspector(2);
         }
 
+        void EditorView::OnViewToggleShowProfiler(wxCommandEvent& event) {
+            Utility::Profiler& profiler = Utility::Profiler::profiler();
+            profiler.setEnabled(!profiler.profiles(this), this);
+            mapDocument().UpdateAllViews();
+        }
+
+        void EditorView::OnViewSaveProfile(wxCommandEvent& event) {
+            const Utility::Profiler& profiler = Utility::Profiler::profiler();
+            assert(profiler.frameCount() > 0);
+
+            wxFileDialog saveDialog(NULL, wxT("Save profile"), wxT(""), wxT("profile.csv"), wxT("CSV files (*.csv)|*.csv"), wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+            if (saveDialog.ShowModal() != wxID_OK)
+                return;
+
+            const String path = saveDialog.GetPath().ToStdString();
+            std::fstream stream(path.c_str(), std::ios::out | std::ios::trunc);
+            if (!stream.is_open()) {
+                console().error("Unable to write profile to %s", path.c_str());
+                return;
+            }
+
+            profiler.writeCSV(stream);
+            console().info("Saved %lu profiled frames to %s", static_cast<unsigned long>(profiler.frameCount()), path.c_str());
+        }
+
         void EditorView::OnUpdateMenuItem(wxUpdateUIEvent& event) {
             AbstractApp* app = static_cast<AbstractApp*>(wxTheApp);
             if (app->preferencesFrame() != NULL) {
@@ -1763,6 +1847,10 @@ namespace TrenchBroom {
                 case CommandIds::Menu::EditSelectNone:
                     event.Enable(editStateManager.selectionMode() != Model::EditStateManager::SMNone);
                     break;
+                case CommandIds::Menu::EditSelectFacesWithTexture:
+                case CommandIds::Menu::EditReplaceTexture:
+                    event.Enable(mapDocument().mruTexture() != NULL);
+                    break;
                 case wxID_COPY:
                     if (textCtrl != NULL)
                         event.Enable(textCtrl->CanCopy());
@@ -1976,6 +2064,13 @@ namespace TrenchBroom {
                 case CommandIds::Menu::ViewSwitchToViewTab:
                     event.Enable(true);
                     break;
+                case CommandIds::Menu::ViewToggleShowProfiler:
+                    event.Enable(true);
+                    event.Check(Utility::Profiler::profiler().profiles(this));
+                    break;
+                case CommandIds::Menu::ViewSaveProfile:
+                    event.Enable(Utility::Profiler::profiler().profiles(this) && Utility::Profiler::profiler().frameCount() > 0);
+                    break;
             }
         }
 
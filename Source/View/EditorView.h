@@ -141,6 +141,8 @@ namespace TrenchBroom {
             void OnEditSelectSiblings(wxCommandEvent& event);
             void OnEditSelectTouching(wxCommandEvent& event);
             void OnEditSelectByFilePosition(wxCommandEvent& event);
+            void OnEditSelectFacesWithTexture(wxCommandEvent& event);
+            void OnEditReplaceTexture(wxCommandEvent& event);
             void OnEditSelectNone(wxCommandEvent& event);
             
             void OnEditHideSelected(wxCommandEvent& event);
@@ -230,6 +232,8 @@ namespace TrenchBroom {
             void OnViewSwitchToEntityInspector(wxCommandEvent& event);
             void OnViewSwitchToFaceInspector(wxCommandEvent& event);
             void OnViewSwitchToViewInspector(wxCommandEvent& event);
+            void OnViewToggleShowProfiler(wxCommandEvent& event);
+            void OnViewSaveProfile(wxCommandEvent& event);
             
             void OnUpdateMenuItem(wxUpdateUIEvent& event);
             
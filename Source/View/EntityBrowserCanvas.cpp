@@ -36,12 +36,13 @@
 #include "View/DocumentViewHolder.h"
 #include "View/EditorView.h"
 
+#include <algorithm>
 #include <map>
 
 namespace TrenchBroom {
     namespace View {
         void EntityBrowserCanvas::addEntityToLayout(Layout& layout, Model::PointEntityDefinition* definition, const Renderer::Text::FontDescriptor& font) {
-            if ((!m_hideUnused || definition->usageCount() > 0) && (m_filterText.empty() || Utility::containsString(definition->name(), m_filterText, false))) {
+            if ((!m_hideUnused || definition->usageCount() > 0) && (m_filterText.empty() || std::binary_search(m_filterMatches.begin(), m_filterMatches.end(), definition))) {
                 Renderer::Text::FontManager& fontManager =  m_documentViewHolder.document().sharedResources().fontManager();
                 const float maxCellWidth = layout.maxCellWidth();
                 const Renderer::Text::FontDescriptor actualFont = fontManager.selectFontSize(font, definition->name(), maxCellWidth, 5);
@@ -125,6 +126,12 @@ namespace TrenchBroom {
             Renderer::Text::FontDescriptor font(fontName, static_cast<unsigned int>(fontSize));
             IO::FileManager fileManager;
 
+            m_filterMatches.clear();
+            if (!m_filterText.empty()) {
+                definitionManager.findDefinitions(m_filterText, m_filterMatches);
+                std::sort(m_filterMatches.begin(), m_filterMatches.end());
+            }
+
             if (m_group) {
                 Model::EntityDefinitionManager::EntityDefinitionGroups groups = definitionManager.groups(Model::EntityDefinition::PointEntity, m_sortOrder);
                 Model::EntityDefinitionManager::EntityDefinitionGroups::const_iterator groupIt, groupEnd;
@@ -45,7 +45,7 @@ namespace TrenchBroom {
                 m_renderer.setOverrideSelectionColors(false);
             }
             
-            m_canvas.Refresh();
+            m_canvas.requestRender();
         }
         
         FlashSelectionAnimation::FlashSelectionAnimation(Renderer::MapRenderer& renderer, View::MapGLCanvas& canvas, wxLongLong duration) :
@@ -43,6 +43,7 @@ namespace TrenchBroom {
 
         BEGIN_EVENT_TABLE(GeneralPreferencePane, wxPanel)
         EVT_BUTTON(CommandIds::GeneralPreferencePane::ChooseQuakePathButtonId, GeneralPreferencePane::OnChooseQuakePathClicked)
+        EVT_CHECKBOX(CommandIds::GeneralPreferencePane::UseMapCacheCheckBoxId, GeneralPreferencePane::OnUseMapCacheChanged)
 
         EVT_COMMAND_SCROLL(CommandIds::GeneralPreferencePane::BrightnessSliderId, GeneralPreferencePane::OnViewSliderChanged)
         EVT_COMMAND_SCROLL(CommandIds::GeneralPreferencePane::GridAlphaSliderId, GeneralPreferencePane::OnViewSliderChanged)
@@ -68,6 +69,7 @@ namespace TrenchBroom {
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
 
             m_quakePathValueLabel->SetLabel(prefs.getString(Preferences::QuakePath));
+            m_useMapCacheCheckBox->SetValue(prefs.getBool(Preferences::UseMapCache));
 
             m_brightnessSlider->SetValue(static_cast<int>(prefs.getFloat(Preferences::RendererBrightness) * 40.0f));
             m_gridAlphaSlider->SetValue(static_cast<int>(prefs.getFloat(Preferences::GridAlpha) * m_gridAlphaSlider->GetMax()));
@@ -116,12 +118,18 @@ namespace TrenchBroom {
             wxStaticText* quakePathLabel = new wxStaticText(quakeBox, wxID_ANY, wxT("Quake Path"));
             m_quakePathValueLabel = new wxStaticText(quakeBox, wxID_ANY, wxT("Not Set"));
             wxButton* chooseQuakePathButton = new wxButton(quakeBox, CommandIds::GeneralPreferencePane::ChooseQuakePathButtonId, wxT("Choose..."));
+            
+            wxStaticText* useMapCacheFakeLabel = new wxStaticText(quakeBox, wxID_ANY, wxT(""));
+            m_useMapCacheCheckBox = new wxCheckBox(quakeBox, CommandIds::GeneralPreferencePane::UseMapCacheCheckBoxId, wxT("Keep a cache file next to each map to load it faster"));
 
             wxFlexGridSizer* innerSizer = new wxFlexGridSizer(3, LayoutConstants::ControlHorizontalMargin, LayoutConstants::ControlVerticalMargin);
             innerSizer->AddGrowableCol(1);
             innerSizer->Add(quakePathLabel, 0, wxALIGN_CENTER_VERTICAL);
             innerSizer->Add(m_quakePathValueLabel, 0, wxALIGN_CENTER_VERTICAL);
             innerSizer->Add(chooseQuakePathButton, 0, wxALIGN_CENTER_VERTICAL);
+            innerSizer->Add(useMapCacheFakeLabel);
+            innerSizer->Add(m_useMapCacheCheckBox, 0, wxALIGN_CENTER_VERTICAL);
+            innerSizer->AddSpacer(0);
             innerSizer->SetItemMinSize(quakePathLabel, GeneralPreferencePaneLayout::MinimumLabelWidth, wxDefaultSize.y);
 
             wxSizer* outerSizer = new wxBoxSizer(wxVERTICAL);
@@ -291,6 +299,16 @@ namespace TrenchBroom {
             }
         }
 
+        void GeneralPreferencePane::OnUseMapCacheChanged(wxCommandEvent& event) {
+            bool value = event.GetInt() != 0;
+
+            Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
+            prefs.setBool(Preferences::UseMapCache, value);
+
+            Controller::PreferenceChangeEvent preferenceChangeEvent(Preferences::UseMapCache);
+            static_cast<TrenchBroomApp*>(wxTheApp)->UpdateAllViews(NULL, &preferenceChangeEvent);
+        }
+
         void GeneralPreferencePane::OnViewSliderChanged(wxScrollEvent& event) {
             wxSlider* sender = static_cast<wxSlider*>(event.GetEventObject());
             int value = sender->GetValue();
@@ -36,6 +36,7 @@ namespace TrenchBroom {
         class GeneralPreferencePane : public PreferencePane {
         private:
             wxStaticText* m_quakePathValueLabel;
+            wxCheckBox* m_useMapCacheCheckBox;
             wxSlider* m_brightnessSlider;
             wxSlider* m_gridAlphaSlider;
             wxChoice* m_gridModeChoice;
@@ -62,6 +63,7 @@ namespace TrenchBroom {
             bool validate();
 
             void OnChooseQuakePathClicked(wxCommandEvent& event);
+            void OnUseMapCacheChanged(wxCommandEvent& event);
             void OnViewSliderChanged(wxScrollEvent& event);
             void OnGridModeChoice(wxCommandEvent& event);
             void OnInstancingModeChoice(wxCommandEvent& event);
@@ -21,18 +21,24 @@
 
 #include "Controller/CameraEvent.h"
 #include "Controller/InputController.h"
+#include "Model/Brush.h"
+#include "Model/Entity.h"
+#include "Model/Map.h"
 #include "Model/MapDocument.h"
 #include "Renderer/ApplyMatrix.h"
 #include "Renderer/Camera.h"
 #include "Renderer/MapRenderer.h"
+#include "Renderer/OffscreenRenderer.h"
 #include "Renderer/OverlayRenderer.h"
 #include "Renderer/RenderContext.h"
+#include "Renderer/RenderStatistics.h"
 #include "Renderer/SharedResources.h"
 #include "Renderer/Vbo.h"
 #include "Renderer/VertexArray.h"
 #include "Model/Filter.h"
 #include "Utility/Console.h"
 #include "Utility/Preferences.h"
+#include "Utility/Profiler.h"
 #include "Utility/VecMath.h"
 #include "View/DocumentViewHolder.h"
 #include "View/EditorFrame.h"
@@ -43,6 +49,10 @@
 #include <wx/wx.h>
 
 #include <cassert>
+#include <cmath>
+#include <ctime>
+#include <iostream>
+#include <vector>
 
 using namespace TrenchBroom::VecMath;
 
@@ -64,6 +74,7 @@ namespace TrenchBroom {
         EVT_MOTION(MapGLCanvas::OnMouseMove)
         EVT_MOUSEWHEEL(MapGLCanvas::OnMouseWheel)
         EVT_MOUSE_CAPTURE_LOST(MapGLCanvas::OnMouseCaptureLost)
+        EVT_TIMER(wxID_ANY, MapGLCanvas::OnRenderTimer)
         END_EVENT_TABLE()
 
         wxDragResult MapGLCanvasDropTarget::OnEnter(wxCoord x, wxCoord y, wxDragResult def) {
@@ -141,11 +152,17 @@ namespace TrenchBroom {
         m_inputController(new Controller::InputController(documentViewHolder)),
         m_overlayRenderer(NULL),
         m_hasFocus(false),
-        m_ignoreNextClick(false) {
+        m_ignoreNextClick(false),
+        m_renderTimer(this),
+        m_lastRenderTime(0),
+        m_renderRequestTime(0),
+        m_renderPending(false),
+        m_benchmarkFrames(0) {
             SetDropTarget(new MapGLCanvasDropTarget(this, *m_inputController));
         }
 
         MapGLCanvas::~MapGLCanvas() {
+            m_renderTimer.Stop();
 			if (GetCapture() == this)
 				ReleaseMouse();
 
@@ -174,7 +191,7 @@ namespace TrenchBroom {
                 resetModifierKeys();
             else
                 clearModifierKeys();
-            Refresh();
+            requestRender();
 
             return true;
         }
@@ -191,15 +208,152 @@ namespace TrenchBroom {
             m_documentViewHolder.view().editorFrame().updateMenuBar();
         }
 
+        void MapGLCanvas::requestRender() {
+            Utility::Profiler& profiler = Utility::Profiler::profiler();
+            const bool profiling = m_documentViewHolder.valid() && profiler.profiles(&m_documentViewHolder.view());
+            if (profiling)
+                profiler.count(Utility::Profiler::RenderRequests);
+            
+            if (!IsShownOnScreen()) {
+                if (profiling)
+                    profiler.count(Utility::Profiler::DroppedRenders);
+                return;
+            }
+
+            const wxLongLong now = wxGetLocalTimeMillis();
+            if (m_renderPending) {
+                // the windowing system may swallow a refresh, e.g. while the canvas is being resized, so don't
+                // wait for a paint event forever
+                if (now - m_renderRequestTime < 4 * RenderInterval) {
+                    if (profiling)
+                        profiler.count(Utility::Profiler::CoalescedRenders);
+                    return;
+                }
+            }
+
+            m_renderPending = true;
+            m_renderRequestTime = now;
+
+            const wxLongLong elapsed = now - m_lastRenderTime;
+            if (elapsed >= RenderInterval)
+                Refresh();
+            else
+                m_renderTimer.Start(static_cast<int>(RenderInterval - elapsed.ToLong()), wxTIMER_ONE_SHOT);
+        }
+
+        void MapGLCanvas::runRenderBenchmark(unsigned int frameCount, std::ostream& stream) {
+            EditorView& view = m_documentViewHolder.view();
+            if (!SetCurrent(*m_glContext)) {
+                view.console().error("Unable to set current OpenGL context");
+                return;
+            }
+
+            Model::MapDocument& document = m_documentViewHolder.document();
+            const Model::EntityList& entities = document.map().entities();
+            std::vector<BBoxf> objectBounds;
+            for (unsigned int i = 0; i < entities.size(); i++) {
+                const Model::BrushList& brushes = entities[i]->brushes();
+                if (brushes.empty())
+                    objectBounds.push_back(entities[i]->bounds());
+                for (unsigned int j = 0; j < brushes.size(); j++)
+                    objectBounds.push_back(brushes[j]->bounds());
+            }
+
+            BBoxf bounds;
+            if (!objectBounds.empty()) {
+                bounds = objectBounds[0];
+                for (unsigned int i = 1; i < objectBounds.size(); i++)
+                    bounds.mergeWith(objectBounds[i]);
+            }
+
+            const Vec3f center = bounds.center();
+            const float radius = (std::max)(256.0f, bounds.size().length() / 2.0f);
+
+            Renderer::Camera& camera = view.camera();
+            const Vec3f position = camera.position();
+            const Vec3f direction = camera.direction();
+            const Vec3f up = camera.up();
+
+            const int width = GetClientSize().x;
+            const int height = GetClientSize().y;
+            Renderer::OffscreenRenderer offscreenRenderer(false);
+            offscreenRenderer.setDimensions(static_cast<unsigned int>(width), static_cast<unsigned int>(height));
+
+            Renderer::ShaderManager& shaderManager = document.sharedResources().shaderManager();
+            Utility::Grid& grid = document.grid();
+            Renderer::RenderStatistics& statistics = Renderer::RenderStatistics::statistics();
+            const bool countingEnabled = statistics.enabled;
+            statistics.enabled = true;
+
+            stream << "frame,cpu_ms,draw_calls,buffer_uploads,uploaded_bytes,texture_binds,shader_changes" << std::endl;
+
+            double totalTime = 0.0;
+            for (unsigned int i = 0; i < frameCount; i++) {
+                const float angle = Math<float>::TwoPi * static_cast<float>(i) / static_cast<float>(frameCount);
+                camera.moveTo(center + Vec3f(std::cos(angle) * radius, std::sin(angle) * radius, radius / 2.0f));
+                camera.lookAt(center, Vec3f::PosZ);
+
+                statistics.reset();
+                const clock_t start = clock();
+
+                offscreenRenderer.preRender();
+                glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                camera.update(0, 0, width, height);
+
+                Renderer::RenderContext renderContext(camera, view.filter(), shaderManager, grid, view.viewOptions(), inputController().inputState(), view.console());
+                view.renderer().render(renderContext);
+                glFinish();
+                offscreenRenderer.postRender();
+
+                const double time = 1000.0 * static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+                totalTime += time;
+
+                stream << i << ","
+                       << time << ","
+                       << statistics.drawCalls << ","
+                       << statistics.bufferUploads << ","
+                       << statistics.uploadedBytes << ","
+                       << statistics.textureBinds << ","
+                       << statistics.shaderChanges << std::endl;
+            }
+
+            statistics.enabled = countingEnabled;
+            camera.moveTo(position);
+            camera.setDirection(direction, up);
+
+            if (frameCount > 0)
+                view.console().info("Rendered %u benchmark frames in %.1f ms (%.2f ms per frame)", frameCount, totalTime, totalTime / frameCount);
+        }
+
+        void MapGLCanvas::scheduleRenderBenchmark(unsigned int frameCount) {
+            m_benchmarkFrames = frameCount;
+            requestRender();
+        }
+
         void MapGLCanvas::OnPaint(wxPaintEvent& event) {
             if (!m_documentViewHolder.valid() || !IsShownOnScreen())
                 return;
 
+            m_renderTimer.Stop();
+            m_renderPending = false;
+            m_lastRenderTime = wxGetLocalTimeMillis();
+
             EditorView& view = m_documentViewHolder.view();
+            Utility::Profiler& profiler = Utility::Profiler::profiler();
+            const bool profiling = profiler.profiles(&view);
+            Utility::Profiler::Suspension suspension(&view);
 
 			if (SetCurrent(*m_glContext)) {
                 wxPaintDC(this);
                 
+                if (profiling) {
+                    Renderer::RenderStatistics& statistics = Renderer::RenderStatistics::statistics();
+                    statistics.reset();
+                    statistics.enabled = true;
+                    profiler.beginFrame();
+                }
+                
                 glEnable(GL_MULTISAMPLE);
 
 				Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
@@ -228,8 +382,8 @@ namespace TrenchBroom {
 
                 // render overlays
                 if (m_overlayRenderer == NULL)
-                    m_overlayRenderer = new Renderer::OverlayRenderer();
-                m_overlayRenderer->render(renderContext, GetClientSize().x, GetClientSize().y);
+                    m_overlayRenderer = new Renderer::OverlayRenderer(m_documentViewHolder.document().sharedResources().fontManager());
+                m_overlayRenderer->render(renderContext, GetClientSize().x, GetClientSize().y, profiling);
 
                 // render focus rectangle
                 if (m_hasFocus) {
@@ -288,6 +442,24 @@ namespace TrenchBroom {
                 }
 
 				SwapBuffers();
+
+                if (profiling) {
+                    Renderer::RenderStatistics& statistics = Renderer::RenderStatistics::statistics();
+                    statistics.enabled = false;
+                    profiler.count(Utility::Profiler::DrawCalls, statistics.drawCalls);
+                    profiler.count(Utility::Profiler::TextureBinds, statistics.textureBinds);
+                    profiler.count(Utility::Profiler::ShaderChanges, statistics.shaderChanges);
+                    profiler.count(Utility::Profiler::BufferUploads, statistics.bufferUploads);
+                    profiler.count(Utility::Profiler::UploadedBytes, statistics.uploadedBytes);
+                    profiler.endFrame();
+                }
+
+                if (m_benchmarkFrames > 0) {
+                    const unsigned int frameCount = m_benchmarkFrames;
+                    m_benchmarkFrames = 0;
+                    runRenderBenchmark(frameCount, std::cout);
+                    wxTheApp->ExitMainLoop();
+                }
 			} else {
 				view.console().error("Unable to set current OpenGL context");
 			}
@@ -434,5 +606,10 @@ namespace TrenchBroom {
         void MapGLCanvas::OnMouseCaptureLost(wxMouseCaptureLostEvent& event) {
             m_inputController->endDrag();
         }
+
+        void MapGLCanvas::OnRenderTimer(wxTimerEvent& event) {
+            if (m_renderPending)
+                Refresh();
+        }
     }
 }
@@ -28,6 +28,8 @@
 #include <wx/glcanvas.h>
 #include <wx/timer.h>
 
+#include <iosfwd>
+
 namespace TrenchBroom {
     namespace Controller {
         class InputController;
@@ -81,6 +83,14 @@ namespace TrenchBroom {
             bool m_hasFocus;
             bool m_ignoreNextClick;
 
+            static const int RenderInterval = 16;
+
+            wxTimer m_renderTimer;
+            wxLongLong m_lastRenderTime;
+            wxLongLong m_renderRequestTime;
+            bool m_renderPending;
+            unsigned int m_benchmarkFrames;
+
             bool handleModifierKey(int keyCode, bool down);
         public:
             MapGLCanvas(wxWindow* parent, DocumentViewHolder& documentViewHolder);
@@ -99,7 +109,28 @@ namespace TrenchBroom {
             void resetModifierKeys();
             void clearModifierKeys();
             void updateMenuBar();
-            
+
+            /**
+             * Schedules a redraw of this canvas. Requests are coalesced so that the canvas is redrawn at most once per
+             * render interval, no matter how many tools, commands or animations ask for a redraw in between. While
+             * this canvas is profiled, the requests and how many of them were coalesced or dropped are counted in the
+             * profiler's frames.
+             */
+            void requestRender();
+
+            /**
+             * Renders the given number of frames into an offscreen buffer while the camera circles around the map and
+             * writes the CPU time and the render statistics of every frame to the given stream as CSV. The camera is
+             * restored afterwards.
+             */
+            void runRenderBenchmark(unsigned int frameCount, std::ostream& stream);
+
+            /**
+             * Runs a render benchmark with the given number of frames when this canvas is painted for the first time,
+             * writes the results to the standard output and exits the application.
+             */
+            void scheduleRenderBenchmark(unsigned int frameCount);
+
             void OnPaint(wxPaintEvent& event);
             void OnKeyDown(wxKeyEvent& event);
             void OnKeyUp(wxKeyEvent& event);
@@ -115,6 +146,7 @@ namespace TrenchBroom {
             void OnMouseMove(wxMouseEvent& event);
             void OnMouseWheel(wxMouseEvent& event);
             void OnMouseCaptureLost(wxMouseCaptureLostEvent& event);
+            void OnRenderTimer(wxTimerEvent& event);
 
             DECLARE_EVENT_TABLE()
         };
@@ -97,6 +97,8 @@ namespace TrenchBroom {
             if (reloadTextures) {
                 m_canvas->clear();
                 m_canvas->reload();
+            } else {
+                m_canvas->invalidateUsage();
             }
             m_canvas->Refresh();
         }
@@ -19,7 +19,6 @@
 
 #include "TextureBrowserCanvas.h"
 
-#include "IO/FileManager.h"
 #include "Model/MapDocument.h"
 #include "Renderer/ApplyMatrix.h"
 #include "Renderer/SharedResources.h"
@@ -40,28 +39,65 @@
 #include "View/EditorView.h"
 #include "View/TextureSelectedCommand.h"
 
+#include <algorithm>
 #include <cassert>
 
 using namespace TrenchBroom::VecMath;
 
 namespace TrenchBroom {
     namespace View {
-        void TextureBrowserCanvas::addTextureToLayout(Layout& layout, Model::Texture* texture, const Renderer::Text::FontDescriptor& font) {
-            if ((!m_hideUnused || texture->usageCount() > 0) && (m_filterText.empty() || Utility::containsString(texture->name(), m_filterText, false))) {
-                Renderer::Text::FontManager& fontManager =  m_documentViewHolder.document().sharedResources().fontManager();
-                const float maxCellWidth = layout.maxCellWidth();
-                const Renderer::Text::FontDescriptor actualFont = fontManager.selectFontSize(font, texture->name(), maxCellWidth, 5);
-                const Vec2f actualSize = fontManager.font(actualFont)->measure(texture->name());
-
-                Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
-                const float scaleFactor = prefs.getFloat(Preferences::TextureBrowserIconSize);
-                const unsigned int scaledTextureWidth = static_cast<unsigned int>(Math<float>::round(scaleFactor * static_cast<float>(texture->width())));
-                const unsigned int scaledTextureHeight = static_cast<unsigned int>(Math<float>::round(scaleFactor * static_cast<float>(texture->height())));
-
-                Renderer::TextureRendererManager& textureRendererManager = m_documentViewHolder.document().sharedResources().textureRendererManager();
-                Renderer::TextureRenderer& textureRenderer = textureRendererManager.renderer(texture);
-                layout.addItem(TextureCellData(texture, &textureRenderer, actualFont), scaledTextureWidth, scaledTextureHeight, actualSize.x(), font.size() + 2.0f);
+        void TextureBrowserCanvas::filterTextures(const Model::TextureList& textures, Model::TextureList& result) const {
+            Model::TextureList::const_iterator it, end;
+            for (it = textures.begin(), end = textures.end(); it != end; ++it) {
+                Model::Texture* texture = *it;
+                if ((!m_hideUnused || texture->usageCount() > 0) && (m_filterText.empty() || std::binary_search(m_filterMatches.begin(), m_filterMatches.end(), texture)))
+                    result.push_back(texture);
+            }
+        }
+
+        void TextureBrowserCanvas::validateFilteredTextures() {
+            if (m_filteredTexturesValid && m_filteredText == m_filterText)
+                return;
+            
+            m_filteredTextures.clear();
+            m_filterMatches.clear();
+            
+            Model::TextureManager& textureManager = m_documentViewHolder.document().textureManager();
+            if (!m_filterText.empty()) {
+                textureManager.findTextures(m_filterText, m_filterMatches);
+                std::sort(m_filterMatches.begin(), m_filterMatches.end());
             }
+            
+            if (m_group) {
+                const Model::TextureCollectionList& collections = textureManager.collections();
+                for (size_t i = 0; i < collections.size(); i++) {
+                    Model::TextureCollection* collection = collections[i];
+                    m_filteredTextures.push_back(FilteredTextureGroup(collection, Model::TextureList()));
+                    filterTextures(collection->textures(m_sortOrder), m_filteredTextures.back().second);
+                }
+            } else {
+                m_filteredTextures.push_back(FilteredTextureGroup(NULL, Model::TextureList()));
+                filterTextures(textureManager.textures(m_sortOrder), m_filteredTextures.back().second);
+            }
+            
+            m_filteredText = m_filterText;
+            m_filteredTexturesValid = true;
+        }
+
+        void TextureBrowserCanvas::addTextureToLayout(Layout& layout, Model::Texture* texture, const Renderer::Text::FontDescriptor& font) {
+            Renderer::Text::FontManager& fontManager =  m_documentViewHolder.document().sharedResources().fontManager();
+            const float maxCellWidth = layout.maxCellWidth();
+            const Renderer::Text::FontDescriptor actualFont = fontManager.selectFontSize(font, texture->name(), maxCellWidth, 5);
+            const Vec2f actualSize = fontManager.font(actualFont)->measure(texture->name());
+
+            Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
+            const float scaleFactor = prefs.getFloat(Preferences::TextureBrowserIconSize);
+            const unsigned int scaledTextureWidth = static_cast<unsigned int>(Math<float>::round(scaleFactor * static_cast<float>(texture->width())));
+            const unsigned int scaledTextureHeight = static_cast<unsigned int>(Math<float>::round(scaleFactor * static_cast<float>(texture->height())));
+
+            Renderer::TextureRendererManager& textureRendererManager = m_documentViewHolder.document().sharedResources().textureRendererManager();
+            Renderer::TextureRenderer& textureRenderer = textureRendererManager.renderer(texture);
+            layout.addItem(TextureCellData(texture, &textureRenderer, actualFont), scaledTextureWidth, scaledTextureHeight, actualSize.x(), font.size() + 2.0f);
         }
 
         void TextureBrowserCanvas::doInitLayout(Layout& layout) {
@@ -78,37 +114,33 @@ namespace TrenchBroom {
 
         void TextureBrowserCanvas::doReloadLayout(Layout& layout) {
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
-            Model::TextureManager& textureManager = m_documentViewHolder.document().textureManager();
 
             String fontName = prefs.getString(Preferences::RendererFontName);
             int fontSize = prefs.getInt(Preferences::TextureBrowserFontSize);
 
             assert(fontSize >= 0);
             Renderer::Text::FontDescriptor font(fontName, static_cast<unsigned int>(fontSize));
-            IO::FileManager fileManager;
-
-            if (m_group) {
-                const Model::TextureCollectionList& collections = textureManager.collections();
-                for (size_t i = 0; i < collections.size(); i++) {
-                    Model::TextureCollection* collection = collections[i];
-                    if (m_group) {
-                        String name = fileManager.pathComponents(collection->name()).back();
-                        layout.addGroup(collection, fontSize + 2.0f);
-                    }
 
-                    Model::TextureList textures = collection->textures(m_sortOrder);
-                    for (size_t j = 0; j < textures.size(); j++)
-                        addTextureToLayout(layout, textures[j], font);
-                }
-            } else {
-                layout.addGroup(NULL, 0.0f);
-                Model::TextureList textures = textureManager.textures(m_sortOrder);
+            validateFilteredTextures();
+            
+            FilteredTextureGroupList::const_iterator groupIt, groupEnd;
+            for (groupIt = m_filteredTextures.begin(), groupEnd = m_filteredTextures.end(); groupIt != groupEnd; ++groupIt) {
+                Model::TextureCollection* collection = groupIt->first;
+                if (collection != NULL)
+                    layout.addGroup(collection, fontSize + 2.0f);
+                else
+                    layout.addGroup(NULL, 0.0f);
+                
+                const Model::TextureList& textures = groupIt->second;
                 for (size_t i = 0; i < textures.size(); i++)
                     addTextureToLayout(layout, textures[i], font);
             }
         }
 
         void TextureBrowserCanvas::doClear() {
+            m_filteredTextures.clear();
+            m_filterMatches.clear();
+            m_filteredTexturesValid = false;
         }
 
         void TextureBrowserCanvas::doRender(Layout& layout, float y, float height) {
@@ -134,19 +166,24 @@ namespace TrenchBroom {
             const Mat4f view = viewMatrix(Vec3f::NegZ, Vec3f::PosY) * translationMatrix(Vec3f(0.0f, 0.0f, 0.1f));
             Renderer::Transformation transformation(projection, view);
 
-            size_t visibleGroupCount = 0;
-            size_t visibleItemCount = 0;
+            // only the groups and cells within the visible rect are collected, and each pass below renders them
+            // from a single vertex array
+            Layout::GroupPtrList visibleGroups;
+            Layout::CellPtrList visibleCells;
+            layout.visibleItems(y, height, visibleGroups, visibleCells);
 
             typedef std::map<Renderer::Text::FontDescriptor, Vec2f::List> StringMap;
             StringMap stringVertices;
-
-            for (unsigned int i = 0; i < layout.size(); i++) {
-                const Layout::Group& group = layout[i];
-                if (group.intersectsY(y, height)) {
-                    visibleGroupCount++;
-
-                    Model::TextureCollection* collection = group.item();
-                    if (collection != NULL && !collection->name().empty()) {
+            size_t titleCount = 0;
+            size_t borderCount = 0;
+
+            Layout::GroupPtrList::const_iterator groupIt, groupEnd;
+            for (groupIt = visibleGroups.begin(), groupEnd = visibleGroups.end(); groupIt != groupEnd; ++groupIt) {
+                const Layout::Group& group = **groupIt;
+                Model::TextureCollection* collection = group.item();
+                if (collection != NULL) {
+                    titleCount++;
+                    if (!collection->name().empty()) {
                         const LayoutBounds titleBounds = layout.titleBoundsForVisibleRect(group, y, height);
                         const Vec2f offset(titleBounds.left() + 2.0f, height - (titleBounds.top() - y) - titleBounds.height());
 
@@ -155,62 +192,50 @@ namespace TrenchBroom {
                         Vec2f::List& vertices = stringVertices[defaultDescriptor];
                         vertices.insert(vertices.end(), titleVertices.begin(), titleVertices.end());
                     }
-
-                    for (unsigned int j = 0; j < group.size(); j++) {
-                        const Layout::Group::Row& row = group[j];
-                        if (row.intersectsY(y, height)) {
-                            for (unsigned int k = 0; k < row.size(); k++) {
-                                visibleItemCount++;
-
-                                const Layout::Group::Row::Cell& cell = row[k];
-                                const LayoutBounds titleBounds = cell.titleBounds();
-                                const Vec2f offset(titleBounds.left() + 2.0f, height - (titleBounds.top() - y) - titleBounds.height());
-
-                                Renderer::Text::TexturedFont* font = fontManager.font(cell.item().fontDescriptor);
-                                Vec2f::List titleVertices = font->quads(cell.item().texture->name(), false, offset);
-                                Vec2f::List& vertices = stringVertices[cell.item().fontDescriptor];
-                                vertices.insert(vertices.end(), titleVertices.begin(), titleVertices.end());
-                            }
-                        }
-                    }
                 }
             }
+            
+            Layout::CellPtrList::const_iterator cellIt, cellEnd;
+            for (cellIt = visibleCells.begin(), cellEnd = visibleCells.end(); cellIt != cellEnd; ++cellIt) {
+                const Layout::Group::Row::Cell& cell = **cellIt;
+                const Model::Texture* texture = cell.item().texture;
+                if (texture == m_selectedTexture || texture->usageCount() > 0 || texture->overridden())
+                    borderCount++;
+                
+                const LayoutBounds titleBounds = cell.titleBounds();
+                const Vec2f offset(titleBounds.left() + 2.0f, height - (titleBounds.top() - y) - titleBounds.height());
+
+                Renderer::Text::TexturedFont* font = fontManager.font(cell.item().fontDescriptor);
+                Vec2f::List titleVertices = font->quads(texture->name(), false, offset);
+                Vec2f::List& vertices = stringVertices[cell.item().fontDescriptor];
+                vertices.insert(vertices.end(), titleVertices.begin(), titleVertices.end());
+            }
 
-            if (visibleItemCount > 0) { // render borders
-                unsigned int vertexCount = static_cast<unsigned int>(4 * visibleItemCount);
-                Renderer::VertexArray vertexArray(*m_vbo, GL_QUADS, vertexCount,
+            if (borderCount > 0) { // render borders
+                Renderer::VertexArray vertexArray(*m_vbo, GL_QUADS, 4 * borderCount,
                                                   Renderer::Attribute::position2f(),
                                                   Renderer::Attribute::color4f());
 
                 Renderer::SetVboState mapVbo(*m_vbo, Renderer::Vbo::VboMapped);
-                for (unsigned int i = 0; i < layout.size(); i++) {
-                    const Layout::Group& group = layout[i];
-                    if (group.intersectsY(y, height)) {
-                        for (unsigned int j = 0; j < group.size(); j++) {
-                            const Layout::Group::Row& row = group[j];
-                            if (row.intersectsY(y, height)) {
-                                for (unsigned int k = 0; k < row.size(); k++) {
-                                    const Layout::Group::Row::Cell& cell = row[k];
-
-                                    bool selected = cell.item().texture == m_selectedTexture;
-                                    bool inUse = cell.item().texture->usageCount() > 0;
-                                    bool overridden = cell.item().texture->overridden();
-
-                                    if (selected || inUse || overridden) {
-                                        const Color& color = selected ? prefs.getColor(Preferences::SelectedTextureColor) : (inUse ? prefs.getColor(Preferences::UsedTextureColor) : prefs.getColor(Preferences::OverriddenTextureColor));
-
-                                        vertexArray.addAttribute(Vec2f(cell.itemBounds().left() - 1.5f, height - (cell.itemBounds().top() - 1.5f - y)));
-                                        vertexArray.addAttribute(color);
-                                        vertexArray.addAttribute(Vec2f(cell.itemBounds().left() - 1.5f, height - (cell.itemBounds().bottom() + 1.5f - y)));
-                                        vertexArray.addAttribute(color);
-                                        vertexArray.addAttribute(Vec2f(cell.itemBounds().right() + 1.5f, height - (cell.itemBounds().bottom() + 1.5f - y)));
-                                        vertexArray.addAttribute(color);
-                                        vertexArray.addAttribute(Vec2f(cell.itemBounds().right() + 1.5f, height - (cell.itemBounds().top() - 1.5f - y)));
-                                        vertexArray.addAttribute(color);
-                                    }
-                                }
-                            }
-                        }
+                for (cellIt = visibleCells.begin(), cellEnd = visibleCells.end(); cellIt != cellEnd; ++cellIt) {
+                    const Layout::Group::Row::Cell& cell = **cellIt;
+                    const Model::Texture* texture = cell.item().texture;
+                    
+                    bool selected = texture == m_selectedTexture;
+                    bool inUse = texture->usageCount() > 0;
+                    bool overridden = texture->overridden();
+
+                    if (selected || inUse || overridden) {
+                        const Color& color = selected ? prefs.getColor(Preferences::SelectedTextureColor) : (inUse ? prefs.getColor(Preferences::UsedTextureColor) : prefs.getColor(Preferences::OverriddenTextureColor));
+
+                        vertexArray.addAttribute(Vec2f(cell.itemBounds().left() - 1.5f, height - (cell.itemBounds().top() - 1.5f - y)));
+                        vertexArray.addAttribute(color);
+                        vertexArray.addAttribute(Vec2f(cell.itemBounds().left() - 1.5f, height - (cell.itemBounds().bottom() + 1.5f - y)));
+                        vertexArray.addAttribute(color);
+                        vertexArray.addAttribute(Vec2f(cell.itemBounds().right() + 1.5f, height - (cell.itemBounds().bottom() + 1.5f - y)));
+                        vertexArray.addAttribute(color);
+                        vertexArray.addAttribute(Vec2f(cell.itemBounds().right() + 1.5f, height - (cell.itemBounds().top() - 1.5f - y)));
+                        vertexArray.addAttribute(color);
                     }
                 }
 
@@ -219,55 +244,54 @@ namespace TrenchBroom {
                 vertexArray.render();
             }
 
-            { // render textures
+            if (!visibleCells.empty()) { // render textures
+                Renderer::VertexArray vertexArray(*m_vbo, GL_QUADS, 4 * visibleCells.size(),
+                                                  Renderer::Attribute::position2f(),
+                                                  Renderer::Attribute::texCoord02f());
+                
+                Renderer::SetVboState mapVbo(*m_vbo, Renderer::Vbo::VboMapped);
+                for (cellIt = visibleCells.begin(), cellEnd = visibleCells.end(); cellIt != cellEnd; ++cellIt) {
+                    const Layout::Group::Row::Cell& cell = **cellIt;
+                    vertexArray.addAttribute(Vec2f(cell.itemBounds().left(), height - (cell.itemBounds().top() - y)));
+                    vertexArray.addAttribute(Vec2f(0.0f, 0.0f));
+                    vertexArray.addAttribute(Vec2f(cell.itemBounds().left(), height - (cell.itemBounds().bottom() - y)));
+                    vertexArray.addAttribute(Vec2f(0.0f, 1.0f));
+                    vertexArray.addAttribute(Vec2f(cell.itemBounds().right(), height - (cell.itemBounds().bottom() - y)));
+                    vertexArray.addAttribute(Vec2f(1.0f, 1.0f));
+                    vertexArray.addAttribute(Vec2f(cell.itemBounds().right(), height - (cell.itemBounds().top() - y)));
+                    vertexArray.addAttribute(Vec2f(1.0f, 0.0f));
+                }
+                
+                Renderer::SetVboState activateVbo(*m_vbo, Renderer::Vbo::VboActive);
                 Renderer::ActivateShader shader(shaderManager, Renderer::Shaders::TextureBrowserShader);
                 shader.setUniformVariable("ApplyTinting", false);
                 shader.setUniformVariable("Brightness", prefs.getFloat(Preferences::RendererBrightness));
-                for (unsigned int i = 0; i < layout.size(); i++) {
-                    const Layout::Group& group = layout[i];
-                    if (group.intersectsY(y, height)) {
-                        for (unsigned int j = 0; j < group.size(); j++) {
-                            const Layout::Group::Row& row = group[j];
-                            if (row.intersectsY(y, height)) {
-                                for (unsigned int k = 0; k < row.size(); k++) {
-                                    const Layout::Group::Row::Cell& cell = row[k];
-                                    shader.setUniformVariable("GrayScale", cell.item().texture->overridden());
-                                    shader.setUniformVariable("Texture", 0);
-                                    cell.item().textureRenderer->activate();
-                                    glBegin(GL_QUADS);
-                                    glTexCoord2f(0.0f, 0.0f);
-                                    glVertex2f(cell.itemBounds().left(), height - (cell.itemBounds().top() - y));
-                                    glTexCoord2f(0.0f, 1.0f);
-                                    glVertex2f(cell.itemBounds().left(), height - (cell.itemBounds().bottom() - y));
-                                    glTexCoord2f(1.0f, 1.0f);
-                                    glVertex2f(cell.itemBounds().right(), height - (cell.itemBounds().bottom() - y));
-                                    glTexCoord2f(1.0f, 0.0f);
-                                    glVertex2f(cell.itemBounds().right(), height - (cell.itemBounds().top() - y));
-                                    glEnd();
-                                    cell.item().textureRenderer->deactivate();
-                                }
-                            }
-                        }
-                    }
+                shader.setUniformVariable("Texture", 0);
+                
+                vertexArray.setup();
+                for (size_t i = 0; i < visibleCells.size(); i++) {
+                    const Layout::Group::Row::Cell& cell = *visibleCells[i];
+                    shader.setUniformVariable("GrayScale", cell.item().texture->overridden());
+                    cell.item().textureRenderer->activate();
+                    vertexArray.renderPrimitives(4 * i, 4);
+                    cell.item().textureRenderer->deactivate();
                 }
+                vertexArray.cleanup();
             }
 
-            if (visibleGroupCount > 0) { // render group title background
-                unsigned int vertexCount = static_cast<unsigned int>(4 * visibleGroupCount);
-                Renderer::VertexArray vertexArray(*m_vbo, GL_QUADS, vertexCount,
+            if (titleCount > 0) { // render group title background
+                Renderer::VertexArray vertexArray(*m_vbo, GL_QUADS, 4 * titleCount,
                                                   Renderer::Attribute::position2f());
 
                 Renderer::SetVboState mapVbo(*m_vbo, Renderer::Vbo::VboMapped);
-                for (unsigned int i = 0; i < layout.size(); i++) {
-                    const Layout::Group& group = layout[i];
-                    if (group.intersectsY(y, height)) {
-                        if (group.item() != NULL) {
-                            LayoutBounds titleBounds = layout.titleBoundsForVisibleRect(group, y, height);
-                            vertexArray.addAttribute(Vec2f(titleBounds.left(), height - (titleBounds.top() - y)));
-                            vertexArray.addAttribute(Vec2f(titleBounds.left(), height - (titleBounds.bottom() - y)));
-                            vertexArray.addAttribute(Vec2f(titleBounds.right(), height - (titleBounds.bottom() - y)));
-                            vertexArray.addAttribute(Vec2f(titleBounds.right(), height - (titleBounds.top() - y)));
-                        }
+                for (groupIt = visibleGroups.begin(), groupEnd = visibleGroups.end(); groupIt != groupEnd; ++groupIt) {
+                    const Layout::Group& group = **groupIt;
+                    if (group.item() != NULL) {
+                        LayoutBounds titleBounds = layout.titleBoundsForVisibleRect(group, y, height);
+                        vertexArray.addAttribute(Vec2f(titleBounds.left(), height - (titleBounds.top() - y)));
+                        vertexArray.addAttribute(Vec2f(titleBounds.left(), height - (titleBounds.bottom() - y)));
+                        vertexArray.addAttribute(Vec2f(titleBounds.right(), height - (titleBounds.bottom() - y)));
+                        vertexArray.addAttribute(Vec2f(titleBounds.right(), height - (titleBounds.top() - y)));
                     }
                 }
 
@@ -336,7 +360,8 @@ namespace TrenchBroom {
         m_group(false),
         m_hideUnused(false),
         m_sortOrder(Model::TextureSortOrder::Name),
-        m_vbo() {}
+        m_filteredTexturesValid(false),
+        m_vbo(NULL) {}
 
         TextureBrowserCanvas::~TextureBrowserCanvas() {
             clear();
@@ -64,6 +64,9 @@ namespace TrenchBroom {
         
         class TextureBrowserCanvas : public CellLayoutGLCanvas<TextureCellData, TextureGroupData> {
         protected:
+            typedef std::pair<Model::TextureCollection*, Model::TextureList> FilteredTextureGroup;
+            typedef std::vector<FilteredTextureGroup> FilteredTextureGroupList;
+            
             DocumentViewHolder& m_documentViewHolder;
             Model::Texture* m_selectedTexture;
             
@@ -71,8 +74,16 @@ namespace TrenchBroom {
             bool m_hideUnused;
             Model::TextureSortOrder::Type m_sortOrder;
             String m_filterText;
+            
+            FilteredTextureGroupList m_filteredTextures;
+            String m_filteredText;
+            bool m_filteredTexturesValid;
+            Model::TextureList m_filterMatches;
+            
             Renderer::Vbo* m_vbo;
             
+            void filterTextures(const Model::TextureList& textures, Model::TextureList& result) const;
+            void validateFilteredTextures();
             void addTextureToLayout(Layout& layout, Model::Texture* texture, const Renderer::Text::FontDescriptor& font);
             virtual void doInitLayout(Layout& layout);
             virtual void doReloadLayout(Layout& layout);
@@ -88,6 +99,7 @@ namespace TrenchBroom {
                 if (sortOrder == m_sortOrder)
                     return;
                 m_sortOrder = sortOrder;
+                m_filteredTexturesValid = false;
                 reload();
                 Refresh();
             }
@@ -96,6 +108,7 @@ namespace TrenchBroom {
                 if (group == m_group)
                     return;
                 m_group = group;
+                m_filteredTexturesValid = false;
                 reload();
                 Refresh();
             }
@@ -104,6 +117,7 @@ namespace TrenchBroom {
                 if (hideUnused == m_hideUnused)
                     return;
                 m_hideUnused = hideUnused;
+                m_filteredTexturesValid = false;
                 reload();
                 Refresh();
             }
@@ -116,6 +130,16 @@ namespace TrenchBroom {
                 Refresh();
             }
             
+            /**
+             * Must be called when the usage counts of the textures have changed.
+             */
+            inline void invalidateUsage() {
+                if (!m_hideUnused)
+                    return;
+                m_filteredTexturesValid = false;
+                reload();
+            }
+            
             inline Model::Texture* selectedTexture() const {
                 return m_selectedTexture;
             }
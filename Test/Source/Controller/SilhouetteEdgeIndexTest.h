@@ -0,0 +1,182 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_SilhouetteEdgeIndexTest_h
+#define TrenchBroom_SilhouetteEdgeIndexTest_h
+
+#include "TestSuite.h"
+#include "Controller/SilhouetteEdgeIndex.h"
+#include "Model/Brush.h"
+#include "Model/BrushGeometry.h"
+#include "Model/Face.h"
+#include "Utility/List.h"
+#include "Utility/VecMath.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <limits>
+
+namespace TrenchBroom {
+    namespace Controller {
+        class SilhouetteEdgeIndexTest : public TestSuite<SilhouetteEdgeIndexTest> {
+        protected:
+            BBoxf m_worldBounds;
+
+            float random(float min, float max) {
+                return min + (max - min) * static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
+            }
+
+            Vec3f randomPoint(float min, float max) {
+                return Vec3f(random(min, max), random(min, max), random(min, max));
+            }
+
+            Model::BrushList createBrushes(size_t count) {
+                Model::BrushList brushes;
+                for (size_t i = 0; i < count; i++) {
+                    const Vec3f min = randomPoint(-1024.0f, 1024.0f).rounded();
+                    const Vec3f size = randomPoint(8.0f, 128.0f).rounded();
+                    brushes.push_back(new Model::Brush(m_worldBounds, false, BBoxf(min, min + size), NULL));
+                }
+                return brushes;
+            }
+
+            // the closest edge that separates a face turned towards the view point from one turned away from it
+            Model::Face* findClosestEdge(const Model::BrushList& brushes, const Vec3f& viewPoint, const Rayf& ray, float& edgeDistance, float& rayDistance) {
+                Model::Face* result = NULL;
+                edgeDistance = std::numeric_limits<float>::max();
+
+                for (size_t i = 0; i < brushes.size(); i++) {
+                    const Model::EdgeList& edges = brushes[i]->edges();
+                    for (size_t j = 0; j < edges.size(); j++) {
+                        const Model::Edge& edge = *edges[j];
+                        const bool leftAway = edge.left->face->boundary().pointDistance(viewPoint) < 0.0f;
+                        const bool rightAway = edge.right->face->boundary().pointDistance(viewPoint) < 0.0f;
+                        if (leftAway == rightAway)
+                            continue;
+
+                        Vec3f pointOnSegment;
+                        float distanceToClosestPoint;
+                        const float distance = ray.distanceToSegment(edge.start->position, edge.end->position, pointOnSegment, distanceToClosestPoint);
+                        if (!Math<float>::isnan(distance) && distance < edgeDistance) {
+                            edgeDistance = distance;
+                            rayDistance = distanceToClosestPoint;
+                            result = leftAway ? edge.left->face : edge.right->face;
+                        }
+                    }
+                }
+
+                return result;
+            }
+
+            void registerTestCases() {
+                m_worldBounds = BBoxf(Vec3f(-4096.0f, -4096.0f, -4096.0f), Vec3f(4096.0f, 4096.0f, 4096.0f));
+
+                registerTestCase(&SilhouetteEdgeIndexTest::testEmpty);
+                registerTestCase(&SilhouetteEdgeIndexTest::testSingleBrush);
+                registerTestCase(&SilhouetteEdgeIndexTest::testMatchesLinearSearch);
+            }
+        public:
+            void testEmpty() {
+                SilhouetteEdgeIndex index;
+                assert(!index.valid());
+
+                index.build(Model::BrushList());
+                assert(index.valid());
+                index.setViewPoint(Vec3f(0.0f, 0.0f, 0.0f));
+
+                float edgeDistance, rayDistance;
+                assert(index.findClosestEdge(Rayf(Vec3f::Null, Vec3f::PosX), edgeDistance, rayDistance) == NULL);
+
+                index.invalidate();
+                assert(!index.valid());
+            }
+
+            void testSingleBrush() {
+                Model::Brush brush(m_worldBounds, false, BBoxf(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(64.0f, 64.0f, 64.0f)), NULL);
+                Model::BrushList brushes;
+                brushes.push_back(&brush);
+
+                SilhouetteEdgeIndex index;
+                index.build(brushes);
+
+                // looking down at the top face, the top edges are the silhouette, and the side faces are turned away
+                const Vec3f viewPoint(32.0f, 32.0f, 256.0f);
+                index.setViewPoint(viewPoint);
+
+                float edgeDistance, rayDistance;
+                const Rayf ray(viewPoint, (Vec3f(80.0f, 32.0f, 64.0f) - viewPoint).normalized());
+                Model::Face* face = index.findClosestEdge(ray, edgeDistance, rayDistance);
+                assert(face != NULL);
+                assert(face->boundary().normal.equals(Vec3f::PosX));
+                assert(edgeDistance > 0.0f && edgeDistance < 16.0f);
+
+                // inside the brush, all faces are turned towards the viewer
+                index.setViewPoint(Vec3f(32.0f, 32.0f, 32.0f));
+                assert(index.findClosestEdge(ray, edgeDistance, rayDistance) == NULL);
+            }
+
+            void testMatchesLinearSearch() {
+                std::srand(0);
+                Model::BrushList brushes = createBrushes(500);
+
+                SilhouetteEdgeIndex index;
+                index.build(brushes);
+
+                clock_t indexTime = 0;
+                clock_t linearTime = 0;
+                for (size_t i = 0; i < 10; i++) {
+                    const Vec3f viewPoint = randomPoint(-2048.0f, 2048.0f);
+                    index.setViewPoint(viewPoint);
+
+                    for (size_t j = 0; j < 100; j++) {
+                        const Vec3f target = randomPoint(-1024.0f, 1024.0f);
+                        const Rayf ray(viewPoint, (target - viewPoint).normalized());
+
+                        clock_t start = clock();
+                        float expectedEdgeDistance, expectedRayDistance;
+                        Model::Face* expected = findClosestEdge(brushes, viewPoint, ray, expectedEdgeDistance, expectedRayDistance);
+                        linearTime += clock() - start;
+
+                        start = clock();
+                        float edgeDistance, rayDistance;
+                        Model::Face* face = index.findClosestEdge(ray, edgeDistance, rayDistance);
+                        indexTime += clock() - start;
+
+                        assert(face == expected);
+                        if (expected != NULL) {
+                            assert(edgeDistance == expectedEdgeDistance);
+                            assert(rayDistance == expectedRayDistance);
+                        }
+                    }
+                }
+
+                std::printf("1000 edge picks on %lu brushes: index: %.1f ms, linear search: %.1f ms\n",
+                            static_cast<unsigned long>(brushes.size()),
+                            1000.0 * static_cast<double>(indexTime) / CLOCKS_PER_SEC,
+                            1000.0 * static_cast<double>(linearTime) / CLOCKS_PER_SEC);
+
+                Utility::deleteAll(brushes);
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,235 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_GameFileSystemTest_h
+#define TrenchBroom_GameFileSystemTest_h
+
+#include "TestSuite.h"
+#include "IO/GameFileSystem.h"
+#include "Utility/String.h"
+
+#include <cassert>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#if defined _MSC_VER
+#include <cstdint>
+#elif defined __GNUC__
+#include <stdint.h>
+#endif
+
+namespace TrenchBroom {
+    namespace IO {
+        class GameFileSystemTest : public TestSuite<GameFileSystemTest> {
+        private:
+            class MemoryFile : public MappedFile {
+            public:
+                MemoryFile(const String& contents) :
+                MappedFile(NULL, NULL) {
+                    m_begin = new char[contents.size()];
+                    memcpy(m_begin, contents.data(), contents.size());
+                    m_end = m_begin + contents.size();
+                    m_size = contents.size();
+                }
+                
+                ~MemoryFile() {
+                    delete [] m_begin;
+                }
+            };
+            
+            /**
+             * A game file system that keeps its files in memory. File paths are made of a directory and a name
+             * separated by a slash.
+             */
+            class MemoryFileSystem : public GameFileSystem {
+            private:
+                typedef std::map<String, String> FileMap;
+                FileMap m_files;
+            protected:
+                StringList findPaks(const String& directoryPath) {
+                    StringList pakPaths;
+                    FileMap::const_iterator it, end;
+                    for (it = m_files.begin(), end = m_files.end(); it != end; ++it) {
+                        const String& path = it->first;
+                        if (path.size() > directoryPath.size() + 1 &&
+                            path.compare(0, directoryPath.size() + 1, directoryPath + "/") == 0 &&
+                            path.find('/', directoryPath.size() + 1) == String::npos &&
+                            path.compare(path.size() - 4, 4, ".pak") == 0)
+                            pakPaths.push_back(path);
+                    }
+                    return pakPaths;
+                }
+                
+                MappedFile::Ptr mapPak(const String& path) {
+                    FileMap::const_iterator it = m_files.find(path);
+                    if (it == m_files.end())
+                        return MappedFile::Ptr();
+                    return MappedFile::Ptr(new MemoryFile(it->second));
+                }
+                
+                MappedFile::Ptr mapLooseFile(const String& directoryPath, const String& path) {
+                    return mapPak(directoryPath + "/" + path);
+                }
+            public:
+                void addFile(const String& path, const String& contents) {
+                    m_files[path] = contents;
+                }
+                
+                void removeFile(const String& path) {
+                    m_files.erase(path);
+                }
+            };
+            
+            typedef std::map<String, String> PakEntries;
+            
+            static void appendInt(String& str, int32_t value) {
+                str.append(reinterpret_cast<const char*>(&value), sizeof(value));
+            }
+            
+            static String createPak(const PakEntries& entries) {
+                static const size_t HeaderSize = 12;
+                static const size_t EntrySize = 64;
+                static const size_t NameSize = 56;
+                
+                String data;
+                String directory;
+                PakEntries::const_iterator it, end;
+                for (it = entries.begin(), end = entries.end(); it != end; ++it) {
+                    String name = it->first;
+                    name.resize(NameSize, '\0');
+                    directory += name;
+                    appendInt(directory, static_cast<int32_t>(HeaderSize + data.size()));
+                    appendInt(directory, static_cast<int32_t>(it->second.size()));
+                    data += it->second;
+                }
+                assert(directory.size() == entries.size() * EntrySize);
+                
+                String pak = "PACK";
+                appendInt(pak, static_cast<int32_t>(HeaderSize + data.size()));
+                appendInt(pak, static_cast<int32_t>(directory.size()));
+                return pak + data + directory;
+            }
+            
+            static String contents(MappedFile::Ptr file) {
+                if (file.get() == NULL)
+                    return "";
+                return String(file->begin(), file->end());
+            }
+            
+            StringList m_searchPaths;
+        protected:
+            void registerTestCases() {
+                m_searchPaths.push_back("quake/id1");
+                m_searchPaths.push_back("quake/mod");
+                
+                registerTestCase(&GameFileSystemTest::testOverrideOrder);
+                registerTestCase(&GameFileSystemTest::testLooseFileChanges);
+                registerTestCase(&GameFileSystemTest::testRefresh);
+            }
+        public:
+            void testOverrideOrder() {
+                MemoryFileSystem fileSystem;
+                
+                PakEntries pak0;
+                pak0["progs/a.mdl"] = "id1 pak0 a";
+                pak0["progs/b.mdl"] = "id1 pak0 b";
+                pak0["progs/c.mdl"] = "id1 pak0 c";
+                pak0["progs/d.mdl"] = "id1 pak0 d";
+                pak0["maps/E1M1.bsp"] = "id1 pak0 e1m1";
+                fileSystem.addFile("quake/id1/pak0.pak", createPak(pak0));
+                
+                PakEntries pak1;
+                pak1["progs/b.mdl"] = "id1 pak1 b";
+                fileSystem.addFile("quake/id1/pak1.pak", createPak(pak1));
+                fileSystem.addFile("quake/id1/progs/c.mdl", "id1 loose c");
+                fileSystem.addFile("quake/id1/progs/d.mdl", "id1 loose d");
+                
+                PakEntries modPak;
+                modPak["progs/a.mdl"] = "mod pak0 a";
+                modPak["progs/d.mdl"] = "mod pak0 d";
+                fileSystem.addFile("quake/mod/pak0.pak", createPak(modPak));
+                
+                // paks with higher names override paks with lower names
+                assert(contents(fileSystem.findFile("progs/b.mdl", m_searchPaths)) == "id1 pak1 b");
+                // loose files override the paks in the same search path
+                assert(contents(fileSystem.findFile("progs/c.mdl", m_searchPaths)) == "id1 loose c");
+                // later search paths override earlier ones, even if the earlier one has a loose file
+                assert(contents(fileSystem.findFile("progs/a.mdl", m_searchPaths)) == "mod pak0 a");
+                assert(contents(fileSystem.findFile("progs/d.mdl", m_searchPaths)) == "mod pak0 d");
+                // pak entries are found regardless of case and separator
+                assert(contents(fileSystem.findFile("MAPS\\e1m1.BSP", m_searchPaths)) == "id1 pak0 e1m1");
+                
+                assert(fileSystem.findFile("progs/missing.mdl", m_searchPaths).get() == NULL);
+                
+                StringList id1Only;
+                id1Only.push_back("quake/id1");
+                assert(contents(fileSystem.findFile("progs/a.mdl", id1Only)) == "id1 pak0 a");
+            }
+            
+            void testLooseFileChanges() {
+                MemoryFileSystem fileSystem;
+                
+                PakEntries pak0;
+                pak0["progs/a.mdl"] = "id1 pak0 a";
+                fileSystem.addFile("quake/id1/pak0.pak", createPak(pak0));
+                assert(contents(fileSystem.findFile("progs/a.mdl", m_searchPaths)) == "id1 pak0 a");
+                assert(fileSystem.findFile("progs/b.mdl", m_searchPaths).get() == NULL);
+                
+                // loose files are found as soon as they are added and not after they are removed
+                fileSystem.addFile("quake/mod/progs/a.mdl", "mod loose a");
+                fileSystem.addFile("quake/mod/progs/b.mdl", "mod loose b");
+                assert(contents(fileSystem.findFile("progs/a.mdl", m_searchPaths)) == "mod loose a");
+                assert(contents(fileSystem.findFile("progs/b.mdl", m_searchPaths)) == "mod loose b");
+                
+                fileSystem.removeFile("quake/mod/progs/a.mdl");
+                fileSystem.removeFile("quake/mod/progs/b.mdl");
+                assert(contents(fileSystem.findFile("progs/a.mdl", m_searchPaths)) == "id1 pak0 a");
+                assert(fileSystem.findFile("progs/b.mdl", m_searchPaths).get() == NULL);
+            }
+            
+            void testRefresh() {
+                MemoryFileSystem fileSystem;
+                
+                PakEntries pak0;
+                pak0["progs/a.mdl"] = "id1 pak0 a";
+                fileSystem.addFile("quake/id1/pak0.pak", createPak(pak0));
+                assert(contents(fileSystem.findFile("progs/a.mdl", m_searchPaths)) == "id1 pak0 a");
+                
+                // the pak indices are kept until they are refreshed
+                PakEntries modPak;
+                modPak["progs/a.mdl"] = "mod pak0 a";
+                fileSystem.addFile("quake/mod/pak0.pak", createPak(modPak));
+                assert(contents(fileSystem.findFile("progs/a.mdl", m_searchPaths)) == "id1 pak0 a");
+                
+                fileSystem.refresh();
+                assert(contents(fileSystem.findFile("progs/a.mdl", m_searchPaths)) == "mod pak0 a");
+                
+                // entries that were found before a pak was removed remain readable
+                MappedFile::Ptr file = fileSystem.findFile("progs/a.mdl", m_searchPaths);
+                fileSystem.removeFile("quake/mod/pak0.pak");
+                fileSystem.refresh();
+                assert(contents(file) == "mod pak0 a");
+                assert(contents(fileSystem.findFile("progs/a.mdl", m_searchPaths)) == "id1 pak0 a");
+            }
+        };
+    }
+}
+
+#endif
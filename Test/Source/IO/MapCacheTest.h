@@ -0,0 +1,263 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_MapCacheTest_h
+#define TrenchBroom_MapCacheTest_h
+
+#include "TestSuite.h"
+#include "IO/ByteBuffer.h"
+#include "IO/MapCache.h"
+#include "Model/Brush.h"
+#include "Model/BrushGeometry.h"
+#include "Model/Entity.h"
+#include "Model/EntityProperty.h"
+#include "Model/Face.h"
+#include "Model/Map.h"
+#include "Utility/VecMath.h"
+
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace IO {
+        class MapCacheTest : public TestSuite<MapCacheTest> {
+        private:
+            static const size_t HeaderSize = 40;
+            
+            BBoxf m_worldBounds;
+            String m_mapContents;
+            
+            Model::Brush* addBrush(Model::Entity& entity, const BBoxf& bounds) {
+                Model::Brush* brush = new Model::Brush(m_worldBounds, false, bounds, NULL);
+                const Model::FaceList& faces = brush->faces();
+                for (size_t i = 0; i < faces.size(); i++) {
+                    Model::Face& face = *faces[i];
+                    face.setTextureName(i % 2 == 0 ? "metal1_1" : "wood1_3");
+                    face.setXOffset(static_cast<float>(i) * 8.0f);
+                    face.setYOffset(-4.0f);
+                    face.setRotation(static_cast<float>(i) * 15.0f);
+                    face.setXScale(0.5f);
+                    face.setYScale(2.0f);
+                    face.setFilePosition(10 + i);
+                }
+                entity.addBrush(*brush);
+                return brush;
+            }
+            
+            void createMap(Model::Map& map) {
+                Model::Entity* worldspawn = new Model::Entity(m_worldBounds);
+                worldspawn->setProperty(Model::Entity::ClassnameKey, Model::Entity::WorldspawnClassname);
+                worldspawn->setProperty(Model::Entity::WadKey, "gfx/base.wad");
+                worldspawn->setFilePosition(1, 40);
+                addBrush(*worldspawn, BBoxf(Vec3f(-64.0f, -64.0f, -16.0f), Vec3f(64.0f, 64.0f, 0.0f)));
+                addBrush(*worldspawn, BBoxf(Vec3f(-64.0f, -64.0f, 0.0f), Vec3f(-48.0f, 64.0f, 128.0f)));
+                map.addEntity(*worldspawn);
+                
+                Model::Entity* door = new Model::Entity(m_worldBounds);
+                door->setProperty(Model::Entity::ClassnameKey, "func_door");
+                door->setProperty("targetname", "door1");
+                door->setProperty("angle", "-1");
+                door->setFilePosition(41, 12);
+                addBrush(*door, BBoxf(Vec3f(0.0f, -8.0f, 0.0f), Vec3f(32.0f, 8.0f, 96.0f)));
+                map.addEntity(*door);
+                
+                Model::Entity* light = new Model::Entity(m_worldBounds);
+                light->setProperty(Model::Entity::ClassnameKey, "light");
+                light->setProperty(Model::Entity::OriginKey, "16 16 64");
+                light->setFilePosition(53, 4);
+                map.addEntity(*light);
+            }
+            
+            void write(const Model::Map& map, std::vector<char>& contents) {
+                ByteBuffer buffer;
+                MapCache cache("test.map");
+                const bool success = cache.write(map, mapBegin(), mapEnd(), false, buffer);
+                assert(success);
+                contents.assign(buffer.get(), buffer.get() + buffer.size());
+            }
+            
+            bool read(Model::Map& map, const std::vector<char>& contents) {
+                MapCache cache("test.map");
+                return cache.read(map, mapBegin(), mapEnd(), &contents.front(), &contents.front() + contents.size());
+            }
+            
+            const char* mapBegin() const {
+                return m_mapContents.c_str();
+            }
+            
+            const char* mapEnd() const {
+                return m_mapContents.c_str() + m_mapContents.size();
+            }
+            
+            void assertEqualFaces(const Model::Face& expected, const Model::Face& actual) {
+                for (size_t i = 0; i < 3; i++)
+                    assert(actual.point(i) == expected.point(i));
+                assert(actual.textureName() == expected.textureName());
+                assert(actual.xOffset() == expected.xOffset());
+                assert(actual.yOffset() == expected.yOffset());
+                assert(actual.rotation() == expected.rotation());
+                assert(actual.xScale() == expected.xScale());
+                assert(actual.yScale() == expected.yScale());
+                assert(actual.filePosition() == expected.filePosition());
+                assert(actual.vertices().size() == expected.vertices().size());
+                assert(actual.side() != NULL && actual.side()->face == &actual);
+            }
+            
+            void assertEqualBrushes(const Model::Brush& expected, const Model::Brush& actual) {
+                assert(actual.fileLine() == expected.fileLine());
+                assert(actual.fileLineCount() == expected.fileLineCount());
+                assert(actual.bounds() == expected.bounds());
+                assert(actual.vertices().size() == expected.vertices().size());
+                for (size_t i = 0; i < expected.vertices().size(); i++)
+                    assert(actual.vertices()[i]->position == expected.vertices()[i]->position);
+                assert(actual.edges().size() == expected.edges().size());
+                assert(actual.faces().size() == expected.faces().size());
+                for (size_t i = 0; i < expected.faces().size(); i++) {
+                    assert(actual.faces()[i]->brush() == &actual);
+                    assertEqualFaces(*expected.faces()[i], *actual.faces()[i]);
+                }
+            }
+            
+            void assertEqualEntities(const Model::Entity& expected, const Model::Entity& actual) {
+                assert(actual.fileLine() == expected.fileLine());
+                assert(actual.fileLineCount() == expected.fileLineCount());
+                
+                const Model::PropertyList& expectedProperties = expected.properties();
+                const Model::PropertyList& actualProperties = actual.properties();
+                assert(actualProperties.size() == expectedProperties.size());
+                for (size_t i = 0; i < expectedProperties.size(); i++) {
+                    assert(actualProperties[i].key() == expectedProperties[i].key());
+                    assert(actualProperties[i].value() == expectedProperties[i].value());
+                }
+                
+                assert(actual.brushes().size() == expected.brushes().size());
+                for (size_t i = 0; i < expected.brushes().size(); i++) {
+                    assert(actual.brushes()[i]->entity() == &actual);
+                    assertEqualBrushes(*expected.brushes()[i], *actual.brushes()[i]);
+                }
+            }
+        protected:
+            void registerTestCases() {
+                m_worldBounds = BBoxf(Vec3f(-4096.0f, -4096.0f, -4096.0f), Vec3f(4096.0f, 4096.0f, 4096.0f));
+                m_mapContents = "// the contents of the map file the cache belongs to\n";
+                
+                registerTestCase(&MapCacheTest::testRoundTrip);
+                registerTestCase(&MapCacheTest::testChangedMap);
+                registerTestCase(&MapCacheTest::testChangedVersion);
+                registerTestCase(&MapCacheTest::testCorruptedPayload);
+                registerTestCase(&MapCacheTest::testTruncatedPayload);
+            }
+        public:
+            void testRoundTrip() {
+                Model::Map map(m_worldBounds, false);
+                createMap(map);
+                
+                std::vector<char> contents;
+                write(map, contents);
+                
+                Model::Map restoredMap(m_worldBounds, false);
+                assert(read(restoredMap, contents));
+                assert(restoredMap.entities().size() == map.entities().size());
+                for (size_t i = 0; i < map.entities().size(); i++)
+                    assertEqualEntities(*map.entities()[i], *restoredMap.entities()[i]);
+                
+                // the restored geometry can be edited like parsed geometry
+                Model::Brush& brush = *restoredMap.entities()[0]->brushes()[0];
+                brush.rebuildGeometry();
+                assert(brush.vertices().size() == 8);
+            }
+            
+            void testChangedMap() {
+                Model::Map map(m_worldBounds, false);
+                createMap(map);
+                
+                std::vector<char> contents;
+                write(map, contents);
+                
+                // the cache belongs to a different version of the map file
+                m_mapContents[3] = 'T';
+                Model::Map restoredMap(m_worldBounds, false);
+                const bool success = read(restoredMap, contents);
+                m_mapContents[3] = 't';
+                
+                assert(!success);
+                assert(restoredMap.entities().empty());
+            }
+            
+            void testChangedVersion() {
+                Model::Map map(m_worldBounds, false);
+                createMap(map);
+                
+                std::vector<char> contents;
+                write(map, contents);
+                
+                // the format version follows the four magic bytes
+                uint32_t version;
+                memcpy(&version, &contents[4], sizeof(version));
+                version++;
+                memcpy(&contents[4], &version, sizeof(version));
+                
+                Model::Map restoredMap(m_worldBounds, false);
+                assert(!read(restoredMap, contents));
+                assert(restoredMap.entities().empty());
+            }
+            
+            void testCorruptedPayload() {
+                Model::Map map(m_worldBounds, false);
+                createMap(map);
+                
+                std::vector<char> contents;
+                write(map, contents);
+                
+                for (size_t i = HeaderSize; i < contents.size(); i += 13) {
+                    std::vector<char> corrupted(contents);
+                    corrupted[i] ^= 0x5A;
+                    
+                    Model::Map restoredMap(m_worldBounds, false);
+                    assert(!read(restoredMap, corrupted));
+                    assert(restoredMap.entities().empty());
+                }
+            }
+            
+            void testTruncatedPayload() {
+                Model::Map map(m_worldBounds, false);
+                createMap(map);
+                
+                std::vector<char> contents;
+                write(map, contents);
+                
+                // a payload that is cut off must be rejected even if the header matches it
+                contents.resize(contents.size() - 5);
+                const uint64_t payloadSize = static_cast<uint64_t>(contents.size() - HeaderSize);
+                const MapCache::Hash payloadHash = MapCache::hash(&contents[HeaderSize], &contents.front() + contents.size());
+                memcpy(&contents[24], &payloadSize, sizeof(payloadSize));
+                memcpy(&contents[32], &payloadHash, sizeof(payloadHash));
+                
+                Model::Map restoredMap(m_worldBounds, false);
+                assert(!read(restoredMap, contents));
+                assert(restoredMap.entities().empty());
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,303 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_BrushGeometryTest_h
+#define TrenchBroom_BrushGeometryTest_h
+
+#include "TestSuite.h"
+#include "Model/BrushGeometry.h"
+#include "Model/Face.h"
+#include "Utility/List.h"
+#include "Utility/VecMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Model {
+        class BrushGeometryTest : public TestSuite<BrushGeometryTest> {
+        private:
+            typedef std::vector<FaceList> BrushList;
+
+            BBoxf m_worldBounds;
+            BrushList m_brushes;
+
+            void addFace(FaceList& faces, const Vec3f& normal, const Vec3f& anchor) {
+                const Vec3f axis = std::abs(normal.z()) < 0.9f ? Vec3f::PosZ : Vec3f::PosX;
+                const Vec3f xAxis = crossed(axis, normal).normalized() * 64.0f;
+                const Vec3f yAxis = crossed(normal, xAxis);
+                faces.push_back(new Face(m_worldBounds, false, anchor, anchor + yAxis, anchor + xAxis, ""));
+            }
+
+            void addBox(FaceList& faces, const BBoxf& bounds) {
+                addFace(faces, Vec3f::NegX, bounds.min);
+                addFace(faces, Vec3f::NegY, bounds.min);
+                addFace(faces, Vec3f::NegZ, bounds.min);
+                addFace(faces, Vec3f::PosX, bounds.max);
+                addFace(faces, Vec3f::PosY, bounds.max);
+                addFace(faces, Vec3f::PosZ, bounds.max);
+            }
+
+            void addPrism(FaceList& faces, const Vec3f& center, float radius, float height, size_t sides, float rotation) {
+                for (size_t i = 0; i < sides; i++) {
+                    const float angle = rotation + 2.0f * Math<float>::Pi * static_cast<float>(i) / static_cast<float>(sides);
+                    const Vec3f normal(std::cos(angle), std::sin(angle), 0.0f);
+                    addFace(faces, normal, center + radius * normal);
+                }
+                addFace(faces, Vec3f::NegZ, center);
+                addFace(faces, Vec3f::PosZ, center + height * Vec3f::PosZ);
+            }
+
+            void createCorpus() {
+                FaceList faces;
+
+                // axis aligned blocks like floors, walls and pillars
+                for (size_t i = 0; i < 8; i++) {
+                    const float offset = 128.0f * static_cast<float>(i);
+                    addBox(faces, BBoxf(Vec3f(offset, -offset, 0.0f), Vec3f(offset + 16.0f * (i + 1), 64.0f, 8.0f + 32.0f * i)));
+                    m_brushes.push_back(faces);
+                    faces.clear();
+                }
+
+                // prisms such as rotated blocks and cylinders
+                for (size_t sides = 3; sides <= 16; sides++) {
+                    addPrism(faces, Vec3f(32.0f * sides, 0.0f, -64.0f), 48.0f, 96.0f, sides, 0.0f);
+                    m_brushes.push_back(faces);
+                    faces.clear();
+
+                    addPrism(faces, Vec3f(0.0f, 32.0f * sides, 64.0f), 64.0f, 16.0f, sides, Math<float>::radians(15.0f));
+                    m_brushes.push_back(faces);
+                    faces.clear();
+                }
+
+                // ramps
+                for (size_t i = 1; i < 4; i++) {
+                    addBox(faces, BBoxf(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(128.0f, 64.0f, 64.0f)));
+                    addFace(faces, Vec3f(-static_cast<float>(i), 0.0f, 2.0f).normalized(), Vec3f(0.0f, 0.0f, 16.0f));
+                    m_brushes.push_back(faces);
+                    faces.clear();
+                }
+
+                // pyramids
+                for (size_t i = 1; i < 4; i++) {
+                    const float slope = static_cast<float>(i);
+                    addFace(faces, Vec3f::NegZ, Vec3f::Null);
+                    addFace(faces, Vec3f( slope, 0.0f, 1.0f).normalized(), Vec3f( 64.0f, 0.0f, 0.0f));
+                    addFace(faces, Vec3f(-slope, 0.0f, 1.0f).normalized(), Vec3f(-64.0f, 0.0f, 0.0f));
+                    addFace(faces, Vec3f(0.0f,  slope, 1.0f).normalized(), Vec3f(0.0f,  64.0f, 0.0f));
+                    addFace(faces, Vec3f(0.0f, -slope, 1.0f).normalized(), Vec3f(0.0f, -64.0f, 0.0f));
+                    m_brushes.push_back(faces);
+                    faces.clear();
+                }
+
+                // blocks with beveled edges
+                addBox(faces, BBoxf(Vec3f(-64.0f, -64.0f, -64.0f), Vec3f(64.0f, 64.0f, 64.0f)));
+                for (int x = -1; x <= 1; x++) {
+                    for (int y = -1; y <= 1; y++) {
+                        for (int z = -1; z <= 1; z++) {
+                            if (std::abs(x) + std::abs(y) + std::abs(z) == 2) {
+                                const Vec3f direction(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z));
+                                const Vec3f normal = direction.normalized();
+                                addFace(faces, normal, 56.0f * direction);
+                            }
+                        }
+                    }
+                }
+                m_brushes.push_back(faces);
+                faces.clear();
+
+                // blocks with redundant and duplicate faces
+                addBox(faces, BBoxf(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(64.0f, 64.0f, 64.0f)));
+                addFace(faces, Vec3f(1.0f, 1.0f, 1.0f).normalized(), Vec3f(128.0f, 128.0f, 128.0f));
+                addFace(faces, Vec3f::PosZ, Vec3f(32.0f, 32.0f, 64.0f));
+                m_brushes.push_back(faces);
+                faces.clear();
+            }
+
+            FaceList sortedFaces(const FaceList& faces) {
+                FaceList result = faces;
+                std::sort(result.begin(), result.end(), Face::WeightOrder(Planef::WeightOrder(true)));
+                std::sort(result.begin(), result.end(), Face::WeightOrder(Planef::WeightOrder(false)));
+                return result;
+            }
+        protected:
+            void setup() {
+                m_worldBounds = BBoxf(Vec3f(-8192.0f, -8192.0f, -8192.0f), Vec3f(8192.0f, 8192.0f, 8192.0f));
+                createCorpus();
+            }
+
+            void teardown() {
+                for (size_t i = 0; i < m_brushes.size(); i++)
+                    Utility::deleteAll(m_brushes[i]);
+                m_brushes.clear();
+            }
+
+            void registerTestCases() {
+                registerTestCase(&BrushGeometryTest::testCreateFromFaces);
+                registerTestCase(&BrushGeometryTest::testCreateFromOpenFaces);
+                registerTestCase(&BrushGeometryTest::testTransform);
+                registerTestCase(&BrushGeometryTest::benchmarkCreateFromFaces);
+            }
+        public:
+            void testCreateFromFaces() {
+                for (size_t i = 0; i < m_brushes.size(); i++) {
+                    const FaceList faces = sortedFaces(m_brushes[i]);
+
+                    FaceSet expectedDroppedFaces;
+                    BrushGeometry expected(m_worldBounds);
+                    expected.addFaces(faces, expectedDroppedFaces);
+
+                    FaceSet droppedFaces;
+                    BrushGeometry* actual = BrushGeometry::createFromFaces(m_worldBounds, faces, droppedFaces);
+                    assert(actual != NULL);
+                    assert(droppedFaces == expectedDroppedFaces);
+                    assert(actual->vertices.size() == expected.vertices.size());
+                    assert(actual->edges.size() == expected.edges.size());
+                    assert(actual->sides.size() == expected.sides.size());
+                    assert(actual->bounds.min.equals(expected.bounds.min, 0.01f));
+                    assert(actual->bounds.max.equals(expected.bounds.max, 0.01f));
+
+                    for (size_t j = 0; j < actual->sides.size(); j++) {
+                        const Side& side = *actual->sides[j];
+                        assert(side.face->side() == &side);
+
+                        Vec3f::List positions;
+                        for (size_t k = 0; k < side.vertices.size(); k++) {
+                            positions.push_back(side.vertices[k]->position);
+                            assert(side.edges[k]->startVertex(&side) == side.vertices[k]);
+                        }
+
+                        Side* expectedSide = findSide(expected.sides, positions, 0.01f);
+                        assert(expectedSide != NULL);
+                        assert(expectedSide->face == side.face);
+                    }
+
+                    delete actual;
+                }
+            }
+
+            void testCreateFromOpenFaces() {
+                FaceList faces;
+                addFace(faces, Vec3f::NegX, Vec3f::Null);
+                addFace(faces, Vec3f::PosX, Vec3f(64.0f, 64.0f, 64.0f));
+                addFace(faces, Vec3f::NegY, Vec3f::Null);
+                addFace(faces, Vec3f::PosY, Vec3f(64.0f, 64.0f, 64.0f));
+                addFace(faces, Vec3f::NegZ, Vec3f::Null);
+
+                FaceSet droppedFaces;
+                assert(BrushGeometry::createFromFaces(m_worldBounds, sortedFaces(faces), droppedFaces) == NULL);
+                assert(droppedFaces.empty());
+
+                Utility::deleteAll(faces);
+            }
+
+            void testTransform() {
+                Mat4f::List transforms;
+                transforms.push_back(translationMatrix(Vec3f(64.0f, -32.0f, 16.0f)));
+                transforms.push_back(translationMatrix(Vec3f(16.0f, 0.0f, 8.0f)) * Mat4f::Rot90ZCW);
+                transforms.push_back(Mat4f::Rot180X);
+                transforms.push_back(Mat4f::MirX);
+                transforms.push_back(translationMatrix(Vec3f(0.0f, 128.0f, 0.0f)) * Mat4f::MirZ);
+
+                for (size_t i = 0; i < m_brushes.size(); i++) {
+                    const FaceList faces = sortedFaces(m_brushes[i]);
+
+                    FaceSet droppedFaces;
+                    BrushGeometry actual(m_worldBounds);
+                    actual.addFaces(faces, droppedFaces);
+
+                    for (size_t j = 0; j < transforms.size(); j++) {
+                        const Mat4f& pointTransform = transforms[j];
+                        const Mat4f vectorTransform = translationMatrix(-(pointTransform * Vec3f::Null)) * pointTransform;
+                        const bool invertOrientation = matrixDeterminant(pointTransform) < 0.0f;
+
+                        for (size_t k = 0; k < faces.size(); k++)
+                            faces[k]->transform(pointTransform, vectorTransform, false, invertOrientation);
+                        actual.transform(pointTransform, invertOrientation);
+                        assert(actual.sidesOnBoundaries());
+
+                        FaceSet expectedDroppedFaces;
+                        BrushGeometry expected(m_worldBounds);
+                        expected.addFaces(sortedFaces(faces), expectedDroppedFaces);
+                        assert(actual.vertices.size() == expected.vertices.size());
+                        assert(actual.edges.size() == expected.edges.size());
+                        assert(actual.sides.size() == expected.sides.size());
+                        assert(actual.bounds.min.equals(expected.bounds.min, 0.01f));
+                        assert(actual.bounds.max.equals(expected.bounds.max, 0.01f));
+
+                        for (size_t k = 0; k < actual.sides.size(); k++) {
+                            const Side& side = *actual.sides[k];
+
+                            Vec3f::List positions;
+                            for (size_t l = 0; l < side.vertices.size(); l++) {
+                                positions.push_back(side.vertices[l]->position);
+                                assert(side.edges[l]->startVertex(&side) == side.vertices[l]);
+                            }
+
+                            Side* expectedSide = findSide(expected.sides, positions, 0.01f);
+                            assert(expectedSide != NULL);
+                            assert(expectedSide->face == side.face);
+                        }
+                        actual.restoreFaceSides();
+                    }
+                }
+            }
+
+            void benchmarkCreateFromFaces() {
+                static const size_t Iterations = 100;
+
+                std::vector<FaceList> sorted;
+                for (size_t i = 0; i < m_brushes.size(); i++)
+                    sorted.push_back(sortedFaces(m_brushes[i]));
+
+                clock_t start = clock();
+                for (size_t i = 0; i < Iterations; i++) {
+                    for (size_t j = 0; j < sorted.size(); j++) {
+                        FaceSet droppedFaces;
+                        BrushGeometry geometry(m_worldBounds);
+                        geometry.addFaces(sorted[j], droppedFaces);
+                    }
+                }
+                const clock_t incremental = clock() - start;
+
+                start = clock();
+                for (size_t i = 0; i < Iterations; i++) {
+                    for (size_t j = 0; j < sorted.size(); j++) {
+                        FaceSet droppedFaces;
+                        delete BrushGeometry::createFromFaces(m_worldBounds, sorted[j], droppedFaces);
+                    }
+                }
+                const clock_t direct = clock() - start;
+
+                std::printf("BrushGeometry: built %lu brushes %lu times, incremental: %.1f ms, direct: %.1f ms\n",
+                            static_cast<unsigned long>(sorted.size()),
+                            static_cast<unsigned long>(Iterations),
+                            1000.0 * incremental / CLOCKS_PER_SEC,
+                            1000.0 * direct / CLOCKS_PER_SEC);
+            }
+        };
+    }
+}
+
+#endif
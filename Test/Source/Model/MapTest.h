@@ -0,0 +1,169 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_MapTest_h
+#define TrenchBroom_MapTest_h
+
+#include "TestSuite.h"
+#include "Model/Brush.h"
+#include "Model/Entity.h"
+#include "Model/Face.h"
+#include "Model/Map.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace TrenchBroom {
+    namespace Model {
+        class MapTest : public TestSuite<MapTest> {
+        protected:
+            BBoxf m_worldBounds;
+
+            Entity* createEntity(const String& classname) {
+                Entity* entity = new Entity(m_worldBounds);
+                entity->setProperty(Entity::ClassnameKey, classname);
+                return entity;
+            }
+
+            bool contains(const EntityList& entities, const Entity* entity) {
+                return std::find(entities.begin(), entities.end(), entity) != entities.end();
+            }
+
+            bool contains(const FaceList& faces, const Face* face) {
+                return std::find(faces.begin(), faces.end(), face) != faces.end();
+            }
+
+            Brush* addBrush(Entity& entity, const BBoxf& bounds, const String& textureName) {
+                Brush* brush = new Brush(m_worldBounds, false, bounds, NULL);
+                const FaceList& faces = brush->faces();
+                for (size_t i = 0; i < faces.size(); i++)
+                    faces[i]->setTextureName(textureName);
+                entity.addBrush(*brush);
+                return brush;
+            }
+
+            void registerTestCases() {
+                m_worldBounds = BBoxf(Vec3f(-4096.0f, -4096.0f, -4096.0f), Vec3f(4096.0f, 4096.0f, 4096.0f));
+
+                registerTestCase(&MapTest::testEntityPropertyIndex);
+                registerTestCase(&MapTest::testFaceTextureIndex);
+            }
+        public:
+            void testEntityPropertyIndex() {
+                Map map(m_worldBounds, false);
+
+                Entity* light = createEntity("light");
+                light->setProperty(Entity::OriginKey, "0 0 0");
+                light->setProperty(Entity::TargetnameKey, "t1");
+                map.addEntity(*light);
+
+                Entity* door = createEntity("func_door");
+                door->setProperty(Entity::TargetKey, "t1");
+                door->setProperty(Entity::SpawnFlagsKey, "256");
+                map.addEntity(*door);
+
+                assert(map.entitiesWithProperty(Entity::ClassnameKey, "light").size() == 1);
+                assert(contains(map.entitiesWithProperty(Entity::ClassnameKey, "light"), light));
+                assert(contains(map.entitiesWithFlag(Entity::SpawnFlagsKey, 256), door));
+                assert(contains(map.entitiesWithProperty(Entity::TargetKey, "t1"), door));
+
+                // values that are unique to an entity are not indexed
+                assert(map.entitiesWithProperty(Entity::OriginKey) == NULL);
+                assert(map.entitiesWithProperty(Entity::OriginKey, "0 0 0").empty());
+
+                // set
+                light->setProperty(Entity::ClassnameKey, "light_torch");
+                assert(map.entitiesWithProperty(Entity::ClassnameKey, "light").empty());
+                assert(contains(map.entitiesWithProperty(Entity::ClassnameKey, "light_torch"), light));
+
+                door->setProperty(Entity::SpawnFlagsKey, "1");
+                assert(!contains(map.entitiesWithFlag(Entity::SpawnFlagsKey, 256), door));
+                assert(contains(map.entitiesWithFlag(Entity::SpawnFlagsKey, 1), door));
+
+                // rename
+                door->renameProperty(Entity::TargetKey, Entity::TargetnameKey);
+                assert(map.entitiesWithProperty(Entity::TargetKey) == NULL);
+                assert(map.entitiesWithProperty(Entity::TargetnameKey, "t1").size() == 2);
+
+                light->renameProperty(Entity::TargetnameKey, Entity::MessageKey);
+                assert(map.entitiesWithProperty(Entity::TargetnameKey, "t1").size() == 1);
+                assert(contains(map.entitiesWithProperty(Entity::TargetnameKey, "t1"), door));
+                assert(map.entitiesWithProperty(Entity::MessageKey) == NULL);
+
+                // remove
+                door->removeProperty(Entity::TargetnameKey);
+                assert(map.entitiesWithProperty(Entity::TargetnameKey) == NULL);
+
+                map.removeEntity(*light);
+                assert(map.entitiesWithProperty(Entity::ClassnameKey, "light_torch").empty());
+                assert(map.entitiesWithProperty(Entity::ClassnameKey, "func_door").size() == 1);
+                delete light;
+
+                // the map deletes the remaining entities
+            }
+
+            void testFaceTextureIndex() {
+                Map map(m_worldBounds, false);
+
+                // faces are indexed when their entity is added to the map
+                Entity* worldspawn = createEntity(Entity::WorldspawnClassname);
+                Brush* brush1 = addBrush(*worldspawn, BBoxf(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(64.0f, 64.0f, 64.0f)), "METAL1_1");
+                assert(map.facesWithTexture("metal1_1").empty());
+                map.addEntity(*worldspawn);
+
+                const size_t faceCount = brush1->faces().size();
+                assert(map.facesWithTexture("metal1_1").size() == faceCount);
+                assert(map.facesWithTexture("METAL1_1").size() == faceCount);
+                assert(map.facesWithTexture().size() == 1);
+
+                // and when their brush is added to an entity in the map
+                Brush* brush2 = addBrush(*worldspawn, BBoxf(Vec3f(128.0f, 0.0f, 0.0f), Vec3f(192.0f, 32.0f, 16.0f)), "sky1");
+                assert(map.facesWithTexture("sky1").size() == brush2->faces().size());
+                assert(map.facesWithTexture().size() == 2);
+
+                // changing the texture name moves the face to another bucket
+                Face* face = brush1->faces()[0];
+                face->setTextureName("sky1");
+                assert(map.facesWithTexture("metal1_1").size() == faceCount - 1);
+                assert(!contains(map.facesWithTexture("metal1_1"), face));
+                assert(contains(map.facesWithTexture("sky1"), face));
+
+                // changing only the case keeps the face in its bucket
+                face->setTextureName("SKY1");
+                assert(contains(map.facesWithTexture("sky1"), face));
+                assert(map.facesWithTexture("sky1").size() == brush2->faces().size() + 1);
+
+                // removing the brush from its entity removes its faces
+                worldspawn->removeBrush(*brush2);
+                assert(map.facesWithTexture("sky1").size() == 1);
+                delete brush2;
+
+                // removing the entity removes all of its faces
+                map.removeEntity(*worldspawn);
+                assert(map.facesWithTexture().empty());
+
+                map.addEntity(*worldspawn);
+                assert(map.facesWithTexture("metal1_1").size() == faceCount - 1);
+                assert(map.facesWithTexture("sky1").size() == 1);
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,297 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_EdgeRendererTest_h
+#define TrenchBroom_EdgeRendererTest_h
+
+#include "TestSuite.h"
+#include "Model/Brush.h"
+#include "Model/BrushGeometry.h"
+#include "Model/Entity.h"
+#include "Model/EntityDefinition.h"
+#include "Renderer/EdgeRenderer.h"
+#include "Renderer/FakeGL.h"
+#include "Renderer/Vbo.h"
+#include "Utility/Color.h"
+#include "Utility/VecMath.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Renderer {
+        class EdgeRendererTest : public TestSuite<EdgeRendererTest> {
+        private:
+            static const size_t CubeEdgeCount = 12;
+            static const size_t ColoredVertexSize = 7 * sizeof(float);
+            
+            typedef std::pair<Vec3f, Vec3f> EdgePositions;
+            typedef std::vector<EdgePositions> EdgePositionsList;
+            
+            BBoxf m_worldBounds;
+            
+            static bool lexicographicLess(const Vec3f& lhs, const Vec3f& rhs) {
+                if (lhs.x() != rhs.x())
+                    return lhs.x() < rhs.x();
+                if (lhs.y() != rhs.y())
+                    return lhs.y() < rhs.y();
+                return lhs.z() < rhs.z();
+            }
+            
+            static bool edgeLess(const EdgePositions& lhs, const EdgePositions& rhs) {
+                if (lhs.first != rhs.first)
+                    return lexicographicLess(lhs.first, rhs.first);
+                return lexicographicLess(lhs.second, rhs.second);
+            }
+            
+            static EdgePositions makeEdge(const Vec3f& start, const Vec3f& end) {
+                return lexicographicLess(start, end) ? EdgePositions(start, end) : EdgePositions(end, start);
+            }
+            
+            Model::Brush* addBrush(Model::Entity& entity, const BBoxf& bounds) {
+                Model::Brush* brush = new Model::Brush(m_worldBounds, false, bounds, NULL);
+                entity.addBrush(*brush);
+                return brush;
+            }
+            
+            /**
+             * Counts the vertices of the given edge renderer that have the given color.
+             */
+            size_t countVertices(const EdgeRenderer& renderer, const Color& color) {
+                Vbo& vbo = const_cast<Vbo&>(*renderer.vbo());
+                SetVboState mapVbo(vbo, Vbo::VboMapped);
+                
+                // the VBO is mapped, so its buffer is bound
+                const FakeGL::Buffer& buffer = FakeGL::buffers()[FakeGL::boundBuffer()];
+                size_t count = 0;
+                for (size_t offset = 0; offset + ColoredVertexSize <= buffer.size(); offset += ColoredVertexSize) {
+                    float values[4];
+                    memcpy(values, &buffer[offset + 3 * sizeof(float)], sizeof(values));
+                    if (Color(values[0], values[1], values[2], values[3]) == color)
+                        count++;
+                }
+                return count;
+            }
+            
+            /**
+             * Returns the edges that are stored in the allocated blocks of the given edge renderer, sorted. The VBO is
+             * packed first so that the allocated blocks are at its start, which moves the blocks of the renderer
+             * behind its back, so the renderer must not be rendered afterwards.
+             */
+            EdgePositionsList storedEdges(const EdgeRenderer& renderer) {
+                Vbo& vbo = const_cast<Vbo&>(*renderer.vbo());
+                SetVboState mapVbo(vbo, Vbo::VboMapped);
+                vbo.pack();
+                
+                const FakeGL::Buffer& buffer = FakeGL::buffers()[FakeGL::boundBuffer()];
+                const size_t usedBytes = vbo.totalCapacity() - vbo.freeCapacity();
+                assert(usedBytes % (2 * ColoredVertexSize) == 0);
+                
+                EdgePositionsList edges;
+                for (size_t offset = 0; offset < usedBytes; offset += 2 * ColoredVertexSize) {
+                    Vec3f start, end;
+                    memcpy(&start, &buffer[offset], sizeof(Vec3f));
+                    memcpy(&end, &buffer[offset + ColoredVertexSize], sizeof(Vec3f));
+                    edges.push_back(makeEdge(start, end));
+                }
+                std::sort(edges.begin(), edges.end(), edgeLess);
+                return edges;
+            }
+            
+            EdgePositionsList brushEdges(const Model::BrushList& brushes) {
+                EdgePositionsList edges;
+                for (size_t i = 0; i < brushes.size(); i++) {
+                    const Model::EdgeList& brushEdges = brushes[i]->edges();
+                    for (size_t j = 0; j < brushEdges.size(); j++)
+                        edges.push_back(makeEdge(brushEdges[j]->start->position, brushEdges[j]->end->position));
+                }
+                std::sort(edges.begin(), edges.end(), edgeLess);
+                edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+                return edges;
+            }
+            
+            void translate(Model::Brush& brush, const Vec3f& delta) {
+                brush.transform(translationMatrix(delta), Mat4f::Identity, false, false);
+            }
+            
+            std::vector<unsigned char> bufferContents(const EdgeRenderer& renderer) {
+                Vbo& vbo = const_cast<Vbo&>(*renderer.vbo());
+                SetVboState mapVbo(vbo, Vbo::VboMapped);
+                return FakeGL::buffers()[FakeGL::boundBuffer()];
+            }
+        protected:
+            void registerTestCases() {
+                m_worldBounds = BBoxf(Vec3f(-4096.0f, -4096.0f, -4096.0f), Vec3f(4096.0f, 4096.0f, 4096.0f));
+                
+                registerTestCase(&EdgeRendererTest::testSharedEdges);
+                registerTestCase(&EdgeRendererTest::testInvalidateBrushes);
+                registerTestCase(&EdgeRendererTest::testReloadDefinitions);
+            }
+        public:
+            void testSharedEdges() {
+                Model::Entity* worldspawn = new Model::Entity(m_worldBounds);
+                worldspawn->setProperty(Model::Entity::ClassnameKey, Model::Entity::WorldspawnClassname);
+                
+                // the cubes touch at x = 64, where they share four edges
+                Model::Brush* left = addBrush(*worldspawn, BBoxf(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(64.0f, 64.0f, 64.0f)));
+                Model::Brush* right = addBrush(*worldspawn, BBoxf(Vec3f(64.0f, 0.0f, 0.0f), Vec3f(128.0f, 64.0f, 64.0f)));
+                Model::BrushList brushes;
+                brushes.push_back(left);
+                brushes.push_back(right);
+                
+                EdgeRenderer renderer(Color(1.0f, 1.0f, 1.0f, 1.0f));
+                renderer.setBrushes(brushes);
+                renderer.validate();
+                
+                const size_t sharedEdgeCount = 4;
+                EdgePositionsList edges = storedEdges(renderer);
+                assert(edges.size() == 2 * CubeEdgeCount - sharedEdgeCount);
+                assert(edges == brushEdges(brushes));
+                
+                // moving the owner of the shared edges away passes them on to the other cube
+                translate(*left, Vec3f(-128.0f, 0.0f, 0.0f));
+                renderer.invalidateBrushes(Model::BrushList(1, left));
+                renderer.validate();
+                edges = storedEdges(renderer);
+                assert(edges.size() == 2 * CubeEdgeCount);
+                assert(edges == brushEdges(brushes));
+                
+                // moving it back shares the edges again
+                translate(*left, Vec3f(128.0f, 0.0f, 0.0f));
+                renderer.invalidateBrushes(Model::BrushList(1, left));
+                renderer.validate();
+                edges = storedEdges(renderer);
+                assert(edges.size() == 2 * CubeEdgeCount - sharedEdgeCount);
+                assert(edges == brushEdges(brushes));
+                
+                // removing either cube leaves all edges of the other one
+                for (size_t i = 0; i < 2; i++) {
+                    renderer.setBrushes(Model::BrushList(1, brushes[i]));
+                    renderer.validate();
+                    edges = storedEdges(renderer);
+                    assert(edges.size() == CubeEdgeCount);
+                    assert(edges == brushEdges(Model::BrushList(1, brushes[i])));
+                    
+                    renderer.setBrushes(brushes);
+                    renderer.validate();
+                    assert(storedEdges(renderer).size() == 2 * CubeEdgeCount - sharedEdgeCount);
+                }
+                
+                delete worldspawn;
+            }
+            
+            void testInvalidateBrushes() {
+                Model::Entity* worldspawn = new Model::Entity(m_worldBounds);
+                worldspawn->setProperty(Model::Entity::ClassnameKey, Model::Entity::WorldspawnClassname);
+                
+                Model::BrushList brushes;
+                for (size_t i = 0; i < 3; i++) {
+                    const float x = 128.0f * i;
+                    brushes.push_back(addBrush(*worldspawn, BBoxf(Vec3f(x, 0.0f, 0.0f), Vec3f(x + 64.0f, 64.0f, 64.0f))));
+                }
+                
+                EdgeRenderer renderer(Color(1.0f, 1.0f, 1.0f, 1.0f));
+                renderer.setBrushes(brushes);
+                renderer.validate();
+                
+                Vbo& vbo = const_cast<Vbo&>(*renderer.vbo());
+                const size_t blockSize = 2 * CubeEdgeCount * ColoredVertexSize;
+                const size_t usedBytes = vbo.totalCapacity() - vbo.freeCapacity();
+                assert(usedBytes == 3 * blockSize);
+                
+                const std::vector<unsigned char> before = bufferContents(renderer);
+                vbo.resetWrittenBytes();
+                vbo.resetCounters();
+                
+                // moving the middle cube rewrites its block in place and nothing else
+                translate(*brushes[1], Vec3f(0.0f, 0.0f, 32.0f));
+                renderer.invalidateBrushes(Model::BrushList(1, brushes[1]));
+                renderer.validate();
+                
+                assert(vbo.writtenBytes() == blockSize);
+                assert(vbo.counters().allocations == 0);
+                assert(vbo.counters().frees == 0);
+                assert(vbo.counters().movedBlocks == 0);
+                assert(vbo.totalCapacity() - vbo.freeCapacity() == usedBytes);
+                
+                const std::vector<unsigned char> after = bufferContents(renderer);
+                assert(after.size() == before.size());
+                size_t firstChange = after.size();
+                size_t lastChange = 0;
+                for (size_t i = 0; i < after.size(); i++) {
+                    if (after[i] != before[i]) {
+                        firstChange = std::min(firstChange, i);
+                        lastChange = i;
+                    }
+                }
+                
+                // all changes are within one block, so the blocks of the other cubes kept their addresses and data
+                assert(firstChange < after.size());
+                assert(firstChange / blockSize == lastChange / blockSize);
+                
+                delete worldspawn;
+            }
+            
+            void testReloadDefinitions() {
+                const Color defaultColor(0.5f, 0.5f, 0.5f, 1.0f);
+                const Color oldColor(1.0f, 0.0f, 0.0f, 1.0f);
+                const Color newColor(0.0f, 0.0f, 1.0f, 1.0f);
+                
+                Model::BrushEntityDefinition* oldDefinition = new Model::BrushEntityDefinition("func_door", oldColor, "", Model::PropertyDefinition::List());
+                Model::BrushEntityDefinition* newDefinition = new Model::BrushEntityDefinition("func_door", newColor, "", Model::PropertyDefinition::List());
+                
+                Model::Entity* worldspawn = new Model::Entity(m_worldBounds);
+                worldspawn->setProperty(Model::Entity::ClassnameKey, Model::Entity::WorldspawnClassname);
+                Model::Entity* door = new Model::Entity(m_worldBounds);
+                door->setProperty(Model::Entity::ClassnameKey, "func_door");
+                door->setDefinition(oldDefinition);
+                
+                Model::BrushList brushes;
+                brushes.push_back(addBrush(*worldspawn, BBoxf(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(64.0f, 64.0f, 64.0f))));
+                brushes.push_back(addBrush(*door, BBoxf(Vec3f(128.0f, 0.0f, 0.0f), Vec3f(192.0f, 64.0f, 64.0f))));
+                
+                EdgeRenderer renderer(defaultColor);
+                renderer.setBrushes(brushes);
+                renderer.validate();
+                assert(countVertices(renderer, defaultColor) == 2 * CubeEdgeCount);
+                assert(countVertices(renderer, oldColor) == 2 * CubeEdgeCount);
+                
+                // reloading the definitions replaces the definitions of all entities
+                door->setDefinition(newDefinition);
+                renderer.invalidateAll();
+                renderer.validate();
+                assert(countVertices(renderer, defaultColor) == 2 * CubeEdgeCount);
+                assert(countVertices(renderer, oldColor) == 0);
+                assert(countVertices(renderer, newColor) == 2 * CubeEdgeCount);
+                
+                delete door;
+                delete worldspawn;
+                delete oldDefinition;
+                delete newDefinition;
+            }
+        };
+    }
+}
+
+#endif
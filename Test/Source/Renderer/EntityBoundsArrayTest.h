@@ -0,0 +1,187 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_EntityBoundsArrayTest_h
+#define TrenchBroom_EntityBoundsArrayTest_h
+
+#include "TestSuite.h"
+#include "Model/Entity.h"
+#include "Model/Filter.h"
+#include "Renderer/EntityBoundsArray.h"
+#include "Renderer/FakeGL.h"
+#include "Renderer/Vbo.h"
+#include "Utility/List.h"
+#include "Utility/VecMath.h"
+
+#include <cassert>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Renderer {
+        class EntityBoundsArrayTest : public TestSuite<EntityBoundsArrayTest> {
+        private:
+            class ShowAllFilter : public Model::Filter {
+            public:
+                bool entityVisible(const Model::Entity& entity) const { return true; }
+                bool entityPickable(const Model::Entity& entity) const { return true; }
+                bool brushVisible(const Model::Brush& brush) const { return true; }
+                bool brushPickable(const Model::Brush& brush) const { return true; }
+                bool brushVerticesPickable(const Model::Brush& brush) const { return true; }
+            };
+            
+            static const size_t EntityCount = 2000;
+            static const size_t VertexCount = 24;
+            static const size_t ColoredVertexSize = 7 * sizeof(float);
+            static const size_t VertexSize = 3 * sizeof(float);
+            
+            BBoxf m_worldBounds;
+            Model::EntityList m_entities;
+            ShowAllFilter m_filter;
+        protected:
+            void registerTestCases() {
+                registerTestCase(&EntityBoundsArrayTest::testWriteAddedEntities);
+                registerTestCase(&EntityBoundsArrayTest::testWriteChangedEntities);
+                registerTestCase(&EntityBoundsArrayTest::testRemoveEntities);
+                registerTestCase(&EntityBoundsArrayTest::testChangeVertexFormat);
+            }
+            
+            void setup() {
+                m_worldBounds = BBoxf(Vec3f(-8192.0f, -8192.0f, -8192.0f), Vec3f(8192.0f, 8192.0f, 8192.0f));
+                for (size_t i = 0; i < EntityCount; i++) {
+                    Model::Entity* entity = new Model::Entity(m_worldBounds);
+                    entity->setProperty(Model::Entity::ClassnameKey, "info_null");
+                    entity->setProperty(Model::Entity::OriginKey, Vec3f(static_cast<float>(i % 64) * 64.0f, static_cast<float>(i / 64) * 64.0f, 0.0f), true);
+                    m_entities.push_back(entity);
+                }
+            }
+            
+            void teardown() {
+                Utility::deleteAll(m_entities);
+            }
+            
+            void addAll(EntityBoundsArray& array) {
+                Model::EntityList::const_iterator it, end;
+                for (it = m_entities.begin(), end = m_entities.end(); it != end; ++it)
+                    array.addEntity(**it);
+            }
+            
+            void moveEntity(Model::Entity& entity, const Vec3f& delta) {
+                entity.setProperty(Model::Entity::OriginKey, entity.origin() + delta, true);
+            }
+        public:
+            void testWriteAddedEntities() {
+                EntityBoundsArray array;
+                addAll(array);
+                array.validate(m_filter);
+                
+                assert(array.vbo() != NULL);
+                assert(array.vbo()->writtenBytes() == EntityCount * VertexCount * ColoredVertexSize);
+                
+                // nothing changed, so nothing is written
+                const size_t writtenBytes = array.vbo()->writtenBytes();
+                array.invalidateVisibility();
+                array.validate(m_filter);
+                assert(array.vbo()->writtenBytes() == writtenBytes);
+            }
+            
+            void testWriteChangedEntities() {
+                EntityBoundsArray array;
+                addAll(array);
+                array.validate(m_filter);
+                
+                Vbo& vbo = const_cast<Vbo&>(*array.vbo());
+                vbo.resetWrittenBytes();
+                
+                Model::Entity& entity = *m_entities[EntityCount / 2];
+                moveEntity(entity, Vec3f(16.0f, 0.0f, 0.0f));
+                array.invalidateEntity(entity);
+                array.validate(m_filter);
+                assert(vbo.writtenBytes() == VertexCount * ColoredVertexSize);
+                
+                vbo.resetWrittenBytes();
+                Model::EntityList changedEntities;
+                for (size_t i = 0; i < 10; i++) {
+                    Model::Entity& changedEntity = *m_entities[i * 7];
+                    moveEntity(changedEntity, Vec3f(0.0f, 16.0f, 0.0f));
+                    changedEntities.push_back(&changedEntity);
+                }
+                array.invalidateEntities(changedEntities);
+                array.validate(m_filter);
+                assert(vbo.writtenBytes() == changedEntities.size() * VertexCount * ColoredVertexSize);
+                
+                vbo.resetWrittenBytes();
+                array.invalidateAll();
+                array.validate(m_filter);
+                assert(vbo.writtenBytes() == EntityCount * VertexCount * ColoredVertexSize);
+            }
+            
+            void testRemoveEntities() {
+                EntityBoundsArray array;
+                addAll(array);
+                array.validate(m_filter);
+                
+                Vbo& vbo = const_cast<Vbo&>(*array.vbo());
+                vbo.resetWrittenBytes();
+                
+                for (size_t i = 0; i < EntityCount; i += 2)
+                    array.removeEntity(*m_entities[i]);
+                array.validate(m_filter);
+                assert(vbo.writtenBytes() == 0);
+                
+                // re-added entities reuse the freed blocks
+                array.addEntity(*m_entities[0]);
+                array.addEntity(*m_entities[2]);
+                array.validate(m_filter);
+                assert(vbo.writtenBytes() == 2 * VertexCount * ColoredVertexSize);
+                
+                // invalidating a removed entity has no effect
+                vbo.resetWrittenBytes();
+                array.invalidateEntity(*m_entities[4]);
+                array.validate(m_filter);
+                assert(vbo.writtenBytes() == 0);
+                
+                array.clear();
+                array.validate(m_filter);
+                assert(vbo.writtenBytes() == 0);
+            }
+            
+            void testChangeVertexFormat() {
+                EntityBoundsArray array;
+                addAll(array);
+                array.setColored(false);
+                array.validate(m_filter);
+                assert(array.vbo()->writtenBytes() == EntityCount * VertexCount * VertexSize);
+                
+                // the default color only affects colored bounds
+                Vbo& vbo = const_cast<Vbo&>(*array.vbo());
+                vbo.resetWrittenBytes();
+                array.setDefaultColor(Color(1.0f, 0.0f, 0.0f, 1.0f));
+                array.validate(m_filter);
+                assert(vbo.writtenBytes() == 0);
+                
+                array.setColored(true);
+                array.validate(m_filter);
+                assert(array.vbo()->writtenBytes() == EntityCount * VertexCount * ColoredVertexSize);
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,116 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FakeGL.h"
+
+#include "Renderer/Shader/ShaderManager.h"
+#include "Renderer/Shader/ShaderProgram.h"
+
+#include <cassert>
+
+namespace TrenchBroom {
+    namespace FakeGL {
+        BufferMap& buffers() {
+            static BufferMap buffers;
+            return buffers;
+        }
+        
+        GLuint& boundBuffer() {
+            static GLuint buffer = 0;
+            return buffer;
+        }
+        
+        static GLuint nextBufferId = 1;
+        
+        static void GLAPIENTRY genBuffers(GLsizei n, GLuint* ids) {
+            for (GLsizei i = 0; i < n; i++) {
+                ids[i] = nextBufferId++;
+                buffers()[ids[i]];
+            }
+        }
+        
+        static void GLAPIENTRY deleteBuffers(GLsizei n, const GLuint* ids) {
+            for (GLsizei i = 0; i < n; i++)
+                buffers().erase(ids[i]);
+        }
+        
+        static void GLAPIENTRY bindBuffer(GLenum target, GLuint buffer) {
+            boundBuffer() = buffer;
+        }
+        
+        static void GLAPIENTRY bufferData(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage) {
+            buffers()[boundBuffer()].assign(static_cast<size_t>(size), 0);
+        }
+        
+        static GLvoid* GLAPIENTRY mapBuffer(GLenum target, GLenum access) {
+            Buffer& buffer = buffers()[boundBuffer()];
+            return buffer.empty() ? NULL : &buffer.front();
+        }
+        
+        static GLboolean GLAPIENTRY unmapBuffer(GLenum target) {
+            return GL_TRUE;
+        }
+        
+        static void GLAPIENTRY multiDrawArrays(GLenum mode, const GLint* first, const GLsizei* count, GLsizei primcount) {}
+    }
+}
+
+PFNGLGENBUFFERSPROC __glewGenBuffers = &TrenchBroom::FakeGL::genBuffers;
+PFNGLDELETEBUFFERSPROC __glewDeleteBuffers = &TrenchBroom::FakeGL::deleteBuffers;
+PFNGLBINDBUFFERPROC __glewBindBuffer = &TrenchBroom::FakeGL::bindBuffer;
+PFNGLBUFFERDATAPROC __glewBufferData = &TrenchBroom::FakeGL::bufferData;
+PFNGLMAPBUFFERPROC __glewMapBuffer = &TrenchBroom::FakeGL::mapBuffer;
+PFNGLUNMAPBUFFERPROC __glewUnmapBuffer = &TrenchBroom::FakeGL::unmapBuffer;
+PFNGLMULTIDRAWARRAYSPROC __glewMultiDrawArrays = &TrenchBroom::FakeGL::multiDrawArrays;
+
+extern "C" {
+    GLenum GLAPIENTRY glGetError() {
+        return GL_NO_ERROR;
+    }
+    
+    void GLAPIENTRY glEnableClientState(GLenum array) {}
+    void GLAPIENTRY glDisableClientState(GLenum array) {}
+    void GLAPIENTRY glVertexPointer(GLint size, GLenum type, GLsizei stride, const GLvoid* pointer) {}
+    void GLAPIENTRY glColorPointer(GLint size, GLenum type, GLsizei stride, const GLvoid* pointer) {}
+}
+
+namespace TrenchBroom {
+    namespace Renderer {
+        // the renderers under test are validated, but never rendered, so their shaders only have to link
+        namespace Shaders {
+            const ShaderConfig ColoredEdgeShader = ShaderConfig("Colored Edge Shader Program", "ColoredEdge.vertsh", "Edge.fragsh");
+            const ShaderConfig EdgeShader = ShaderConfig("Edge Shader Program", "Edge.vertsh", "Edge.fragsh");
+        }
+        
+        ShaderProgram& ShaderManager::shaderProgram(const ShaderConfig& config) {
+            assert(false);
+            return *m_programs[&config];
+        }
+        
+        bool ShaderProgram::activate() {
+            return false;
+        }
+        
+        void ShaderProgram::deactivate() {}
+        
+        bool ShaderProgram::setUniformVariable(const String& name, const Vec4f& value) {
+            return false;
+        }
+    }
+}
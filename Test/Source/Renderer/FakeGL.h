@@ -0,0 +1,45 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_FakeGL_h
+#define TrenchBroom_FakeGL_h
+
+#include <GL/glew.h>
+
+#include <map>
+#include <vector>
+
+/*
+ Minimal client side implementations of the OpenGL functions used by Renderer::Vbo and the renderers under test, so
+ that they can be tested without an OpenGL context. Buffer objects are backed by plain memory, drawing does nothing.
+ The GLEW function pointers and GL entry points are defined in FakeGL.cpp, so the test target must not link against
+ GLEW or an OpenGL library. FakeGL.cpp also stubs the shader functions that the renderers under test refer to.
+ */
+
+namespace TrenchBroom {
+    namespace FakeGL {
+        typedef std::vector<unsigned char> Buffer;
+        typedef std::map<GLuint, Buffer> BufferMap;
+        
+        BufferMap& buffers();
+        GLuint& boundBuffer();
+    }
+}
+
+#endif
@@ -0,0 +1,337 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_VboTest_h
+#define TrenchBroom_VboTest_h
+
+#include "TestSuite.h"
+#include "Renderer/FakeGL.h"
+#include "Renderer/RenderStatistics.h"
+#include "Renderer/Vbo.h"
+#include "Utility/VecMath.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Renderer {
+        class VboTest : public TestSuite<VboTest> {
+        private:
+            class Allocation {
+            public:
+                VboBlock* block;
+                unsigned char pattern;
+                
+                Allocation(VboBlock* i_block, unsigned char i_pattern) :
+                block(i_block),
+                pattern(i_pattern) {}
+            };
+            
+            typedef std::vector<Allocation> AllocationList;
+            
+            static const size_t Granularity = 12;
+            
+            unsigned int m_seed;
+            
+            unsigned int next() {
+                m_seed = m_seed * 1103515245 + 12345;
+                return (m_seed >> 16) & 0x7FFF;
+            }
+            
+            void allocate(Vbo& vbo, size_t capacity, AllocationList& allocations) {
+                const unsigned char pattern = static_cast<unsigned char>(allocations.size() % 251 + 1);
+                VboBlock* block = vbo.allocBlock(capacity);
+                const std::vector<unsigned char> buffer(capacity, pattern);
+                block->writeBuffer(&buffer.front(), 0, capacity);
+                allocations.push_back(Allocation(block, pattern));
+            }
+            
+            void free(size_t index, AllocationList& allocations) {
+                allocations[index].block->freeBlock();
+                allocations[index] = allocations.back();
+                allocations.pop_back();
+            }
+            
+            /**
+             * Replays a trace of allocations and frees of random sizes that leaves the VBO fragmented.
+             */
+            void replayTrace(Vbo& vbo, size_t operationCount, AllocationList& allocations) {
+                m_seed = 1;
+                for (size_t i = 0; i < operationCount; i++) {
+                    if (allocations.empty() || next() % 3 != 0)
+                        allocate(vbo, Granularity * (1 + next() % 64), allocations);
+                    else
+                        free(next() % allocations.size(), allocations);
+                }
+            }
+            
+            void checkContents(const AllocationList& allocations) {
+                // the VBO under test is mapped, so its buffer is bound
+                const FakeGL::Buffer& buffer = FakeGL::buffers()[FakeGL::boundBuffer()];
+                AllocationList::const_iterator it, end;
+                for (it = allocations.begin(), end = allocations.end(); it != end; ++it) {
+                    const VboBlock& block = *it->block;
+                    assert(!block.free());
+                    assert(block.address() + block.capacity() <= buffer.size());
+                    for (size_t i = 0; i < block.capacity(); i++)
+                        assert(buffer[block.address() + i] == it->pattern);
+                }
+            }
+            
+            size_t usedCapacity(const AllocationList& allocations) {
+                size_t capacity = 0;
+                AllocationList::const_iterator it, end;
+                for (it = allocations.begin(), end = allocations.end(); it != end; ++it)
+                    capacity += it->block->capacity();
+                return capacity;
+            }
+        protected:
+            void registerTestCases() {
+                registerTestCase(&VboTest::testAllocAndFree);
+                registerTestCase(&VboTest::testCompactBeforeGrowing);
+                registerTestCase(&VboTest::testGrowPreservesContents);
+                registerTestCase(&VboTest::testCompactWithinBudget);
+                registerTestCase(&VboTest::testShiftRanges);
+                registerTestCase(&VboTest::testPack);
+                registerTestCase(&VboTest::testCountUploads);
+            }
+        public:
+            void testAllocAndFree() {
+                Vbo vbo(GL_ARRAY_BUFFER, 100 * Granularity);
+                SetVboState mapVbo(vbo, Vbo::VboMapped);
+                
+                VboBlock* first = vbo.allocBlock(10 * Granularity);
+                VboBlock* second = vbo.allocBlock(20 * Granularity);
+                VboBlock* third = vbo.allocBlock(30 * Granularity);
+                assert(first->address() == 0);
+                assert(second->address() == 10 * Granularity);
+                assert(third->address() == 30 * Granularity);
+                assert(vbo.freeCapacity() == 40 * Granularity);
+                assert(vbo.freeBlockCount() == 1);
+                assert(vbo.fragmentation() == 0.0f);
+                
+                first->freeBlock();
+                assert(vbo.freeBlockCount() == 2);
+                assert(vbo.largestFreeBlockCapacity() == 40 * Granularity);
+                assert(VecMath::Math<float>::eq(vbo.fragmentation(), 0.2f));
+                
+                // the smallest fitting block is used
+                VboBlock* fourth = vbo.allocBlock(5 * Granularity);
+                assert(fourth->address() == 0);
+                
+                // freeing merges adjacent free blocks
+                fourth->freeBlock();
+                second->freeBlock();
+                assert(vbo.freeBlockCount() == 2);
+                assert(vbo.largestFreeBlockCapacity() == 40 * Granularity);
+                third->freeBlock();
+                assert(vbo.freeBlockCount() == 1);
+                assert(vbo.freeCapacity() == vbo.totalCapacity());
+                
+                assert(vbo.counters().allocations == 4);
+                assert(vbo.counters().frees == 4);
+                assert(vbo.counters().resizes == 0);
+                assert(vbo.counters().movedBytes == 0);
+            }
+            
+            void testCompactBeforeGrowing() {
+                Vbo vbo(GL_ARRAY_BUFFER, 100 * Granularity);
+                SetVboState mapVbo(vbo, Vbo::VboMapped);
+                
+                AllocationList allocations;
+                for (size_t i = 0; i < 10; i++)
+                    allocate(vbo, 10 * Granularity, allocations);
+                free(2, allocations);
+                free(5, allocations);
+                assert(vbo.freeCapacity() == 20 * Granularity);
+                assert(vbo.freeBlockCount() == 2);
+                
+                // no free block can hold this, but both together can, so the VBO is compacted instead of grown
+                allocate(vbo, 15 * Granularity, allocations);
+                assert(vbo.counters().resizes == 0);
+                assert(vbo.counters().movedBlocks > 0);
+                assert(vbo.totalCapacity() == 100 * Granularity);
+                assert(vbo.freeCapacity() == 5 * Granularity);
+                checkContents(allocations);
+            }
+            
+            void testGrowPreservesContents() {
+                Vbo vbo(GL_ARRAY_BUFFER, 100 * Granularity);
+                SetVboState mapVbo(vbo, Vbo::VboMapped);
+                
+                AllocationList allocations;
+                for (size_t i = 0; i < 10; i++)
+                    allocate(vbo, 10 * Granularity, allocations);
+                free(2, allocations);
+                free(5, allocations);
+                assert(vbo.freeCapacity() == 20 * Granularity);
+                
+                // the free capacity cannot hold this, so the VBO grows and all blocks are packed
+                allocate(vbo, 25 * Granularity, allocations);
+                assert(vbo.counters().resizes == 1);
+                assert(vbo.counters().movedBlocks > 0);
+                assert(vbo.totalCapacity() >= 125 * Granularity);
+                assert(vbo.freeBlockCount() == 1);
+                checkContents(allocations);
+            }
+            
+            void testCompactWithinBudget() {
+                Vbo vbo(GL_ARRAY_BUFFER, 0x1000);
+                SetVboState mapVbo(vbo, Vbo::VboMapped);
+                
+                AllocationList allocations;
+                replayTrace(vbo, 20000, allocations);
+                checkContents(allocations);
+                
+                const Vbo::Counters traceCounters = vbo.counters();
+                const size_t freeBlockCount = vbo.freeBlockCount();
+                const float fragmentation = vbo.fragmentation();
+                assert(freeBlockCount > 1);
+                
+                const size_t budget = 0x1000;
+                const size_t maxBlockCapacity = 64 * Granularity;
+                size_t steps = 0;
+                size_t movedBytes = 0;
+                vbo.resetCounters();
+                
+                size_t moved = 0;
+                while ((moved = vbo.compact(budget)) > 0) {
+                    assert(moved < budget + maxBlockCapacity);
+                    movedBytes += moved;
+                    steps++;
+                    checkContents(allocations);
+                }
+                
+                assert(vbo.freeBlockCount() == 1);
+                assert(vbo.fragmentation() == 0.0f);
+                assert(vbo.largestFreeBlockCapacity() == vbo.totalCapacity() - usedCapacity(allocations));
+                assert(vbo.counters().movedBytes == movedBytes);
+                assert(vbo.counters().allocations == 0);
+                
+                std::printf("Vbo: %lu allocations, %lu frees, %lu resizes, %lu free blocks (fragmentation %.2f), compacted in %lu steps moving %lu bytes\n",
+                            static_cast<unsigned long>(traceCounters.allocations),
+                            static_cast<unsigned long>(traceCounters.frees),
+                            static_cast<unsigned long>(traceCounters.resizes),
+                            static_cast<unsigned long>(freeBlockCount),
+                            fragmentation,
+                            static_cast<unsigned long>(steps),
+                            static_cast<unsigned long>(movedBytes));
+            }
+            
+            void testShiftRanges() {
+                Vbo vbo(GL_ARRAY_BUFFER, 100 * Granularity);
+                SetVboState mapVbo(vbo, Vbo::VboMapped);
+                
+                // blocks of 10 vertices, where blocks 0, 2 and 4 are freed, leaving holes between the ranges
+                AllocationList allocations;
+                for (size_t i = 0; i < 8; i++)
+                    allocate(vbo, 10 * Granularity, allocations);
+                std::vector<VboBlock*> blocks;
+                for (size_t i = 0; i < allocations.size(); i++)
+                    blocks.push_back(allocations[i].block);
+                for (size_t i = 0; i < 6; i += 2)
+                    blocks[i]->freeBlock();
+                
+                // the last range covers the adjacent blocks 5, 6 and 7
+                std::vector<GLint> firsts;
+                std::vector<GLsizei> counts;
+                firsts.push_back(10);
+                counts.push_back(10);
+                firsts.push_back(30);
+                counts.push_back(10);
+                firsts.push_back(50);
+                counts.push_back(30);
+                
+                // moves blocks 1, 3 and 5, but not blocks 6 and 7
+                Vbo::MoveList moves;
+                vbo.compact(25 * Granularity, moves);
+                assert(vbo.counters().movedBlocks == 3);
+                Vbo::shiftRanges(moves, Granularity, firsts, counts);
+                
+                assert(firsts.size() == 4);
+                assert(firsts[0] == static_cast<GLint>(blocks[1]->address() / Granularity) && counts[0] == 10);
+                assert(firsts[1] == static_cast<GLint>(blocks[3]->address() / Granularity) && counts[1] == 10);
+                assert(firsts[2] == static_cast<GLint>(blocks[5]->address() / Granularity) && counts[2] == 10);
+                assert(firsts[3] == static_cast<GLint>(blocks[6]->address() / Granularity) && counts[3] == 20);
+                assert(firsts[0] == 0 && firsts[1] == 10 && firsts[2] == 20 && firsts[3] == 60);
+            }
+            
+            void testCountUploads() {
+                RenderStatistics& statistics = RenderStatistics::statistics();
+                const bool wasEnabled = statistics.enabled;
+                statistics.enabled = true;
+                statistics.reset();
+                
+                Vbo vbo(GL_ARRAY_BUFFER, 100 * Granularity);
+                AllocationList allocations;
+                {
+                    SetVboState mapVbo(vbo, Vbo::VboMapped);
+                    allocate(vbo, 10 * Granularity, allocations);
+                }
+                assert(statistics.bufferUploads == 1);
+                assert(statistics.uploadedBytes == 10 * Granularity);
+                
+                // mapping without writing anything uploads nothing
+                {
+                    SetVboState mapVbo(vbo, Vbo::VboMapped);
+                }
+                assert(statistics.bufferUploads == 1);
+                
+                // neither does resetting the written bytes while the VBO is mapped
+                {
+                    SetVboState mapVbo(vbo, Vbo::VboMapped);
+                    vbo.resetWrittenBytes();
+                }
+                assert(statistics.bufferUploads == 1);
+                
+                {
+                    SetVboState mapVbo(vbo, Vbo::VboMapped);
+                    allocate(vbo, 5 * Granularity, allocations);
+                }
+                assert(statistics.bufferUploads == 2);
+                assert(statistics.uploadedBytes == 15 * Granularity);
+                
+                statistics.reset();
+                statistics.enabled = wasEnabled;
+            }
+            
+            void testPack() {
+                Vbo vbo(GL_ARRAY_BUFFER, 0x1000);
+                SetVboState mapVbo(vbo, Vbo::VboMapped);
+                
+                AllocationList allocations;
+                replayTrace(vbo, 2000, allocations);
+                vbo.pack();
+                
+                assert(vbo.freeBlockCount() == 1);
+                assert(vbo.largestFreeBlockCapacity() == vbo.freeCapacity());
+                checkContents(allocations);
+                
+                size_t address = 0;
+                for (size_t i = 0; i < allocations.size(); i++)
+                    address = std::max(address, allocations[i].block->address() + allocations[i].block->capacity());
+                assert(address == usedCapacity(allocations));
+            }
+        };
+    }
+}
+
+#endif
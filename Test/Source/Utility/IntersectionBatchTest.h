@@ -0,0 +1,189 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_IntersectionBatchTest_h
+#define TrenchBroom_IntersectionBatchTest_h
+
+#include "TestSuite.h"
+#include "Utility/IntersectionBatch.h"
+#include "Utility/VecMath.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace VecMath {
+        class IntersectionBatchTest : public TestSuite<IntersectionBatchTest> {
+        protected:
+            void registerTestCases() {
+                registerTestCase(&IntersectionBatchTest::testBBoxBatch);
+                registerTestCase(&IntersectionBatchTest::testBBoxBatchSwapRemove);
+                registerTestCase(&IntersectionBatchTest::testThroughput);
+            }
+
+            float randomFloat(const float min, const float max) {
+                return min + (max - min) * static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
+            }
+
+            Vec3f randomVector(const float min, const float max) {
+                return Vec3f(randomFloat(min, max), randomFloat(min, max), randomFloat(min, max));
+            }
+
+            BBoxf randomBounds() {
+                const Vec3f min = randomVector(-1024.0f, 1024.0f);
+                return BBoxf(min, min + randomVector(8.0f, 256.0f));
+            }
+
+            Rayf randomRay() {
+                Vec3f direction = randomVector(-1.0f, 1.0f);
+                switch (std::rand() % 4) {
+                    case 0:
+                        // axis aligned rays exercise the parallel slab case
+                        direction = direction.firstAxis();
+                        break;
+                    default:
+                        direction.normalize();
+                        break;
+                }
+                return Rayf(randomVector(-1280.0f, 1280.0f), direction);
+            }
+
+            bool sameResult(const float expected, const float actual) {
+                if (Math<float>::isnan(expected) || Math<float>::isnan(actual))
+                    return Math<float>::isnan(expected) == Math<float>::isnan(actual);
+                return Math<float>::eq(expected, actual, 0.01f);
+            }
+        public:
+            void testBBoxBatch() {
+                std::srand(1);
+
+                std::vector<BBoxf> bounds;
+                BBoxBatch batch;
+                for (size_t i = 0; i < 1003; i++) {
+                    bounds.push_back(randomBounds());
+                    batch.add(bounds.back());
+                }
+
+                // include a box that contains the ray origin
+                const Rayf insideRay(Vec3f(1.0f, 2.0f, 3.0f), Vec3f(1.0f, 1.0f, 0.0f).normalized());
+                bounds[7] = BBoxf(Vec3f(-16.0f, -16.0f, -16.0f), Vec3f(16.0f, 16.0f, 16.0f));
+                batch.set(7, bounds[7]);
+
+                std::vector<float> distances(batch.size());
+                std::vector<float> scalarDistances(batch.size());
+                batch.intersectWithRay(insideRay, &distances[0]);
+                assert(sameResult(bounds[7].intersectWithRay(insideRay), distances[7]));
+
+                size_t hitCount = 0;
+                for (size_t i = 0; i < 200; i++) {
+                    const Rayf ray = randomRay();
+                    batch.intersectWithRay(ray, &distances[0]);
+                    batch.intersectWithRayScalar(ray, &scalarDistances[0]);
+                    for (size_t j = 0; j < bounds.size(); j++) {
+                        assert(sameResult(bounds[j].intersectWithRay(ray), distances[j]));
+                        assert(sameResult(scalarDistances[j], distances[j]));
+                        if (!Math<float>::isnan(distances[j]))
+                            hitCount++;
+                    }
+                }
+                assert(hitCount > 0);
+            }
+
+            void testBBoxBatchSwapRemove() {
+                BBoxBatch batch;
+                batch.add(BBoxf(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(1.0f, 1.0f, 1.0f)));
+                batch.add(BBoxf(Vec3f(0.0f, 0.0f, 10.0f), Vec3f(1.0f, 1.0f, 11.0f)));
+                batch.add(BBoxf(Vec3f(0.0f, 0.0f, 20.0f), Vec3f(1.0f, 1.0f, 21.0f)));
+
+                batch.swapRemove(0);
+                assert(batch.size() == 2);
+
+                const Rayf ray(Vec3f(0.5f, 0.5f, -10.0f), Vec3f::PosZ);
+                float distances[2];
+                batch.intersectWithRay(ray, distances);
+                assert(Math<float>::eq(distances[0], 30.0f));
+                assert(Math<float>::eq(distances[1], 20.0f));
+            }
+
+            void testThroughput() {
+                std::srand(3);
+
+                const size_t boundsCount = 4096;
+                const size_t rayCount = 2000;
+
+                std::vector<BBoxf> bounds;
+                BBoxBatch batch;
+                for (size_t i = 0; i < boundsCount; i++) {
+                    bounds.push_back(randomBounds());
+                    batch.add(bounds.back());
+                }
+
+                std::vector<Rayf> rays;
+                for (size_t i = 0; i < rayCount; i++)
+                    rays.push_back(randomRay());
+
+                std::vector<float> distances(boundsCount);
+                size_t boxHits = 0;
+                size_t slabHits = 0;
+                size_t batchHits = 0;
+
+                clock_t start = clock();
+                for (size_t i = 0; i < rayCount; i++)
+                    for (size_t j = 0; j < boundsCount; j++)
+                        if (!Math<float>::isnan(bounds[j].intersectWithRay(rays[i])))
+                            boxHits++;
+                const clock_t boxTime = clock() - start;
+
+                start = clock();
+                for (size_t i = 0; i < rayCount; i++) {
+                    batch.intersectWithRayScalar(rays[i], &distances[0]);
+                    for (size_t j = 0; j < boundsCount; j++)
+                        if (!Math<float>::isnan(distances[j]))
+                            slabHits++;
+                }
+                const clock_t slabTime = clock() - start;
+
+                start = clock();
+                for (size_t i = 0; i < rayCount; i++) {
+                    batch.intersectWithRay(rays[i], &distances[0]);
+                    for (size_t j = 0; j < boundsCount; j++)
+                        if (!Math<float>::isnan(distances[j]))
+                            batchHits++;
+                }
+                const clock_t batchTime = clock() - start;
+
+                // BBox::intersectWithRay against the slab test one box at a time and four boxes at a time
+                std::printf("%lu rays against %lu boxes (%lu / %lu / %lu hits): BBox: %.1f ms, slab: %.1f ms, batch: %.1f ms\n",
+                            static_cast<unsigned long>(rayCount),
+                            static_cast<unsigned long>(boundsCount),
+                            static_cast<unsigned long>(boxHits),
+                            static_cast<unsigned long>(slabHits),
+                            static_cast<unsigned long>(batchHits),
+                            1000.0 * static_cast<double>(boxTime) / CLOCKS_PER_SEC,
+                            1000.0 * static_cast<double>(slabTime) / CLOCKS_PER_SEC,
+                            1000.0 * static_cast<double>(batchTime) / CLOCKS_PER_SEC);
+            }
+        };
+    }
+}
+
+#endif
@@ -56,6 +56,7 @@ namespace TrenchBroom {
                 registerTestCase(&MatTest::testDeterminant2);
                 registerTestCase(&MatTest::testAdjoin);
                 registerTestCase(&MatTest::testAdjoint);
+                registerTestCase(&MatTest::testAxisAlignedMatrix);
             }
         public:
             void testInvert() {
@@ -388,6 +389,27 @@ namespace TrenchBroom {
                                -272.0f,  -72.0f,  104.0f,  192.0f);
                 assert(adjointMatrix(m1) == m2);
             }
+
+            void testAxisAlignedMatrix() {
+                Mat4f result;
+                assert(axisAlignedMatrix(Mat4f::Identity, result) && result == Mat4f::Identity);
+                assert(axisAlignedMatrix(Mat4f::MirY, result) && result == Mat4f::MirY);
+                assert(axisAlignedMatrix(translationMatrix(Vec3f(16.0f, -8.0f, 0.5f)), result));
+
+                const Mat4f rotation = rotationMatrix(Math<float>::Pi / 2.0f, Vec3f::PosZ) * translationMatrix(Vec3f(32.0f, 0.0f, 0.0f));
+                assert(axisAlignedMatrix(rotation, result));
+                assert(result.equals(rotation));
+                assert(result[0][0] == 0.0f && result[1][1] == 0.0f && result[0][1] == -result[1][0]);
+
+                assert(!axisAlignedMatrix(rotationMatrix(Math<float>::Pi / 4.0f, Vec3f::PosZ), result));
+                assert(!axisAlignedMatrix(scalingMatrix(2.0f), result));
+
+                const Mat4f projection(1.0f, 0.0f, 0.0f, 0.0f,
+                                       1.0f, 0.0f, 0.0f, 0.0f,
+                                       0.0f, 0.0f, 1.0f, 0.0f,
+                                       0.0f, 0.0f, 0.0f, 1.0f);
+                assert(!axisAlignedMatrix(projection, result));
+            }
         };
     }
 }
@@ -0,0 +1,192 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_ProfilerTest_h
+#define TrenchBroom_ProfilerTest_h
+
+#include "TestSuite.h"
+#include "Utility/Profiler.h"
+#include "Utility/String.h"
+
+#include <cassert>
+
+namespace TrenchBroom {
+    namespace Utility {
+        class ProfilerTest : public TestSuite<ProfilerTest> {
+        protected:
+            bool endsWith(const String& str, const String& suffix) {
+                return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+            }
+            
+            void registerTestCases() {
+                registerTestCase(&ProfilerTest::testDisabled);
+                registerTestCase(&ProfilerTest::testHistory);
+                registerTestCase(&ProfilerTest::testAverage);
+                registerTestCase(&ProfilerTest::testWriteCSV);
+                registerTestCase(&ProfilerTest::testScopedTimer);
+                registerTestCase(&ProfilerTest::testOwner);
+            }
+        public:
+            void testDisabled() {
+                Profiler profiler;
+                assert(!profiler.enabled());
+                
+                profiler.count(Profiler::DrawCalls, 10);
+                profiler.addTime(Profiler::PickTime, CLOCKS_PER_SEC);
+                profiler.endFrame();
+                assert(profiler.frameCount() == 0);
+                
+                profiler.setEnabled(true);
+                profiler.endFrame();
+                assert(profiler.frameCount() == 1);
+                assert(profiler.lastFrame().counts[Profiler::DrawCalls] == 0);
+                assert(profiler.lastFrame().times[Profiler::PickTime] < 1000.0);
+            }
+            
+            void testHistory() {
+                Profiler profiler;
+                profiler.setEnabled(true);
+                
+                const size_t frameCount = Profiler::HistorySize + 10;
+                for (size_t i = 0; i < frameCount; i++) {
+                    profiler.count(Profiler::OctreeNodesVisited, i);
+                    profiler.count(Profiler::OctreeNodesVisited);
+                    profiler.endFrame();
+                }
+                
+                assert(profiler.frameCount() == Profiler::HistorySize);
+                for (size_t i = 0; i < profiler.frameCount(); i++) {
+                    const Profiler::Frame& frame = profiler.frame(i);
+                    assert(frame.number == i + 10);
+                    assert(frame.counts[Profiler::OctreeNodesVisited] == i + 11);
+                }
+                assert(profiler.lastFrame().number == frameCount - 1);
+                
+                // re-enabling starts a new history
+                profiler.setEnabled(false);
+                profiler.setEnabled(true);
+                assert(profiler.frameCount() == 0);
+            }
+            
+            void testAverage() {
+                Profiler profiler;
+                profiler.setEnabled(true);
+                
+                profiler.count(Profiler::DrawCalls, 10);
+                profiler.addTime(Profiler::GeometryTime, CLOCKS_PER_SEC);
+                profiler.endFrame();
+                profiler.count(Profiler::DrawCalls, 20);
+                profiler.endFrame();
+                
+                const Profiler::Frame average = profiler.average();
+                assert(average.counts[Profiler::DrawCalls] == 15);
+                assert(average.times[Profiler::GeometryTime] == 500.0);
+                assert(average.number == 1);
+            }
+            
+            void testWriteCSV() {
+                Profiler profiler;
+                profiler.setEnabled(true);
+                profiler.count(Profiler::TextureBinds, 3);
+                profiler.count(Profiler::UploadedBytes, 4096);
+                profiler.endFrame();
+                profiler.endFrame();
+                
+                StringStream stream;
+                profiler.writeCSV(stream);
+                
+                String line;
+                std::getline(stream, line);
+                assert(line == "frame,frame_ms,pick_ms,geometry_ms,draw_calls,texture_binds,shader_changes,buffer_uploads,uploaded_bytes,octree_nodes_visited,render_requests,coalesced_renders,dropped_renders");
+                std::getline(stream, line);
+                assert(line.substr(0, 2) == "0,");
+                assert(endsWith(line, ",0,0,0,3,0,0,4096,0,0,0,0"));
+                std::getline(stream, line);
+                assert(line.substr(0, 2) == "1,");
+                assert(endsWith(line, ",0,0,0,0,0,0,0,0,0,0,0"));
+                assert(!std::getline(stream, line));
+            }
+            
+            void testScopedTimer() {
+                Profiler& profiler = Profiler::profiler();
+                const bool enabled = profiler.enabled();
+                
+                profiler.setEnabled(true);
+                {
+                    Profiler::ScopedTimer timer(Profiler::PickTime);
+                    const clock_t start = clock();
+                    while (clock() - start < CLOCKS_PER_SEC / 100);
+                }
+                profiler.endFrame();
+                assert(profiler.lastFrame().times[Profiler::PickTime] >= 10.0);
+                assert(profiler.lastFrame().times[Profiler::FrameTime] >= profiler.lastFrame().times[Profiler::PickTime]);
+                
+                profiler.setEnabled(false);
+                {
+                    Profiler::ScopedTimer timer(Profiler::PickTime);
+                }
+                profiler.endFrame();
+                assert(profiler.frameCount() == 1);
+                
+                profiler.setEnabled(enabled);
+            }
+            
+            void testOwner() {
+                Profiler& profiler = Profiler::profiler();
+                const bool enabled = profiler.enabled();
+                
+                int view1, view2;
+                profiler.setEnabled(true, &view1);
+                assert(profiler.profiles(&view1));
+                assert(!profiler.profiles(&view2));
+                
+                profiler.count(Profiler::DrawCalls, 1);
+                {
+                    Profiler::Suspension suspension(&view2);
+                    assert(!profiler.recording());
+                    profiler.count(Profiler::DrawCalls, 10);
+                    {
+                        Profiler::ScopedTimer timer(Profiler::PickTime);
+                        const clock_t start = clock();
+                        while (clock() - start < CLOCKS_PER_SEC / 100);
+                    }
+                }
+                {
+                    Profiler::Suspension suspension(&view1);
+                    assert(profiler.recording());
+                    profiler.count(Profiler::DrawCalls, 2);
+                }
+                profiler.endFrame();
+                assert(profiler.lastFrame().counts[Profiler::DrawCalls] == 3);
+                assert(profiler.lastFrame().times[Profiler::PickTime] == 0.0);
+                
+                profiler.setEnabled(true, &view2);
+                assert(profiler.profiles(&view2));
+                assert(profiler.frameCount() == 0);
+                
+                profiler.setEnabled(false);
+                assert(!profiler.profiles(&view2));
+                
+                profiler.setEnabled(enabled);
+            }
+        };
+    }
+}
+
+#endif
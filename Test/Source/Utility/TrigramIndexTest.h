@@ -0,0 +1,163 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_TrigramIndexTest_h
+#define TrenchBroom_TrigramIndexTest_h
+
+#include "TestSuite.h"
+#include "Utility/String.h"
+#include "Utility/TrigramIndex.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Utility {
+        class TrigramIndexTest : public TestSuite<TrigramIndexTest> {
+        protected:
+            typedef std::vector<size_t> IndexList;
+            
+            void registerTestCases() {
+                registerTestCase(&TrigramIndexTest::testFind);
+                registerTestCase(&TrigramIndexTest::testClear);
+                registerTestCase(&TrigramIndexTest::testRandomNames);
+            }
+            
+            void findAll(const StringList& names, const String& pattern, IndexList& result) {
+                for (size_t i = 0; i < names.size(); i++)
+                    if (containsString(names[i], pattern, false))
+                        result.push_back(i);
+            }
+            
+            String randomName() {
+                static const char* syllables[] = { "metal", "tech", "wiz", "+0", "+a", "sky", "door", "base", "lite", "_", "wall", "floor", "rune", "*", "lava", "Comp", "TRIM", "1", "2" };
+                static const size_t syllableCount = sizeof(syllables) / sizeof(syllables[0]);
+                
+                String name;
+                const size_t count = 1 + static_cast<size_t>(std::rand()) % 4;
+                for (size_t i = 0; i < count; i++)
+                    name += syllables[static_cast<size_t>(std::rand()) % syllableCount];
+                return name;
+            }
+        public:
+            void testFind() {
+                TrigramIndex<size_t> index;
+                index.add("metal1_1", 0);
+                index.add("METAL2_2", 1);
+                index.add("sky1", 2);
+                index.add("+0button", 3);
+                index.add("tal", 4);
+                
+                IndexList result;
+                index.find("metal", result);
+                assert(result.size() == 2);
+                assert(result[0] == 0);
+                assert(result[1] == 1);
+                
+                result.clear();
+                index.find("Tal", result);
+                assert(result.size() == 3);
+                assert(result[2] == 4);
+                
+                result.clear();
+                index.find("y", result);
+                assert(result.size() == 1);
+                assert(result[0] == 2);
+                
+                result.clear();
+                index.find("", result);
+                assert(result.size() == 5);
+                
+                result.clear();
+                index.find("metal3", result);
+                assert(result.empty());
+                
+                // both trigrams occur in "metal1_1", but not in this order
+                result.clear();
+                index.find("l1_1_", result);
+                assert(result.empty());
+            }
+            
+            void testClear() {
+                TrigramIndex<size_t> index;
+                index.add("metal1_1", 0);
+                assert(!index.empty());
+                assert(index.size() == 1);
+                
+                index.clear();
+                assert(index.empty());
+                
+                IndexList result;
+                index.find("metal", result);
+                assert(result.empty());
+            }
+            
+            void testRandomNames() {
+                std::srand(0);
+                
+                const size_t nameCount = 100000;
+                StringList names;
+                TrigramIndex<size_t> index;
+                for (size_t i = 0; i < nameCount; i++) {
+                    names.push_back(randomName());
+                    index.add(names.back(), i);
+                }
+                
+                StringList patterns;
+                for (size_t i = 0; i < 100; i++) {
+                    const String name = randomName();
+                    const size_t start = static_cast<size_t>(std::rand()) % name.size();
+                    const size_t length = 1 + static_cast<size_t>(std::rand()) % 8;
+                    patterns.push_back(name.substr(start, length));
+                }
+                
+                clock_t indexTime = 0;
+                clock_t scanTime = 0;
+                size_t matchCount = 0;
+                for (size_t i = 0; i < patterns.size(); i++) {
+                    IndexList expected;
+                    IndexList actual;
+                    
+                    clock_t start = clock();
+                    findAll(names, patterns[i], expected);
+                    scanTime += clock() - start;
+                    
+                    start = clock();
+                    index.find(patterns[i], actual);
+                    indexTime += clock() - start;
+                    
+                    assert(actual == expected);
+                    matchCount += actual.size();
+                }
+                
+                std::printf("%lu queries on %lu names (%lu matches): index: %.1f ms, linear scan: %.1f ms\n",
+                            static_cast<unsigned long>(patterns.size()),
+                            static_cast<unsigned long>(nameCount),
+                            static_cast<unsigned long>(matchCount),
+                            1000.0 * static_cast<double>(indexTime) / CLOCKS_PER_SEC,
+                            1000.0 * static_cast<double>(scanTime) / CLOCKS_PER_SEC);
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,158 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_ClipboardCacheTest_h
+#define TrenchBroom_ClipboardCacheTest_h
+
+#include "TestSuite.h"
+#include "Model/Brush.h"
+#include "Model/BrushGeometry.h"
+#include "Model/Entity.h"
+#include "Model/Face.h"
+#include "Utility/List.h"
+#include "View/ClipboardCache.h"
+
+#include <cassert>
+
+namespace TrenchBroom {
+    namespace View {
+        class ClipboardCacheTest : public TestSuite<ClipboardCacheTest> {
+        protected:
+            BBoxf m_worldBounds;
+
+            Model::Entity* createEntity(const String& classname) {
+                Model::Entity* entity = new Model::Entity(m_worldBounds);
+                entity->setProperty(Model::Entity::ClassnameKey, classname);
+                return entity;
+            }
+
+            Model::Brush* addBrush(Model::Entity& entity, const BBoxf& bounds) {
+                Model::Brush* brush = new Model::Brush(m_worldBounds, false, bounds, NULL);
+                entity.addBrush(*brush);
+                return brush;
+            }
+
+            void assertSameBrush(const Model::Brush& original, const Model::Brush& copy) {
+                assert(&original != &copy);
+                assert(copy.bounds() == original.bounds());
+                assert(copy.center() == original.center());
+                assert(copy.vertices().size() == original.vertices().size());
+                for (size_t i = 0; i < original.vertices().size(); i++)
+                    assert(copy.vertices()[i]->position == original.vertices()[i]->position);
+                assert(copy.edges().size() == original.edges().size());
+
+                assert(copy.faces().size() == original.faces().size());
+                for (size_t i = 0; i < original.faces().size(); i++) {
+                    const Model::Face& originalFace = *original.faces()[i];
+                    const Model::Face& copyFace = *copy.faces()[i];
+                    assert(copyFace.brush() == &copy);
+                    assert(copyFace.side() != NULL && copyFace.side()->face == &copyFace);
+                    assert(copyFace.boundary().normal == originalFace.boundary().normal);
+                    assert(copyFace.textureName() == originalFace.textureName());
+                    assert(copyFace.vertices().size() == originalFace.vertices().size());
+                }
+            }
+
+            void registerTestCases() {
+                m_worldBounds = BBoxf(Vec3f(-4096.0f, -4096.0f, -4096.0f), Vec3f(4096.0f, 4096.0f, 4096.0f));
+
+                registerTestCase(&ClipboardCacheTest::testGetObjects);
+                registerTestCase(&ClipboardCacheTest::testMismatch);
+            }
+        public:
+            void testGetObjects() {
+                const BBoxf bounds1(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(64.0f, 64.0f, 64.0f));
+                const BBoxf bounds2(Vec3f(-64.0f, -64.0f, 0.0f), Vec3f(-32.0f, 0.0f, 128.0f));
+
+                Model::Entity* worldspawn = createEntity(Model::Entity::WorldspawnClassname);
+                Model::Brush* brush1 = addBrush(*worldspawn, bounds1);
+                addBrush(*worldspawn, BBoxf(Vec3f(128.0f, 0.0f, 0.0f), Vec3f(192.0f, 32.0f, 16.0f)));
+                Model::Entity* door = createEntity("func_door");
+                Model::Brush* brush2 = addBrush(*door, bounds2);
+                Model::Entity* light = createEntity("light");
+
+                Model::EntityList pointEntities;
+                pointEntities.push_back(light);
+                Model::BrushList brushes;
+                brushes.push_back(brush1);
+                brushes.push_back(brush2);
+
+                ClipboardCache& cache = ClipboardCache::sharedCache();
+                cache.setObjects("{\n}\n", m_worldBounds, false, pointEntities, brushes);
+
+                // the cached objects must not depend on the originals
+                delete worldspawn;
+                delete door;
+                delete light;
+
+                Model::Brush expected1(m_worldBounds, false, bounds1, NULL);
+                Model::Brush expected2(m_worldBounds, false, bounds2, NULL);
+
+                for (size_t i = 0; i < 2; i++) {
+                    Model::EntityList entities;
+                    assert(cache.getObjects("{\r\n}\r\n", m_worldBounds, false, entities));
+                    assert(entities.size() == 3);
+
+                    // the entities are ordered and filled like the map writer writes them
+                    assert(entities[0]->worldspawn());
+                    assert(entities[0]->brushes().size() == 1);
+                    assertSameBrush(expected1, *entities[0]->brushes()[0]);
+                    assert(*entities[1]->classname() == "light");
+                    assert(entities[1]->brushes().empty());
+                    assert(*entities[2]->classname() == "func_door");
+                    assert(entities[2]->brushes().size() == 1);
+                    assertSameBrush(expected2, *entities[2]->brushes()[0]);
+
+                    // the copies are complete brushes that can be edited
+                    Model::Brush& copy = *entities[0]->brushes()[0];
+                    copy.rebuildGeometry();
+                    assertSameBrush(expected1, copy);
+
+                    Utility::deleteAll(entities);
+                }
+
+                cache.clear();
+            }
+
+            void testMismatch() {
+                Model::Entity* worldspawn = createEntity(Model::Entity::WorldspawnClassname);
+                Model::BrushList brushes;
+                brushes.push_back(addBrush(*worldspawn, BBoxf(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(64.0f, 64.0f, 64.0f))));
+
+                ClipboardCache& cache = ClipboardCache::sharedCache();
+                cache.setObjects("{\n}\n", m_worldBounds, false, Model::EntityList(), brushes);
+
+                Model::EntityList entities;
+                assert(!cache.getObjects("{\n}", m_worldBounds, false, entities));
+                assert(!cache.getObjects("{\n}\n{\n}\n", m_worldBounds, false, entities));
+                assert(!cache.getObjects("{\n}\n", m_worldBounds, true, entities));
+                assert(!cache.getObjects("{\n}\n", BBoxf(Vec3f(-8192.0f, -8192.0f, -8192.0f), Vec3f(8192.0f, 8192.0f, 8192.0f)), false, entities));
+                assert(entities.empty());
+
+                cache.clear();
+                assert(!cache.getObjects("{\n}\n", m_worldBounds, false, entities));
+                assert(entities.empty());
+
+                delete worldspawn;
+            }
+        };
+    }
+}
+
+#endif
@@ -20,10 +20,22 @@
 #include <iostream>
 
 #include "TestSuite.h"
+#include "Controller/SilhouetteEdgeIndexTest.h"
+#include "IO/GameFileSystemTest.h"
+#include "IO/MapCacheTest.h"
+#include "Model/BrushGeometryTest.h"
+#include "Model/MapTest.h"
+#include "Renderer/EdgeRendererTest.h"
+#include "Renderer/EntityBoundsArrayTest.h"
+#include "Renderer/VboTest.h"
 #include "Utility/FindIntegerPlanePointsTest.h"
+#include "Utility/IntersectionBatchTest.h"
 #include "Utility/MatTest.h"
 #include "Utility/PlaneTest.h"
+#include "Utility/ProfilerTest.h"
+#include "Utility/TrigramIndexTest.h"
 #include "Utility/VecTest.h"
+#include "View/ClipboardCacheTest.h"
 
 int main(int argc, const char * argv[]) {
     using namespace TrenchBroom;
@@ -36,6 +48,42 @@ int main(int argc, const char * argv[]) {
 
     VecMath::PlaneTest planeTest;
     planeTest.run();
+
+    VecMath::IntersectionBatchTest intersectionBatchTest;
+    intersectionBatchTest.run();
+
+    Model::BrushGeometryTest brushGeometryTest;
+    brushGeometryTest.run();
+    
+    Model::MapTest mapTest;
+    mapTest.run();
+    
+    Controller::SilhouetteEdgeIndexTest silhouetteEdgeIndexTest;
+    silhouetteEdgeIndexTest.run();
+    
+    IO::GameFileSystemTest gameFileSystemTest;
+    gameFileSystemTest.run();
+    
+    IO::MapCacheTest mapCacheTest;
+    mapCacheTest.run();
+    
+    Renderer::EdgeRendererTest edgeRendererTest;
+    edgeRendererTest.run();
+    
+    Renderer::EntityBoundsArrayTest entityBoundsArrayTest;
+    entityBoundsArrayTest.run();
+    
+    Renderer::VboTest vboTest;
+    vboTest.run();
+    
+    Utility::TrigramIndexTest trigramIndexTest;
+    trigramIndexTest.run();
+    
+    Utility::ProfilerTest profilerTest;
+    profilerTest.run();
+    
+    View::ClipboardCacheTest clipboardCacheTest;
+    clipboardCacheTest.run();
     
     /*
     VecMath::FindIntegerPlanePointsTest planePointsTest;